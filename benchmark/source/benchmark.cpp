@@ -6,12 +6,30 @@
 void hash_map_benchmark();
 void com_ptr_benchmark();
 void vector_benchmark();
+void mpmc_queue_benchmark();
+void task_scheduler_benchmark();
+void parallel_benchmark();
+void spin_lock_benchmark();
+void epoch_benchmark();
+void chunk_pool_benchmark();
+void slab_heap_benchmark();
+void numa_heap_benchmark();
+void shared_ring_benchmark();
 
 int main()
 {
 	hash_map_benchmark();
 	vector_benchmark();
 	com_ptr_benchmark();
+	mpmc_queue_benchmark();
+	task_scheduler_benchmark();
+	parallel_benchmark();
+	spin_lock_benchmark();
+	epoch_benchmark();
+	chunk_pool_benchmark();
+	slab_heap_benchmark();
+	numa_heap_benchmark();
+	shared_ring_benchmark();
 
 	return 0;
 }
@@ -0,0 +1,137 @@
+#include "stdafx.h"
+#include <lean/memory/chunk_pool.h>
+#include <lean/memory/concurrent_chunk_pool.h>
+#include <lean/containers/mpmc_queue.h>
+#include <lean/concurrent/spin_lock.h>
+#include <lean/concurrent/thread.h>
+#include <vector>
+
+namespace
+{
+
+static const long allocation_count = 1000000 / DEBUG_DENOMINATOR;
+
+struct element
+{
+	long values[8];
+};
+
+struct locked_pool_test
+{
+	lean::chunk_pool<element, 1024> pool;
+	lean::spin_lock<> lock;
+
+	LEAN_INLINE void* allocate()
+	{
+		lean::scoped_sl_lock guard(lock);
+		return pool.allocate();
+	}
+
+	LEAN_INLINE void free(void *memory)
+	{
+		lean::scoped_sl_lock guard(lock);
+		pool.free(memory);
+	}
+};
+
+struct concurrent_pool_test
+{
+	lean::concurrent_chunk_pool<element, 1024> pool;
+
+	LEAN_INLINE void* allocate() { return pool.allocate(); }
+	LEAN_INLINE void free(void *memory) { pool.free(memory); }
+};
+
+typedef lean::mpmc_queue<void*> pointer_queue;
+
+template <class Test>
+struct producer
+{
+	Test *test;
+	pointer_queue *queue;
+	long count;
+
+	void operator ()()
+	{
+		for (long i = 0; i < count; )
+		{
+			void *memory = test->allocate();
+
+			// Free locally when consumers cannot keep up
+			if (queue->try_push(memory))
+				++i;
+			else
+				test->free(memory);
+		}
+	}
+};
+
+template <class Test>
+struct consumer
+{
+	Test *test;
+	pointer_queue *queue;
+	volatile long *remaining;
+
+	void operator ()()
+	{
+		void *memory;
+
+		while (*remaining > 0)
+			if (queue->try_pop(memory))
+			{
+				test->free(memory);
+				lean::atomic_decrement(*remaining);
+			}
+	}
+};
+
+template <class Test>
+double run_pool(long producerCount, long consumerCount)
+{
+	Test test;
+	pointer_queue queue(4096);
+	volatile long remaining = allocation_count / producerCount * producerCount;
+
+	lean::highres_timer timer;
+
+	{
+		std::vector<lean::thread> threads(producerCount + consumerCount);
+
+		for (long i = 0; i < producerCount; ++i)
+		{
+			producer<Test> prod = { &test, &queue, allocation_count / producerCount };
+			threads[i] = lean::thread(prod);
+		}
+
+		for (long i = 0; i < consumerCount; ++i)
+		{
+			consumer<Test> cons = { &test, &queue, &remaining };
+			threads[producerCount + i] = lean::thread(cons);
+		}
+
+		for (size_t i = 0; i < threads.size(); ++i)
+			threads[i].join();
+	}
+
+	return timer.milliseconds();
+}
+
+} // namespace
+
+LEAN_NOLTINLINE void chunk_pool_benchmark()
+{
+	static const long thread_counts[][2] = { { 1, 1 }, { 2, 2 }, { 4, 4 }, { 8, 8 } };
+
+	for (size_t i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]); ++i)
+	{
+		long producerCount = thread_counts[i][0];
+		long consumerCount = thread_counts[i][1];
+
+		double lockedTime = run_pool<locked_pool_test>(producerCount, consumerCount);
+		double concurrentTime = run_pool<concurrent_pool_test>(producerCount, consumerCount);
+
+		std::cout << producerCount << "x" << consumerCount << " ";
+		print_results("pool_producer_consumer", "locked chunk_pool", lockedTime, "concurrent_chunk_pool", concurrentTime);
+	}
+}
@@ -0,0 +1,90 @@
+#include "stdafx.h"
+#include <lean/concurrent/epoch.h>
+#include <lean/concurrent/atomic.h>
+
+namespace
+{
+
+static const long read_count = 10000000 / DEBUG_DENOMINATOR;
+static const long retire_count = 1000000 / DEBUG_DENOMINATOR;
+
+struct node
+{
+	long value;
+};
+
+LEAN_NOINLINE long read_unprotected(node *const volatile &shared)
+{
+	long sum = 0;
+
+	for (long i = 0; i < read_count; ++i)
+		sum += lean::atomic_load(shared, lean::memory_order_acquire)->value;
+
+	return sum;
+}
+
+LEAN_NOINLINE long read_protected(node *const volatile &shared, lean::epoch_participant &participant)
+{
+	long sum = 0;
+
+	for (long i = 0; i < read_count; ++i)
+	{
+		lean::scoped_epoch_section section(participant);
+		sum += lean::atomic_load(shared, lean::memory_order_acquire)->value;
+	}
+
+	return sum;
+}
+
+LEAN_NOINLINE void free_immediately()
+{
+	for (long i = 0; i < retire_count; ++i)
+	{
+		node *volatile created = new node();
+		delete created;
+	}
+}
+
+LEAN_NOINLINE void free_retired(lean::epoch_participant &participant)
+{
+	for (long i = 0; i < retire_count; ++i)
+		participant.retire(new node());
+
+	participant.collect();
+}
+
+} // namespace
+
+LEAN_NOLTINLINE void epoch_benchmark()
+{
+	lean::epoch_domain domain;
+	lean::scoped_epoch_registration registration(domain);
+
+	node sharedNode = { 1 };
+	node *volatile shared = &sharedNode;
+
+	{
+		lean::highres_timer timer;
+		long sum = read_unprotected(shared);
+		double unprotectedTime = timer.milliseconds();
+
+		timer.tick();
+		sum += read_protected(shared, *registration);
+		double protectedTime = timer.milliseconds();
+
+		std::cout << "(" << sum << ") ";
+		print_results("epoch_read", "unprotected", unprotectedTime, "epoch_section", protectedTime);
+	}
+
+	{
+		lean::highres_timer timer;
+		free_immediately();
+		double deleteTime = timer.milliseconds();
+
+		timer.tick();
+		free_retired(*registration);
+		double retireTime = timer.milliseconds();
+
+		print_results("epoch_reclaim", "delete", deleteTime, "retire", retireTime);
+	}
+}
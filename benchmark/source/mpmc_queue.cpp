@@ -0,0 +1,131 @@
+#include "stdafx.h"
+#include <lean/containers/mpmc_queue.h>
+#include <lean/containers/simple_queue.h>
+#include <lean/concurrent/thread.h>
+#include <lean/concurrent/atomic.h>
+#include <deque>
+#include <vector>
+
+namespace
+{
+
+static const long element_count = 1000000 / DEBUG_DENOMINATOR;
+
+struct simple_queue_test
+{
+	typedef lean::simple_queue< std::deque<int> > queue_type;
+
+	queue_type queue;
+
+	simple_queue_test(size_t) { }
+
+	LEAN_INLINE bool try_push(int value)
+	{
+		queue.push_back(value);
+		return true;
+	}
+
+	LEAN_INLINE bool try_pop(int &value)
+	{
+		lean::scoped_cs_lock lock(queue.lock());
+
+		if (queue.container().empty())
+			return false;
+
+		value = queue.container().front();
+		queue.container().pop_front();
+		return true;
+	}
+};
+
+struct mpmc_queue_test
+{
+	typedef lean::mpmc_queue<int> queue_type;
+
+	queue_type queue;
+
+	mpmc_queue_test(size_t capacity)
+		: queue(capacity) { }
+
+	LEAN_INLINE bool try_push(int value) { return queue.try_push(value); }
+	LEAN_INLINE bool try_pop(int &value) { return queue.try_pop(value); }
+};
+
+template <class Test>
+struct producer
+{
+	Test *test;
+	long count;
+
+	void operator ()()
+	{
+		for (long i = 0; i < count; )
+			if (test->try_push(static_cast<int>(i)))
+				++i;
+	}
+};
+
+template <class Test>
+struct consumer
+{
+	Test *test;
+	volatile long *remaining;
+
+	void operator ()()
+	{
+		int value;
+
+		while (*remaining > 0)
+			if (test->try_pop(value))
+				lean::atomic_decrement(*remaining);
+	}
+};
+
+template <class Test>
+double run_queue(long producerCount, long consumerCount)
+{
+	Test test(1024);
+	volatile long remaining = element_count / producerCount * producerCount;
+
+	lean::highres_timer timer;
+
+	{
+		std::vector<lean::thread> threads(producerCount + consumerCount);
+
+		for (long i = 0; i < producerCount; ++i)
+		{
+			producer<Test> prod = { &test, element_count / producerCount };
+			threads[i] = lean::thread(prod);
+		}
+
+		for (long i = 0; i < consumerCount; ++i)
+		{
+			consumer<Test> cons = { &test, &remaining };
+			threads[producerCount + i] = lean::thread(cons);
+		}
+
+		for (size_t i = 0; i < threads.size(); ++i)
+			threads[i].join();
+	}
+
+	return timer.milliseconds();
+}
+
+} // namespace
+
+LEAN_NOLTINLINE void mpmc_queue_benchmark()
+{
+	static const long thread_counts[][2] = { { 1, 1 }, { 1, 4 }, { 4, 1 }, { 4, 4 }, { 8, 8 }, { 16, 16 } };
+
+	for (size_t i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]); ++i)
+	{
+		long producerCount = thread_counts[i][0];
+		long consumerCount = thread_counts[i][1];
+
+		double simpleTime = run_queue<simple_queue_test>(producerCount, consumerCount);
+		double mpmcTime = run_queue<mpmc_queue_test>(producerCount, consumerCount);
+
+		std::cout << producerCount << "x" << consumerCount << " ";
+		print_results("queue_contention", "simple_queue", simpleTime, "mpmc_queue", mpmcTime);
+	}
+}
@@ -0,0 +1,106 @@
+#include "stdafx.h"
+#include <lean/memory/numa_heap.h>
+#include <lean/functional/parallel.h>
+#include <lean/containers/simple_vector.h>
+#include <cstring>
+
+namespace
+{
+
+typedef lean::simple_vector<float, lean::simple_vector_policies::pod> float_vector;
+
+static const size_t block_size = (256 << 20) / DEBUG_DENOMINATOR;
+static const size_t element_count = 50000000 / DEBUG_DENOMINATOR;
+static const ptrdiff_t grain_size = 65536;
+static const int pass_count = 4;
+
+/// Sums the given block of memory.
+LEAN_NOINLINE size_t read_block(const size_t *block, size_t count)
+{
+	size_t sum = 0;
+
+	for (int pass = 0; pass < pass_count; ++pass)
+		for (size_t i = 0; i < count; ++i)
+			sum += block[i];
+
+	return sum;
+}
+
+/// Allocates a block from the given heap, measuring the time it takes to read it repeatedly.
+template <class Heap>
+double time_read(size_t &sum)
+{
+	size_t *block = static_cast<size_t*>( Heap::allocate(block_size) );
+	memset(block, 1, block_size);
+
+	lean::highres_timer timer;
+	sum += read_block(block, block_size / sizeof(size_t));
+	double time = timer.milliseconds();
+
+	Heap::free(block);
+	return time;
+}
+
+struct add
+{
+	double operator ()(double a, double b) const { return a + b; }
+};
+
+/// Measures the time it takes to sum the given vector in parallel.
+double time_reduce(lean::task_scheduler &scheduler, float_vector &values, double &sum)
+{
+	lean::highres_timer timer;
+
+	for (int pass = 0; pass < pass_count; ++pass)
+		sum += lean::parallel_reduce(scheduler, values.begin(), values.end(), grain_size, 0.0, add());
+
+	return timer.milliseconds();
+}
+
+} // namespace
+
+LEAN_NOLTINLINE void numa_heap_benchmark()
+{
+	int nodeCount = lean::numa_heap_base::node_count();
+	size_t sum = 0;
+
+	if (nodeCount < 2)
+		std::cout << "numa: single node, local & remote placement identical" << std::endl << std::endl;
+
+	{
+		lean::numa_heap_base::run_on_node(0);
+
+		double localTime = time_read< lean::numa_heap<0> >(sum);
+		double remoteTime = (nodeCount > 1)
+			? time_read< lean::numa_heap<1> >(sum)
+			: time_read< lean::numa_heap<0> >(sum);
+		double interleavedTime = time_read<lean::interleaved_heap>(sum);
+
+		print_results("numa_read", "local", localTime, "remote", remoteTime);
+		print_results("numa_read", "local", localTime, "interleaved", interleavedTime);
+
+		lean::numa_heap_base::run_on_node(lean::numa_heap_base::all_nodes);
+	}
+
+	{
+		lean::task_scheduler &scheduler = lean::default_task_scheduler();
+		double reduceSum = 0.0;
+
+		// Pages first touched by the calling thread
+		float_vector serialValues;
+		serialValues.resize(element_count);
+		double serialTime = time_reduce(scheduler, serialValues, reduceSum);
+
+		// Pages first touched by the workers reducing them
+		float_vector parallelValues;
+		lean::parallel_first_touch(scheduler, parallelValues, element_count, grain_size);
+		double parallelTime = time_reduce(scheduler, parallelValues, reduceSum);
+
+		print_results("numa_first_touch_reduce", "serial", serialTime, "parallel", parallelTime);
+
+		sum += static_cast<size_t>(reduceSum);
+	}
+
+	if (sum == 42)
+		std::cout << std::endl;
+}
@@ -0,0 +1,88 @@
+#include "stdafx.h"
+#include <lean/functional/parallel.h>
+#include <lean/containers/simple_vector.h>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+namespace
+{
+
+typedef lean::simple_vector<float, lean::simple_vector_policies::pod> float_vector;
+
+static const size_t element_count = 20000000 / DEBUG_DENOMINATOR;
+static const ptrdiff_t grain_size = 16384;
+
+struct add
+{
+	double operator ()(double a, double b) const { return a + b; }
+};
+
+struct transform
+{
+	float operator ()(float a) const { return sqrt(a) * 0.5f + 1.0f; }
+};
+
+void fill(float_vector &values)
+{
+	srand(12452);
+
+	values.resize(element_count);
+	for (size_t i = 0; i < element_count; ++i)
+		values[i] = static_cast<float>(rand());
+}
+
+} // namespace
+
+LEAN_NOLTINLINE void parallel_benchmark()
+{
+	lean::task_scheduler &scheduler = lean::default_task_scheduler();
+
+	float_vector values, results;
+	fill(values);
+	results.resize(element_count);
+
+	{
+		lean::highres_timer stdTimer;
+		double stdSum = std::accumulate(values.begin(), values.end(), 0.0);
+		double stdTime = stdTimer.milliseconds();
+
+		lean::highres_timer leanTimer;
+		double leanSum = lean::parallel_reduce(scheduler, values.begin(), values.end(), grain_size, 0.0, add());
+		double leanTime = leanTimer.milliseconds();
+
+		if (std::abs(stdSum - leanSum) > 1.0e-6 * stdSum)
+			std::cout << "reduce mismatch!" << std::endl;
+
+		print_results("reduce", "std", stdTime, "lean", leanTime);
+	}
+
+	{
+		lean::highres_timer stdTimer;
+		std::transform(values.begin(), values.end(), results.begin(), transform());
+		double stdTime = stdTimer.milliseconds();
+
+		lean::highres_timer leanTimer;
+		lean::parallel_transform(scheduler, values.begin(), values.end(), results.begin(), grain_size, transform());
+		double leanTime = leanTimer.milliseconds();
+
+		print_results("transform", "std", stdTime, "lean", leanTime);
+	}
+
+	{
+		float_vector sorted(values);
+
+		lean::highres_timer stdTimer;
+		std::sort(sorted.begin(), sorted.end());
+		double stdTime = stdTimer.milliseconds();
+
+		lean::highres_timer leanTimer;
+		lean::parallel_sort(scheduler, values.begin(), values.end(), grain_size, std::less<float>());
+		double leanTime = leanTimer.milliseconds();
+
+		if (!std::equal(values.begin(), values.end(), sorted.begin()))
+			std::cout << "sort mismatch!" << std::endl;
+
+		print_results("sort", "std", stdTime, "lean", leanTime);
+	}
+}
@@ -0,0 +1,268 @@
+#include "stdafx.h"
+#include <lean/io/shared_ring.h>
+#include <cstring>
+
+#ifndef _WIN32
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+
+static const int message_count = 200000 / DEBUG_DENOMINATOR;
+static const size_t message_size = 4096;
+static const int round_trip_count = 100000 / DEBUG_DENOMINATOR;
+static const size_t ping_size = 64;
+
+static const size_t ring_capacity = 4 << 20;
+static const char *const request_ring_name = "/dev/shm/lean_shared_ring_benchmark_request";
+static const char *const reply_ring_name = "/dev/shm/lean_shared_ring_benchmark_reply";
+
+/// Reads the given number of bytes from the given pipe.
+void read_pipe(int fd, void *data, size_t size)
+{
+	for (size_t offset = 0; offset < size; )
+	{
+		ssize_t count = ::read(fd, static_cast<char*>(data) + offset, size - offset);
+
+		if (count <= 0)
+			::_exit(1);
+
+		offset += count;
+	}
+}
+
+/// Writes the given number of bytes to the given pipe.
+void write_pipe(int fd, const void *data, size_t size)
+{
+	for (size_t offset = 0; offset < size; )
+	{
+		ssize_t count = ::write(fd, static_cast<const char*>(data) + offset, size - offset);
+
+		if (count <= 0)
+			::_exit(1);
+
+		offset += count;
+	}
+}
+
+/// Reserves a record of the given size, waiting for the consumer if the ring is full.
+void* reserve_record(lean::shared_ring &ring, size_t size)
+{
+	void *record;
+
+	while (!(record = ring.reserve(size)))
+		ring.wait_writable(size);
+
+	return record;
+}
+
+/// Waits for the next record, returning its first byte.
+char receive_record(lean::shared_ring &ring)
+{
+	size_t size;
+	const void *record;
+
+	while (!(record = ring.peek(size)))
+		ring.wait_readable();
+
+	char value = *static_cast<const char*>(record);
+	ring.release();
+	return value;
+}
+
+/// Sums the first byte of every record.
+struct first_byte_sum
+{
+	int *sum;
+
+	void operator ()(const void *data, size_t, lean::int4) const
+	{
+		*sum += *static_cast<const char*>(data);
+	}
+};
+
+/// Streams messages to a child process through a pipe.
+double time_pipe_throughput()
+{
+	int fds[2];
+	if (::pipe(fds) != 0)
+		return 0.0;
+
+	pid_t child = ::fork();
+
+	if (child == 0)
+	{
+		::close(fds[1]);
+
+		static char buffer[message_size];
+		int sum = 0;
+
+		for (int i = 0; i < message_count; ++i)
+		{
+			read_pipe(fds[0], buffer, message_size);
+			sum += buffer[0];
+		}
+
+		::_exit(sum == 42);
+	}
+
+	::close(fds[0]);
+
+	static char message[message_size];
+	lean::highres_timer timer;
+
+	for (int i = 0; i < message_count; ++i)
+	{
+		memset(message, i & 0x7f, message_size);
+		write_pipe(fds[1], message, message_size);
+	}
+
+	::close(fds[1]);
+	::waitpid(child, nullptr, 0);
+	return timer.milliseconds();
+}
+
+/// Streams messages to a child process through a shared ring, filling records in place.
+double time_ring_throughput()
+{
+	lean::shared_ring ring(request_ring_name, ring_capacity, lean::file::overwrite);
+
+	pid_t child = ::fork();
+
+	if (child == 0)
+	{
+		lean::shared_ring consumer(request_ring_name);
+
+		int sum = 0;
+		first_byte_sum fun = { &sum };
+
+		for (int received = 0; received < message_count; )
+		{
+			size_t count = consumer.read(fun);
+
+			if (count)
+				received += static_cast<int>(count);
+			else
+				consumer.wait_readable();
+		}
+
+		::_exit(sum == 42);
+	}
+
+	lean::highres_timer timer;
+
+	for (int i = 0; i < message_count; ++i)
+	{
+		void *record = reserve_record(ring, message_size);
+		memset(record, i & 0x7f, message_size);
+		ring.commit(record);
+	}
+
+	::waitpid(child, nullptr, 0);
+	return timer.milliseconds();
+}
+
+/// Bounces small messages off a child process through two pipes.
+double time_pipe_latency()
+{
+	int requests[2], replies[2];
+	if (::pipe(requests) != 0 || ::pipe(replies) != 0)
+		return 0.0;
+
+	pid_t child = ::fork();
+	char message[ping_size] = { 0 };
+
+	if (child == 0)
+	{
+		for (int i = 0; i < round_trip_count; ++i)
+		{
+			read_pipe(requests[0], message, ping_size);
+			write_pipe(replies[1], message, ping_size);
+		}
+
+		::_exit(0);
+	}
+
+	lean::highres_timer timer;
+
+	for (int i = 0; i < round_trip_count; ++i)
+	{
+		write_pipe(requests[1], message, ping_size);
+		read_pipe(replies[0], message, ping_size);
+	}
+
+	double time = timer.milliseconds();
+
+	::waitpid(child, nullptr, 0);
+	::close(requests[0]);
+	::close(requests[1]);
+	::close(replies[0]);
+	::close(replies[1]);
+	return time;
+}
+
+/// Bounces small messages off a child process through two shared rings.
+double time_ring_latency()
+{
+	lean::shared_ring requests(request_ring_name, ring_capacity, lean::file::overwrite);
+	lean::shared_ring replies(reply_ring_name, ring_capacity, lean::file::overwrite);
+
+	pid_t child = ::fork();
+
+	if (child == 0)
+	{
+		lean::shared_ring childRequests(request_ring_name);
+		lean::shared_ring childReplies(reply_ring_name);
+
+		for (int i = 0; i < round_trip_count; ++i)
+		{
+			char value = receive_record(childRequests);
+
+			void *reply = reserve_record(childReplies, ping_size);
+			memset(reply, value, ping_size);
+			childReplies.commit(reply);
+		}
+
+		::_exit(0);
+	}
+
+	lean::highres_timer timer;
+
+	for (int i = 0; i < round_trip_count; ++i)
+	{
+		void *request = reserve_record(requests, ping_size);
+		memset(request, i & 0x7f, ping_size);
+		requests.commit(request);
+
+		receive_record(replies);
+	}
+
+	double time = timer.milliseconds();
+
+	::waitpid(child, nullptr, 0);
+	return time;
+}
+
+} // namespace
+
+LEAN_NOLTINLINE void shared_ring_benchmark()
+{
+	print_results("shared_ring_throughput", "pipe", time_pipe_throughput(), "shared_ring", time_ring_throughput());
+	print_results("shared_ring_latency", "pipe", time_pipe_latency(), "shared_ring", time_ring_latency());
+
+	::unlink(request_ring_name);
+	::unlink(reply_ring_name);
+}
+
+#else
+
+LEAN_NOLTINLINE void shared_ring_benchmark()
+{
+	// NOTE: Consumer process spawned using fork()
+	std::cout << "shared_ring: two-process benchmark unavailable on this platform" << std::endl << std::endl;
+}
+
+#endif
@@ -0,0 +1,167 @@
+#include "stdafx.h"
+#include <lean/memory/crt_heap.h>
+#include <lean/memory/slab_heap.h>
+#include <lean/concurrent/thread.h>
+#include <vector>
+
+namespace
+{
+
+static const long churn_count = 10000000 / DEBUG_DENOMINATOR;
+static const long batch_count = 1000 / DEBUG_DENOMINATOR;
+static const long batch_size = 1000;
+static const long thread_churn_count = 2000000 / DEBUG_DENOMINATOR;
+
+/// Allocates & immediately frees blocks of one size.
+template <class Heap>
+LEAN_NOINLINE void churn_fixed(size_t size)
+{
+	for (long i = 0; i < churn_count; ++i)
+	{
+		void *volatile block = Heap::allocate(size);
+		Heap::free(block);
+	}
+}
+
+/// Allocates batches of blocks of mixed small sizes, freeing each batch in reverse order.
+template <class Heap>
+LEAN_NOINLINE void batch_lifo(const size_t *sizes)
+{
+	std::vector<void*> blocks(batch_size);
+
+	for (long i = 0; i < batch_count; ++i)
+	{
+		for (long j = 0; j < batch_size; ++j)
+			blocks[j] = Heap::allocate(sizes[j]);
+
+		for (long j = batch_size; j-- > 0; )
+			Heap::free(blocks[j]);
+	}
+}
+
+/// Keeps a working set of blocks of mixed sizes, replacing random blocks.
+template <class Heap>
+LEAN_NOINLINE void working_set(const size_t *sizes, const long *victims)
+{
+	std::vector<void*> blocks(batch_size);
+
+	for (long j = 0; j < batch_size; ++j)
+		blocks[j] = Heap::allocate(sizes[j]);
+
+	for (long i = 0; i < batch_count; ++i)
+		for (long j = 0; j < batch_size; ++j)
+		{
+			long victim = victims[j];
+			Heap::free(blocks[victim]);
+			blocks[victim] = Heap::allocate(sizes[(victim + i) % batch_size]);
+		}
+
+	for (long j = 0; j < batch_size; ++j)
+		Heap::free(blocks[j]);
+}
+
+/// Allocates & frees blocks of mixed sizes in a small working set, run on multiple threads.
+template <class Heap>
+struct thread_churn
+{
+	const size_t *sizes;
+
+	void operator ()() const
+	{
+		void *blocks[16] = { nullptr };
+
+		for (long i = 0; i < thread_churn_count; ++i)
+		{
+			void *&block = blocks[i % 16];
+			Heap::free(block);
+			block = Heap::allocate(sizes[i % batch_size]);
+		}
+
+		for (long i = 0; i < 16; ++i)
+			Heap::free(blocks[i]);
+	}
+};
+
+template <class Heap>
+double run_threads(long threadCount, const size_t *sizes)
+{
+	lean::highres_timer timer;
+
+	{
+		std::vector<lean::thread> threads(threadCount);
+
+		for (long i = 0; i < threadCount; ++i)
+		{
+			thread_churn<Heap> churn = { sizes };
+			threads[i] = lean::thread(churn);
+		}
+
+		for (long i = 0; i < threadCount; ++i)
+			threads[i].join();
+	}
+
+	return timer.milliseconds();
+}
+
+} // namespace
+
+LEAN_NOLTINLINE void slab_heap_benchmark()
+{
+	std::mt19937 random;
+	std::vector<size_t> sizes(batch_size);
+	std::vector<long> victims(batch_size);
+
+	// Mostly small blocks, skewed towards the smallest sizes
+	for (long j = 0; j < batch_size; ++j)
+	{
+		sizes[j] = 8 + random() % ((j % 8 == 0) ? 1024 : 128);
+		victims[j] = static_cast<long>(random() % batch_size);
+	}
+
+	{
+		lean::highres_timer timer;
+		churn_fixed<lean::crt_heap>(64);
+		double crtTime = timer.milliseconds();
+
+		timer.tick();
+		churn_fixed<lean::slab_heap>(64);
+		double slabTime = timer.milliseconds();
+
+		print_results("heap_churn_fixed", "crt_heap", crtTime, "slab_heap", slabTime);
+	}
+
+	{
+		lean::highres_timer timer;
+		batch_lifo<lean::crt_heap>(&sizes[0]);
+		double crtTime = timer.milliseconds();
+
+		timer.tick();
+		batch_lifo<lean::slab_heap>(&sizes[0]);
+		double slabTime = timer.milliseconds();
+
+		print_results("heap_batch_lifo", "crt_heap", crtTime, "slab_heap", slabTime);
+	}
+
+	{
+		lean::highres_timer timer;
+		working_set<lean::crt_heap>(&sizes[0], &victims[0]);
+		double crtTime = timer.milliseconds();
+
+		timer.tick();
+		working_set<lean::slab_heap>(&sizes[0], &victims[0]);
+		double slabTime = timer.milliseconds();
+
+		print_results("heap_working_set", "crt_heap", crtTime, "slab_heap", slabTime);
+	}
+
+	static const long thread_counts[] = { 1, 2, 4, 8 };
+
+	for (size_t i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]); ++i)
+	{
+		double crtTime = run_threads<lean::crt_heap>(thread_counts[i], &sizes[0]);
+		double slabTime = run_threads<lean::slab_heap>(thread_counts[i], &sizes[0]);
+
+		std::cout << thread_counts[i] << "x ";
+		print_results("heap_thread_churn", "crt_heap", crtTime, "slab_heap", slabTime);
+	}
+}
@@ -0,0 +1,93 @@
+#include "stdafx.h"
+#include <lean/concurrent/spin_lock.h>
+#include <lean/concurrent/ticket_lock.h>
+#include <lean/concurrent/critical_section.h>
+#include <lean/concurrent/thread.h>
+#include <vector>
+
+namespace
+{
+
+static const long acquisition_count = 1000000 / DEBUG_DENOMINATOR;
+
+typedef lean::spin_lock<long, lean::busy_backoff> busy_spin_lock;
+typedef lean::spin_lock<long, lean::pause_backoff> pause_spin_lock;
+typedef lean::spin_lock<long, lean::exponential_backoff<> > exponential_spin_lock;
+typedef lean::spin_lock<long, lean::yield_backoff<> > yield_spin_lock;
+typedef lean::ticket_lock<long, lean::pause_backoff> pause_ticket_lock;
+
+template <class Lock>
+struct contender
+{
+	Lock *lock;
+	volatile long *shared;
+	long count;
+	long workLength;
+
+	void operator ()()
+	{
+		for (long i = 0; i < count; ++i)
+		{
+			lock->lock();
+
+			// Simulate critical section work
+			for (long j = 0; j < workLength; ++j)
+				*shared += j;
+
+			lock->unlock();
+		}
+	}
+};
+
+template <class Lock>
+double run_contention(long threadCount, long workLength)
+{
+	Lock lock;
+	volatile long shared = 0;
+
+	lean::highres_timer timer;
+
+	{
+		std::vector<lean::thread> threads(threadCount);
+
+		for (long i = 0; i < threadCount; ++i)
+		{
+			contender<Lock> cont = { &lock, &shared, acquisition_count / threadCount, workLength };
+			threads[i] = lean::thread(cont);
+		}
+
+		for (size_t i = 0; i < threads.size(); ++i)
+			threads[i].join();
+	}
+
+	return timer.milliseconds();
+}
+
+} // namespace
+
+LEAN_NOLTINLINE void spin_lock_benchmark()
+{
+	static const long thread_counts[] = { 1, 2, 4, 8, 16 };
+	static const long work_lengths[] = { 0, 16, 256 };
+
+	for (size_t i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]); ++i)
+		for (size_t j = 0; j < sizeof(work_lengths) / sizeof(work_lengths[0]); ++j)
+		{
+			long threadCount = thread_counts[i];
+			long workLength = work_lengths[j];
+
+			double busyTime = run_contention<busy_spin_lock>(threadCount, workLength);
+			double pauseTime = run_contention<pause_spin_lock>(threadCount, workLength);
+			double exponentialTime = run_contention<exponential_spin_lock>(threadCount, workLength);
+			double yieldTime = run_contention<yield_spin_lock>(threadCount, workLength);
+			double ticketTime = run_contention<pause_ticket_lock>(threadCount, workLength);
+			double sectionTime = run_contention<lean::critical_section>(threadCount, workLength);
+
+			std::cout << threadCount << " threads, " << workLength << " work ";
+			print_results("spin_lock_backoff", "busy", busyTime, "pause", pauseTime);
+			std::cout << threadCount << " threads, " << workLength << " work ";
+			print_results("spin_lock_backoff", "exponential", exponentialTime, "yield", yieldTime);
+			std::cout << threadCount << " threads, " << workLength << " work ";
+			print_results("spin_lock_fairness", "ticket_lock", ticketTime, "critical_section", sectionTime);
+		}
+}
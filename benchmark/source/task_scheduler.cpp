@@ -0,0 +1,138 @@
+#include "stdafx.h"
+#include <lean/concurrent/task_scheduler.h>
+#include <vector>
+
+namespace
+{
+
+long serial_fib(int n)
+{
+	return (n < 2) ? n : serial_fib(n - 1) + serial_fib(n - 2);
+}
+
+long task_fib(lean::task_scheduler &scheduler, int n);
+
+struct fib_task
+{
+	lean::task_scheduler *scheduler;
+	int n;
+	long *result;
+
+	void operator ()() const { *result = task_fib(*scheduler, n); }
+};
+
+long task_fib(lean::task_scheduler &scheduler, int n)
+{
+	if (n < 2)
+		return n;
+
+	lean::task_group group;
+	long a;
+	fib_task task = { &scheduler, n - 1, &a };
+	scheduler.spawn(group, task);
+	long b = task_fib(scheduler, n - 2);
+	scheduler.wait(group);
+	return a + b;
+}
+
+typedef std::vector<int>::const_iterator int_iterator;
+
+long long serial_sum(int_iterator begin, int_iterator end)
+{
+	long long sum = 0;
+	for (; begin != end; ++begin)
+		sum += *begin;
+	return sum;
+}
+
+long long task_sum(lean::task_scheduler &scheduler, int_iterator begin, int_iterator end, ptrdiff_t grain);
+
+struct sum_task
+{
+	lean::task_scheduler *scheduler;
+	int_iterator begin, end;
+	ptrdiff_t grain;
+	long long *result;
+
+	void operator ()() const { *result = task_sum(*scheduler, begin, end, grain); }
+};
+
+long long task_sum(lean::task_scheduler &scheduler, int_iterator begin, int_iterator end, ptrdiff_t grain)
+{
+	if (end - begin <= grain)
+		return serial_sum(begin, end);
+
+	int_iterator middle = begin + (end - begin) / 2;
+
+	lean::task_group group;
+	long long a;
+	sum_task task = { &scheduler, begin, middle, grain, &a };
+	scheduler.spawn(group, task);
+	long long b = task_sum(scheduler, middle, end, grain);
+	scheduler.wait(group);
+	return a + b;
+}
+
+} // namespace
+
+LEAN_NOLTINLINE void task_scheduler_benchmark()
+{
+	lean::task_scheduler scheduler;
+
+	{
+		static const int fib_n = 30 - DEBUG_DENOMINATOR / 10;
+		long serialResult, taskResult;
+
+		lean::highres_timer serialTimer;
+		serialResult = serial_fib(fib_n);
+		double serialTime = serialTimer.milliseconds();
+
+		lean::highres_timer taskTimer;
+		taskResult = task_fib(scheduler, fib_n);
+		double taskTime = taskTimer.milliseconds();
+
+		if (serialResult != taskResult)
+			std::cout << "fib mismatch!" << std::endl;
+
+		print_results("fib_fork_join", "serial", serialTime, "tasks", taskTime);
+
+		// Single worker isolates spawn / wait overhead from parallel speedup
+		lean::task_scheduler singleScheduler(1);
+
+		lean::highres_timer singleTimer;
+		task_fib(singleScheduler, fib_n);
+		double singleTime = singleTimer.milliseconds();
+
+		// Every call with n >= 2 spawns exactly one task
+		double taskCount = static_cast<double>(serial_fib(fib_n + 1) - 1);
+		std::cout << "fib_fork_join overhead per task: "
+			<< (singleTime - serialTime) * 1000000.0 / taskCount << " ns" << std::endl << std::endl;
+	}
+
+	{
+		std::vector<int> values(20000000 / DEBUG_DENOMINATOR);
+		for (size_t i = 0; i < values.size(); ++i)
+			values[i] = rand();
+
+		static const ptrdiff_t grains[] = { 1024, 16384, 262144 };
+
+		for (size_t i = 0; i < sizeof(grains) / sizeof(grains[0]); ++i)
+		{
+			long long serialResult, taskResult;
+
+			lean::highres_timer serialTimer;
+			serialResult = serial_sum(values.begin(), values.end());
+			double serialTime = serialTimer.milliseconds();
+
+			lean::highres_timer taskTimer;
+			taskResult = task_sum(scheduler, values.begin(), values.end(), grains[i]);
+			double taskTime = taskTimer.milliseconds();
+
+			if (serialResult != taskResult)
+				std::cout << "sum mismatch!" << std::endl;
+
+			std::cout << "grain " << grains[i] << " ";
+			print_results("parallel_sum", "serial", serialTime, "tasks", taskTime);
+		}
+	}
+}
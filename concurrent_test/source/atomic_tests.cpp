@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include <lean/memory/aligned.h>
+#include <lean/concurrent/atomic.h>
 
 #include <iostream>
 
@@ -25,3 +26,62 @@ BOOST_AUTO_TEST_CASE( aligned_array )
 }
 
 BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE( atomic )
+
+BOOST_AUTO_TEST_CASE( fetch_ops )
+{
+	volatile long value = 5;
+	BOOST_CHECK_EQUAL(lean::atomic_fetch_add(value, 3), 5);
+	BOOST_CHECK_EQUAL(lean::atomic_fetch_add(value, -1, lean::memory_order_relaxed), 8);
+	BOOST_CHECK_EQUAL(lean::atomic_fetch_or(value, 0x10), 7);
+	BOOST_CHECK_EQUAL(lean::atomic_fetch_and(value, 0x13, lean::memory_order_acq_rel), 0x17);
+	BOOST_CHECK_EQUAL(value, 0x13);
+
+	volatile short shortValue = 1;
+	BOOST_CHECK_EQUAL(lean::atomic_fetch_or(shortValue, static_cast<short>(2)), 1);
+	BOOST_CHECK_EQUAL(shortValue, 3);
+}
+
+BOOST_AUTO_TEST_CASE( wide_integers )
+{
+	volatile long long value = 0x100000000LL;
+	BOOST_CHECK_EQUAL(lean::atomic_increment(value), 0x100000001LL);
+	BOOST_CHECK_EQUAL(lean::atomic_fetch_add(value, 0x100000000LL), 0x100000001LL);
+	BOOST_CHECK(lean::atomic_test_and_set(value, 0x200000001LL, 7LL));
+	BOOST_CHECK_EQUAL(lean::atomic_set(value, 1LL), 7LL);
+	BOOST_CHECK_EQUAL(lean::atomic_decrement(value), 0LL);
+}
+
+BOOST_AUTO_TEST_CASE( loads_and_stores )
+{
+	volatile long value = 0;
+	lean::atomic_store(value, 3, lean::memory_order_release);
+	BOOST_CHECK_EQUAL(lean::atomic_load(value, lean::memory_order_acquire), 3);
+	lean::atomic_store(value, 4);
+	BOOST_CHECK_EQUAL(lean::atomic_load(value, lean::memory_order_relaxed), 4);
+
+	int object = 0;
+	int *volatile pointer = nullptr;
+	lean::atomic_store(pointer, &object, lean::memory_order_release);
+	BOOST_CHECK_EQUAL(lean::atomic_load(pointer, lean::memory_order_acquire), &object);
+}
+
+#ifdef LEAN_ATOMIC_DOUBLE_WORD
+
+BOOST_AUTO_TEST_CASE( double_word )
+{
+	volatile lean::double_word value = { 1, 2 };
+	lean::double_word expected = { 1, 2 };
+	lean::double_word wrong = { 1, 3 };
+	lean::double_word replacement = { 3, 4 };
+
+	BOOST_CHECK(!lean::atomic_test_and_set(value, wrong, replacement));
+	BOOST_CHECK(lean::atomic_test_and_set(value, expected, replacement));
+	BOOST_CHECK_EQUAL(value.low, 3U);
+	BOOST_CHECK_EQUAL(value.high, 4U);
+}
+
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,189 @@
+#include "stdafx.h"
+#include <lean/concurrent/distributed_shareable_lock.h>
+#include <lean/concurrent/thread.h>
+
+namespace
+{
+
+typedef lean::distributed_shareable_lock<4, lean::yield_backoff<> > test_lock;
+
+struct reader_writer
+{
+	test_lock *lock;
+	long *value;
+	long *copy;
+	volatile long *inconsistencies;
+	int writeEvery;
+
+	void operator ()() const
+	{
+		for (int i = 0; i < 2000; ++i)
+		{
+			if (i % writeEvery == 0)
+			{
+				lean::smart::scoped_lock<test_lock> exclusive(*lock);
+				++*value;
+				++*copy;
+			}
+			else
+			{
+				lean::smart::scoped_lock< test_lock, lean::shared_lock_policy<test_lock> > shared(*lock);
+
+				if (*value != *copy)
+					lean::atomic_increment(*inconsistencies);
+			}
+		}
+	}
+};
+
+/// Tracks threads inside the critical section, counting overlaps of readers & writers.
+struct occupancy
+{
+	volatile long readers;
+	volatile long writers;
+	volatile long overlaps;
+};
+
+struct overlap_checker
+{
+	test_lock *lock;
+	occupancy *inside;
+	int writeEvery;
+
+	void operator ()() const
+	{
+		for (int i = 0; i < 20000; ++i)
+		{
+			// Exercise both the blocking & the trying paths of the reader/writer handshake
+			bool tryOnly = (i % 3 == 0);
+
+			if (i % writeEvery == 0)
+			{
+				if (tryOnly && !lock->try_lock())
+					continue;
+				else if (!tryOnly)
+					lock->lock();
+
+				if (lean::atomic_increment(inside->writers) != 1 || lean::atomic_load(inside->readers) != 0)
+					lean::atomic_increment(inside->overlaps);
+				lean::atomic_decrement(inside->writers);
+
+				lock->unlock();
+			}
+			else
+			{
+				if (tryOnly && !lock->try_lock_shared())
+					continue;
+				else if (!tryOnly)
+					lock->lock_shared();
+
+				lean::atomic_increment(inside->readers);
+				if (lean::atomic_load(inside->writers) != 0)
+					lean::atomic_increment(inside->overlaps);
+				lean::atomic_decrement(inside->readers);
+
+				lock->unlock_shared();
+			}
+		}
+	}
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE( distributed_shareable_lock )
+
+BOOST_AUTO_TEST_CASE( exclusion )
+{
+	lean::distributed_shareable_lock<> lock;
+
+	lock.lock_shared();
+	BOOST_CHECK(lock.try_lock_shared());
+	BOOST_CHECK(!lock.try_lock());
+	BOOST_CHECK(!lock.try_upgrade_lock());
+	lock.unlock_shared();
+
+	BOOST_CHECK(lock.try_upgrade_lock());
+	BOOST_CHECK(!lock.try_lock_shared());
+	BOOST_CHECK(!lock.try_lock());
+	lock.downgrade_lock();
+
+	BOOST_CHECK(lock.try_lock_shared());
+	lock.unlock_shared();
+	lock.upgrade_lock();
+	lock.unlock();
+
+	BOOST_CHECK(lock.try_lock());
+	lock.unlock();
+}
+
+BOOST_AUTO_TEST_CASE( scoped_locks )
+{
+	lean::distributed_shareable_lock<> lock;
+
+	{
+		lean::scoped_dsl_lock_shared shared(lock);
+
+		{
+			lean::scoped_dsl_upgrade_lock upgrade(lock);
+			BOOST_CHECK(!lock.try_lock_shared());
+		}
+
+		BOOST_CHECK(!lock.try_lock());
+	}
+
+	{
+		lean::scoped_dsl_lock exclusive(lock);
+		BOOST_CHECK(!lock.try_lock_shared());
+	}
+
+	BOOST_CHECK(lock.try_lock());
+	lock.unlock();
+}
+
+BOOST_AUTO_TEST_CASE( contention )
+{
+	static const int threadCount = 6;
+
+	test_lock lock;
+	long value = 0, copy = 0;
+	volatile long inconsistencies = 0;
+
+	lean::thread threads[threadCount];
+
+	for (int i = 0; i < threadCount; ++i)
+	{
+		reader_writer task = { &lock, &value, &copy, &inconsistencies, 10 + i };
+		threads[i] = lean::thread(task);
+	}
+
+	for (int i = 0; i < threadCount; ++i)
+		threads[i].join();
+
+	BOOST_CHECK_EQUAL(inconsistencies, 0);
+	BOOST_CHECK_EQUAL(value, copy);
+}
+
+BOOST_AUTO_TEST_CASE( reader_writer_overlap )
+{
+	static const int threadCount = 8;
+
+	test_lock lock;
+	occupancy inside = { 0, 0, 0 };
+
+	lean::thread threads[threadCount];
+
+	for (int i = 0; i < threadCount; ++i)
+	{
+		overlap_checker task = { &lock, &inside, 2 + i % 4 };
+		threads[i] = lean::thread(task);
+	}
+
+	for (int i = 0; i < threadCount; ++i)
+		threads[i].join();
+
+	BOOST_CHECK_EQUAL(inside.overlaps, 0);
+	BOOST_CHECK_EQUAL(inside.readers, 0);
+	BOOST_CHECK_EQUAL(inside.writers, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,172 @@
+#include "stdafx.h"
+#include <lean/concurrent/epoch.h>
+#include <lean/concurrent/thread.h>
+
+namespace
+{
+
+static const long alive_magic = 0x600DF00D;
+static const long dead_magic = 0xDEADBEEF;
+
+volatile long constructed_count = 0;
+volatile long destructed_count = 0;
+
+struct node
+{
+	volatile long magic;
+	long value;
+
+	node(long value)
+		: magic(alive_magic),
+		value(value)
+	{
+		lean::atomic_increment(constructed_count);
+	}
+	~node()
+	{
+		magic = dead_magic;
+		lean::atomic_increment(destructed_count);
+	}
+};
+
+struct shared_state
+{
+	lean::epoch_domain *domain;
+	node *volatile current;
+	volatile long stop;
+	volatile long violations;
+};
+
+struct reader
+{
+	shared_state *state;
+
+	void operator ()() const
+	{
+		lean::scoped_epoch_registration registration(*state->domain);
+
+		while (!state->stop)
+		{
+			lean::scoped_epoch_section section(*registration);
+
+			node *observed = lean::atomic_load(state->current, lean::memory_order_acquire);
+
+			// Node may be replaced, but must not be freed while inside the critical section
+			for (int i = 0; i < 16; ++i)
+				if (observed->magic != alive_magic)
+					lean::atomic_increment(state->violations);
+		}
+	}
+};
+
+struct writer
+{
+	shared_state *state;
+	long count;
+
+	void operator ()() const
+	{
+		lean::scoped_epoch_registration registration(*state->domain);
+
+		for (long i = 0; i < count; ++i)
+		{
+			node *replaced = lean::atomic_set(state->current, new node(i));
+			registration->retire(replaced);
+		}
+	}
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE( epoch )
+
+BOOST_AUTO_TEST_CASE( single_thread )
+{
+	long constructed = constructed_count;
+	long destructed = destructed_count;
+
+	{
+		lean::epoch_domain domain(4);
+		lean::scoped_epoch_registration registration(domain);
+
+		for (int i = 0; i < 100; ++i)
+			registration->retire(new node(i));
+
+		// Objects are freed in batches as the epoch advances
+		BOOST_CHECK(destructed_count - destructed > 0);
+		BOOST_CHECK(registration->retired_count() < 100);
+
+		{
+			lean::scoped_epoch_section section(*registration);
+
+			unsigned long epoch = domain.epoch();
+			node *pinned = new node(100);
+			registration->retire(pinned);
+
+			// Epoch cannot advance twice while inside a critical section
+			domain.try_advance();
+			domain.try_advance();
+			BOOST_CHECK(domain.epoch() - epoch <= 1);
+			BOOST_CHECK_EQUAL(pinned->magic, alive_magic);
+		}
+	}
+
+	// All retired objects freed on domain destruction
+	BOOST_CHECK_EQUAL(constructed_count - constructed, destructed_count - destructed);
+}
+
+BOOST_AUTO_TEST_CASE( registration_reuse )
+{
+	lean::epoch_domain domain;
+
+	lean::epoch_participant *first = domain.register_thread();
+	domain.unregister_thread(first);
+	lean::epoch_participant *second = domain.register_thread();
+	BOOST_CHECK_EQUAL(first, second);
+	domain.unregister_thread(second);
+}
+
+BOOST_AUTO_TEST_CASE( stress )
+{
+	static const int readerCount = 3;
+	static const int writerCount = 2;
+
+	long constructed = constructed_count;
+	long destructed = destructed_count;
+
+	{
+		lean::epoch_domain domain(16);
+		shared_state state = { &domain, new node(-1), 0, 0 };
+
+		lean::thread writers[writerCount];
+		lean::thread readers[readerCount];
+
+		for (int i = 0; i < readerCount; ++i)
+		{
+			reader task = { &state };
+			readers[i] = lean::thread(task);
+		}
+
+		for (int i = 0; i < writerCount; ++i)
+		{
+			writer task = { &state, 20000 };
+			writers[i] = lean::thread(task);
+		}
+
+		for (int i = 0; i < writerCount; ++i)
+			writers[i].join();
+
+		lean::atomic_set(state.stop, 1L);
+
+		for (int i = 0; i < readerCount; ++i)
+			readers[i].join();
+
+		BOOST_CHECK_EQUAL(state.violations, 0);
+
+		delete state.current;
+	}
+
+	BOOST_CHECK_EQUAL(constructed_count - constructed, destructed_count - destructed);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,197 @@
+#include "stdafx.h"
+#include <lean/functional/parallel.h>
+#include <lean/containers/simple_vector.h>
+#include <vector>
+#include <string>
+#include <numeric>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+
+struct double_index
+{
+	int *dest;
+
+	void operator ()(int i) const { dest[i] = 2 * i; }
+};
+
+struct add
+{
+	long long operator ()(long long a, long long b) const { return a + b; }
+};
+
+struct negate
+{
+	int operator ()(int a) const { return -a; }
+};
+
+struct increment
+{
+	void operator ()(int &a) const { ++a; }
+};
+
+/// Throws on construction once the given number of instances is exceeded.
+struct limited
+{
+	static volatile long instances;
+	static long limit;
+
+	limited()
+	{
+		if (lean::atomic_increment(instances) > limit)
+		{
+			lean::atomic_decrement(instances);
+			throw std::bad_alloc();
+		}
+	}
+	limited(const limited&) { lean::atomic_increment(instances); }
+	~limited() { lean::atomic_decrement(instances); }
+};
+
+volatile long limited::instances = 0;
+long limited::limit = 0;
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE( parallel )
+
+BOOST_AUTO_TEST_CASE( for_index )
+{
+	lean::task_scheduler scheduler(4);
+
+	const int count = 100003;
+	std::vector<int> values(count);
+	double_index body = { &values[0] };
+	lean::parallel_for(scheduler, 0, count, 1000, body);
+
+	for (int i = 0; i < count; ++i)
+		BOOST_CHECK_EQUAL(values[i], 2 * i);
+}
+
+BOOST_AUTO_TEST_CASE( reduce_transform )
+{
+	lean::task_scheduler scheduler(4);
+
+	const int count = 100003;
+	std::vector<int> values(count);
+	for (int i = 0; i < count; ++i)
+		values[i] = rand();
+
+	BOOST_CHECK_EQUAL(
+		lean::parallel_reduce(scheduler, values.begin(), values.end(), 777, 0LL, add()),
+		std::accumulate(values.begin(), values.end(), 0LL) );
+
+	std::vector<int> negated(count);
+	lean::parallel_transform(scheduler, values.begin(), values.end(), negated.begin(), 500, negate());
+
+	for (int i = 0; i < count; ++i)
+		BOOST_CHECK_EQUAL(negated[i], -values[i]);
+}
+
+BOOST_AUTO_TEST_CASE( sort )
+{
+	lean::task_scheduler scheduler(4);
+
+	for (int count = 0; count < 64; ++count)
+	{
+		std::vector<int> values(count);
+		for (int i = 0; i < count; ++i)
+			values[i] = rand() % 7;
+
+		std::vector<int> sorted(values);
+		std::sort(sorted.begin(), sorted.end());
+
+		lean::parallel_sort(scheduler, values.begin(), values.end(), 2, std::less<int>());
+		BOOST_CHECK(values == sorted);
+	}
+
+	std::vector<int> values(100003);
+	for (size_t i = 0; i < values.size(); ++i)
+		values[i] = rand();
+
+	std::vector<int> sorted(values);
+	std::sort(sorted.begin(), sorted.end());
+
+	lean::parallel_sort(scheduler, values.begin(), values.end(), 1000, std::less<int>());
+	BOOST_CHECK(values == sorted);
+
+	// Non-trivial elements are moved through the scratch storage
+	std::vector<std::string> strings(5000);
+	for (size_t i = 0; i < strings.size(); ++i)
+		strings[i] = std::string(rand() % 40, static_cast<char>('a' + rand() % 26));
+
+	std::vector<std::string> sortedStrings(strings);
+	std::sort(sortedStrings.begin(), sortedStrings.end());
+
+	lean::parallel_sort(scheduler, strings.begin(), strings.end(), 100, std::less<std::string>());
+	BOOST_CHECK(strings == sortedStrings);
+}
+
+BOOST_AUTO_TEST_CASE( ranges )
+{
+	typedef lean::simple_vector<int, lean::simple_vector_policies::pod> vec_type;
+	vec_type values;
+
+	const int count = 10000;
+	for (int i = 0; i < count; ++i)
+		values.push_back(count - i);
+
+	lean::parallel_for_each(values, 100, increment());
+	lean::parallel_sort(values, 100);
+
+	for (int i = 0; i < count; ++i)
+		BOOST_CHECK_EQUAL(values[i], i + 2);
+
+	BOOST_CHECK_EQUAL(lean::parallel_reduce(values, 100, 0LL, add()), (long long) count * (count + 3) / 2);
+}
+
+BOOST_AUTO_TEST_CASE( first_touch )
+{
+	lean::task_scheduler scheduler(4);
+
+	typedef lean::simple_vector<int, lean::simple_vector_policies::pod> vec_type;
+	vec_type values;
+	values.push_back(7);
+
+	const int count = 100003;
+	lean::parallel_first_touch(scheduler, values, count, 4096);
+	BOOST_CHECK_EQUAL(values.size(), (size_t) count);
+	BOOST_CHECK_EQUAL(values[0], 7);
+
+	double_index body = { values.data() };
+	lean::parallel_for(scheduler, 1, count, 4096, body);
+
+	for (int i = 1; i < count; ++i)
+		BOOST_CHECK_EQUAL(values[i], 2 * i);
+
+	// Never shrinks
+	lean::parallel_first_touch(scheduler, values, 10, 4096);
+	BOOST_CHECK_EQUAL(values.size(), (size_t) count);
+}
+
+BOOST_AUTO_TEST_CASE( first_touch_failure )
+{
+	lean::task_scheduler scheduler(4);
+
+	typedef lean::simple_vector<limited, lean::simple_vector_policies::semipod> vec_type;
+	vec_type values;
+	limited::limit = 5000;
+	values.push_back(limited());
+
+	// Some chunks fail, all new elements destructed
+	BOOST_CHECK_THROW(lean::parallel_first_touch(scheduler, values, 10001, 100), std::bad_alloc);
+	BOOST_CHECK_EQUAL(values.size(), 1U);
+	BOOST_CHECK_EQUAL(limited::instances, 1);
+
+	limited::limit = 20000;
+	lean::parallel_first_touch(scheduler, values, 10001, 100);
+	BOOST_CHECK_EQUAL(values.size(), 10001U);
+	BOOST_CHECK_EQUAL(limited::instances, 10001);
+
+	values.clear();
+	BOOST_CHECK_EQUAL(limited::instances, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,105 @@
+#include "stdafx.h"
+#include <lean/concurrent/spin_lock.h>
+#include <lean/concurrent/shareable_spin_lock.h>
+#include <lean/concurrent/ticket_lock.h>
+#include <lean/concurrent/thread.h>
+
+namespace
+{
+
+static const int thread_count = 4;
+static const int increment_count = 10000;
+
+template <class Lock>
+struct locked_increment
+{
+	Lock *lock;
+	long *counter;
+
+	void operator ()() const
+	{
+		for (int i = 0; i < increment_count; ++i)
+		{
+			lock->lock();
+			++*counter;
+			lock->unlock();
+		}
+	}
+};
+
+template <class Lock>
+long contended_increment()
+{
+	Lock lock;
+	long counter = 0;
+
+	lean::thread threads[thread_count];
+	locked_increment<Lock> increment = { &lock, &counter };
+
+	for (int i = 0; i < thread_count; ++i)
+		threads[i] = lean::thread(increment);
+
+	for (int i = 0; i < thread_count; ++i)
+		threads[i].join();
+
+	return counter;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE( spin_lock )
+
+BOOST_AUTO_TEST_CASE( try_lock )
+{
+	lean::spin_lock<> spinLock;
+	BOOST_CHECK(spinLock.try_lock());
+	BOOST_CHECK(!spinLock.try_lock());
+	spinLock.unlock();
+	BOOST_CHECK(spinLock.try_lock());
+	spinLock.unlock();
+
+	lean::ticket_lock<> ticketLock;
+	BOOST_CHECK(ticketLock.try_lock());
+	BOOST_CHECK(!ticketLock.try_lock());
+	ticketLock.unlock();
+	ticketLock.lock();
+	BOOST_CHECK(!ticketLock.try_lock());
+	ticketLock.unlock();
+	BOOST_CHECK(ticketLock.try_lock());
+	ticketLock.unlock();
+}
+
+BOOST_AUTO_TEST_CASE( shared_lock )
+{
+	lean::shareable_spin_lock<> lock;
+
+	lock.lock_shared();
+	BOOST_CHECK(lock.try_lock_shared());
+	BOOST_CHECK(!lock.try_lock());
+	lock.unlock_shared();
+	lock.upgrade_lock();
+	BOOST_CHECK(!lock.try_lock_shared());
+	lock.downgrade_lock();
+	lock.unlock_shared();
+	BOOST_CHECK(lock.try_lock());
+	lock.unlock();
+}
+
+BOOST_AUTO_TEST_CASE( contention )
+{
+	static const long expected = thread_count * increment_count;
+
+	typedef lean::spin_lock<long, lean::busy_backoff> busy_spin_lock;
+	typedef lean::spin_lock<long, lean::pause_backoff> pause_spin_lock;
+	typedef lean::spin_lock<long, lean::yield_backoff<> > yield_spin_lock;
+	typedef lean::ticket_lock<long, lean::yield_backoff<> > yield_ticket_lock;
+
+	BOOST_CHECK_EQUAL(contended_increment< lean::spin_lock<> >(), expected);
+	BOOST_CHECK_EQUAL(contended_increment<busy_spin_lock>(), expected);
+	BOOST_CHECK_EQUAL(contended_increment<pause_spin_lock>(), expected);
+	BOOST_CHECK_EQUAL(contended_increment<yield_spin_lock>(), expected);
+	BOOST_CHECK_EQUAL(contended_increment< lean::shareable_spin_lock<> >(), expected);
+	BOOST_CHECK_EQUAL(contended_increment<yield_ticket_lock>(), expected);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
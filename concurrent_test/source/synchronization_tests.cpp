@@ -0,0 +1,101 @@
+#include "stdafx.h"
+#include <lean/concurrent/critical_section.h>
+#include <lean/concurrent/semaphore.h>
+#include <lean/concurrent/event.h>
+#include <lean/concurrent/thread.h>
+
+namespace
+{
+
+struct contended_increment
+{
+	lean::critical_section *section;
+	lean::event *start;
+	lean::semaphore *done;
+	long *counter;
+
+	void operator ()() const
+	{
+		start->wait();
+
+		for (int i = 0; i < 10000; ++i)
+		{
+			lean::scoped_cs_lock lock(*section);
+			++*counter;
+		}
+
+		done->unlock();
+	}
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE( synchronization )
+
+BOOST_AUTO_TEST_CASE( critical_section_reentrancy )
+{
+	lean::critical_section section;
+
+	BOOST_CHECK(section.try_lock());
+	BOOST_CHECK(section.try_lock());
+	section.lock();
+	section.unlock();
+	section.unlock();
+	section.unlock();
+
+	BOOST_CHECK(section.try_lock());
+	section.unlock();
+}
+
+BOOST_AUTO_TEST_CASE( semaphore_count )
+{
+	lean::semaphore semaphore(2);
+
+	BOOST_CHECK(semaphore.try_lock());
+	BOOST_CHECK(semaphore.try_lock());
+	BOOST_CHECK(!semaphore.try_lock());
+
+	semaphore.unlock();
+	BOOST_CHECK(semaphore.try_lock());
+}
+
+BOOST_AUTO_TEST_CASE( event_state )
+{
+	lean::event event;
+
+	event.set();
+	event.wait();
+	event.wait();
+
+	event.reset();
+	event.signaled(true);
+	event.wait();
+}
+
+BOOST_AUTO_TEST_CASE( contended_lock )
+{
+	static const int threadCount = 4;
+
+	lean::critical_section section;
+	lean::event start;
+	lean::semaphore done(0);
+	long counter = 0;
+
+	lean::thread threads[threadCount];
+	contended_increment increment = { &section, &start, &done, &counter };
+
+	for (int i = 0; i < threadCount; ++i)
+		threads[i] = lean::thread(increment);
+
+	start.set();
+
+	for (int i = 0; i < threadCount; ++i)
+		done.lock();
+
+	for (int i = 0; i < threadCount; ++i)
+		threads[i].join();
+
+	BOOST_CHECK_EQUAL(counter, threadCount * 10000);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,103 @@
+#include "stdafx.h"
+#include <lean/concurrent/task_scheduler.h>
+#include <vector>
+
+namespace
+{
+
+long fib(lean::task_scheduler &scheduler, int n);
+
+struct fib_task
+{
+	lean::task_scheduler *scheduler;
+	int n;
+	long *result;
+
+	void operator ()() const { *result = fib(*scheduler, n); }
+};
+
+long fib(lean::task_scheduler &scheduler, int n)
+{
+	if (n < 2)
+		return n;
+
+	lean::task_group group;
+	long a;
+	fib_task task = { &scheduler, n - 1, &a };
+	scheduler.spawn(group, task);
+	long b = fib(scheduler, n - 2);
+	scheduler.wait(group);
+	return a + b;
+}
+
+struct increment_task
+{
+	volatile long *counter;
+
+	void operator ()() const { lean::atomic_increment(*counter); }
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE( task_scheduler )
+
+BOOST_AUTO_TEST_CASE( fork_join )
+{
+	lean::task_scheduler scheduler(4);
+	BOOST_CHECK_EQUAL(scheduler.worker_count(), 4);
+
+	BOOST_CHECK_EQUAL(fib(scheduler, 20), 6765);
+	BOOST_CHECK_EQUAL(fib(scheduler, 1), 1);
+}
+
+BOOST_AUTO_TEST_CASE( external_spawn )
+{
+	lean::task_scheduler scheduler(2);
+
+	volatile long counter = 0;
+	lean::task_group group;
+
+	// Exceeds the external queue capacity, remaining tasks run inline
+	const long task_count = 5000;
+
+	for (long i = 0; i < task_count; ++i)
+	{
+		increment_task task = { &counter };
+		scheduler.spawn(group, task);
+	}
+
+	scheduler.wait(group);
+	BOOST_CHECK(group.done());
+	BOOST_CHECK_EQUAL(counter, task_count);
+}
+
+BOOST_AUTO_TEST_CASE( single_worker )
+{
+	lean::task_scheduler scheduler(1);
+	BOOST_CHECK_EQUAL(fib(scheduler, 15), 610);
+}
+
+BOOST_AUTO_TEST_CASE( repeated_rounds )
+{
+	lean::task_scheduler scheduler(4);
+
+	// Stolen & external tasks are freed by threads other than the allocating ones
+	for (int round = 0; round < 200; ++round)
+	{
+		BOOST_CHECK_EQUAL(fib(scheduler, 12), 144);
+
+		volatile long counter = 0;
+		lean::task_group group;
+
+		for (long i = 0; i < 100; ++i)
+		{
+			increment_task task = { &counter };
+			scheduler.spawn(group, task);
+		}
+
+		scheduler.wait(group);
+		BOOST_CHECK_EQUAL(counter, 100);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
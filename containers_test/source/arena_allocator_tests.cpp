@@ -0,0 +1,153 @@
+#include "stdafx.h"
+#include <lean/memory/arena_allocator.h>
+#include <lean/containers/simple_vector.h>
+#include <lean/containers/simple_hash_map.h>
+#include <lean/containers/dynamic_array.h>
+#include <lean/containers/parallel_vector.h>
+
+namespace
+{
+
+typedef lean::chunk_heap<1024, lean::default_heap, 0> test_arena;
+
+/// Checks whether any memory was allocated from the given arena.
+bool arena_used(const test_arena &arena)
+{
+	return arena.stats().usedBytes > 0;
+}
+
+struct first_tag { };
+struct second_tag { };
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE( arena_allocator )
+
+BOOST_AUTO_TEST_CASE( simple_vector )
+{
+	test_arena arena, otherArena;
+
+	typedef lean::simple_vector< int, lean::simple_vector_policies::pod, lean::arena_allocator<int, test_arena> > vec_type;
+	vec_type vec( (vec_type::allocator_type(arena)) );
+
+	for (int i = 0; i < 100; ++i)
+		vec.push_back(i);
+
+	BOOST_CHECK(arena_used(arena));
+	BOOST_CHECK(&vec.get_allocator().arena() == &arena);
+
+	// Copies allocate from the same arena
+	vec_type copy(vec);
+	BOOST_CHECK(copy.get_allocator() == vec.get_allocator());
+	BOOST_CHECK_EQUAL(copy.size(), 100U);
+	BOOST_CHECK_EQUAL(copy[99], 99);
+
+	// Swap exchanges arenas
+	vec_type other( (vec_type::allocator_type(otherArena)) );
+	other.push_back(-1);
+	vec.swap(other);
+	BOOST_CHECK(&vec.get_allocator().arena() == &otherArena);
+	BOOST_CHECK(&other.get_allocator().arena() == &arena);
+	BOOST_CHECK_EQUAL(vec.size(), 1U);
+	BOOST_CHECK_EQUAL(other.size(), 100U);
+
+	// Move transfers arenas
+	vec = std::move(other);
+	BOOST_CHECK(&vec.get_allocator().arena() == &arena);
+	BOOST_CHECK_EQUAL(vec.size(), 100U);
+	BOOST_CHECK_EQUAL(vec[42], 42);
+}
+
+BOOST_AUTO_TEST_CASE( simple_hash_map )
+{
+	test_arena arena, otherArena;
+
+	typedef lean::simple_hash_map< int, int, lean::simple_hash_map_policies::pod, lean::hash<int>, lean::containers::default_keys<int>,
+		std::equal_to<int>, lean::arena_allocator<int, test_arena> > map_type;
+	map_type map( (map_type::allocator_type(arena)) );
+
+	for (int i = 0; i < 100; ++i)
+		map[i] = 2 * i;
+
+	BOOST_CHECK(arena_used(arena));
+
+	map_type other( (map_type::allocator_type(otherArena)) );
+	other[1000] = 1;
+	
+	// Move transfers elements & arena
+	other = std::move(map);
+	BOOST_CHECK(&other.get_allocator().arena() == &arena);
+	BOOST_CHECK_EQUAL(other.size(), 100U);
+	BOOST_CHECK_EQUAL(other[42], 84);
+	BOOST_CHECK(other.find(1000) == other.end());
+	BOOST_CHECK_EQUAL(map.size(), 0U);
+
+	// Swap exchanges arenas
+	map[7] = 7;
+	swap(map, other);
+	BOOST_CHECK(&map.get_allocator().arena() == &arena);
+	BOOST_CHECK_EQUAL(map.size(), 100U);
+	BOOST_CHECK_EQUAL(other.size(), 1U);
+	BOOST_CHECK_EQUAL(other[7], 7);
+}
+
+BOOST_AUTO_TEST_CASE( dynamic_array )
+{
+	test_arena arena;
+
+	typedef lean::dynamic_array< int, lean::arena_heap<test_arena> > array_type;
+	array_type array(100, array_type::heap_type(arena));
+
+	for (int i = 0; i < 100; ++i)
+		array.push_back(i);
+
+	BOOST_CHECK(arena_used(arena));
+	BOOST_CHECK(&array.get_heap().arena() == &arena);
+
+	array_type copy(array);
+	BOOST_CHECK(&copy.get_heap().arena() == &arena);
+	BOOST_CHECK_EQUAL(copy[99], 99);
+
+	test_arena otherArena;
+	array_type other( (array_type::heap_type(otherArena)) );
+	other = std::move(copy);
+	BOOST_CHECK(&other.get_heap().arena() == &arena);
+	BOOST_CHECK_EQUAL(other.size(), 100U);
+}
+
+BOOST_AUTO_TEST_CASE( parallel_vector )
+{
+	test_arena arena;
+
+	typedef lean::arena_allocator<void, test_arena> allocator_type;
+	typedef lean::parallel_vector_t< lean::simple_vector_binder<lean::vector_policies::pod, allocator_type> >
+		::make<int, first_tag, float, second_tag>::type vec_type;
+	vec_type vec( (vec_type::allocator_type(arena)) );
+
+	for (int i = 0; i < 100; ++i)
+		vec.push_back(i, static_cast<float>(i));
+
+	BOOST_CHECK(arena_used(arena));
+	BOOST_CHECK_EQUAL(vec.size(), 100U);
+	BOOST_CHECK_EQUAL(vec(first_tag())[42], 42);
+	BOOST_CHECK_EQUAL(vec(second_tag())[42], 42.0f);
+}
+
+BOOST_AUTO_TEST_CASE( reset_arena )
+{
+	test_arena arena;
+
+	{
+		lean::simple_vector< int, lean::simple_vector_policies::pod, lean::arena_allocator<int, test_arena> >
+			vec( (lean::arena_allocator<int, test_arena>(arena)) );
+		vec.resize(1000);
+	}
+
+	BOOST_CHECK(arena.stats().usedBytes >= 1000 * sizeof(int));
+
+	// Per-request containers released all at once
+	arena.clear();
+	BOOST_CHECK_EQUAL(arena.stats().usedBytes, 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,125 @@
+#include "stdafx.h"
+#include <lean/containers/mpmc_queue.h>
+#include <lean/concurrent/thread.h>
+#include <lean/concurrent/atomic.h>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE( mpmc_queue )
+
+BOOST_AUTO_TEST_CASE( single_threaded )
+{
+	lean::mpmc_queue<int> queue(5);
+
+	BOOST_CHECK_EQUAL(queue.capacity(), 8);
+	BOOST_CHECK(queue.empty());
+
+	int value = -1;
+	BOOST_CHECK(!queue.try_pop(value));
+
+	for (int i = 0; i < 8; ++i)
+		BOOST_CHECK(queue.try_push(i));
+
+	BOOST_CHECK(!queue.try_push(8));
+	BOOST_CHECK_EQUAL(queue.size(), 8);
+
+	// FIFO order, wrapping around the ring several times
+	for (int lap = 0; lap < 3; ++lap)
+		for (int i = 0; i < 8; ++i)
+		{
+			BOOST_CHECK(queue.try_pop(value));
+			BOOST_CHECK_EQUAL(value, lap * 8 + i);
+			BOOST_CHECK(queue.try_push(lap * 8 + i + 8));
+		}
+
+	BOOST_CHECK_EQUAL(queue.size(), 8);
+}
+
+BOOST_AUTO_TEST_CASE( batched )
+{
+	lean::mpmc_queue<int> queue(8);
+
+	int values[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+	BOOST_CHECK_EQUAL(queue.try_push_n(values, 3), 3);
+	BOOST_CHECK_EQUAL(queue.try_push_n(values + 3, 7), 5);
+	BOOST_CHECK_EQUAL(queue.try_push_n(values + 8, 2), 0);
+
+	int popped[10] = { 0 };
+	BOOST_CHECK_EQUAL(queue.try_pop_n(popped, 6), 6);
+	BOOST_CHECK_EQUAL(queue.try_pop_n(popped + 6, 4), 2);
+	BOOST_CHECK_EQUAL(queue.try_pop_n(popped + 8, 2), 0);
+
+	for (int i = 0; i < 8; ++i)
+		BOOST_CHECK_EQUAL(popped[i], i);
+}
+
+namespace
+{
+
+struct producer
+{
+	lean::mpmc_queue<long> *queue;
+	long first, count, stride;
+
+	void operator ()()
+	{
+		for (long i = 0; i < count; )
+			if (queue->try_push(first + i * stride))
+				++i;
+	}
+};
+
+struct consumer
+{
+	lean::mpmc_queue<long> *queue;
+	volatile long *sum;
+	volatile long *remaining;
+
+	void operator ()()
+	{
+		long batch[4];
+
+		while (*remaining > 0)
+		{
+			size_t count = queue->try_pop_n(batch, 4);
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				long oldSum;
+				do { oldSum = *sum; }
+				while (!lean::atomic_test_and_set(*sum, oldSum, oldSum + batch[i]));
+				lean::atomic_decrement(*remaining);
+			}
+		}
+	}
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE( concurrent )
+{
+	const long thread_count = 4;
+	const long element_count = 10000;
+
+	lean::mpmc_queue<long> queue(64);
+	volatile long sum = 0;
+	volatile long remaining = thread_count * element_count;
+
+	std::vector<lean::thread> threads(2 * thread_count);
+
+	for (long i = 0; i < thread_count; ++i)
+	{
+		producer prod = { &queue, i, element_count, thread_count };
+		threads[2 * i] = lean::thread(prod);
+		consumer cons = { &queue, &sum, &remaining };
+		threads[2 * i + 1] = lean::thread(cons);
+	}
+
+	for (size_t i = 0; i < threads.size(); ++i)
+		threads[i].join();
+
+	const long total = thread_count * element_count;
+	BOOST_CHECK_EQUAL(sum, total * (total - 1) / 2);
+	BOOST_CHECK(queue.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,156 @@
+#include "stdafx.h"
+#include <lean/io/async_io.h>
+#include <vector>
+
+namespace
+{
+
+static const size_t block_size = 4096;
+static const int block_count = 256;
+
+/// Fills the given block with a pattern identifying it.
+void fill_block(char *block, int index)
+{
+	for (size_t i = 0; i < block_size; ++i)
+		block[i] = static_cast<char>(index * 31 + i);
+}
+
+/// Checks the given block for the pattern identifying it.
+bool check_block(const char *block, int index)
+{
+	for (size_t i = 0; i < block_size; ++i)
+		if (block[i] != static_cast<char>(index * 31 + i))
+			return false;
+
+	return true;
+}
+
+/// Counts completed requests & verifies the blocks read.
+void count_completion(lean::async_request &request)
+{
+	int *completed = static_cast<int*>(request.context);
+	++completed[0];
+
+	if (request.result != static_cast<ptrdiff_t>(block_size)
+		|| request.operation == lean::async_request::read && !check_block(request.buffer, static_cast<int>(request.offset / block_size)))
+		++completed[1];
+}
+
+/// Writes & reads back a file using the given engine.
+void test_engine(lean::async_io &io, const char *name, bool registered)
+{
+	std::vector<char> buffers(block_count * block_size);
+	std::vector<lean::async_request> requests(block_count);
+	int completed[2] = { 0, 0 };
+
+	if (registered)
+	{
+		lean::async_buffer buffer = { &buffers[0], buffers.size() };
+		registered = io.register_buffers(&buffer, 1);
+
+		// May exceed the limit of locked memory
+		if (!registered)
+			BOOST_TEST_MESSAGE("async_io: buffers could not be registered");
+	}
+
+	{
+		lean::raw_file file(name, lean::file::readwrite, lean::file::overwrite);
+
+		for (int i = 0; i < block_count; ++i)
+		{
+			char *block = &buffers[i * block_size];
+			fill_block(block, i);
+
+			requests[i] = lean::async_request(file, lean::async_request::write, i * block_size, block, block_size, &count_completion, completed);
+			if (registered)
+				requests[i].bufferIndex = 0;
+			io.prepare(requests[i]);
+
+			// Never exceeds queue depth
+			BOOST_CHECK_LE(io.in_flight(), io.queue_depth());
+		}
+
+		io.wait_all();
+		BOOST_CHECK_EQUAL(io.in_flight(), 0U);
+		BOOST_CHECK_EQUAL(completed[0], block_count);
+		BOOST_CHECK_EQUAL(completed[1], 0);
+		BOOST_CHECK_EQUAL(file.size(), block_count * block_size);
+	}
+
+	std::fill(buffers.begin(), buffers.end(), 0);
+	completed[0] = 0;
+
+	{
+		lean::raw_file file(name, lean::file::read);
+
+		// Read back to front
+		for (int i = block_count; i-- > 0; )
+		{
+			requests[i] = lean::async_request(file, lean::async_request::read, i * block_size, &buffers[i * block_size], block_size, &count_completion, completed);
+			if (registered)
+				requests[i].bufferIndex = 0;
+			io.prepare(requests[i]);
+		}
+
+		io.wait(requests[0]);
+		BOOST_CHECK(requests[0].done());
+
+		io.wait_all();
+		BOOST_CHECK_EQUAL(completed[0], block_count);
+		BOOST_CHECK_EQUAL(completed[1], 0);
+
+		// Reading past the end of the file
+		char tail[2 * block_size];
+		lean::async_request request(file, lean::async_request::read, (block_count - 1) * block_size, tail, sizeof(tail));
+		io.submit(request);
+		io.wait(request);
+		BOOST_CHECK_EQUAL(request.result, static_cast<ptrdiff_t>(block_size));
+		BOOST_CHECK(check_block(tail, block_count - 1));
+	}
+
+	if (registered)
+		io.unregister_buffers();
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE( async_io )
+
+BOOST_AUTO_TEST_CASE( default_engine )
+{
+	// io_uring where available
+	lean::async_io io(32);
+	test_engine(io, MAKE_TEST_FILENAME("async1.dat"), false);
+	test_engine(io, MAKE_TEST_FILENAME("async1.dat"), true);
+}
+
+BOOST_AUTO_TEST_CASE( thread_pool )
+{
+	lean::async_io io(32, 3, true);
+	BOOST_CHECK_EQUAL(io.engine(), lean::async_io::thread_pool);
+	test_engine(io, MAKE_TEST_FILENAME("async2.dat"), false);
+	test_engine(io, MAKE_TEST_FILENAME("async2.dat"), true);
+}
+
+BOOST_AUTO_TEST_CASE( poll )
+{
+	lean::async_io io(4, 1, true);
+
+	char block[block_size];
+	fill_block(block, 0);
+
+	lean::raw_file file(MAKE_TEST_FILENAME("async3.dat"), lean::file::readwrite, lean::file::overwrite);
+	lean::async_request request(file, lean::async_request::write, 0, block, block_size);
+
+	// Prepared requests are only submitted when flushed
+	io.prepare(request);
+	BOOST_CHECK_EQUAL(io.in_flight(), 1U);
+	BOOST_CHECK_EQUAL(io.flush(), 1U);
+
+	while (!io.poll());
+	BOOST_CHECK(request.done());
+	BOOST_CHECK_EQUAL(request.result, static_cast<ptrdiff_t>(block_size));
+	BOOST_CHECK_EQUAL(io.in_flight(), 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
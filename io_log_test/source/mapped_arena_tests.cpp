@@ -0,0 +1,112 @@
+#include "stdafx.h"
+#include <lean/io/mapped_arena.h>
+#include <lean/containers/simple_vector.h>
+#include <lean/containers/simple_hash_map.h>
+
+namespace
+{
+
+typedef lean::mapped_arena_allocator<int> int_allocator;
+typedef lean::simple_vector<int, lean::simple_vector_policies::pod, int_allocator> int_vector;
+typedef lean::simple_hash_map<int, int_vector, lean::simple_hash_map_policies::nonpod,
+	lean::hash<int>, lean::containers::default_keys<int>, std::equal_to<int>, int_allocator> vector_map;
+
+/// Root object stored in the arena.
+struct dataset
+{
+	int_vector values;
+	vector_map groups;
+
+	explicit dataset(const int_allocator &allocator)
+		: values(allocator),
+		groups(allocator) { }
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE( mapped_arena )
+
+BOOST_AUTO_TEST_CASE( offset_ptr )
+{
+	int values[4] = { 0, 1, 2, 3 };
+
+	lean::offset_ptr<int> ptr(values);
+	BOOST_CHECK_EQUAL(ptr.get(), &values[0]);
+	BOOST_CHECK_EQUAL(*++ptr, 1);
+	BOOST_CHECK_EQUAL(ptr[2], 3);
+
+	// Copies point to the same object
+	lean::offset_ptr<int> copy(ptr);
+	BOOST_CHECK(copy == ptr);
+	copy += 2;
+	BOOST_CHECK_EQUAL(copy - ptr, 2);
+
+	lean::offset_ptr<int> null;
+	BOOST_CHECK(!null);
+	null = values;
+	BOOST_CHECK_EQUAL(null.get(), &values[0]);
+}
+
+BOOST_AUTO_TEST_CASE( growth )
+{
+	lean::mapped_arena arena(MAKE_TEST_FILENAME("arena1.dat"), 4096, lean::file::overwrite);
+	BOOST_CHECK_EQUAL(arena.capacity(), 4096U);
+
+	void *small = arena.allocate(100);
+	BOOST_CHECK(reinterpret_cast<uintptr_t>(small) % lean::mapped_arena::default_alignment == 0);
+
+	void *large = arena.allocate<64>(100000);
+	BOOST_CHECK(reinterpret_cast<uintptr_t>(large) % 64 == 0);
+	BOOST_CHECK(arena.capacity() >= arena.size());
+
+	// Last block reclaimed
+	lean::uint8 size = arena.size();
+	arena.free(arena.allocate(1000), 1000);
+	BOOST_CHECK_EQUAL(arena.size(), size);
+
+	arena.trim();
+	BOOST_CHECK_EQUAL(arena.capacity(), arena.size());
+}
+
+BOOST_AUTO_TEST_CASE( reopen_containers )
+{
+	static const int count = 10000;
+
+	{
+		lean::mapped_arena arena(MAKE_TEST_FILENAME("arena2.dat"), 16 * 1024 * 1024, lean::file::overwrite);
+		int_allocator allocator(arena);
+
+		dataset *data = new( arena.allocate(sizeof(dataset), alignof(dataset)) ) dataset(allocator);
+		arena.root(data);
+
+		for (int i = 0; i < 10; ++i)
+			data->groups.insert( vector_map::value_type(i, int_vector(allocator)) );
+
+		for (int i = 0; i < count; ++i)
+		{
+			data->values.push_back(i);
+			data->groups.find(i % 10)->second.push_back(i);
+		}
+
+		// Allocators never grow the file
+		BOOST_CHECK_THROW(data->values.reserve(count * count), std::bad_alloc);
+	}
+	{
+		lean::mapped_arena arena(MAKE_TEST_FILENAME("arena2.dat"));
+		dataset *data = static_cast<dataset*>(arena.root());
+		BOOST_REQUIRE(data);
+
+		BOOST_CHECK_EQUAL(data->values.size(), (size_t) count);
+		BOOST_CHECK_EQUAL(data->values[count - 1], count - 1);
+		BOOST_CHECK_EQUAL(data->groups.size(), 10U);
+		BOOST_REQUIRE(data->groups.find(3) != data->groups.end());
+		BOOST_CHECK_EQUAL(data->groups.find(3)->second.size(), (size_t) count / 10);
+		BOOST_CHECK_EQUAL(data->groups.find(3)->second[5], 53);
+
+		// Containers remain usable after reopening
+		data->values.push_back(count);
+		BOOST_CHECK_EQUAL(data->values.back(), count);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
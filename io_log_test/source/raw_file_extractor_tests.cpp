@@ -0,0 +1,140 @@
+#include "stdafx.h"
+#include <lean/io/raw_file_extractor.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+static const int line_count = 5000;
+
+/// Gets the contents of the given line.
+std::string make_line(int index)
+{
+	// Lines of varying length, some exceeding the buffer size
+	return std::string(index % 97 + (index % 500 == 0) * 300, static_cast<char>('a' + index % 26));
+}
+
+/// Writes the test file.
+void write_lines(const char *name)
+{
+	lean::raw_file file(name, lean::file::write, lean::file::overwrite);
+
+	for (int i = 0; i < line_count; ++i)
+	{
+		std::string line = make_line(i) + '\n';
+		file.write(line.data(), line.size());
+	}
+}
+
+/// Reads & checks all lines of the test file.
+template <size_t BufferSize>
+int read_lines(const char *name, bool readAhead)
+{
+	lean::raw_file file(name, lean::file::read, lean::file::open, lean::file::sequential);
+	lean::raw_file_extractor<BufferSize> extractor(file, readAhead);
+
+	int lineCount = 0, violations = 0;
+	std::string line;
+	size_t scanned = 0;
+
+	for (;;)
+	{
+		typename lean::raw_file_extractor<BufferSize>::span buffered = extractor.peek(lean::min(scanned + 1, BufferSize));
+
+		if (buffered.empty())
+			break;
+
+		const char *newline = std::find(buffered.begin() + scanned, buffered.end(), '\n');
+
+		if (newline != buffered.end())
+		{
+			line.append(buffered.begin(), newline);
+
+			if (line != make_line(lineCount++))
+				++violations;
+
+			line.clear();
+			extractor.consume(newline + 1 - buffered.begin());
+			scanned = 0;
+		}
+		// Line exceeding buffer, take what we have
+		else if (buffered.size() >= BufferSize || extractor.eof())
+		{
+			line.append(buffered.begin(), buffered.end());
+			extractor.consume(buffered.size());
+			scanned = 0;
+		}
+		else
+			scanned = buffered.size();
+	}
+
+	return (lineCount == line_count) ? violations : -1;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE( raw_file_extractor )
+
+BOOST_AUTO_TEST_CASE( lines )
+{
+	const char *name = MAKE_TEST_FILENAME("extract1.txt");
+	write_lines(name);
+
+	BOOST_CHECK_EQUAL(read_lines<64>(name, false), 0);
+	BOOST_CHECK_EQUAL(read_lines<64>(name, true), 0);
+	BOOST_CHECK_EQUAL(read_lines<4096>(name, false), 0);
+	BOOST_CHECK_EQUAL(read_lines<4096>(name, true), 0);
+}
+
+BOOST_AUTO_TEST_CASE( iterator )
+{
+	const char *name = MAKE_TEST_FILENAME("extract2.txt");
+	write_lines(name);
+
+	std::string expected;
+	for (int i = 0; i < line_count; ++i)
+		expected += make_line(i) + '\n';
+
+	for (int readAhead = 0; readAhead < 2; ++readAhead)
+	{
+		lean::raw_file file(name, lean::file::read);
+		lean::raw_file_extractor<128> extractor(file, readAhead != 0);
+		BOOST_CHECK_EQUAL(extractor.reading_ahead(), readAhead != 0);
+
+		std::string contents(extractor.iter(), extractor.iter_end());
+		BOOST_CHECK(contents == expected);
+		BOOST_CHECK(extractor.eof());
+	}
+}
+
+BOOST_AUTO_TEST_CASE( extract )
+{
+	const char *name = MAKE_TEST_FILENAME("extract3.dat");
+
+	std::vector<char> data(100000);
+	for (size_t i = 0; i < data.size(); ++i)
+		data[i] = static_cast<char>(i * 7);
+
+	{
+		lean::raw_file file(name, lean::file::write, lean::file::overwrite);
+		file.write(&data[0], data.size());
+	}
+
+	lean::raw_file file(name, lean::file::read);
+	lean::raw_file_extractor<1000> extractor(file, true);
+
+	char value;
+	BOOST_CHECK(extractor.extract(value));
+	BOOST_CHECK_EQUAL(value, data[0]);
+
+	std::vector<char> extracted(data.size());
+	BOOST_CHECK_EQUAL(extractor.extract(&extracted[1], data.size()), data.size() - 1);
+	BOOST_CHECK(std::equal(data.begin() + 1, data.end(), extracted.begin() + 1));
+
+	BOOST_CHECK(!extractor.extract(value));
+	BOOST_CHECK(extractor.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
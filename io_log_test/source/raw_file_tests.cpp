@@ -1,6 +1,70 @@
 #include "stdafx.h"
 #include <lean/io/raw_file.h>
+#include <lean/io/raw_file_inserter.h>
 #include <lean/time/timer.h>
+#include <lean/concurrent/thread.h>
+#include <lean/concurrent/atomic.h>
+#include <vector>
+#include <algorithm>
+
+namespace
+{
+
+static const size_t block_size = 512;
+static const int block_count = 64;
+
+/// Fills the given block with a pattern identifying it.
+void fill_block(char *block, int index)
+{
+	for (size_t i = 0; i < block_size; ++i)
+		block[i] = static_cast<char>(index + i);
+}
+
+/// Reads all blocks of the given file in a scattered order, checking their contents.
+struct block_reader
+{
+	const lean::raw_file *file;
+	int seed;
+	volatile long *violations;
+
+	void operator ()()
+	{
+		char expected[block_size], block[block_size];
+
+		for (int pass = 0; pass < 16; ++pass)
+			for (int i = 0; i < block_count; ++i)
+			{
+				int index = (i * 37 + seed + pass) % block_count;
+				fill_block(expected, index);
+
+				if (file->read_at(index * block_size, block, block_size) != block_size
+					|| memcmp(block, expected, block_size) != 0)
+					lean::atomic_increment(*violations);
+			}
+	}
+};
+
+/// Inserts characters & ranges of bytes of varying sizes.
+template <class Inserter>
+void insert_blocks(Inserter &inserter, std::vector<char> &expected)
+{
+	char block[block_size];
+
+	for (int i = 0; i < block_count; ++i)
+	{
+		fill_block(block, i);
+		size_t size = (i * 37) % block_size;
+
+		if (i % 3 == 0)
+			std::copy(block, block + size, inserter.iter());
+		else
+			inserter.insert(block, size);
+
+		expected.insert(expected.end(), block, block + size);
+	}
+}
+
+} // namespace
 
 BOOST_AUTO_TEST_SUITE( raw_file )
 
@@ -66,4 +130,129 @@ BOOST_AUTO_TEST_CASE( revision )
 	BOOST_CHECK_GT(file2.revision(), file1.revision());
 }
 
+BOOST_AUTO_TEST_CASE( positional )
+{
+	static const int threadCount = 8;
+
+	lean::raw_file file(MAKE_TEST_FILENAME("test5.dat"), lean::file::readwrite, lean::file::overwrite);
+
+	// Written back to front, independent of the file cursor
+	for (int i = block_count; i-- > 0; )
+	{
+		char block[block_size];
+		fill_block(block, i);
+		BOOST_CHECK_EQUAL(file.write_at(i * block_size, block, block_size), block_size);
+	}
+
+	BOOST_CHECK_EQUAL(file.size(), block_count * block_size);
+
+	// Reading past the end of the file
+	char tail[2 * block_size];
+	BOOST_CHECK_EQUAL(file.read_at((block_count - 1) * block_size, tail, sizeof(tail)), block_size);
+
+	volatile long violations = 0;
+	lean::thread threads[threadCount];
+
+	for (int i = 0; i < threadCount; ++i)
+	{
+		block_reader task = { &file, i, &violations };
+		threads[i] = lean::thread(task);
+	}
+
+	for (int i = 0; i < threadCount; ++i)
+		threads[i].join();
+
+	BOOST_CHECK_EQUAL(violations, 0);
+}
+
+BOOST_AUTO_TEST_CASE( vectored )
+{
+	char header[] = "header", trailer[] = "trailer";
+	char blocks[4][block_size];
+
+	for (int i = 0; i < 4; ++i)
+		fill_block(blocks[i], i);
+
+	{
+		lean::raw_file file(MAKE_TEST_FILENAME("test6.dat"), lean::file::readwrite, lean::file::overwrite);
+
+		// Empty ranges are skipped
+		lean::raw_file::const_span spans[] = {
+				lean::raw_file::const_span(header, header + sizeof(header)),
+				lean::raw_file::const_span(blocks[0], blocks[0] + 4 * block_size),
+				lean::raw_file::const_span(trailer, trailer),
+				lean::raw_file::const_span(trailer, trailer + sizeof(trailer))
+			};
+		BOOST_CHECK_EQUAL(file.write(lean::raw_file::const_span_list(spans, spans + 4)), sizeof(header) + 4 * block_size + sizeof(trailer));
+		BOOST_CHECK_EQUAL(file.write_at(sizeof(header), lean::raw_file::const_span_list(spans + 1, spans + 2)), 4 * block_size);
+		BOOST_CHECK_EQUAL(file.size(), sizeof(header) + 4 * block_size + sizeof(trailer));
+	}
+
+	{
+		lean::raw_file file(MAKE_TEST_FILENAME("test6.dat"), lean::file::read);
+
+		char readHeader[sizeof(header)], readTrailer[sizeof(trailer) + 16];
+		std::vector<char> readBlocks(4 * block_size);
+
+		// Reading past the end of the file
+		lean::raw_file::span spans[] = {
+				lean::raw_file::span(readHeader, readHeader + sizeof(readHeader)),
+				lean::raw_file::span(&readBlocks[0], &readBlocks[0] + readBlocks.size()),
+				lean::raw_file::span(readTrailer, readTrailer + sizeof(readTrailer))
+			};
+		BOOST_CHECK_EQUAL(file.read(lean::raw_file::span_list(spans, spans + 3)), sizeof(header) + 4 * block_size + sizeof(trailer));
+		BOOST_CHECK_EQUAL(readHeader, header);
+		BOOST_CHECK(memcmp(&readBlocks[0], blocks[0], 4 * block_size) == 0);
+		BOOST_CHECK_EQUAL(readTrailer, trailer);
+
+		memset(&readBlocks[0], 0, readBlocks.size());
+		BOOST_CHECK_EQUAL(file.read_at(sizeof(header) + block_size, lean::raw_file::span_list(spans + 1, spans + 2)), 3 * block_size + sizeof(trailer));
+		BOOST_CHECK(memcmp(&readBlocks[0], blocks[1], 3 * block_size) == 0);
+	}
+
+	{
+		lean::raw_file file(MAKE_TEST_FILENAME("test7.dat"), lean::file::readwrite, lean::file::overwrite);
+
+		{
+			lean::raw_file_inserter<block_size> inserter(file);
+			*inserter.iter()++ = 'x';
+
+			// Small ranges buffered, large ranges written along with buffered output
+			lean::raw_file::const_span spans[] = {
+					lean::raw_file::const_span(header, header + sizeof(header)),
+					lean::raw_file::const_span(blocks[0], blocks[0] + 4 * block_size)
+				};
+			inserter.insert(lean::raw_file::const_span_list(spans, spans + 1));
+			BOOST_CHECK_EQUAL(file.size(), 0);
+			inserter.insert(lean::raw_file::const_span_list(spans, spans + 2));
+			BOOST_CHECK_EQUAL(file.size(), 1 + 2 * sizeof(header) + 4 * block_size);
+		}
+
+		char data[1 + 2 * sizeof(header) + block_size];
+		BOOST_CHECK_EQUAL(file.read_at(0, data, sizeof(data)), sizeof(data));
+		BOOST_CHECK_EQUAL(data[0], 'x');
+		BOOST_CHECK_EQUAL(data + 1 + sizeof(header), header);
+		BOOST_CHECK(memcmp(data + 1 + 2 * sizeof(header), blocks[0], block_size) == 0);
+	}
+}
+
+BOOST_AUTO_TEST_CASE( inserter )
+{
+	for (int bufferCount = 1; bufferCount <= 3; ++bufferCount)
+	{
+		lean::raw_file file(MAKE_TEST_FILENAME("test8.dat"), lean::file::readwrite, lean::file::overwrite);
+		std::vector<char> expected;
+
+		{
+			lean::raw_file_inserter<64> inserter(file, bufferCount);
+			BOOST_CHECK_EQUAL(inserter.background(), bufferCount > 1);
+			insert_blocks(inserter, expected);
+		}
+
+		std::vector<char> data(expected.size() + 1);
+		BOOST_CHECK_EQUAL(file.read_at(0, &data[0], data.size()), expected.size());
+		BOOST_CHECK(std::equal(expected.begin(), expected.end(), data.begin()));
+	}
+}
+
 BOOST_AUTO_TEST_SUITE_END()
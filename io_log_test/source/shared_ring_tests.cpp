@@ -0,0 +1,190 @@
+#include "stdafx.h"
+#include <lean/io/shared_ring.h>
+#include <lean/concurrent/thread.h>
+#include <cstring>
+
+namespace
+{
+
+/// Writes a record containing the given value repeated to fill the given size.
+bool write_record(lean::shared_ring &ring, int value, size_t size)
+{
+	char *data = static_cast<char*>( ring.reserve(size, value % 7) );
+
+	if (data)
+	{
+		memset(data, value & 0xff, size);
+		ring.commit(data);
+	}
+
+	return (data != nullptr);
+}
+
+/// Producer writing a sequence of records tagged with its index.
+struct producer
+{
+	const char *name;
+	int index;
+	int count;
+
+	void operator ()()
+	{
+		lean::shared_ring ring(name);
+
+		for (int i = 0; i < count; )
+		{
+			int record[2] = { index, i };
+
+			if (ring.write(record, sizeof(record)))
+				++i;
+			else
+				ring.wait_writable(sizeof(record), 1000);
+		}
+	}
+};
+
+/// Checks the order of records received per producer.
+struct order_check
+{
+	int *next;
+	int *violations;
+
+	void operator ()(const void *data, size_t size, lean::int4) const
+	{
+		const int *record = static_cast<const int*>(data);
+
+		if (size != 2 * sizeof(int) || record[1] != next[record[0]]++)
+			++*violations;
+	}
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE( shared_ring )
+
+BOOST_AUTO_TEST_CASE( records )
+{
+	lean::shared_ring ring(MAKE_TEST_FILENAME("ring1.dat"), 4096, lean::file::overwrite);
+	BOOST_CHECK_EQUAL(ring.capacity(), 4096U);
+	BOOST_CHECK(ring.empty());
+
+	size_t size;
+	lean::int4 type;
+	BOOST_CHECK(!ring.peek(size));
+
+	BOOST_CHECK(write_record(ring, 1, 10));
+	void *reserved = ring.reserve(20, 2);
+	BOOST_REQUIRE(reserved);
+	BOOST_CHECK(write_record(ring, 3, 30));
+
+	// Reserved records block the consumer until committed or aborted
+	const char *data = static_cast<const char*>( ring.peek(size, type) );
+	BOOST_REQUIRE(data);
+	BOOST_CHECK_EQUAL(size, 10U);
+	BOOST_CHECK_EQUAL(type, 1);
+	BOOST_CHECK_EQUAL(data[9], 1);
+	ring.release();
+	BOOST_CHECK(!ring.peek(size));
+
+	ring.abort(reserved);
+
+	data = static_cast<const char*>( ring.peek(size, type) );
+	BOOST_REQUIRE(data);
+	BOOST_CHECK_EQUAL(size, 30U);
+	BOOST_CHECK_EQUAL(type, 3);
+	ring.release();
+
+	BOOST_CHECK(ring.empty());
+	BOOST_CHECK(!ring.wait_readable(0));
+}
+
+BOOST_AUTO_TEST_CASE( wrap_around )
+{
+	lean::shared_ring ring(MAKE_TEST_FILENAME("ring2.dat"), 4096, lean::file::overwrite);
+
+	int written = 0, read = 0, violations = 0;
+
+	// Odd record sizes force padding at the end of the buffer
+	for (int pass = 0; pass < 200; ++pass)
+	{
+		while (write_record(ring, written, 13 + written % 300))
+			++written;
+
+		// Full ring rejects further records
+		BOOST_CHECK(!ring.reserve(ring.max_record_size()));
+
+		size_t size;
+		lean::int4 type;
+
+		while (const char *data = static_cast<const char*>( ring.peek(size, type) ))
+		{
+			if (size != 13U + read % 300 || type != read % 7 || data[size - 1] != static_cast<char>(read & 0xff))
+				++violations;
+
+			ring.release();
+			++read;
+		}
+	}
+
+	BOOST_CHECK_EQUAL(read, written);
+	BOOST_CHECK_EQUAL(violations, 0);
+	BOOST_CHECK(ring.empty());
+}
+
+BOOST_AUTO_TEST_CASE( reopen )
+{
+	{
+		lean::shared_ring ring(MAKE_TEST_FILENAME("ring3.dat"), 4096, lean::file::overwrite);
+		BOOST_CHECK(write_record(ring, 5, 100));
+	}
+	{
+		lean::shared_ring ring(MAKE_TEST_FILENAME("ring3.dat"));
+		BOOST_CHECK_EQUAL(ring.capacity(), 4096U);
+
+		size_t size;
+		BOOST_REQUIRE(ring.peek(size));
+		BOOST_CHECK_EQUAL(size, 100U);
+		ring.release();
+	}
+}
+
+BOOST_AUTO_TEST_CASE( producers )
+{
+	static const int producerCount = 3;
+	static const int recordCount = 20000;
+
+	const char *name = MAKE_TEST_FILENAME("ring4.dat");
+	lean::shared_ring ring(name, 4096, lean::file::overwrite);
+
+	// Producers map the ring separately, just like other processes
+	lean::thread threads[producerCount];
+
+	for (int i = 0; i < producerCount; ++i)
+	{
+		producer task = { name, i, recordCount };
+		threads[i] = lean::thread(task);
+	}
+
+	int next[producerCount] = { 0 };
+	int violations = 0;
+	order_check check = { next, &violations };
+
+	for (int total = 0; total < producerCount * recordCount; )
+	{
+		size_t count = ring.read(check);
+
+		if (count)
+			total += static_cast<int>(count);
+		else
+			ring.wait_readable(1000);
+	}
+
+	for (int i = 0; i < producerCount; ++i)
+		threads[i].join();
+
+	BOOST_CHECK_EQUAL(violations, 0);
+	BOOST_CHECK_EQUAL(next[producerCount - 1], recordCount);
+	BOOST_CHECK(ring.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
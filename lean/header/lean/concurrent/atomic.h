@@ -9,6 +9,39 @@
 #include "../lean.h"
 #include "../meta/strip.h"
 
+#if defined(_WIN64) || defined(__LP64__) || defined(_LP64)
+	/// Size of two pointer-sized words.
+	#define LEAN_DOUBLE_WORD_SIZE 16
+#else
+	/// Size of two pointer-sized words.
+	#define LEAN_DOUBLE_WORD_SIZE 8
+#endif
+
+namespace lean
+{
+namespace concurrent
+{
+
+/// Memory ordering constraints imposed on surrounding memory accesses by atomic operations.
+enum memory_order
+{
+	memory_order_relaxed,	///< No ordering constraints, only atomicity is guaranteed.
+	memory_order_acquire,	///< Subsequent memory accesses may not be moved before a load.
+	memory_order_release,	///< Preceding memory accesses may not be moved after a store.
+	memory_order_acq_rel,	///< Combines acquire and release semantics.
+	memory_order_seq_cst	///< Full barrier, all threads observe one total order of all such operations.
+};
+
+/// Two pointer-sized words that may be compared and exchanged atomically where LEAN_ATOMIC_DOUBLE_WORD is defined.
+struct LEAN_ALIGN(LEAN_DOUBLE_WORD_SIZE) double_word
+{
+	uintptr_t low;	///< Low word.
+	uintptr_t high;	///< High word.
+};
+
+} // namespace
+} // namespace
+
 #ifdef _MSC_VER
 
 #include <intrin.h>
@@ -45,6 +78,24 @@ namespace concurrent
 			return _InterlockedExchange(&value, newValue);
 		}
 
+		/// Atomically adds the given value, returning the previous value.
+		__forceinline long atomic_fetch_add(volatile long &value, long delta, memory_order)
+		{
+			return _InterlockedExchangeAdd(&value, delta);
+		}
+
+		/// Atomically ORs the given value, returning the previous value.
+		__forceinline long atomic_fetch_or(volatile long &value, long mask, memory_order)
+		{
+			return _InterlockedOr(&value, mask);
+		}
+
+		/// Atomically ANDs the given value, returning the previous value.
+		__forceinline long atomic_fetch_and(volatile long &value, long mask, memory_order)
+		{
+			return _InterlockedAnd(&value, mask);
+		}
+
 		//// Short ////
 
 		/// Atomically increments the given value, returning the results.
@@ -71,6 +122,132 @@ namespace concurrent
 			return _InterlockedExchange16(&value, newValue);
 		}
 
+		/// Atomically adds the given value, returning the previous value.
+		__forceinline short atomic_fetch_add(volatile short &value, short delta, memory_order)
+		{
+			return _InterlockedExchangeAdd16(&value, delta);
+		}
+
+		/// Atomically ORs the given value, returning the previous value.
+		__forceinline short atomic_fetch_or(volatile short &value, short mask, memory_order)
+		{
+			return _InterlockedOr16(&value, mask);
+		}
+
+		/// Atomically ANDs the given value, returning the previous value.
+		__forceinline short atomic_fetch_and(volatile short &value, short mask, memory_order)
+		{
+			return _InterlockedAnd16(&value, mask);
+		}
+
+		//// Long long ////
+
+		/// Atomically tests if the given value is equal to the given expected value, assigning the given new value on success.
+		__forceinline bool atomic_test_and_set(volatile long long &value, long long expectedValue, long long newValue)
+		{
+			return (_InterlockedCompareExchange64(&value, newValue, expectedValue) == expectedValue);
+		}
+
+#ifdef _M_IX86
+		// No native 64-bit read-modify-write intrinsics on x86, emulate using compare-exchange
+
+		/// Atomically increments the given value, returning the results.
+		__forceinline long long atomic_increment(volatile long long &value)
+		{
+			long long oldValue;
+			do { oldValue = value; } while (!atomic_test_and_set(value, oldValue, oldValue + 1));
+			return oldValue + 1;
+		}
+
+		/// Atomically decrements the given value, returning the results.
+		__forceinline long long atomic_decrement(volatile long long &value)
+		{
+			long long oldValue;
+			do { oldValue = value; } while (!atomic_test_and_set(value, oldValue, oldValue - 1));
+			return oldValue - 1;
+		}
+
+		/// Atomically sets the given value.
+		__forceinline long long atomic_set(volatile long long &value, long long newValue)
+		{
+			long long oldValue;
+			do { oldValue = value; } while (!atomic_test_and_set(value, oldValue, newValue));
+			return oldValue;
+		}
+
+		/// Atomically adds the given value, returning the previous value.
+		__forceinline long long atomic_fetch_add(volatile long long &value, long long delta, memory_order)
+		{
+			long long oldValue;
+			do { oldValue = value; } while (!atomic_test_and_set(value, oldValue, oldValue + delta));
+			return oldValue;
+		}
+
+		/// Atomically ORs the given value, returning the previous value.
+		__forceinline long long atomic_fetch_or(volatile long long &value, long long mask, memory_order)
+		{
+			long long oldValue;
+			do { oldValue = value; } while (!atomic_test_and_set(value, oldValue, oldValue | mask));
+			return oldValue;
+		}
+
+		/// Atomically ANDs the given value, returning the previous value.
+		__forceinline long long atomic_fetch_and(volatile long long &value, long long mask, memory_order)
+		{
+			long long oldValue;
+			do { oldValue = value; } while (!atomic_test_and_set(value, oldValue, oldValue & mask));
+			return oldValue;
+		}
+
+		/// Atomically loads the given value.
+		__forceinline long long atomic_load(const volatile long long &value, memory_order)
+		{
+			return _InterlockedCompareExchange64(const_cast<volatile long long*>(&value), 0, 0);
+		}
+
+		/// Atomically stores the given value.
+		__forceinline void atomic_store(volatile long long &value, long long newValue, memory_order)
+		{
+			atomic_set(value, newValue);
+		}
+#else
+		/// Atomically increments the given value, returning the results.
+		__forceinline long long atomic_increment(volatile long long &value)
+		{
+			return _InterlockedIncrement64(&value);
+		}
+
+		/// Atomically decrements the given value, returning the results.
+		__forceinline long long atomic_decrement(volatile long long &value)
+		{
+			return _InterlockedDecrement64(&value);
+		}
+
+		/// Atomically sets the given value.
+		__forceinline long long atomic_set(volatile long long &value, long long newValue)
+		{
+			return _InterlockedExchange64(&value, newValue);
+		}
+
+		/// Atomically adds the given value, returning the previous value.
+		__forceinline long long atomic_fetch_add(volatile long long &value, long long delta, memory_order)
+		{
+			return _InterlockedExchangeAdd64(&value, delta);
+		}
+
+		/// Atomically ORs the given value, returning the previous value.
+		__forceinline long long atomic_fetch_or(volatile long long &value, long long mask, memory_order)
+		{
+			return _InterlockedOr64(&value, mask);
+		}
+
+		/// Atomically ANDs the given value, returning the previous value.
+		__forceinline long long atomic_fetch_and(volatile long long &value, long long mask, memory_order)
+		{
+			return _InterlockedAnd64(&value, mask);
+		}
+#endif
+
 		//// Integers ////
 
 		template <size_t Size>
@@ -84,6 +261,7 @@ namespace concurrent
 
 		template <> struct atomic_type<sizeof(short)> { typedef short type; };
 		template <> struct atomic_type<sizeof(long)> { typedef long type; };
+		template <> struct atomic_type<sizeof(long long)> { typedef long long type; };
 
 		//// Pointers ////
 
@@ -112,6 +290,221 @@ namespace concurrent
 #endif
 		}
 
+		//// Loads & stores ////
+
+		// x86 / x64: Aligned loads have acquire, aligned stores release semantics,
+		// only the compiler needs to be kept from reordering
+
+		/// Atomically loads the given value.
+		template <class Value>
+		__forceinline Value atomic_load(const volatile Value &value, memory_order)
+		{
+			Value result = value;
+			_ReadWriteBarrier();
+			return result;
+		}
+
+		/// Atomically stores the given value.
+		template <class Value>
+		__forceinline void atomic_store(volatile Value &value, Value newValue, memory_order order)
+		{
+			if (order == memory_order_seq_cst)
+				atomic_set(value, newValue);
+			else
+			{
+				_ReadWriteBarrier();
+				value = newValue;
+			}
+		}
+
+		//// Double words ////
+
+		/// Atomically tests if the given double word is equal to the given expected double word, assigning the given new double word on success.
+		__forceinline bool atomic_test_and_set(volatile double_word &value, const double_word &expectedValue, const double_word &newValue)
+		{
+#ifdef _M_IX86
+			long long expectedInt = *reinterpret_cast<const long long*>(&expectedValue);
+
+			return (_InterlockedCompareExchange64(
+					reinterpret_cast<volatile long long*>(&value),
+					*reinterpret_cast<const long long*>(&newValue),
+					expectedInt
+				) == expectedInt);
+#else
+			long long expectedInts[2] = {
+					static_cast<long long>(expectedValue.low),
+					static_cast<long long>(expectedValue.high)
+				};
+
+			return (_InterlockedCompareExchange128(
+					reinterpret_cast<volatile long long*>(&value),
+					static_cast<long long>(newValue.high),
+					static_cast<long long>(newValue.low),
+					expectedInts
+				) != 0);
+#endif
+		}
+
+	} // namespace
+
+} // namespace
+} // namespace
+
+/// Atomic compare-exchange of double words supported.
+#define LEAN_ATOMIC_DOUBLE_WORD 1
+
+#elif defined(__GNUC__)
+
+namespace lean
+{
+namespace concurrent
+{
+	namespace impl
+	{
+		/// Converts the given memory order into the corresponding builtin memory model.
+		LEAN_INLINE int builtin_order(memory_order order)
+		{
+			switch (order)
+			{
+			case memory_order_relaxed: return __ATOMIC_RELAXED;
+			case memory_order_acquire: return __ATOMIC_ACQUIRE;
+			case memory_order_release: return __ATOMIC_RELEASE;
+			case memory_order_acq_rel: return __ATOMIC_ACQ_REL;
+			default: return __ATOMIC_SEQ_CST;
+			}
+		}
+
+		/// Converts the given memory order into a builtin memory model valid for loads.
+		LEAN_INLINE int builtin_load_order(memory_order order)
+		{
+			return (order == memory_order_release || order == memory_order_acq_rel)
+				? __ATOMIC_ACQUIRE
+				: builtin_order(order);
+		}
+
+		/// Converts the given memory order into a builtin memory model valid for stores.
+		LEAN_INLINE int builtin_store_order(memory_order order)
+		{
+			return (order == memory_order_acquire || order == memory_order_acq_rel)
+				? __ATOMIC_RELEASE
+				: builtin_order(order);
+		}
+
+		//// Integers ////
+
+		/// Atomically increments the given value, returning the results.
+		template <class Integer>
+		LEAN_INLINE Integer atomic_increment(volatile Integer &value)
+		{
+			return __atomic_add_fetch(&value, 1, __ATOMIC_SEQ_CST);
+		}
+
+		/// Atomically decrements the given value, returning the results.
+		template <class Integer>
+		LEAN_INLINE Integer atomic_decrement(volatile Integer &value)
+		{
+			return __atomic_sub_fetch(&value, 1, __ATOMIC_SEQ_CST);
+		}
+
+		/// Atomically tests if the given value is equal to the given expected value, assigning the given new value on success.
+		template <class Integer>
+		LEAN_INLINE bool atomic_test_and_set(volatile Integer &value, Integer expectedValue, Integer newValue)
+		{
+			return __atomic_compare_exchange_n(&value, &expectedValue, newValue, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+		}
+
+		/// Atomically sets the given value.
+		template <class Integer>
+		LEAN_INLINE Integer atomic_set(volatile Integer &value, Integer newValue)
+		{
+			return __atomic_exchange_n(&value, newValue, __ATOMIC_SEQ_CST);
+		}
+
+		/// Atomically adds the given value, returning the previous value.
+		template <class Integer>
+		LEAN_INLINE Integer atomic_fetch_add(volatile Integer &value, Integer delta, memory_order order)
+		{
+			return __atomic_fetch_add(&value, delta, builtin_order(order));
+		}
+
+		/// Atomically ORs the given value, returning the previous value.
+		template <class Integer>
+		LEAN_INLINE Integer atomic_fetch_or(volatile Integer &value, Integer mask, memory_order order)
+		{
+			return __atomic_fetch_or(&value, mask, builtin_order(order));
+		}
+
+		/// Atomically ANDs the given value, returning the previous value.
+		template <class Integer>
+		LEAN_INLINE Integer atomic_fetch_and(volatile Integer &value, Integer mask, memory_order order)
+		{
+			return __atomic_fetch_and(&value, mask, builtin_order(order));
+		}
+
+		/// Atomically loads the given value.
+		template <class Value>
+		LEAN_INLINE Value atomic_load(const volatile Value &value, memory_order order)
+		{
+			return __atomic_load_n(&value, builtin_load_order(order));
+		}
+
+		/// Atomically stores the given value.
+		template <class Value>
+		LEAN_INLINE void atomic_store(volatile Value &value, Value newValue, memory_order order)
+		{
+			__atomic_store_n(&value, newValue, builtin_store_order(order));
+		}
+
+		template <size_t Size>
+		struct atomic_type
+		{
+			// Always checked, therefore use static_assert with care
+			LEAN_STATIC_ASSERT_MSG_ALT(Size & ~Size, // = false, dependent
+				"Atomic operations on integers of the given type unsupported.",
+				Atomic_operations_on_integers_of_the_given_type_unsupported);
+		};
+
+		template <> struct atomic_type<sizeof(short)> { typedef short type; };
+		template <> struct atomic_type<sizeof(int)> { typedef int type; };
+		template <> struct atomic_type<sizeof(long long)> { typedef long long type; };
+
+		//// Pointers ////
+
+		/// Atomically tests if the given pointer is equal to the given expected pointer, assigning the given new pointer on success.
+		LEAN_INLINE bool atomic_test_and_set(void *volatile &ptr, void *expectedPtr, void *newPtr)
+		{
+			return __atomic_compare_exchange_n(&ptr, &expectedPtr, newPtr, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+		}
+
+		/// Atomically sets the given pointer.
+		LEAN_INLINE void* atomic_set(void *volatile &ptr, void *newPtr)
+		{
+			return __atomic_exchange_n(&ptr, newPtr, __ATOMIC_SEQ_CST);
+		}
+
+		//// Double words ////
+
+#if LEAN_DOUBLE_WORD_SIZE == 16 && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)
+		typedef unsigned __int128 double_word_int;
+	/// Atomic compare-exchange of double words supported.
+	#define LEAN_ATOMIC_DOUBLE_WORD 1
+#elif LEAN_DOUBLE_WORD_SIZE == 8 && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_8)
+		typedef unsigned long long double_word_int;
+	/// Atomic compare-exchange of double words supported.
+	#define LEAN_ATOMIC_DOUBLE_WORD 1
+#endif
+
+#ifdef LEAN_ATOMIC_DOUBLE_WORD
+		/// Atomically tests if the given double word is equal to the given expected double word, assigning the given new double word on success.
+		LEAN_INLINE bool atomic_test_and_set(volatile double_word &value, const double_word &expectedValue, const double_word &newValue)
+		{
+			return __sync_bool_compare_and_swap(
+				reinterpret_cast<volatile double_word_int*>(&value),
+				*reinterpret_cast<const double_word_int*>(&expectedValue),
+				*reinterpret_cast<const double_word_int*>(&newValue) );
+		}
+#endif
+
 	} // namespace
 
 } // namespace
@@ -172,6 +565,60 @@ namespace concurrent
 			static_cast<atomic_int>(newValue) ) );
 	}
 
+	/// Atomically adds the given value, returning the previous value.
+	template <class Integer>
+	LEAN_INLINE Integer atomic_fetch_add(volatile Integer &value, typename identity<Integer>::type delta, memory_order order = memory_order_seq_cst)
+	{
+		typedef typename impl::atomic_type<sizeof(Integer)>::type atomic_int;
+
+		return static_cast<Integer>( impl::atomic_fetch_add(
+			reinterpret_cast<volatile atomic_int&>(value),
+			static_cast<atomic_int>(delta), order ) );
+	}
+
+	/// Atomically ORs the given value, returning the previous value.
+	template <class Integer>
+	LEAN_INLINE Integer atomic_fetch_or(volatile Integer &value, typename identity<Integer>::type mask, memory_order order = memory_order_seq_cst)
+	{
+		typedef typename impl::atomic_type<sizeof(Integer)>::type atomic_int;
+
+		return static_cast<Integer>( impl::atomic_fetch_or(
+			reinterpret_cast<volatile atomic_int&>(value),
+			static_cast<atomic_int>(mask), order ) );
+	}
+
+	/// Atomically ANDs the given value, returning the previous value.
+	template <class Integer>
+	LEAN_INLINE Integer atomic_fetch_and(volatile Integer &value, typename identity<Integer>::type mask, memory_order order = memory_order_seq_cst)
+	{
+		typedef typename impl::atomic_type<sizeof(Integer)>::type atomic_int;
+
+		return static_cast<Integer>( impl::atomic_fetch_and(
+			reinterpret_cast<volatile atomic_int&>(value),
+			static_cast<atomic_int>(mask), order ) );
+	}
+
+	/// Atomically loads the given value. Release semantics are strengthened to acquire semantics.
+	template <class Integer>
+	LEAN_INLINE Integer atomic_load(const volatile Integer &value, memory_order order = memory_order_seq_cst)
+	{
+		typedef typename impl::atomic_type<sizeof(Integer)>::type atomic_int;
+
+		return static_cast<Integer>( impl::atomic_load(
+			reinterpret_cast<const volatile atomic_int&>(value), order ) );
+	}
+
+	/// Atomically stores the given value. Acquire semantics are strengthened to release semantics.
+	template <class Integer>
+	LEAN_INLINE void atomic_store(volatile Integer &value, typename identity<Integer>::type newValue, memory_order order = memory_order_seq_cst)
+	{
+		typedef typename impl::atomic_type<sizeof(Integer)>::type atomic_int;
+
+		impl::atomic_store(
+			reinterpret_cast<volatile atomic_int&>(value),
+			static_cast<atomic_int>(newValue), order );
+	}
+
 	/// Atomically tests if the given value is equal to the given expected value, assigning the given new value on success.
 	template <class Pointer>
 	LEAN_INLINE bool atomic_test_and_set(Pointer *volatile &value, typename identity<Pointer>::type *expectedValue, typename identity<Pointer>::type *newValue)
@@ -191,12 +638,65 @@ namespace concurrent
 			const_cast<void*>(static_cast<const void*>(newValue)) ) );
 	}
 
+	/// Atomically loads the given value. Release semantics are strengthened to acquire semantics.
+	template <class Pointer>
+	LEAN_INLINE Pointer* atomic_load(Pointer *const volatile &value, memory_order order = memory_order_seq_cst)
+	{
+		return static_cast<Pointer*>( impl::atomic_load(
+			reinterpret_cast<void *const volatile &>(value), order ) );
+	}
+
+	/// Atomically stores the given value. Acquire semantics are strengthened to release semantics.
+	template <class Pointer>
+	LEAN_INLINE void atomic_store(Pointer *volatile &value, typename identity<Pointer>::type *newValue, memory_order order = memory_order_seq_cst)
+	{
+		impl::atomic_store(
+			const_cast<void *volatile &>(reinterpret_cast<const void *volatile &>(const_cast<const Pointer *volatile &>(value))),
+			const_cast<void*>(static_cast<const void*>(newValue)), order );
+	}
+
+#ifdef LEAN_ATOMIC_DOUBLE_WORD
+	//// Double words ////
+
+	/// Atomically tests if the given double word is equal to the given expected double word, assigning the given new double word on success.
+	LEAN_INLINE bool atomic_test_and_set(volatile double_word &value, const double_word &expectedValue, const double_word &newValue)
+	{
+		return impl::atomic_test_and_set(value, expectedValue, newValue);
+	}
+#endif
+
+	/// Hints the processor that the calling thread is spin-waiting.
+	LEAN_INLINE void cpu_pause()
+	{
+#if defined(_MSC_VER)
+		_mm_pause();
+#elif defined(__i386__) || defined(__x86_64__)
+		__builtin_ia32_pause();
+#elif defined(__arm__) || defined(__aarch64__)
+		__asm__ __volatile__("yield");
+#endif
+	}
+
 } // namespace
 
 using concurrent::atomic_increment;
 using concurrent::atomic_decrement;
 using concurrent::atomic_test_and_set;
 using concurrent::atomic_set;
+using concurrent::atomic_fetch_add;
+using concurrent::atomic_fetch_or;
+using concurrent::atomic_fetch_and;
+using concurrent::atomic_load;
+using concurrent::atomic_store;
+
+using concurrent::memory_order;
+using concurrent::memory_order_relaxed;
+using concurrent::memory_order_acquire;
+using concurrent::memory_order_release;
+using concurrent::memory_order_acq_rel;
+using concurrent::memory_order_seq_cst;
+using concurrent::double_word;
+using concurrent::cpu_pause;
 
 } // namespace
 
@@ -0,0 +1,106 @@
+/*****************************************************/
+/* lean Concurrent              (c) Tobias Zirr 2011 */
+/*****************************************************/
+
+#pragma once
+#ifndef LEAN_CONCURRENT_BACKOFF
+#define LEAN_CONCURRENT_BACKOFF
+
+#include "../lean.h"
+#include "atomic.h"
+
+namespace lean
+{
+namespace concurrent
+{
+
+/// Yields the remainder of the calling thread's time slice to other threads ready to run.
+LEAN_MAYBE_EXPORT void yield_thread();
+
+/// Backoff policy busy-waiting without any delay. Constructed once per contended lock acquisition,
+/// pause() is called after every failed attempt to acquire the lock.
+struct busy_backoff
+{
+	/// Does nothing.
+	LEAN_INLINE void pause() { }
+};
+
+/// Backoff policy issuing one pause instruction per failed attempt to acquire a lock.
+struct pause_backoff
+{
+	/// Hints the processor that the calling thread is spin-waiting.
+	LEAN_INLINE void pause()
+	{
+		cpu_pause();
+	}
+};
+
+/// Backoff policy issuing an exponentially growing number of pause instructions per failed attempt to acquire a lock.
+template <unsigned int MinPauseCount = 1, unsigned int MaxPauseCount = 1024>
+class exponential_backoff
+{
+private:
+	unsigned int m_pauseCount;
+
+public:
+	/// Constructs a backoff policy starting at the minimum number of pause instructions.
+	exponential_backoff()
+		: m_pauseCount(MinPauseCount) { }
+
+	/// Issues the current number of pause instructions, doubling the number for the next call.
+	LEAN_INLINE void pause()
+	{
+		for (unsigned int i = 0; i < m_pauseCount; ++i)
+			cpu_pause();
+
+		if (m_pauseCount < MaxPauseCount)
+			m_pauseCount = min(2 * m_pauseCount, MaxPauseCount);
+	}
+};
+
+/// Backoff policy issuing pause instructions for the given number of failed attempts to acquire a lock,
+/// yielding to other threads for any subsequent failed attempt.
+template <unsigned int SpinCount = 64>
+class yield_backoff
+{
+private:
+	unsigned int m_spinCount;
+
+public:
+	/// Constructs a backoff policy.
+	yield_backoff()
+		: m_spinCount(0) { }
+
+	/// Issues a pause instruction or yields to other threads once the spin count has been exceeded.
+	LEAN_INLINE void pause()
+	{
+		if (m_spinCount < SpinCount)
+		{
+			++m_spinCount;
+			cpu_pause();
+		}
+		else
+			yield_thread();
+	}
+};
+
+/// Default backoff policy.
+typedef exponential_backoff<> default_backoff;
+
+} // namespace
+
+using concurrent::yield_thread;
+
+using concurrent::busy_backoff;
+using concurrent::pause_backoff;
+using concurrent::exponential_backoff;
+using concurrent::yield_backoff;
+using concurrent::default_backoff;
+
+} // namespace
+
+#ifdef LEAN_INCLUDE_LINKED
+#include "source/backoff.cpp"
+#endif
+
+#endif
\ No newline at end of file
@@ -13,9 +13,12 @@ namespace lean
 }
 
 #include "atomic.h"
+#include "backoff.h"
 
 #include "spin_lock.h"
 #include "shareable_spin_lock.h"
+#include "ticket_lock.h"
+#include "distributed_shareable_lock.h"
 
 #include "shareable_lock_policies.h"
 
@@ -8,7 +8,14 @@
 
 #include "../lean.h"
 #include "../tags/noncopyable.h"
-#include <windows.h>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include "atomic.h"
+	#include "futex.h"
+	#include <pthread.h>
+#endif
 
 // Include automatically to encourage use of scoped_lock
 #include "../smart/scoped_lock.h"
@@ -18,6 +25,8 @@ namespace lean
 namespace concurrent
 {
 
+#ifdef _WIN32
+
 /// Implements a light-weight reentrant binary lock.
 class critical_section : public noncopyable
 {
@@ -56,6 +65,102 @@ public:
 	}
 };
 
+#else
+
+/// Implements a light-weight reentrant binary lock.
+class critical_section : public noncopyable
+{
+private:
+	// 0: unlocked, 1: locked, 2: locked with waiters
+	volatile int m_state;
+	int m_spinCount;
+	int m_spinEstimate;
+
+	pthread_t m_owner;
+	long m_recursionCount;
+
+	/// Acquires ownership for the calling thread.
+	LEAN_INLINE void acquired(pthread_t self)
+	{
+		m_owner = self;
+		m_recursionCount = 1;
+	}
+
+	/// Spins for some time, then waits for the lock to become available.
+	LEAN_NOINLINE void lock_slow(pthread_t self)
+	{
+		// Adapt spinning to the time the lock has recently been held for
+		int maxSpin = min(2 * m_spinEstimate + 16, m_spinCount);
+
+		for (int i = 0; i < maxSpin; ++i)
+		{
+			cpu_pause();
+
+			if (m_state == 0 && atomic_test_and_set(m_state, 0, 1))
+			{
+				m_spinEstimate += (i - m_spinEstimate) / 8;
+				acquired(self);
+				return;
+			}
+		}
+
+		m_spinEstimate += (maxSpin - m_spinEstimate) / 8;
+
+		// Mark contended, the unlocking thread will issue a wake-up
+		while (atomic_set(m_state, 2) != 0)
+			futex_wait(m_state, 2);
+
+		acquired(self);
+	}
+
+public:
+	/// Constructs a critical section. Throws a runtime_error on failure.
+	critical_section(unsigned long spinCount = 4096)
+		: m_state(0),
+		m_spinCount( static_cast<int>( min(spinCount, 1UL << 20) ) ),
+		m_spinEstimate(0),
+		m_owner(),
+		m_recursionCount(0) { }
+
+	/// Tries to lock this critical section, returning false if currenty locked by another user.
+	LEAN_INLINE bool try_lock()
+	{
+		pthread_t self = ::pthread_self();
+
+		if (atomic_test_and_set(m_state, 0, 1))
+		{
+			acquired(self);
+			return true;
+		}
+		else if (m_recursionCount > 0 && ::pthread_equal(m_owner, self))
+		{
+			++m_recursionCount;
+			return true;
+		}
+		else
+			return false;
+	}
+
+	/// Locks this critical section, returning immediately on success, otherwise waiting for the section to become unlocked.
+	LEAN_INLINE void lock()
+	{
+		if (!try_lock())
+			lock_slow(::pthread_self());
+	}
+
+	/// Unlocks this critical section, permitting waiting threads to continue execution.
+	LEAN_INLINE void unlock()
+	{
+		LEAN_ASSERT(m_recursionCount > 0);
+
+		if (--m_recursionCount == 0)
+			if (atomic_set(m_state, 0) == 2)
+				futex_wake(m_state);
+	}
+};
+
+#endif
+
 /// Scoped critical section lock.
 typedef smart::scoped_lock<critical_section> scoped_cs_lock;
 
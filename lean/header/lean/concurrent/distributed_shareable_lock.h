@@ -0,0 +1,231 @@
+/*****************************************************/
+/* lean Concurrent              (c) Tobias Zirr 2011 */
+/*****************************************************/
+
+#pragma once
+#ifndef LEAN_CONCURRENT_DISTRIBUTED_SHAREABLE_LOCK
+#define LEAN_CONCURRENT_DISTRIBUTED_SHAREABLE_LOCK
+
+#include "../lean.h"
+#include "../tags/noncopyable.h"
+#include "atomic.h"
+#include "backoff.h"
+#include "thread_slot.h"
+
+// Include automatically to encourage use of scoped_lock
+#include "shareable_lock_policies.h"
+#include "../smart/scoped_lock.h"
+
+namespace lean
+{
+namespace concurrent
+{
+
+/// Implements a writer-preferring shareable spin lock that is NOT reentrant. Readers register in one of
+/// the given number of cache-line-sized slots chosen by thread, writers wait for all slots to drain.
+/// Scales well with many concurrent readers, at the cost of more expensive exclusive locking.
+template <size_t SlotCount = 16, class Backoff = default_backoff>
+class distributed_shareable_lock : public noncopyable
+{
+public:
+	/// Number of reader slots.
+	static const size_t slot_count = SlotCount;
+	/// Assumed size of one cache line.
+	static const size_t cache_line_size = 64;
+
+private:
+	/// Reader slot, padded to avoid false sharing.
+	struct slot
+	{
+		volatile long readers;
+		char pad[cache_line_size - sizeof(long)];
+	};
+
+	slot m_slots[SlotCount];
+	volatile long m_writer;
+	char m_padWriter[cache_line_size - sizeof(long)];
+
+	/// Gets the reader slot of the calling thread.
+	LEAN_INLINE slot& current_slot()
+	{
+		return m_slots[current_thread_slot(SlotCount)];
+	}
+
+	/// Gets the number of readers currently registered in all slots.
+	LEAN_INLINE long reader_count() const
+	{
+		long readers = 0;
+
+		// Sequentially consistent, must not be reordered before the writer flag was claimed
+		for (size_t i = 0; i < SlotCount; ++i)
+			readers += atomic_load(m_slots[i].readers);
+
+		return readers;
+	}
+
+	/// Claims the writer flag, waiting for other writers to release it.
+	LEAN_NOINLINE void lock_writer()
+	{
+		Backoff backoff;
+
+		while (!atomic_test_and_set(m_writer, 0L, 1L))
+			do
+			{
+				backoff.pause();
+			}
+			while (m_writer != 0);
+	}
+
+	/// Waits for all readers to leave their slots.
+	LEAN_NOINLINE void wait_for_readers()
+	{
+		Backoff backoff;
+
+		// Sequentially consistent, must not be reordered before the writer flag was claimed
+		for (size_t i = 0; i < SlotCount; ++i)
+			while (atomic_load(m_slots[i].readers) != 0)
+				backoff.pause();
+	}
+
+	/// Waits for pending writers, then tries to obtain shared ownership until successful.
+	LEAN_NOINLINE void lock_shared_contended(slot &readerSlot)
+	{
+		Backoff backoff;
+
+		do
+		{
+			do
+			{
+				backoff.pause();
+			}
+			while (m_writer != 0);
+		}
+		while (!try_lock_shared(readerSlot));
+	}
+
+	/// Tries to obtain shared ownership using the given slot.
+	LEAN_INLINE bool try_lock_shared(slot &readerSlot)
+	{
+		atomic_increment(readerSlot.readers);
+
+		// Sequentially consistent, writers either see our registration or we see theirs
+		if (atomic_load(m_writer) == 0)
+			return true;
+
+		atomic_decrement(readerSlot.readers);
+		return false;
+	}
+
+public:
+	/// Constructs a distributed shareable lock.
+	distributed_shareable_lock()
+		: m_writer(0)
+	{
+		for (size_t i = 0; i < SlotCount; ++i)
+			m_slots[i].readers = 0;
+	}
+
+	/// Tries to exclusively lock this lock, returning false if currently locked / shared by another user.
+	LEAN_INLINE bool try_lock()
+	{
+		if (!atomic_test_and_set(m_writer, 0L, 1L))
+			return false;
+
+		if (reader_count() == 0)
+			return true;
+
+		atomic_set(m_writer, 0L);
+		return false;
+	}
+
+	/// Tries to atomically upgrade shared ownership of this lock to exclusive ownership,
+	/// returning false if currently shared with another user.
+	LEAN_INLINE bool try_upgrade_lock()
+	{
+		if (!atomic_test_and_set(m_writer, 0L, 1L))
+			return false;
+
+		// Only the calling thread left
+		if (reader_count() == 1)
+		{
+			atomic_decrement(current_slot().readers);
+			return true;
+		}
+
+		atomic_set(m_writer, 0L);
+		return false;
+	}
+
+	/// Exclusively locks this lock, returning immediately on success, otherwise waiting for the lock to become available.
+	/// New readers are held off as soon as the calling thread starts waiting.
+	LEAN_INLINE void lock()
+	{
+		if (!atomic_test_and_set(m_writer, 0L, 1L))
+			lock_writer();
+
+		wait_for_readers();
+	}
+
+	/// Upgrades shared ownership of this lock to exclusive ownership, returning immediately on success,
+	/// otherwise waiting for the lock to become available. NOT atomic, shared ownership may be lost in between.
+	LEAN_INLINE void upgrade_lock()
+	{
+		// Unlock required, otherwise multiple upgrade
+		// calls at the same time will lead to deadlocks
+		unlock_shared();
+		lock();
+	}
+
+	/// Atomically releases exclusive ownership and re-acquires shared ownership, permitting waiting threads to continue execution.
+	LEAN_INLINE void downgrade_lock()
+	{
+		atomic_increment(current_slot().readers);
+		atomic_store(m_writer, 0L, memory_order_release);
+	}
+
+	/// Unlocks this lock, permitting waiting threads to continue execution.
+	LEAN_INLINE void unlock()
+	{
+		atomic_store(m_writer, 0L, memory_order_release);
+	}
+
+	/// Tries to obtain shared ownership of this lock, returning false if currently locked exclusively by another user.
+	LEAN_INLINE bool try_lock_shared()
+	{
+		return try_lock_shared(current_slot());
+	}
+
+	/// Obtains shared ownership of this lock, returning immediately on success, otherwise waiting for the lock to become available.
+	LEAN_INLINE void lock_shared()
+	{
+		slot &readerSlot = current_slot();
+
+		if (!try_lock_shared(readerSlot))
+			lock_shared_contended(readerSlot);
+	}
+
+	/// Releases shared ownership of this lock, permitting waiting threads to continue execution.
+	LEAN_INLINE void unlock_shared()
+	{
+		atomic_decrement(current_slot().readers);
+	}
+};
+
+/// Scoped exclusive distributed shareable lock.
+typedef smart::scoped_lock< distributed_shareable_lock<> > scoped_dsl_lock;
+/// Scoped shared distributed shareable lock.
+typedef smart::scoped_lock< distributed_shareable_lock<>, shared_lock_policy< distributed_shareable_lock<> > > scoped_dsl_lock_shared;
+/// Scoped distributed shareable lock upgrade.
+typedef smart::scoped_lock< distributed_shareable_lock<>, upgrade_lock_policy< distributed_shareable_lock<> > > scoped_dsl_upgrade_lock;
+
+} // namespace
+
+using concurrent::distributed_shareable_lock;
+
+using concurrent::scoped_dsl_lock;
+using concurrent::scoped_dsl_lock_shared;
+using concurrent::scoped_dsl_upgrade_lock;
+
+} // namespace
+
+#endif
\ No newline at end of file
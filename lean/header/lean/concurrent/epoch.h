@@ -0,0 +1,205 @@
+/*****************************************************/
+/* lean Concurrent              (c) Tobias Zirr 2011 */
+/*****************************************************/
+
+#pragma once
+#ifndef LEAN_CONCURRENT_EPOCH
+#define LEAN_CONCURRENT_EPOCH
+
+#include "../lean.h"
+#include "../tags/noncopyable.h"
+#include "../smart/scoped_lock.h"
+#include "atomic.h"
+#include <vector>
+
+namespace lean
+{
+namespace concurrent
+{
+
+class epoch_domain;
+
+/// Registration of one thread with an epoch domain. Used by exactly one thread at a time.
+class epoch_participant : public noncopyable
+{
+	friend class epoch_domain;
+
+public:
+	/// Function destroying retired objects.
+	typedef void (*deleter_type)(void *object);
+
+	/// Number of epochs that retired objects are kept in.
+	static const size_t limbo_count = 3;
+
+private:
+	// (epoch << 1) | active, read by other threads
+	volatile unsigned long m_state;
+	char m_padState[64 - sizeof(unsigned long)];
+
+	epoch_domain *m_domain;
+	long m_nesting;
+	volatile long m_inUse;
+	epoch_participant *m_next;
+
+	/// Retired object.
+	struct retired_object
+	{
+		void *object;
+		deleter_type deleter;
+	};
+	typedef std::vector<retired_object> retired_vector;
+	retired_vector m_limbo[limbo_count];
+	unsigned long m_limboEpoch[limbo_count];
+	size_t m_retiredCount;
+	size_t m_collectCountdown;
+
+	/// Deletes the given object.
+	template <class Type>
+	static void delete_object(void *object)
+	{
+		delete static_cast<Type*>(object);
+	}
+
+	/// Constructor.
+	LEAN_MAYBE_EXPORT explicit epoch_participant(epoch_domain *domain);
+	/// Destroys all objects still retired.
+	LEAN_MAYBE_EXPORT ~epoch_participant();
+
+	/// Marks the calling thread as active in the current global epoch.
+	LEAN_MAYBE_EXPORT void enter_epoch();
+	/// Frees all objects retired in the given limbo list.
+	LEAN_MAYBE_EXPORT void free_limbo(size_t index);
+
+public:
+	/// Enters a critical section, protecting all objects reachable from shared data structures from being freed until left.
+	/// Critical sections may be nested.
+	LEAN_INLINE void enter()
+	{
+		if (m_nesting++ == 0)
+			enter_epoch();
+	}
+	/// Leaves a critical section.
+	LEAN_INLINE void leave()
+	{
+		LEAN_ASSERT(m_nesting > 0);
+
+		if (--m_nesting == 0)
+			atomic_store(m_state, 0UL, memory_order_release);
+	}
+	/// Checks if the calling thread is currently inside a critical section.
+	LEAN_INLINE bool active() const { return (m_nesting > 0); }
+
+	/// Schedules the given object for destruction by the given deleter once no thread may be referencing it anymore.
+	/// The object needs to have been unlinked from all shared data structures before.
+	LEAN_MAYBE_EXPORT void retire(void *object, deleter_type deleter);
+	/// Schedules the given object for deletion once no thread may be referencing it anymore.
+	/// The object needs to have been unlinked from all shared data structures before.
+	template <class Type>
+	LEAN_INLINE void retire(Type *object)
+	{
+		retire(const_cast<void*>(static_cast<const void*>(object)), &delete_object<Type>);
+	}
+
+	/// Tries to advance the global epoch and frees all objects retired by this thread that are no longer referenced.
+	LEAN_MAYBE_EXPORT void collect();
+
+	/// Gets the number of objects retired by this thread that have not been freed yet.
+	LEAN_INLINE size_t retired_count() const { return m_retiredCount; }
+	/// Gets the domain this participant is registered with.
+	LEAN_INLINE epoch_domain* domain() const { return m_domain; }
+};
+
+/// Epoch-based memory reclamation domain. Threads register as participants, read shared data structures
+/// inside cheap critical sections and retire unlinked objects to be freed in batches once all threads have
+/// left the critical sections that might have observed them.
+class epoch_domain : public noncopyable
+{
+	friend class epoch_participant;
+
+private:
+	volatile unsigned long m_epoch;
+	char m_padEpoch[64 - sizeof(unsigned long)];
+
+	epoch_participant *volatile m_participants;
+	size_t m_collectThreshold;
+
+public:
+	/// Constructs an epoch domain, each participant attempting to free retired objects after the given number of retirements.
+	LEAN_MAYBE_EXPORT explicit epoch_domain(size_t collectThreshold = 64);
+	/// Frees all retired objects. All threads need to have been unregistered.
+	LEAN_MAYBE_EXPORT ~epoch_domain();
+
+	/// Registers the calling thread, re-using participants of unregistered threads where possible.
+	LEAN_MAYBE_EXPORT epoch_participant* register_thread();
+	/// Unregisters the given participant. Objects retired but not yet freed are taken over by subsequent registrations.
+	LEAN_MAYBE_EXPORT void unregister_thread(epoch_participant *participant);
+
+	/// Advances the global epoch, if all threads in critical sections have observed the current epoch.
+	LEAN_MAYBE_EXPORT bool try_advance();
+
+	/// Gets the current global epoch.
+	LEAN_INLINE unsigned long epoch() const { return atomic_load(m_epoch, memory_order_acquire); }
+};
+
+/// Epoch critical section policy.
+struct epoch_section_policy
+{
+	/// Enters a critical section.
+	static LEAN_INLINE bool try_lock(epoch_participant &participant)
+	{
+		participant.enter();
+		return true;
+	}
+	/// Enters a critical section.
+	static LEAN_INLINE void lock(epoch_participant &participant)
+	{
+		participant.enter();
+	}
+	/// Leaves a critical section.
+	static LEAN_INLINE void unlock(epoch_participant &participant)
+	{
+		participant.leave();
+	}
+};
+
+/// Scoped epoch critical section.
+typedef smart::scoped_lock<epoch_participant, epoch_section_policy> scoped_epoch_section;
+
+/// Scoped epoch domain registration.
+class scoped_epoch_registration : public noncopyable
+{
+private:
+	epoch_participant *m_participant;
+
+public:
+	/// Registers the calling thread with the given domain.
+	LEAN_INLINE explicit scoped_epoch_registration(epoch_domain &domain)
+		: m_participant( domain.register_thread() ) { }
+	/// Unregisters the calling thread.
+	LEAN_INLINE ~scoped_epoch_registration()
+	{
+		m_participant->domain()->unregister_thread(m_participant);
+	}
+
+	/// Gets the participant.
+	LEAN_INLINE epoch_participant& participant() const { return *m_participant; }
+	/// Gets the participant.
+	LEAN_INLINE epoch_participant& operator *() const { return *m_participant; }
+	/// Gets the participant.
+	LEAN_INLINE epoch_participant* operator ->() const { return m_participant; }
+};
+
+} // namespace
+
+using concurrent::epoch_participant;
+using concurrent::epoch_domain;
+using concurrent::scoped_epoch_section;
+using concurrent::scoped_epoch_registration;
+
+} // namespace
+
+#ifdef LEAN_INCLUDE_LINKED
+#include "source/epoch.cpp"
+#endif
+
+#endif
\ No newline at end of file
@@ -8,13 +8,21 @@
 
 #include "../lean.h"
 #include "../tags/noncopyable.h"
-#include <windows.h>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include "atomic.h"
+	#include "futex.h"
+#endif
 
 namespace lean
 {
 namespace concurrent
 {
 
+#ifdef _WIN32
+
 /// Implements an event.
 class event : public noncopyable
 {
@@ -70,6 +78,78 @@ public:
 	}
 };
 
+#else
+
+/// Implements an event.
+class event : public noncopyable
+{
+private:
+	volatile int m_signaled;
+	volatile int m_waiters;
+
+public:
+	/// Number of times to re-check the event state before going to sleep.
+	static const int spin_count = 128;
+
+private:
+	/// Spins for some time, then waits for the event to become signaled.
+	LEAN_NOINLINE void wait_slow()
+	{
+		for (int i = 0; i < spin_count; ++i)
+		{
+			cpu_pause();
+
+			if (m_signaled)
+				return;
+		}
+
+		atomic_increment(m_waiters);
+
+		while (!m_signaled)
+			futex_wait(m_signaled, 0);
+
+		atomic_decrement(m_waiters);
+	}
+
+public:
+	/// Constructs an event.
+	event(bool signaled = false)
+		: m_signaled(signaled),
+		m_waiters(0) { }
+
+	/// Waits for the next event notification.
+	LEAN_INLINE void wait()
+	{
+		if (!m_signaled)
+			wait_slow();
+	}
+
+	/// Sets the event state to signaled.
+	LEAN_INLINE void set()
+	{
+		atomic_set(m_signaled, 1);
+
+		if (m_waiters > 0)
+			futex_wake_all(m_signaled);
+	}
+	/// Resets the event state to non-signaled.
+	LEAN_INLINE void reset()
+	{
+		atomic_set(m_signaled, 0);
+	}
+
+	/// Sets the event state.
+	LEAN_INLINE void signaled(bool signaled)
+	{
+		if (signaled)
+			set();
+		else
+			reset();
+	}
+};
+
+#endif
+
 } // namespace
 
 using concurrent::event;
@@ -0,0 +1,82 @@
+/*****************************************************/
+/* lean Concurrent              (c) Tobias Zirr 2011 */
+/*****************************************************/
+
+#pragma once
+#ifndef LEAN_CONCURRENT_FUTEX
+#define LEAN_CONCURRENT_FUTEX
+
+#include "../lean.h"
+
+#ifdef __linux__
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <climits>
+#include <ctime>
+
+namespace lean
+{
+namespace concurrent
+{
+
+/// Blocks the calling thread while the given value equals the given expected value. May return spuriously.
+LEAN_INLINE void futex_wait(volatile int &value, int expected)
+{
+	::syscall(SYS_futex, const_cast<int*>(&value), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+
+/// Wakes up to the given number of threads blocked on the given value.
+LEAN_INLINE void futex_wake(volatile int &value, int count = 1)
+{
+	::syscall(SYS_futex, const_cast<int*>(&value), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+
+/// Wakes all threads blocked on the given value.
+LEAN_INLINE void futex_wake_all(volatile int &value)
+{
+	futex_wake(value, INT_MAX);
+}
+
+/// Blocks the calling thread while the given value, which may be shared across processes, equals the given
+/// expected value. May return spuriously.
+LEAN_INLINE void futex_wait_shared(volatile int &value, int expected)
+{
+	::syscall(SYS_futex, const_cast<int*>(&value), FUTEX_WAIT, expected, nullptr, nullptr, 0);
+}
+
+/// Blocks the calling thread while the given value, which may be shared across processes, equals the given
+/// expected value, for at most the given number of microseconds. May return spuriously.
+LEAN_INLINE void futex_wait_shared(volatile int &value, int expected, uint8 timeoutMicroseconds)
+{
+	::timespec timeout;
+	timeout.tv_sec = static_cast<time_t>(timeoutMicroseconds / 1000000U);
+	timeout.tv_nsec = static_cast<long>(timeoutMicroseconds % 1000000U) * 1000L;
+
+	::syscall(SYS_futex, const_cast<int*>(&value), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+}
+
+/// Wakes up to the given number of threads blocked on the given value, which may be shared across processes.
+LEAN_INLINE void futex_wake_shared(volatile int &value, int count = 1)
+{
+	::syscall(SYS_futex, const_cast<int*>(&value), FUTEX_WAKE, count, nullptr, nullptr, 0);
+}
+
+} // namespace
+
+using concurrent::futex_wait;
+using concurrent::futex_wake;
+using concurrent::futex_wake_all;
+using concurrent::futex_wait_shared;
+using concurrent::futex_wake_shared;
+
+} // namespace
+
+#else
+
+#error Futexes unavailable on this platform.
+
+#endif
+
+#endif
\ No newline at end of file
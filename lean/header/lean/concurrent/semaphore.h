@@ -8,13 +8,21 @@
 
 #include "../lean.h"
 #include "../tags/noncopyable.h"
-#include <windows.h>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include "atomic.h"
+	#include "futex.h"
+#endif
 
 namespace lean
 {
 namespace concurrent
 {
 
+#ifdef _WIN32
+
 /// Implements a semaphore.
 class semaphore : public noncopyable
 {
@@ -61,6 +69,78 @@ public:
 	}
 };
 
+#else
+
+/// Implements a semaphore.
+class semaphore : public noncopyable
+{
+private:
+	volatile int m_count;
+	volatile int m_waiters;
+
+public:
+	/// Number of times to retry acquiring the semaphore before going to sleep.
+	static const int spin_count = 128;
+
+private:
+	/// Spins for some time, then waits for the semaphore to become available.
+	LEAN_NOINLINE void lock_slow()
+	{
+		for (int i = 0; i < spin_count; ++i)
+		{
+			cpu_pause();
+
+			if (m_count > 0 && try_lock())
+				return;
+		}
+
+		atomic_increment(m_waiters);
+
+		while (!try_lock())
+			futex_wait(m_count, 0);
+
+		atomic_decrement(m_waiters);
+	}
+
+public:
+	/// Constructs a semaphore.
+	explicit semaphore(long initialCount = 1)
+		: m_count( static_cast<int>(initialCount) ),
+		m_waiters(0) { }
+
+	/// Tries to acquire this semaphore, returning false if currenty unavailable.
+	LEAN_INLINE bool try_lock()
+	{
+		for (;;)
+		{
+			int count = m_count;
+
+			if (count <= 0)
+				return false;
+			else if (atomic_test_and_set(m_count, count, count - 1))
+				return true;
+		}
+	}
+
+	/// Acquires this semaphore, returning immediately on success, otherwise waiting for the semaphore to become available.
+	LEAN_INLINE void lock()
+	{
+		if (!try_lock())
+			lock_slow();
+	}
+
+	/// Releases this semaphore, permitting waiting threads to continue execution.
+	LEAN_INLINE void unlock()
+	{
+		atomic_increment(m_count);
+
+		if (m_waiters > 0)
+			futex_wake(m_count);
+	}
+};
+
+#endif
+
 } // namespace
 
 using concurrent::semaphore;
@@ -9,6 +9,7 @@
 #include "../lean.h"
 #include "../tags/noncopyable.h"
 #include "atomic.h"
+#include "backoff.h"
 
 // Include automatically to encourage use of scoped_lock
 #include "shareable_lock_policies.h"
@@ -19,14 +20,48 @@ namespace lean
 namespace concurrent
 {
 
-/// Implements a shareable spin lock that is NOT reentrant.
-template <class Counter = long>
+/// Implements a shareable spin lock that is NOT reentrant. Contended threads spin on reads
+/// of the lock state (test-and-test-and-set), delaying retries as specified by the given backoff policy.
+template <class Counter = long, class Backoff = default_backoff>
 class shareable_spin_lock : public noncopyable
 {
 private:
 	Counter m_counter;
 	Counter m_exclCounter;
 
+	/// Waits for the lock to become available, then tries to exclusively lock it until successful.
+	LEAN_NOINLINE void lock_contended()
+	{
+		Backoff backoff;
+
+		do
+		{
+			do
+			{
+				backoff.pause();
+			}
+			while (static_cast<volatile Counter&>(m_counter) != static_cast<Counter>(0));
+		}
+		while (!try_lock());
+	}
+
+	/// Waits for exclusive users to release the lock, then tries to obtain shared ownership until successful.
+	LEAN_NOINLINE void lock_shared_contended()
+	{
+		Backoff backoff;
+
+		do
+		{
+			do
+			{
+				backoff.pause();
+			}
+			while (static_cast<volatile Counter&>(m_exclCounter) != static_cast<Counter>(0) ||
+				static_cast<volatile Counter&>(m_counter) == static_cast<Counter>(-1));
+		}
+		while (!try_lock_shared());
+	}
+
 public:
 	/// Constructs a shareable spin lock.
 	shareable_spin_lock()
@@ -50,7 +85,8 @@ public:
 	LEAN_INLINE void lock()
 	{
 		atomic_increment(m_exclCounter);
-		while (!try_lock());
+		if (!try_lock())
+			lock_contended();
 		atomic_decrement(m_exclCounter);
 	}
 
@@ -63,7 +99,8 @@ public:
 		// Unlock required, otherwise multiple upgrade
 		// calls at the same time will lead to deadlocks
 		unlock_shared();
-		while (!try_lock());
+		if (!try_lock())
+			lock_contended();
 		
 		atomic_decrement(m_exclCounter);
 	}
@@ -71,13 +108,13 @@ public:
 	/// Atomically releases exclusive ownership and re-acquires shared ownership, permitting waiting threads to continue execution.
 	LEAN_INLINE void downgrade_lock()
 	{
-		atomic_test_and_set(m_counter, static_cast<Counter>(-1), static_cast<Counter>(1));
+		atomic_store(m_counter, static_cast<Counter>(1), memory_order_release);
 	}
 
 	/// Unlocks this spin lock, permitting waiting threads to continue execution.
 	LEAN_INLINE void unlock()
 	{
-		atomic_test_and_set(m_counter, static_cast<Counter>(-1), static_cast<Counter>(0));
+		atomic_store(m_counter, static_cast<Counter>(0), memory_order_release);
 	}
 
 	/// Tries to obtain shared ownership of this spin lock, returning false if currently locked exclusively by another user.
@@ -99,7 +136,8 @@ public:
 	/// Obtains shared ownership of this spin lock, returning immediately on success, otherwise waiting for the lock to become available.
 	LEAN_INLINE void lock_shared()
 	{
-		while (!try_lock_shared());
+		if (!try_lock_shared())
+			lock_shared_contended();
 	}
 
 	/// Releases shared ownership of this spin lock, permitting waiting threads to continue execution.
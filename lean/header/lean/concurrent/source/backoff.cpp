@@ -0,0 +1,28 @@
+#ifdef LEAN_BUILD_LIB
+#include "../../depconfig.h"
+#include "../backoff.h"
+#endif
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <sched.h>
+#endif
+
+namespace lean
+{
+namespace concurrent
+{
+
+// Yields the remainder of the calling thread's time slice to other threads ready to run.
+LEAN_MAYBE_LINK void yield_thread()
+{
+#ifdef _WIN32
+	::SwitchToThread();
+#else
+	::sched_yield();
+#endif
+}
+
+} // namespace
+} // namespace
@@ -0,0 +1,177 @@
+#ifdef LEAN_BUILD_LIB
+#include "../../depconfig.h"
+#include "../epoch.h"
+#endif
+
+namespace lean
+{
+namespace concurrent
+{
+
+// Constructor.
+LEAN_ALWAYS_LINK epoch_participant::epoch_participant(epoch_domain *domain)
+	: m_state(0),
+	m_domain(domain),
+	m_nesting(0),
+	m_inUse(0),
+	m_next(nullptr),
+	m_retiredCount(0),
+	m_collectCountdown(domain->m_collectThreshold)
+{
+	for (size_t i = 0; i < limbo_count; ++i)
+		m_limboEpoch[i] = 0;
+}
+
+// Destroys all objects still retired.
+LEAN_ALWAYS_LINK epoch_participant::~epoch_participant()
+{
+	for (size_t i = 0; i < limbo_count; ++i)
+		free_limbo(i);
+}
+
+// Marks the calling thread as active in the current global epoch.
+LEAN_ALWAYS_LINK void epoch_participant::enter_epoch()
+{
+	unsigned long epoch;
+
+	do
+	{
+		epoch = atomic_load(m_domain->m_epoch, memory_order_relaxed);
+		// Full barrier, announcement needs to be visible before any shared data is read
+		atomic_set(m_state, (epoch << 1) | 1UL);
+	}
+	// Make sure the announced epoch was still current after the announcement
+	while (atomic_load(m_domain->m_epoch) != epoch);
+}
+
+// Frees all objects retired in the given limbo list.
+LEAN_ALWAYS_LINK void epoch_participant::free_limbo(size_t index)
+{
+	retired_vector objects;
+	// Deleters may retire further objects
+	objects.swap(m_limbo[index]);
+	m_retiredCount -= objects.size();
+
+	for (retired_vector::const_iterator it = objects.begin(); it != objects.end(); ++it)
+		(*it->deleter)(it->object);
+
+	// Keep storage
+	objects.clear();
+	if (m_limbo[index].empty())
+		m_limbo[index].swap(objects);
+}
+
+// Schedules the given object for destruction by the given deleter once no thread may be referencing it anymore.
+LEAN_ALWAYS_LINK void epoch_participant::retire(void *object, deleter_type deleter)
+{
+	LEAN_ASSERT(deleter);
+
+	unsigned long epoch = m_domain->epoch();
+	size_t index = epoch % limbo_count;
+
+	// Objects retired limbo_count epochs ago are safe to be freed
+	if (m_limboEpoch[index] != epoch)
+	{
+		free_limbo(index);
+		m_limboEpoch[index] = epoch;
+	}
+
+	retired_object retired = { object, deleter };
+	m_limbo[index].push_back(retired);
+	++m_retiredCount;
+
+	if (--m_collectCountdown == 0)
+		collect();
+}
+
+// Tries to advance the global epoch and frees all objects retired by this thread that are no longer referenced.
+LEAN_ALWAYS_LINK void epoch_participant::collect()
+{
+	m_collectCountdown = m_domain->m_collectThreshold;
+
+	m_domain->try_advance();
+	unsigned long epoch = m_domain->epoch();
+
+	// Objects retired two epochs ago can no longer be seen by any thread
+	for (size_t i = 0; i < limbo_count; ++i)
+		if (!m_limbo[i].empty() && epoch - m_limboEpoch[i] >= 2)
+			free_limbo(i);
+}
+
+// Constructs an epoch domain, each participant attempting to free retired objects after the given number of retirements.
+LEAN_ALWAYS_LINK epoch_domain::epoch_domain(size_t collectThreshold)
+	: m_epoch(0),
+	m_participants(nullptr),
+	m_collectThreshold( (collectThreshold != 0) ? collectThreshold : 1 )
+{
+}
+
+// Frees all retired objects. All threads need to have been unregistered.
+LEAN_ALWAYS_LINK epoch_domain::~epoch_domain()
+{
+	epoch_participant *participant = m_participants;
+
+	while (participant)
+	{
+		LEAN_ASSERT(!participant->m_inUse);
+
+		epoch_participant *next = participant->m_next;
+		delete participant;
+		participant = next;
+	}
+}
+
+// Registers the calling thread, re-using participants of unregistered threads where possible.
+LEAN_ALWAYS_LINK epoch_participant* epoch_domain::register_thread()
+{
+	for (epoch_participant *participant = atomic_load(m_participants, memory_order_acquire);
+		participant; participant = participant->m_next)
+		if (!participant->m_inUse && atomic_test_and_set(participant->m_inUse, 0L, 1L))
+			return participant;
+
+	epoch_participant *participant = new epoch_participant(this);
+	participant->m_inUse = 1;
+
+	epoch_participant *head;
+
+	do
+	{
+		head = m_participants;
+		participant->m_next = head;
+	}
+	while (!atomic_test_and_set(m_participants, head, participant));
+
+	return participant;
+}
+
+// Unregisters the given participant. Objects retired but not yet freed are taken over by subsequent registrations.
+LEAN_ALWAYS_LINK void epoch_domain::unregister_thread(epoch_participant *participant)
+{
+	LEAN_ASSERT(participant);
+	LEAN_ASSERT(!participant->active());
+
+	participant->collect();
+	atomic_store(participant->m_inUse, 0L, memory_order_release);
+}
+
+// Advances the global epoch, if all threads in critical sections have observed the current epoch.
+LEAN_ALWAYS_LINK bool epoch_domain::try_advance()
+{
+	unsigned long epoch = atomic_load(m_epoch, memory_order_acquire);
+	unsigned long current = (epoch << 1) | 1UL;
+
+	for (const epoch_participant *participant = atomic_load(m_participants, memory_order_acquire);
+		participant; participant = participant->m_next)
+	{
+		unsigned long state = atomic_load(participant->m_state);
+
+		// Active in a previous epoch
+		if ((state & 1UL) && state != current)
+			return false;
+	}
+
+	return atomic_test_and_set(m_epoch, epoch, epoch + 1);
+}
+
+} // namespace
+} // namespace
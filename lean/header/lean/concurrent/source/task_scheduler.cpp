@@ -0,0 +1,315 @@
+#ifdef LEAN_BUILD_LIB
+#include "../../depconfig.h"
+#include "../task_scheduler.h"
+#endif
+
+#include "../../logging/errors.h"
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <unistd.h>
+#endif
+
+namespace lean
+{
+namespace concurrent
+{
+
+// Gets the worker bound to the calling thread.
+LEAN_ALWAYS_LINK task_scheduler::worker*& task_scheduler::current_worker()
+{
+	static LEAN_THREAD_LOCAL worker *current = nullptr;
+	return current;
+}
+
+// Starts the given number of worker threads, one per hardware thread if zero.
+LEAN_ALWAYS_LINK task_scheduler::task_scheduler(size_t workerCount)
+	: m_workers(nullptr),
+	m_workerCount( (workerCount != 0) ? workerCount : hardware_concurrency() ),
+	m_external(external_queue_capacity),
+	m_wake(0),
+	m_sleepCount(0),
+	m_stop(0)
+{
+	m_workers = new worker[m_workerCount];
+
+	for (size_t i = 0; i < m_workerCount; ++i)
+	{
+		m_workers[i].scheduler = this;
+		m_workers[i].random = static_cast<unsigned long>(i) * 2654435761UL + 1;
+	}
+
+	try
+	{
+		for (size_t i = 0; i < m_workerCount; ++i)
+		{
+			worker_main main = { &m_workers[i] };
+			m_workers[i].handle = thread(main);
+		}
+	}
+	catch (...)
+	{
+		shutdown();
+		throw;
+	}
+}
+
+// Stops all worker threads. All task groups need to have been waited for.
+LEAN_ALWAYS_LINK task_scheduler::~task_scheduler()
+{
+	shutdown();
+}
+
+// Stops and joins all worker threads.
+LEAN_ALWAYS_LINK void task_scheduler::shutdown()
+{
+	atomic_set(m_stop, 1L);
+
+	while (take_sleeper())
+		m_wake.unlock();
+
+	for (size_t i = 0; i < m_workerCount; ++i)
+		m_workers[i].handle.join();
+
+	delete[] m_workers;
+	m_workers = nullptr;
+}
+
+// Allocates task storage.
+LEAN_ALWAYS_LINK void* task_scheduler::allocate_task(worker *self)
+{
+	if (self)
+	{
+		if (self->returned)
+			reclaim_tasks(*self);
+
+		return self->pool.allocate();
+	}
+	else
+	{
+		scoped_sl_lock lock(m_externalPoolLock);
+		return m_externalPool.allocate();
+	}
+}
+
+// Frees task storage into the pool that allocated it.
+LEAN_ALWAYS_LINK void task_scheduler::free_task(task *task, worker *self)
+{
+	worker *owner = task->owner;
+
+	if (owner == self && self)
+		self->pool.free(task);
+	else if (owner)
+	{
+		// Stolen task, hand back to its owner
+		struct task *returned;
+
+		do
+		{
+			returned = owner->returned;
+			task->nextFree = returned;
+		}
+		while (!atomic_test_and_set(owner->returned, returned, task));
+	}
+	else
+	{
+		scoped_sl_lock lock(m_externalPoolLock);
+		m_externalPool.free(task);
+	}
+}
+
+// Reclaims all tasks returned to the given worker's pool by other threads.
+LEAN_ALWAYS_LINK void task_scheduler::reclaim_tasks(worker &self)
+{
+	// NOTE: Taking the whole list at once avoids ABA, only pushes race with the owner
+	task *returned = atomic_set(self.returned, static_cast<task*>(nullptr));
+
+	while (returned)
+	{
+		task *next = returned->nextFree;
+		self.pool.free(returned);
+		returned = next;
+	}
+}
+
+// Enqueues the given task.
+LEAN_ALWAYS_LINK void task_scheduler::enqueue(task *task, worker *self)
+{
+	bool queued = (self)
+		? self->deque.push(task)
+		: m_external.try_push(task);
+
+	if (queued)
+		wake_one();
+	else
+		// Queue overflow, degrade to serial execution
+		execute(task, self);
+}
+
+// Gets the next task to run, nullptr if none available.
+LEAN_ALWAYS_LINK task_scheduler::task* task_scheduler::find_task(worker *self)
+{
+	task *next = nullptr;
+
+	if (self)
+		next = self->deque.pop();
+
+	if (!next)
+		m_external.try_pop(next);
+
+	if (!next)
+	{
+		unsigned long random = (self)
+			? self->random
+			: static_cast<unsigned long>(reinterpret_cast<uintptr_t>(&next) >> 4) | 1;
+
+		for (size_t attempt = 0; !next && attempt < 2 * m_workerCount; ++attempt)
+		{
+			// Xorshift
+			random ^= random << 13;
+			random ^= random >> 17;
+			random ^= random << 5;
+
+			worker &victim = m_workers[random % m_workerCount];
+
+			if (&victim != self)
+				next = victim.deque.steal();
+		}
+
+		if (self)
+			self->random = random;
+	}
+
+	return next;
+}
+
+// Executes and frees the given task.
+LEAN_ALWAYS_LINK void task_scheduler::execute(task *task, worker *self)
+{
+	task_group *group = task->group;
+
+	try
+	{
+		task->run(task->callable.storage);
+	}
+	catch (const std::exception &exc)
+	{
+		LEAN_LOG_ERROR_CTX("Unhandled exception during execution of task", exc.what());
+	}
+	catch (...)
+	{
+		LEAN_LOG_ERROR_MSG("Unhandled exception during execution of task");
+	}
+
+	free_task(task, self);
+	atomic_decrement(group->m_pending);
+}
+
+// Checks if there are tasks waiting to be executed.
+LEAN_ALWAYS_LINK bool task_scheduler::has_work() const
+{
+	if (!m_external.empty())
+		return true;
+
+	for (size_t i = 0; i < m_workerCount; ++i)
+		if (!m_workers[i].deque.empty())
+			return true;
+
+	return false;
+}
+
+// Takes one sleeping worker off the sleep count, returning false if none sleeping.
+LEAN_ALWAYS_LINK bool task_scheduler::take_sleeper()
+{
+	for (;;)
+	{
+		long sleepCount = m_sleepCount;
+
+		if (sleepCount <= 0)
+			return false;
+		else if (atomic_test_and_set(m_sleepCount, sleepCount, sleepCount - 1))
+			return true;
+	}
+}
+
+// Wakes one sleeping worker, if any.
+LEAN_ALWAYS_LINK void task_scheduler::wake_one()
+{
+	// Sequentially consistent, must not be reordered before the task was published
+	if (atomic_load(m_sleepCount) > 0 && take_sleeper())
+		m_wake.unlock();
+}
+
+// Puts the calling worker to sleep until new tasks arrive.
+LEAN_ALWAYS_LINK void task_scheduler::idle(worker &self)
+{
+	atomic_increment(m_sleepCount);
+
+	// Re-check after registering to avoid missing wake-ups
+	if (m_stop || has_work())
+	{
+		// Another thread has already taken our registration, consume its wake-up
+		if (!take_sleeper())
+			m_wake.lock();
+	}
+	else
+		m_wake.lock();
+}
+
+// Runs the given worker until the scheduler shuts down.
+LEAN_ALWAYS_LINK void task_scheduler::run_worker(worker &self)
+{
+	current_worker() = &self;
+
+	while (!m_stop)
+	{
+		task *next = find_task(&self);
+
+		if (next)
+			execute(next, &self);
+		else
+			idle(self);
+	}
+
+	current_worker() = nullptr;
+}
+
+// Waits for all tasks in the given group to complete, executing pending tasks meanwhile.
+LEAN_ALWAYS_LINK void task_scheduler::wait(task_group &group)
+{
+	worker *self = this_worker();
+
+	while (group.m_pending > 0)
+	{
+		task *next = find_task(self);
+
+		if (next)
+			execute(next, self);
+		else
+			yield_thread();
+	}
+}
+
+// Gets the number of hardware threads.
+LEAN_ALWAYS_LINK size_t task_scheduler::hardware_concurrency()
+{
+#ifdef _WIN32
+	SYSTEM_INFO sysInfo;
+	::GetSystemInfo(&sysInfo);
+	return (sysInfo.dwNumberOfProcessors > 0) ? sysInfo.dwNumberOfProcessors : 1;
+#else
+	long processorCount = ::sysconf(_SC_NPROCESSORS_ONLN);
+	return (processorCount > 0) ? static_cast<size_t>(processorCount) : 1;
+#endif
+}
+
+// Gets the default task scheduler, running one worker per hardware thread. First call is NOT thread-safe.
+LEAN_ALWAYS_LINK task_scheduler& default_task_scheduler()
+{
+	static task_scheduler scheduler;
+	return scheduler;
+}
+
+} // namespace
+} // namespace
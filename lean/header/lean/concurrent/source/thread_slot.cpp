@@ -0,0 +1,26 @@
+#ifdef LEAN_BUILD_LIB
+#include "../../depconfig.h"
+#include "../thread_slot.h"
+#endif
+
+#include "../atomic.h"
+
+namespace lean
+{
+namespace concurrent
+{
+
+// Gets a small number uniquely identifying the calling thread, assigned sequentially on first call.
+LEAN_ALWAYS_LINK size_t current_thread_slot()
+{
+	static volatile long nextSlot = 0;
+	static LEAN_THREAD_LOCAL long currentSlot = -1;
+
+	if (currentSlot < 0)
+		currentSlot = atomic_increment(nextSlot) - 1;
+
+	return static_cast<size_t>(currentSlot);
+}
+
+} // namespace
+} // namespace
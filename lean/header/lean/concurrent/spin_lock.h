@@ -9,6 +9,7 @@
 #include "../lean.h"
 #include "../tags/noncopyable.h"
 #include "atomic.h"
+#include "backoff.h"
 
 // Include automatically to encourage use of scoped_lock
 #include "../smart/scoped_lock.h"
@@ -18,13 +19,30 @@ namespace lean
 namespace concurrent
 {
 
-/// Implements a simple binary spin lock that is NOT reentrant.
-template <class Counter = long>
+/// Implements a simple binary spin lock that is NOT reentrant. Contended threads spin on reads
+/// of the lock state (test-and-test-and-set), delaying retries as specified by the given backoff policy.
+template <class Counter = long, class Backoff = default_backoff>
 class spin_lock : public noncopyable
 {
 private:
 	Counter m_counter;
 
+	/// Waits for the lock to become unlocked, then tries to lock it until successful.
+	LEAN_NOINLINE void lock_contended()
+	{
+		Backoff backoff;
+
+		do
+		{
+			do
+			{
+				backoff.pause();
+			}
+			while (static_cast<volatile Counter&>(m_counter) != static_cast<Counter>(0));
+		}
+		while (!try_lock());
+	}
+
 public:
 	/// Constructs a binary spin lock.
 	spin_lock()
@@ -39,13 +57,14 @@ public:
 	/// Locks this spin lock, returning immediately on success, otherwise waiting for the lock to become unlocked.
 	LEAN_INLINE void lock()
 	{
-		while (!try_lock());
+		if (!try_lock())
+			lock_contended();
 	}
 
 	/// Unlocks this spin lock, permitting waiting threads to continue execution.
 	LEAN_INLINE void unlock()
 	{
-		atomic_test_and_set(m_counter, static_cast<Counter>(1), static_cast<Counter>(0));
+		atomic_store(m_counter, static_cast<Counter>(0), memory_order_release);
 	}
 };
 
@@ -0,0 +1,238 @@
+/*****************************************************/
+/* lean Concurrent              (c) Tobias Zirr 2011 */
+/*****************************************************/
+
+#pragma once
+#ifndef LEAN_CONCURRENT_TASK_SCHEDULER
+#define LEAN_CONCURRENT_TASK_SCHEDULER
+
+#include "../lean.h"
+#include "../tags/noncopyable.h"
+#include "../memory/chunk_pool.h"
+#include "../containers/mpmc_queue.h"
+#include "atomic.h"
+#include "spin_lock.h"
+#include "semaphore.h"
+#include "thread.h"
+#include "work_stealing_deque.h"
+#include <new>
+
+namespace lean
+{
+namespace concurrent
+{
+
+class task_scheduler;
+
+/// Tracks a number of tasks spawned together, allowing for fork-join parallelism.
+class task_group : public noncopyable
+{
+	friend class task_scheduler;
+
+private:
+	volatile long m_pending;
+
+public:
+	/// Constructs an empty task group.
+	task_group()
+		: m_pending(0) { }
+	/// Checks that all tasks have completed.
+	~task_group()
+	{
+		LEAN_ASSERT(m_pending == 0);
+	}
+
+	/// Checks if all tasks spawned in this group have completed.
+	LEAN_INLINE bool done() const { return (m_pending == 0); }
+};
+
+/// Fixed pool of worker threads executing tasks from per-worker work-stealing deques.
+class task_scheduler : public noncopyable
+{
+public:
+	/// Maximum size of callable objects stored inline with each task.
+	static const size_t max_callable_size = 12 * sizeof(void*);
+	/// Maximum number of tasks queued by one worker before further tasks are run inline.
+	static const size_t deque_capacity = 1024;
+	/// Maximum number of tasks spawned by non-worker threads queued before further tasks are run inline.
+	static const size_t external_queue_capacity = 1024;
+
+private:
+	struct worker;
+
+	/// Task storage.
+	struct task
+	{
+		typedef void (*function_type)(void *callable);
+
+		function_type run;
+		task_group *group;
+		worker *owner;		///< Worker whose pool allocated this task, nullptr if allocated from the external pool.
+		task *nextFree;		///< Next task returned to the owner's pool by other threads.
+		union
+		{
+			double alignDouble;
+			void *alignPtr;
+			char storage[max_callable_size];
+		} callable;
+
+		/// Constructor.
+		task(task_group *group, worker *owner)
+			: run(nullptr),
+			group(group),
+			owner(owner),
+			nextFree(nullptr) { }
+	};
+
+	typedef memory::chunk_pool<task, 64> task_pool;
+
+	/// Worker state.
+	struct worker
+	{
+		task_scheduler *scheduler;
+		work_stealing_deque<task, deque_capacity> deque;
+		task_pool pool;
+		task *volatile returned;	///< Tasks freed by other threads, reclaimed by the owner on allocation.
+		unsigned long random;
+		thread handle;
+
+		/// Constructor.
+		worker()
+			: scheduler(nullptr),
+			returned(nullptr),
+			random(0) { }
+	};
+
+	/// Worker thread entry point.
+	struct worker_main
+	{
+		worker *self;
+
+		void operator ()() const { self->scheduler->run_worker(*self); }
+	};
+
+	worker *m_workers;
+	size_t m_workerCount;
+
+	mpmc_queue<task*> m_external;
+	task_pool m_externalPool;
+	spin_lock<> m_externalPoolLock;
+
+	semaphore m_wake;
+	volatile long m_sleepCount;
+	volatile long m_stop;
+
+	/// Invokes and destructs the callable stored in the given memory.
+	template <class Callable>
+	static void invoke(void *callable)
+	{
+		Callable &fun = *static_cast<Callable*>(callable);
+
+		try
+		{
+			fun();
+		}
+		catch (...)
+		{
+			fun.~Callable();
+			throw;
+		}
+
+		fun.~Callable();
+	}
+
+	/// Gets the worker bound to the calling thread.
+	LEAN_MAYBE_EXPORT static worker*& current_worker();
+	/// Gets the worker bound to the calling thread, nullptr if not a worker of this scheduler.
+	LEAN_INLINE worker* this_worker()
+	{
+		worker *self = current_worker();
+		return (self && self->scheduler == this) ? self : nullptr;
+	}
+
+	/// Allocates task storage.
+	LEAN_MAYBE_EXPORT void* allocate_task(worker *self);
+	/// Frees task storage into the pool that allocated it.
+	LEAN_MAYBE_EXPORT void free_task(task *task, worker *self);
+	/// Reclaims all tasks returned to the given worker's pool by other threads.
+	LEAN_MAYBE_EXPORT void reclaim_tasks(worker &self);
+
+	/// Enqueues the given task.
+	LEAN_MAYBE_EXPORT void enqueue(task *task, worker *self);
+	/// Gets the next task to run, nullptr if none available.
+	LEAN_MAYBE_EXPORT task* find_task(worker *self);
+	/// Executes and frees the given task.
+	LEAN_MAYBE_EXPORT void execute(task *task, worker *self);
+
+	/// Checks if there are tasks waiting to be executed.
+	LEAN_MAYBE_EXPORT bool has_work() const;
+	/// Takes one sleeping worker off the sleep count, returning false if none sleeping.
+	LEAN_MAYBE_EXPORT bool take_sleeper();
+	/// Wakes one sleeping worker, if any.
+	LEAN_MAYBE_EXPORT void wake_one();
+	/// Puts the calling worker to sleep until new tasks arrive.
+	LEAN_MAYBE_EXPORT void idle(worker &self);
+
+	/// Runs the given worker until the scheduler shuts down.
+	LEAN_MAYBE_EXPORT void run_worker(worker &self);
+	/// Stops and joins all worker threads.
+	LEAN_MAYBE_EXPORT void shutdown();
+
+public:
+	/// Starts the given number of worker threads, one per hardware thread if zero.
+	LEAN_MAYBE_EXPORT explicit task_scheduler(size_t workerCount = 0);
+	/// Stops all worker threads. All task groups need to have been waited for.
+	LEAN_MAYBE_EXPORT ~task_scheduler();
+
+	/// Spawns a task running the given callable object in the given group.
+	template <class Callable>
+	void spawn(task_group &group, const Callable &callable)
+	{
+		LEAN_STATIC_ASSERT_MSG_ALT(sizeof(Callable) <= max_callable_size,
+			"Callable object too large to be stored inline with the task.",
+			Callable_object_too_large_to_be_stored_inline_with_the_task);
+
+		worker *self = this_worker();
+		task *spawned = new( allocate_task(self) ) task(&group, self);
+
+		try
+		{
+			new( static_cast<void*>(spawned->callable.storage) ) Callable(callable);
+		}
+		catch (...)
+		{
+			free_task(spawned, self);
+			throw;
+		}
+
+		spawned->run = &invoke<Callable>;
+		atomic_increment(group.m_pending);
+		enqueue(spawned, self);
+	}
+
+	/// Waits for all tasks in the given group to complete, executing pending tasks meanwhile.
+	LEAN_MAYBE_EXPORT void wait(task_group &group);
+
+	/// Gets the number of worker threads.
+	LEAN_INLINE size_t worker_count() const { return m_workerCount; }
+
+	/// Gets the number of hardware threads.
+	LEAN_MAYBE_EXPORT static size_t hardware_concurrency();
+};
+
+/// Gets the default task scheduler, running one worker per hardware thread. First call is NOT thread-safe.
+LEAN_MAYBE_EXPORT task_scheduler& default_task_scheduler();
+
+} // namespace
+
+using concurrent::task_group;
+using concurrent::task_scheduler;
+using concurrent::default_task_scheduler;
+
+} // namespace
+
+#ifdef LEAN_INCLUDE_LINKED
+#include "source/task_scheduler.cpp"
+#endif
+
+#endif
\ No newline at end of file
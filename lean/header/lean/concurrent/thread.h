@@ -8,15 +8,24 @@
 
 #include "../lean.h"
 #include "../tags/noncopyable.h"
-#include <process.h>
-#include <windows.h>
-#include <lean/logging/win_errors.h>
+#include "../meta/strip.h"
+
+#ifdef _WIN32
+	#include <process.h>
+	#include <windows.h>
+	#include <lean/logging/win_errors.h>
+#else
+	#include <pthread.h>
+	#include <lean/logging/errors.h>
+#endif
 
 namespace lean
 {
 namespace concurrent
 {
 
+#ifdef _WIN32
+
 /// Manages a simple thread.
 class thread : public noncopyable
 {
@@ -90,7 +99,7 @@ public:
 	/// Constructs a thread. Throws a runtime_error on failure.
 	template <class Callable>
 	thread(Callable &&callable)
-		: m_handle( run_thread( new Callable(std::move(callable)) ) ) { }
+		: m_handle( run_thread( new typename strip_modref<Callable>::type(std::forward<Callable>(callable)) ) ) { }
 	/// Moves the thread managed by the given thread object to this thread object.
 	thread(thread &&right) noexcept
 		: m_handle(right.m_handle)
@@ -149,6 +158,150 @@ public:
 	}
 };
 
+#else
+
+/// Manages a simple thread.
+class thread : public noncopyable
+{
+private:
+	pthread_t m_handle;
+	bool m_joinable;
+
+	/// Calls the given callable object.
+	template <class Callable>
+	static void* run_thread(void *args)
+	{
+		void *result = nullptr;
+
+		Callable *callable = static_cast<Callable*>(args);
+		LEAN_ASSERT_NOT_NULL(callable);
+
+		try
+		{
+			try
+			{
+				(*callable)();
+			}
+			catch (const std::exception &exc)
+			{
+				LEAN_LOG_ERROR_CTX("Unhandled exception during execution of thread", exc.what());
+				result = reinterpret_cast<void*>(-1);
+			}
+			catch (...)
+			{
+				LEAN_LOG_ERROR_MSG("Unhandled exception during execution of thread");
+				result = reinterpret_cast<void*>(-1);
+			}
+
+			delete callable;
+		}
+		catch (...)
+		{
+			result = reinterpret_cast<void*>(-2);
+		}
+
+		return result;
+	}
+
+	/// Creates a new thread to run the given callable object.
+	template <class Callable>
+	static pthread_t run_thread(Callable *callable)
+	{
+		LEAN_ASSERT_NOT_NULL(callable);
+
+		pthread_t handle;
+
+		if (::pthread_create(&handle, nullptr, &run_thread<Callable>, callable) != 0)
+		{
+			delete callable;
+			LEAN_THROW_ERROR_MSG("pthread_create() failed");
+		}
+
+		return handle;
+	}
+
+public:
+	/// Default constructor.
+	thread()
+		: m_handle(),
+		m_joinable(false) { }
+	/// Constructs a thread. Throws a runtime_error on failure.
+	template <class Callable>
+	thread(const Callable &callable)
+		: m_handle( run_thread( new Callable(callable) ) ),
+		m_joinable(true) { }
+#ifndef LEAN0X_NO_RVALUE_REFERENCES
+	/// Constructs a thread. Throws a runtime_error on failure.
+	template <class Callable>
+	thread(Callable &&callable)
+		: m_handle( run_thread( new typename strip_modref<Callable>::type(std::forward<Callable>(callable)) ) ),
+		m_joinable(true) { }
+	/// Moves the thread managed by the given thread object to this thread object.
+	thread(thread &&right) noexcept
+		: m_handle(right.m_handle),
+		m_joinable(right.m_joinable)
+	{
+		right.m_joinable = false;
+	}
+#endif
+	/// Destructor.
+	~thread()
+	{
+		detach();
+	}
+
+#ifndef LEAN0X_NO_RVALUE_REFERENCES
+	/// Moves the thread managed by the given thread object to this thread object.
+	thread& operator =(thread &&right) noexcept
+	{
+		if (&right != this)
+		{
+			detach();
+			m_handle = right.m_handle;
+			m_joinable = right.m_joinable;
+			right.m_joinable = false;
+		}
+		return *this;
+	}
+#endif
+
+	/// Detaches the managed thread from this thread object.
+	void detach()
+	{
+		if (m_joinable)
+		{
+			::pthread_detach(m_handle);
+			m_joinable = false;
+		}
+	}
+
+	/// Checks if this thread is valid.
+	LEAN_INLINE bool joinable() const
+	{
+		return m_joinable;
+	}
+	/// Waits for the managed thread to exit.
+	void join()
+	{
+		if (m_joinable)
+		{
+			if (::pthread_join(m_handle, nullptr) != 0)
+				LEAN_THROW_ERROR_MSG("pthread_join()");
+
+			// Joined threads may not be joined or detached again
+			m_joinable = false;
+		}
+	}
+
+	/// Gets the native handle.
+	LEAN_INLINE pthread_t native_handle() const
+	{
+		return m_handle;
+	}
+};
+
+#endif
+
 } // namespace
 
 using concurrent::thread;
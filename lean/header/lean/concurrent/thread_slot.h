@@ -0,0 +1,36 @@
+/*****************************************************/
+/* lean Concurrent              (c) Tobias Zirr 2011 */
+/*****************************************************/
+
+#pragma once
+#ifndef LEAN_CONCURRENT_THREAD_SLOT
+#define LEAN_CONCURRENT_THREAD_SLOT
+
+#include "../lean.h"
+
+namespace lean
+{
+namespace concurrent
+{
+
+/// Gets a small number uniquely identifying the calling thread, assigned sequentially on first call.
+/// Numbers are never re-used, threads started later receive larger numbers.
+LEAN_MAYBE_EXPORT size_t current_thread_slot();
+
+/// Gets the slot among the given number of slots assigned to the calling thread. Stable for the lifetime of the thread.
+LEAN_INLINE size_t current_thread_slot(size_t slotCount)
+{
+	return current_thread_slot() % slotCount;
+}
+
+} // namespace
+
+using concurrent::current_thread_slot;
+
+} // namespace
+
+#ifdef LEAN_INCLUDE_LINKED
+#include "source/thread_slot.cpp"
+#endif
+
+#endif
\ No newline at end of file
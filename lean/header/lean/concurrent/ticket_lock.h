@@ -0,0 +1,82 @@
+/*****************************************************/
+/* lean Concurrent              (c) Tobias Zirr 2011 */
+/*****************************************************/
+
+#pragma once
+#ifndef LEAN_CONCURRENT_TICKET_LOCK
+#define LEAN_CONCURRENT_TICKET_LOCK
+
+#include "../lean.h"
+#include "../tags/noncopyable.h"
+#include "atomic.h"
+#include "backoff.h"
+
+// Include automatically to encourage use of scoped_lock
+#include "../smart/scoped_lock.h"
+
+namespace lean
+{
+namespace concurrent
+{
+
+/// Implements a fair binary spin lock that is NOT reentrant. Waiting threads acquire the lock
+/// in the order of their arrival, delaying re-checks as specified by the given backoff policy.
+template <class Counter = long, class Backoff = pause_backoff>
+class ticket_lock : public noncopyable
+{
+private:
+	Counter m_nextTicket;
+	Counter m_servedTicket;
+
+	/// Waits for the given ticket to be served.
+	LEAN_NOINLINE void wait_for(Counter ticket)
+	{
+		Backoff backoff;
+
+		// Acquire, no subsequent RMW orders the critical section after this load
+		while (atomic_load(m_servedTicket, memory_order_acquire) != ticket)
+			backoff.pause();
+	}
+
+public:
+	/// Constructs a ticket lock.
+	ticket_lock()
+		: m_nextTicket(0),
+		m_servedTicket(0) {  }
+
+	/// Tries to lock this ticket lock, returning false if currenty locked by another user.
+	LEAN_INLINE bool try_lock()
+	{
+		Counter servedTicket = static_cast<volatile Counter&>(m_servedTicket);
+		return atomic_test_and_set(m_nextTicket, servedTicket, static_cast<Counter>(servedTicket + 1));
+	}
+
+	/// Locks this ticket lock, returning immediately on success, otherwise waiting for all earlier users to unlock.
+	LEAN_INLINE void lock()
+	{
+		Counter ticket = static_cast<Counter>(atomic_increment(m_nextTicket) - 1);
+
+		if (atomic_load(m_servedTicket, memory_order_acquire) != ticket)
+			wait_for(ticket);
+	}
+
+	/// Unlocks this ticket lock, permitting the next waiting thread to continue execution.
+	LEAN_INLINE void unlock()
+	{
+		// Only modified by the current owner
+		atomic_store(m_servedTicket, static_cast<Counter>(m_servedTicket + 1), memory_order_release);
+	}
+};
+
+/// Scoped ticket lock.
+typedef smart::scoped_lock< ticket_lock<> > scoped_tl_lock;
+
+} // namespace
+
+using concurrent::ticket_lock;
+
+using concurrent::scoped_tl_lock;
+
+} // namespace
+
+#endif
\ No newline at end of file
@@ -0,0 +1,136 @@
+/*****************************************************/
+/* lean Concurrent              (c) Tobias Zirr 2011 */
+/*****************************************************/
+
+#pragma once
+#ifndef LEAN_CONCURRENT_WORK_STEALING_DEQUE
+#define LEAN_CONCURRENT_WORK_STEALING_DEQUE
+
+#include "../lean.h"
+#include "../tags/noncopyable.h"
+#include "atomic.h"
+
+namespace lean
+{
+namespace concurrent
+{
+
+/// Fixed-capacity Chase-Lev work-stealing deque of pointers. The owning thread pushes and pops
+/// at the bottom end, any other thread may steal from the top end.
+template <class Element, size_t Capacity = 1024>
+class work_stealing_deque : public noncopyable
+{
+public:
+	/// Type of the elements referenced by this deque.
+	typedef Element value_type;
+	/// Type of the pointers stored by this deque.
+	typedef value_type* pointer;
+	/// Type of the size returned by this deque.
+	typedef size_t size_type;
+
+	/// Maximum number of elements stored by this deque.
+	static const size_type capacity = Capacity;
+
+	LEAN_STATIC_ASSERT_MSG_ALT((Capacity & (Capacity - 1)) == 0,
+		"Capacity is required to be a power of two.",
+		Capacity_is_required_to_be_a_power_of_two);
+
+private:
+	volatile long m_top;
+	char m_padTop[64 - sizeof(long)];
+	volatile long m_bottom;
+	char m_padBottom[64 - sizeof(long)];
+	pointer volatile m_elements[Capacity];
+
+	static const long mask = static_cast<long>(Capacity - 1);
+
+	/// Computes the wrap-around safe signed distance between the given positions.
+	static LEAN_INLINE long distance(long end, long begin)
+	{
+		return static_cast<long>( static_cast<unsigned long>(end) - static_cast<unsigned long>(begin) );
+	}
+
+public:
+	/// Constructs an empty deque.
+	work_stealing_deque()
+		: m_top(0),
+		m_bottom(0) { }
+
+	/// Pushes the given element onto the bottom of this deque, returning false if full. Owner only.
+	LEAN_INLINE bool push(pointer element)
+	{
+		long bottom = m_bottom;
+
+		if (distance(bottom, m_top) >= static_cast<long>(Capacity))
+			return false;
+
+		m_elements[bottom & mask] = element;
+		// Full barrier required, sleep checks following the push must not be reordered before it
+		atomic_set(m_bottom, bottom + 1);
+		return true;
+	}
+
+	/// Pops an element off the bottom of this deque, returning nullptr if empty. Owner only.
+	LEAN_INLINE pointer pop()
+	{
+		long bottom = m_bottom - 1;
+		// Full barrier required, thieves must see the reservation before top is read
+		atomic_set(m_bottom, bottom);
+		long top = m_top;
+
+		long size = distance(bottom, top);
+		pointer element = nullptr;
+
+		if (size >= 0)
+		{
+			element = m_elements[bottom & mask];
+
+			// Last element, race thieves
+			if (size == 0)
+			{
+				if (!atomic_test_and_set(m_top, top, top + 1))
+					element = nullptr;
+				atomic_store(m_bottom, bottom + 1, memory_order_relaxed);
+			}
+		}
+		else
+			atomic_store(m_bottom, bottom + 1, memory_order_relaxed);
+
+		return element;
+	}
+
+	/// Steals an element from the top of this deque, returning nullptr if empty or lost to a competing thread.
+	LEAN_INLINE pointer steal()
+	{
+		// Sequentially consistent, top must be read before bottom
+		long top = atomic_load(m_top);
+		long bottom = atomic_load(m_bottom);
+
+		if (distance(bottom, top) > 0)
+		{
+			pointer element = m_elements[top & mask];
+
+			if (atomic_test_and_set(m_top, top, top + 1))
+				return element;
+		}
+
+		return nullptr;
+	}
+
+	/// Returns true if the deque is empty. Only a snapshot when accessed concurrently.
+	LEAN_INLINE bool empty() const { return (distance(m_bottom, m_top) <= 0); }
+	/// Returns the number of elements stored in this deque. Only a snapshot when accessed concurrently.
+	LEAN_INLINE size_type size() const
+	{
+		long size = distance(m_bottom, m_top);
+		return (size > 0) ? static_cast<size_type>(size) : 0;
+	}
+};
+
+} // namespace
+
+using concurrent::work_stealing_deque;
+
+} // namespace
+
+#endif
\ No newline at end of file
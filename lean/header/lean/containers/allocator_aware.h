@@ -14,6 +14,33 @@ namespace lean
 namespace containers
 {
 
+namespace impl
+{
+	/// Checks if the given allocator defines a stored pointer type.
+	template <class Allocator>
+	struct has_stored_pointer
+	{
+		template <class Other>
+		static true_type sfinae_check(typename Other::stored_pointer*);
+		template <class Other>
+		static false_type sfinae_check(...);
+
+		static const bool value = LEAN_IS_TRUE_TYPE_SIZE( sfinae_check<Allocator>(0) );
+	};
+
+	template <class Allocator, bool HasStoredPointer = has_stored_pointer<Allocator>::value>
+	struct allocator_stored_pointer : identity<typename Allocator::pointer> { };
+	template <class Allocator>
+	struct allocator_stored_pointer<Allocator, true> : identity<typename Allocator::stored_pointer> { };
+
+} // namespace
+
+/// Redefines the type of pointers containers store to keep track of memory obtained from the given allocator.
+/// Allocators may define a stored_pointer type, e.g. offset_ptr, to allow containers to be relocated in memory
+/// together with the memory they allocated, defaults to the allocator's pointer type.
+template <class Allocator>
+struct stored_pointer : impl::allocator_stored_pointer<Allocator> { };
+
 /// Stores an allocator object if the given allocator type is non-empty.
 template <class Allocator, bool IsEmpty = is_empty<Allocator>::value>
 class allocator_aware_base
@@ -46,6 +73,15 @@ protected:
 		: m_allocator(allocator) { }
 
 #ifdef LEAN0X_NEED_EXPLICIT_MOVE
+	/// Copy construction.
+	LEAN_INLINE allocator_aware_base(const allocator_aware_base &right)
+		: m_allocator(right.m_allocator) { }
+	/// Copy assignment.
+	LEAN_INLINE allocator_aware_base& operator =(const allocator_aware_base &right)
+	{
+		m_allocator = right.m_allocator;
+		return *this;
+	}
 	/// Move construction.
 	LEAN_INLINE allocator_aware_base(allocator_aware_base &&right) noexcept
 		: m_allocator(std::move(right.m_allocator)) { }
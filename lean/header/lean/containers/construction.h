@@ -246,17 +246,17 @@ LEAN_INLINE Element* move_backwards(SrcElement *source, SrcElement *sourceEnd, E
 }
 
 /// Opens a gap of uninitialized elements, returning the new end element.
-template <class Element, class Allocator, class DestructTag>
-LEAN_INLINE void open_uninit(Element *gap, Element *gapEnd, Element *&end, Allocator &allocator, trivial_construction_t moveTag, DestructTag destructTag)
+template <class Element, class EndPointer, class Allocator, class DestructTag>
+LEAN_INLINE void open_uninit(Element *gap, Element *gapEnd, EndPointer &end, Allocator &allocator, trivial_construction_t moveTag, DestructTag destructTag)
 {
 	LEAN_ASSERT(gap <= gapEnd);
 	LEAN_ASSERT(gap <= end);
 
-	end = move_backwards(gap, end, gapEnd, moveTag);
+	end = move_backwards(gap, static_cast<Element*>(end), gapEnd, moveTag);
 }
 /// Opens a gap of uninitialized elements, returning the new end element via the given end reference.
-template <class Element, class Allocator, class DestructTag>
-inline void open_uninit(Element *gap, Element *gapEnd, Element *&end, Allocator &allocator, nontrivial_construction_t moveTag, DestructTag destructTag)
+template <class Element, class EndPointer, class Allocator, class DestructTag>
+inline void open_uninit(Element *gap, Element *gapEnd, EndPointer &end, Allocator &allocator, nontrivial_construction_t moveTag, DestructTag destructTag)
 {
 	LEAN_ASSERT(gap <= gapEnd);
 	LEAN_ASSERT(gap <= end);
@@ -275,18 +275,18 @@ inline void open_uninit(Element *gap, Element *gapEnd, Element *&end, Allocator
 }
 
 /// Closes a gap of uninitialized elements, returning the new end element via the given end reference.
-template <class Element, class Allocator, class DestructTag>
-inline void close_uninit(Element *gap, Element *gapEnd, Element *&end, Allocator &allocator, trivial_construction_t moveTag, DestructTag destructTag)
+template <class Element, class EndPointer, class Allocator, class DestructTag>
+inline void close_uninit(Element *gap, Element *gapEnd, EndPointer &end, Allocator &allocator, trivial_construction_t moveTag, DestructTag destructTag)
 {
 	LEAN_ASSERT(gap <= gapEnd);
 	LEAN_ASSERT(gapEnd <= end);
 
-	end = move(gapEnd, end, gap, moveTag);
+	end = move(gapEnd, static_cast<Element*>(end), gap, moveTag);
 }
 
 /// Closes a gap of uninitialized elements, returning the new end element via the given end reference.
-template <class Element, class Allocator, class DestructTag>
-inline void close_uninit(Element *gap, Element *gapEnd, Element *&end, Allocator &allocator, nontrivial_construction_t moveTag, DestructTag destructTag)
+template <class Element, class EndPointer, class Allocator, class DestructTag>
+inline void close_uninit(Element *gap, Element *gapEnd, EndPointer &end, Allocator &allocator, nontrivial_construction_t moveTag, DestructTag destructTag)
 {
 	LEAN_ASSERT(gap <= gapEnd);
 	LEAN_ASSERT(gapEnd <= end);
@@ -298,14 +298,15 @@ inline void close_uninit(Element *gap, Element *gapEnd, Element *&end, Allocator
 	size_t constructCount = min(gapWidth, postCount);
 	move_construct(gapEnd, gapEnd + constructCount, gap, allocator, moveTag);
 	
-	end = move(gapEnd + constructCount, oldEnd, gap + constructCount, moveTag);
+	Element *newEnd = move(gapEnd + constructCount, oldEnd, gap + constructCount, moveTag);
+	end = newEnd;
 
-	destruct(end, oldEnd, allocator, destructTag);
+	destruct(newEnd, oldEnd, allocator, destructTag);
 }
 
 /// Closes a gap of elements, returning the new end element via the given end reference.
-template <class Element, class Allocator, class MoveTag, class DestructTag>
-inline void close(Element *gap, Element *gapEnd, Element *&end, Allocator &allocator, MoveTag moveTag, DestructTag destructTag)
+template <class Element, class EndPointer, class Allocator, class MoveTag, class DestructTag>
+inline void close(Element *gap, Element *gapEnd, EndPointer &end, Allocator &allocator, MoveTag moveTag, DestructTag destructTag)
 {
 	LEAN_ASSERT(gap <= gapEnd);
 	LEAN_ASSERT(gapEnd <= end);
@@ -314,10 +315,11 @@ inline void close(Element *gap, Element *gapEnd, Element *&end, Allocator &alloc
 		destruct(gap, gapEnd, allocator, destructTag);
 
 	Element *oldEnd = end;
-	end = move(gapEnd, oldEnd, gap, moveTag);
+	Element *newEnd = move(gapEnd, oldEnd, gap, moveTag);
+	end = newEnd;
 	
 	if (!is_trivial_construction<MoveTag>::value)
-		destruct(end, oldEnd, allocator, destructTag);
+		destruct(newEnd, oldEnd, allocator, destructTag);
 }
 
 template <class C>
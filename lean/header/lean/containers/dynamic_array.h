@@ -10,7 +10,7 @@
 #include "../memory/default_heap.h"
 #include "../functional/variadic.h"
 #include "../meta/type_traits.h"
-#include "../tags/noncopyable.h"
+#include "allocator_aware.h"
 #include "construction.h"
 
 namespace lean 
@@ -18,9 +18,9 @@ namespace lean
 namespace containers
 {
 
-/// Dynamic array base class.
+/// Dynamic array base class, storing a heap object if the given heap type is non-empty.
 template <class Element, class Heap>
-struct dynamic_array_base : public noncopyable
+struct dynamic_array_base : public allocator_aware_base<Heap>
 {
 	/// Type of the heap used by this vector.
 	typedef Heap heap_type;
@@ -35,11 +35,13 @@ struct dynamic_array_base : public noncopyable
 	/// One past the last element in the array.
 	value_type *m_elementsEnd;
 
+	typedef allocator_aware_base<Heap> heap_base;
+
 	/// Allocates the given number of elements.
-	static LEAN_INLINE value_type* allocate(size_type capacity)
+	LEAN_INLINE value_type* allocate(size_type capacity)
 	{
 		return (capacity > 0)
-			? static_cast<value_type*>( heap_type::allocate(capacity * sizeof(value_type)) )
+			? static_cast<value_type*>( this->allocator().allocate(capacity * sizeof(value_type)) )
 			: nullptr;
 	}
 	
@@ -51,7 +53,7 @@ struct dynamic_array_base : public noncopyable
 			value_type *oldElements = m_elements;
 			m_elements = nullptr;
 			m_elementsEnd = nullptr;
-			heap_type::free(oldElements);
+			this->allocator().free(oldElements);
 		}
 	}
 
@@ -63,10 +65,21 @@ struct dynamic_array_base : public noncopyable
 	LEAN_INLINE explicit dynamic_array_base(size_type capacity)
 		: m_elements( allocate(capacity) ),
 		m_elementsEnd( m_elements ) { }
+	/// Constructs an empty vector allocating from the given heap.
+	LEAN_INLINE explicit dynamic_array_base(const heap_type &heap)
+		: heap_base(heap),
+		m_elements(nullptr),
+		m_elementsEnd(nullptr) { }
+	/// Constructs an empty vector allocating from the given heap.
+	LEAN_INLINE dynamic_array_base(size_type capacity, const heap_type &heap)
+		: heap_base(heap),
+		m_elements( allocate(capacity) ),
+		m_elementsEnd( m_elements ) { }
 #ifndef LEAN0X_NO_RVALUE_REFERENCES
 	/// Moves all elements from the given vector to this vector.
 	LEAN_INLINE dynamic_array_base(dynamic_array_base &&right) throw()
-		: m_elements(right.m_elements),
+		: heap_base(std::move(right)),
+		m_elements(right.m_elements),
 		m_elementsEnd(right.m_elementsEnd)
 	{
 		right.m_elements = nullptr;
@@ -75,7 +88,8 @@ struct dynamic_array_base : public noncopyable
 #endif
 	/// Moves all elements from the given vector to this vector.
 	LEAN_INLINE dynamic_array_base(dynamic_array_base &right, consume_t) throw()
-		: m_elements(right.m_elements),
+		: heap_base(right),
+		m_elements(right.m_elements),
 		m_elementsEnd(right.m_elementsEnd)
 	{
 		right.m_elements = nullptr;
@@ -85,7 +99,7 @@ struct dynamic_array_base : public noncopyable
 	LEAN_INLINE ~dynamic_array_base()
 	{
 		if (m_elements)
-			heap_type::free(m_elements);
+			this->allocator().free(m_elements);
 	}
 
 	/// Moves all elements from the given vector to this vector.
@@ -100,6 +114,9 @@ struct dynamic_array_base : public noncopyable
 
 			right.m_elements = nullptr;
 			right.m_elementsEnd = nullptr;
+
+			// Elements need to be freed by the heap that allocated them
+			static_cast<heap_base&>(*this) = static_cast<heap_base&>(right);
 		}
 	}
 
@@ -124,7 +141,12 @@ struct dynamic_array_base : public noncopyable
 
 		swap(m_elements, right.m_elements);
 		swap(m_elementsEnd, right.m_elementsEnd);
+		this->heap_base::swap(right);
 	}
+
+private:
+	dynamic_array_base(const dynamic_array_base&);
+	dynamic_array_base& operator =(const dynamic_array_base&);
 };
 
 /// Dynamic array class.
@@ -175,9 +197,15 @@ public:
 	/// Constructs an empty vector.
 	explicit dynamic_array(size_type capacity)
 		: base_type(capacity) { }
+	/// Constructs an empty vector allocating from the given heap.
+	explicit dynamic_array(const heap_type &heap)
+		: base_type(heap) { }
+	/// Constructs an empty vector allocating from the given heap.
+	dynamic_array(size_type capacity, const heap_type &heap)
+		: base_type(capacity, heap) { }
 	/// Copies all elements from the given vector to this vector.
 	dynamic_array(const dynamic_array &right)
-		: base_type(right.size())
+		: base_type(right.size(), right.allocator())
 	{
 		m_elementsEnd = containers::copy_construct(right.m_elements, right.m_elementsEnd, m_elements, no_allocator);
 	}
@@ -375,6 +403,9 @@ public:
 	/// Returns the number of elements contained by this vector.
 	LEAN_INLINE size_type size(void) const { return m_elementsEnd - m_elements; };
 
+	/// Gets a copy of the heap used by this vector.
+	LEAN_INLINE heap_type get_heap() const { return this->allocator(); };
+
 	/// Swaps the contents of this vector and the given vector.
 	LEAN_INLINE void swap(dynamic_array &right) noexcept
 	{
@@ -0,0 +1,371 @@
+/*****************************************************/
+/* lean Containers              (c) Tobias Zirr 2011 */
+/*****************************************************/
+
+#pragma once
+#ifndef LEAN_CONTAINERS_MPMC_QUEUE
+#define LEAN_CONTAINERS_MPMC_QUEUE
+
+#include "../lean.h"
+#include "../memory/default_heap.h"
+#include "../tags/noncopyable.h"
+#include "../concurrent/atomic.h"
+#include "../concurrent/semaphore.h"
+#include <new>
+
+namespace lean
+{
+namespace containers
+{
+
+/// Bounded lock-free multi-producer / multi-consumer queue. Each slot carries a sequence number
+/// telling producers and consumers which lap of the ring buffer it is currently available for.
+template < class Element, class Heap = default_heap >
+class mpmc_queue : public noncopyable
+{
+public:
+	/// Type of the heap used by this queue.
+	typedef Heap heap_type;
+	/// Type of the size returned by this queue.
+	typedef typename heap_type::size_type size_type;
+
+	/// Type of the elements contained by this queue.
+	typedef Element value_type;
+	/// Type of references to the elements contained by this queue.
+	typedef value_type& reference;
+	/// Type of constant references to the elements contained by this queue.
+	typedef const value_type& const_reference;
+
+	/// Size of the padding separating producer and consumer state.
+	static const size_t cache_line_size = 64;
+
+private:
+	struct cell
+	{
+		volatile long sequence;
+		value_type value;
+
+		cell(long sequence)
+			: sequence(sequence) { }
+	};
+
+	char m_padFront[cache_line_size];
+	cell *m_cells;
+	long m_mask;
+	char m_padCells[cache_line_size - sizeof(cell*) - sizeof(long)];
+	volatile long m_enqueuePos;
+	char m_padEnqueue[cache_line_size - sizeof(long)];
+	volatile long m_dequeuePos;
+	char m_padDequeue[cache_line_size - sizeof(long)];
+
+	/// Computes the wrap-around safe signed distance between the given sequence numbers.
+	static LEAN_INLINE long distance(long sequence, long pos)
+	{
+		return static_cast<long>( static_cast<unsigned long>(sequence) - static_cast<unsigned long>(pos) );
+	}
+
+	/// Rounds the given capacity up to the next power of two.
+	static size_type round_capacity(size_type capacity)
+	{
+		size_type rounded = 2;
+		while (rounded < capacity)
+			rounded <<= 1;
+		return rounded;
+	}
+
+	/// Allocates and initializes the given number of cells.
+	static cell* allocate(size_type capacity)
+	{
+		cell *cells = static_cast<cell*>( heap_type::allocate(capacity * sizeof(cell)) );
+		size_type i = 0;
+
+		try
+		{
+			for (; i < capacity; ++i)
+				new( static_cast<void*>(cells + i) ) cell( static_cast<long>(i) );
+		}
+		catch (...)
+		{
+			while (i-- > 0)
+				cells[i].~cell();
+			heap_type::free(cells);
+			throw;
+		}
+
+		return cells;
+	}
+
+	/// Claims a slot for writing, returning nullptr if the queue is full.
+	LEAN_INLINE cell* claim_push(long &pos)
+	{
+		pos = m_enqueuePos;
+
+		for (;;)
+		{
+			cell *slot = m_cells + (pos & m_mask);
+			long dif = distance(atomic_load(slot->sequence, memory_order_acquire), pos);
+
+			if (dif == 0)
+			{
+				if (atomic_test_and_set(m_enqueuePos, pos, pos + 1))
+					return slot;
+			}
+			else if (dif < 0)
+				return nullptr;
+
+			pos = m_enqueuePos;
+		}
+	}
+
+	/// Publishes the given slot to consumers.
+	LEAN_INLINE void commit_push(cell *slot, long pos)
+	{
+		// Full barrier, callers may check for waiting consumers right after publishing
+		atomic_set(slot->sequence, pos + 1);
+	}
+
+	/// Claims a slot for reading, returning nullptr if the queue is empty.
+	LEAN_INLINE cell* claim_pop(long &pos)
+	{
+		pos = m_dequeuePos;
+
+		for (;;)
+		{
+			cell *slot = m_cells + (pos & m_mask);
+			long dif = distance(atomic_load(slot->sequence, memory_order_acquire), pos + 1);
+
+			if (dif == 0)
+			{
+				if (atomic_test_and_set(m_dequeuePos, pos, pos + 1))
+					return slot;
+			}
+			else if (dif < 0)
+				return nullptr;
+
+			pos = m_dequeuePos;
+		}
+	}
+
+	/// Hands the given slot back to producers.
+	LEAN_INLINE void commit_pop(cell *slot, long pos)
+	{
+		atomic_store(slot->sequence, pos + m_mask + 1, memory_order_release);
+	}
+
+	/// Claims up to the given number of consecutive slots whose sequence numbers are offset from their
+	/// positions by the given lap offset, returning the number of slots claimed.
+	LEAN_INLINE size_type claim_n(volatile long &position, long lapOffset, size_type count, long &pos)
+	{
+		pos = position;
+
+		for (;;)
+		{
+			long claimed = 0;
+			long dif = 0;
+
+			for (; static_cast<size_type>(claimed) < count && claimed <= m_mask; ++claimed)
+			{
+				dif = distance(atomic_load(m_cells[(pos + claimed) & m_mask].sequence, memory_order_acquire), pos + claimed + lapOffset);
+
+				if (dif != 0)
+					break;
+			}
+
+			if (claimed > 0)
+			{
+				if (atomic_test_and_set(position, pos, pos + claimed))
+					return static_cast<size_type>(claimed);
+			}
+			else if (dif < 0)
+				return 0;
+
+			pos = position;
+		}
+	}
+
+public:
+	/// Constructs an empty queue holding at least the given number of elements (rounded up to the next power of two).
+	explicit mpmc_queue(size_type capacity)
+		: m_cells( allocate(round_capacity(capacity)) ),
+		m_mask( static_cast<long>(round_capacity(capacity) - 1) ),
+		m_enqueuePos(0),
+		m_dequeuePos(0)
+	{
+		LEAN_ASSERT(capacity <= (static_cast<size_type>(1) << (sizeof(long) * 8 - 2)));
+	}
+	/// Destroys all elements remaining in this queue.
+	~mpmc_queue()
+	{
+		for (long i = 0; i <= m_mask; ++i)
+			m_cells[i].~cell();
+		heap_type::free(m_cells);
+	}
+
+	/// Appends the given element to this queue, returning false if the queue is full.
+	LEAN_INLINE bool try_push(const value_type &value)
+	{
+		long pos;
+		cell *slot = claim_push(pos);
+
+		if (slot)
+		{
+			slot->value = value;
+			commit_push(slot, pos);
+		}
+
+		return (slot != nullptr);
+	}
+#ifndef LEAN0X_NO_RVALUE_REFERENCES
+	/// Appends the given element to this queue, returning false if the queue is full.
+	LEAN_INLINE bool try_push(value_type &&value)
+	{
+		long pos;
+		cell *slot = claim_push(pos);
+
+		if (slot)
+		{
+			slot->value = LEAN_MOVE(value);
+			commit_push(slot, pos);
+		}
+
+		return (slot != nullptr);
+	}
+#endif
+	/// Removes the first element from this queue, returning false if the queue is empty.
+	LEAN_INLINE bool try_pop(value_type &value)
+	{
+		long pos;
+		cell *slot = claim_pop(pos);
+
+		if (slot)
+		{
+			value = LEAN_MOVE(slot->value);
+			commit_pop(slot, pos);
+		}
+
+		return (slot != nullptr);
+	}
+
+	/// Appends as many of the given elements as currently fit into this queue using one atomic operation,
+	/// returning the number of elements appended.
+	template <class Iterator>
+	size_type try_push_n(Iterator values, size_type count)
+	{
+		long pos;
+		size_type claimed = claim_n(m_enqueuePos, 0, count, pos);
+
+		for (size_type i = 0; i < claimed; ++i, ++values)
+		{
+			cell &slot = m_cells[(pos + static_cast<long>(i)) & m_mask];
+			slot.value = *values;
+			commit_push(&slot, pos + static_cast<long>(i));
+		}
+
+		return claimed;
+	}
+	/// Removes up to the given number of elements from this queue using one atomic operation,
+	/// returning the number of elements removed.
+	template <class Iterator>
+	size_type try_pop_n(Iterator values, size_type count)
+	{
+		long pos;
+		size_type claimed = claim_n(m_dequeuePos, 1, count, pos);
+
+		for (size_type i = 0; i < claimed; ++i, ++values)
+		{
+			cell &slot = m_cells[(pos + static_cast<long>(i)) & m_mask];
+			*values = LEAN_MOVE(slot.value);
+			commit_pop(&slot, pos + static_cast<long>(i));
+		}
+
+		return claimed;
+	}
+
+	/// Returns true if the queue is empty. Only a snapshot when accessed concurrently.
+	LEAN_INLINE bool empty() const { return (size() == 0); }
+	/// Returns the number of elements contained by this queue. Only a snapshot when accessed concurrently.
+	LEAN_INLINE size_type size() const
+	{
+		long dif = distance(m_enqueuePos, m_dequeuePos);
+		return (dif > 0) ? static_cast<size_type>(dif) : 0;
+	}
+	/// Returns the number of elements this queue can hold.
+	LEAN_INLINE size_type capacity() const { return static_cast<size_type>(m_mask) + 1; }
+};
+
+/// Bounded multi-producer / multi-consumer queue that puts producers to sleep while full and consumers to sleep while empty.
+template < class Element, class Heap = default_heap >
+class blocking_mpmc_queue : public noncopyable
+{
+public:
+	/// Type of the wrapped non-blocking queue.
+	typedef mpmc_queue<Element, Heap> queue_type;
+	/// Type of the size returned by this queue.
+	typedef typename queue_type::size_type size_type;
+	/// Type of the elements contained by this queue.
+	typedef typename queue_type::value_type value_type;
+
+private:
+	queue_type m_queue;
+	semaphore m_freeSlots;
+	semaphore m_usedSlots;
+
+public:
+	/// Constructs an empty queue holding at least the given number of elements (rounded up to the next power of two).
+	explicit blocking_mpmc_queue(size_type capacity)
+		: m_queue(capacity),
+		m_freeSlots( static_cast<long>(m_queue.capacity()) ),
+		m_usedSlots(0) { }
+
+	/// Appends the given element to this queue, waiting for a free slot if the queue is full.
+	void push(const value_type &value)
+	{
+		m_freeSlots.lock();
+		// Slot might still be drained by a consumer that has not yet returned
+		while (!m_queue.try_push(value));
+		m_usedSlots.unlock();
+	}
+	/// Removes the first element from this queue, waiting for an element if the queue is empty.
+	void pop(value_type &value)
+	{
+		m_usedSlots.lock();
+		// Element might still be written by a producer that has not yet returned
+		while (!m_queue.try_pop(value));
+		m_freeSlots.unlock();
+	}
+
+	/// Appends the given element to this queue, returning false if the queue is full.
+	bool try_push(const value_type &value)
+	{
+		if (!m_freeSlots.try_lock())
+			return false;
+		while (!m_queue.try_push(value));
+		m_usedSlots.unlock();
+		return true;
+	}
+	/// Removes the first element from this queue, returning false if the queue is empty.
+	bool try_pop(value_type &value)
+	{
+		if (!m_usedSlots.try_lock())
+			return false;
+		while (!m_queue.try_pop(value));
+		m_freeSlots.unlock();
+		return true;
+	}
+
+	/// Returns true if the queue is empty. Only a snapshot when accessed concurrently.
+	LEAN_INLINE bool empty() const { return m_queue.empty(); }
+	/// Returns the number of elements contained by this queue. Only a snapshot when accessed concurrently.
+	LEAN_INLINE size_type size() const { return m_queue.size(); }
+	/// Returns the number of elements this queue can hold.
+	LEAN_INLINE size_type capacity() const { return m_queue.capacity(); }
+};
+
+} // namespace
+
+using containers::mpmc_queue;
+using containers::blocking_mpmc_queue;
+
+} // namespace
+
+#endif
\ No newline at end of file
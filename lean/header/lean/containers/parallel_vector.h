@@ -208,7 +208,7 @@ private:
 		size_type newCapacity = v.capacity();
 
 		if (newCapacity > oldCapacity)
-			this->Base::reallocate(newCapacity, v.get_allocator(), v.size(), v.capacity());
+			this->Base::reallocate(newCapacity, v.get_allocator(), v.size(), oldCapacity);
 	}
 
 public:
@@ -323,7 +323,7 @@ public:
 		size_type newCapacity = v.capacity();
 
 		if (newCapacity > oldCapacity)
-			this->Base::reallocate(newCapacity, v.get_allocator(), v.size(), v.capacity());
+			this->Base::reallocate(newCapacity, v.get_allocator(), v.size(), oldCapacity);
 
 		size_type oldSize = v.size();
 		v.resize(size);
@@ -337,7 +337,7 @@ public:
 		size_type newCapacity = v.capacity();
 
 		if (newCapacity > oldCapacity)
-			this->Base::reallocate(newCapacity, v.get_allocator(), v.size(), v.capacity());
+			this->Base::reallocate(newCapacity, v.get_allocator(), v.size(), oldCapacity);
 	}
 
 	LEAN_INLINE size_type size() const { return v.size(); }
@@ -11,6 +11,7 @@
 #include "../smart/terminate_guard.h"
 #include "../tags/noncopyable.h"
 #include "../functional/hashing.h"
+#include "allocator_aware.h"
 #include "../meta/type_traits.h"
 #include <memory>
 #include <utility>
@@ -140,8 +141,9 @@ protected:
 	typedef typename Allocator::template rebind<value_type_>::other allocator_type_;
 	allocator_type_ m_allocator;
 
-	value_type_ *m_elements;
-	value_type_ *m_elementsEnd;
+	typedef typename stored_pointer<allocator_type_>::type stored_pointer_;
+	stored_pointer_ m_elements;
+	stored_pointer_ m_elementsEnd;
 
 	typedef typename allocator_type_::size_type size_type_;
 	size_type_ m_count;
@@ -835,6 +837,12 @@ public:
 	{
 		LEAN_ASSERT(key_valid(KeyValues::end_key));
 	}
+	/// Constructs an empty hash map allocating from the given allocator.
+	explicit simple_hash_map(const allocator_type &allocator)
+		: base_type(0.75f, allocator)
+	{
+		LEAN_ASSERT(key_valid(KeyValues::end_key));
+	}
 	/// Constructs an empty hash map.
 	explicit simple_hash_map(size_type capacity, float maxLoadFactor = 0.75f)
 		: base_type(maxLoadFactor)
@@ -932,15 +940,24 @@ public:
 	{
 		if (&right != this)
 		{
+			// Free using the old allocator
 			free();
 
 			m_elements = std::move(right.m_elements);
 			m_elementsEnd = std::move(right.m_elementsEnd);
+			m_count = std::move(right.m_count);
+			m_capacity = std::move(right.m_capacity);
+			m_maxLoadFactor = std::move(right.m_maxLoadFactor);
 
 			right.m_elements = nullptr;
 			right.m_elementsEnd = nullptr;
+			right.m_count = 0;
+			right.m_capacity = 0;
 
+			// Elements need to be freed by the allocator that allocated them
 			m_allocator = std::move(right.m_allocator);
+			m_hasher = std::move(right.m_hasher);
+			m_keyEqual = std::move(right.m_keyEqual);
 		}
 		return *this;
 	}
@@ -1172,8 +1189,9 @@ public:
 };
 
 /// Swaps the contents of the given hash maps.
-template <class Element, class Policy, class Allocator>
-LEAN_INLINE void swap(simple_hash_map<Element, Policy, Allocator> &left, simple_hash_map<Element, Policy, Allocator> &right) noexcept
+template <class Key, class Element, class Policy, class Hash, class KeyValues, class Pred, class Allocator>
+LEAN_INLINE void swap(simple_hash_map<Key, Element, Policy, Hash, KeyValues, Pred, Allocator> &left,
+					  simple_hash_map<Key, Element, Policy, Hash, KeyValues, Pred, Allocator> &right) noexcept
 {
 	left.swap(right);
 }
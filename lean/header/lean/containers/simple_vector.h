@@ -58,9 +58,10 @@ public:
 	typedef const_pointer const_iterator;
 
 private:
-	Element *m_elements;
-	Element *m_elementsEnd;
-	Element *m_capacityEnd;
+	typedef typename stored_pointer<allocator_type>::type stored_pointer_;
+	stored_pointer_ m_elements;
+	stored_pointer_ m_elementsEnd;
+	stored_pointer_ m_capacityEnd;
 
 	// Make sure size_type is unsigned
 	LEAN_STATIC_ASSERT(is_unsigned<size_type>::value);
@@ -414,6 +415,15 @@ public:
 
 		return *m_elementsEnd++;
 	}
+	/// Marks the given number of elements following the last element as constructed.
+	LEAN_INLINE pointer shift_back_n(size_type count)
+	{
+		LEAN_ASSERT(count <= static_cast<size_type>(m_capacityEnd - m_elementsEnd));
+
+		pointer firstElement = m_elementsEnd;
+		m_elementsEnd += count;
+		return firstElement;
+	}
 
 	/// Appends a default-constructed element to this vector.
 	LEAN_INLINE reference push_back()
@@ -737,15 +747,15 @@ LEAN_INLINE void swap(simple_vector<Element, Policy, Allocator> &left, simple_ve
 	left.swap(right);
 }
 
-/// Default vector binder.
-template <class Policy = vector_policies::nonpod>
+/// Default vector binder, rebinding the given allocator to each element type.
+template <class Policy = vector_policies::nonpod, class Allocator = heap_allocator<void> >
 struct simple_vector_binder
 {
 	/// Constructs a vector type from the given element type.
 	template <class Type>
 	struct rebind
 	{
-		typedef heap_allocator<Type> allocator_type;
+		typedef typename Allocator::template rebind<Type>::other allocator_type;
 		typedef Policy policy;
 		typedef simple_vector<Type, policy, allocator_type> type;
 	};
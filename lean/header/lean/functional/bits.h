@@ -59,6 +59,20 @@ LEAN_INLINE unsigned long first_bit_high(unsigned long mask)
 	return _BitScanReverse(&idx, mask) ? idx : 32;
 }
 
+#else
+
+/// Gets the position of the first set low bit.
+LEAN_INLINE unsigned long first_bit_low(unsigned long mask)
+{
+	return (mask) ? __builtin_ctzl(mask) : sizeof(unsigned long) * CHAR_BIT;
+}
+
+/// Gets the position of the first set high bit.
+LEAN_INLINE unsigned long first_bit_high(unsigned long mask)
+{
+	return (mask) ? sizeof(unsigned long) * CHAR_BIT - 1 - __builtin_clzl(mask) : sizeof(unsigned long) * CHAR_BIT;
+}
+
 #endif
 
 } // namespace
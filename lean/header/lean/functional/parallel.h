@@ -0,0 +1,582 @@
+/*****************************************************/
+/* lean Functional              (c) Tobias Zirr 2011 */
+/*****************************************************/
+
+#pragma once
+#ifndef LEAN_FUNCTIONAL_PARALLEL
+#define LEAN_FUNCTIONAL_PARALLEL
+
+#include "../lean.h"
+#include "../strings/range.h"
+#include "../concurrent/task_scheduler.h"
+#include "../tags/noncopyable.h"
+#include "../containers/construction.h"
+#include "../memory/default_heap.h"
+#include <iterator>
+#include <functional>
+#include <algorithm>
+#include <cstring>
+
+namespace lean
+{
+namespace functional
+{
+
+namespace impl
+{
+
+//// For ////
+
+/// Parallel for context shared by all tasks.
+template <class Index, class Difference, class Body>
+struct parallel_for_context
+{
+	task_scheduler *scheduler;
+	Difference grain;
+	const Body *body;
+};
+
+template <class Index, class Difference, class Body>
+void parallel_for(const parallel_for_context<Index, Difference, Body> &context, Index begin, Index end);
+
+/// Runs a parallel for over a sub-range.
+template <class Index, class Difference, class Body>
+struct parallel_for_task
+{
+	const parallel_for_context<Index, Difference, Body> *context;
+	Index begin, end;
+
+	void operator ()() const { parallel_for(*context, begin, end); }
+};
+
+/// Splits the given range until reaching the grain size, running the body on each index.
+template <class Index, class Difference, class Body>
+void parallel_for(const parallel_for_context<Index, Difference, Body> &context, Index begin, Index end)
+{
+	task_group group;
+
+	// Hand off upper halves, keep lower halves
+	while (static_cast<Difference>(end - begin) > context.grain)
+	{
+		Index middle = begin + (end - begin) / 2;
+		parallel_for_task<Index, Difference, Body> task = { &context, middle, end };
+		context.scheduler->spawn(group, task);
+		end = middle;
+	}
+
+	for (; begin < end; ++begin)
+		(*context.body)(begin);
+
+	context.scheduler->wait(group);
+}
+
+/// Flags chunks whose construction failed.
+class chunk_failures : public noncopyable
+{
+private:
+	bool *m_failed;
+
+public:
+	/// Allocates cleared flags for the given number of chunks.
+	explicit chunk_failures(size_t count)
+		: m_failed( static_cast<bool*>( default_heap::allocate(count) ) )
+	{
+		memset(m_failed, 0, count);
+	}
+	/// Frees all flags.
+	~chunk_failures()
+	{
+		default_heap::free(m_failed);
+	}
+
+	/// Gets the flags.
+	LEAN_INLINE bool* data() { return m_failed; }
+};
+
+/// Default-constructs one chunk of elements.
+template <class Element, class ConstructTag, class DestructTag>
+struct first_touch_body
+{
+	Element *elements;
+	size_t count;
+	size_t grain;
+	bool *failed;
+
+	/// Default-constructs the elements of the given chunk, destructing all of them on failure.
+	void construct(size_t chunk) const
+	{
+		size_t begin = chunk * grain;
+		size_t end = (count - begin > grain) ? begin + grain : count;
+		containers::default_construct(elements + begin, elements + end, containers::no_allocator, ConstructTag());
+	}
+	/// Destructs the elements of the given chunk.
+	void destruct(size_t chunk) const
+	{
+		size_t begin = chunk * grain;
+		size_t end = (count - begin > grain) ? begin + grain : count;
+		containers::destruct(elements + begin, elements + end, containers::no_allocator, DestructTag());
+	}
+
+	void operator ()(size_t chunk) const
+	{
+		// Exceptions cannot cross tasks, flag failed chunks instead
+		try
+		{
+			construct(chunk);
+		}
+		catch (...)
+		{
+			failed[chunk] = true;
+		}
+	}
+};
+
+/// Dereferences iterators passed to the wrapped body.
+template <class Iterator, class Body>
+struct deref_body
+{
+	const Body *body;
+
+	LEAN_INLINE void operator ()(Iterator it) const { (*body)(*it); }
+};
+
+/// Transforms single elements.
+template <class Iterator, class DestIterator, class Function>
+struct transform_body
+{
+	Iterator begin;
+	DestIterator dest;
+	const Function *fun;
+
+	LEAN_INLINE void operator ()(Iterator it) const { dest[it - begin] = (*fun)(*it); }
+};
+
+//// Reduce ////
+
+/// Parallel reduce context shared by all tasks.
+template <class Iterator, class Value, class Reduce, class Combine>
+struct parallel_reduce_context
+{
+	task_scheduler *scheduler;
+	typename std::iterator_traits<Iterator>::difference_type grain;
+	const Value *identity;
+	const Reduce *reduce;
+	const Combine *combine;
+};
+
+template <class Iterator, class Value, class Reduce, class Combine>
+Value parallel_reduce(const parallel_reduce_context<Iterator, Value, Reduce, Combine> &context, Iterator begin, Iterator end);
+
+/// Reduces a sub-range.
+template <class Iterator, class Value, class Reduce, class Combine>
+struct parallel_reduce_task
+{
+	const parallel_reduce_context<Iterator, Value, Reduce, Combine> *context;
+	Iterator begin, end;
+	Value *result;
+
+	void operator ()() const { *result = parallel_reduce(*context, begin, end); }
+};
+
+/// Splits the given range until reaching the grain size, combining partial results.
+template <class Iterator, class Value, class Reduce, class Combine>
+Value parallel_reduce(const parallel_reduce_context<Iterator, Value, Reduce, Combine> &context, Iterator begin, Iterator end)
+{
+	if (end - begin <= context.grain)
+	{
+		Value result(*context.identity);
+
+		for (; begin != end; ++begin)
+			result = (*context.reduce)(result, *begin);
+
+		return result;
+	}
+	else
+	{
+		Iterator middle = begin + (end - begin) / 2;
+
+		task_group group;
+		Value right(*context.identity);
+		parallel_reduce_task<Iterator, Value, Reduce, Combine> task = { &context, middle, end, &right };
+		context.scheduler->spawn(group, task);
+
+		Value left = parallel_reduce(context, begin, middle);
+		context.scheduler->wait(group);
+
+		return (*context.combine)(left, right);
+	}
+}
+
+//// Sort ////
+
+/// Parallel sort context shared by all tasks.
+template <class Iterator, class Pointer, class Predicate>
+struct parallel_sort_context
+{
+	task_scheduler *scheduler;
+	typename std::iterator_traits<Iterator>::difference_type grain;
+	const Predicate *pred;
+	Iterator begin;
+	Pointer buffer;
+};
+
+/// Scratch storage for parallel sorting, holding the elements moved out of the range to be sorted.
+template <class Element, class Heap = default_heap>
+class parallel_sort_buffer : public noncopyable
+{
+private:
+	Element *m_begin;
+	Element *m_end;
+
+public:
+	/// Moves the given range into newly allocated scratch storage.
+	template <class Iterator>
+	parallel_sort_buffer(Iterator begin, Iterator end)
+		: m_begin( static_cast<Element*>( Heap::allocate(sizeof(Element) * (end - begin)) ) )
+	{
+		try
+		{
+			m_end = containers::move_construct(begin, end, m_begin, containers::no_allocator);
+		}
+		catch (...)
+		{
+			Heap::free(m_begin);
+			throw;
+		}
+	}
+	/// Destructs all elements & frees the scratch storage.
+	~parallel_sort_buffer()
+	{
+		containers::destruct(m_begin, m_end, containers::no_allocator);
+		Heap::free(m_begin);
+	}
+
+	/// Gets the first element.
+	LEAN_INLINE Element* data() { return m_begin; }
+};
+
+/// Merges two sorted ranges, moving elements.
+template <class Iterator1, class Iterator2, class DestIterator, class Predicate>
+void merge_move(Iterator1 begin1, Iterator1 end1, Iterator2 begin2, Iterator2 end2, DestIterator dest, const Predicate &pred)
+{
+	while (begin1 != end1 && begin2 != end2)
+		*dest++ = (pred(*begin2, *begin1))
+			? LEAN_MOVE(*begin2++)
+			: LEAN_MOVE(*begin1++);
+
+	for (; begin1 != end1; ++begin1)
+		*dest++ = LEAN_MOVE(*begin1);
+	for (; begin2 != end2; ++begin2)
+		*dest++ = LEAN_MOVE(*begin2);
+}
+
+template <class SrcIterator, class DestIterator, class Context>
+void parallel_merge(const Context &context, SrcIterator begin1, SrcIterator end1, SrcIterator begin2, SrcIterator end2, DestIterator dest);
+
+/// Merges two sorted sub-ranges.
+template <class SrcIterator, class DestIterator, class Context>
+struct parallel_merge_task
+{
+	const Context *context;
+	SrcIterator begin1, end1, begin2, end2;
+	DestIterator dest;
+
+	void operator ()() const { parallel_merge(*context, begin1, end1, begin2, end2, dest); }
+};
+
+/// Merges two sorted ranges by recursively splitting the larger range at its median.
+template <class SrcIterator, class DestIterator, class Context>
+void parallel_merge(const Context &context, SrcIterator begin1, SrcIterator end1, SrcIterator begin2, SrcIterator end2, DestIterator dest)
+{
+	if (end1 - begin1 < end2 - begin2)
+	{
+		std::swap(begin1, begin2);
+		std::swap(end1, end2);
+	}
+
+	if ((end1 - begin1) + (end2 - begin2) <= context.grain)
+		merge_move(begin1, end1, begin2, end2, dest, *context.pred);
+	else
+	{
+		SrcIterator middle1 = begin1 + (end1 - begin1) / 2;
+		SrcIterator middle2 = std::lower_bound(begin2, end2, *middle1, *context.pred);
+		DestIterator middleDest = dest + (middle1 - begin1) + (middle2 - begin2);
+
+		task_group group;
+		parallel_merge_task<SrcIterator, DestIterator, Context> task = { &context, begin1, middle1, begin2, middle2, dest };
+		context.scheduler->spawn(group, task);
+
+		*middleDest = LEAN_MOVE(*middle1);
+		parallel_merge(context, middle1 + 1, end1, middle2, end2, middleDest + 1);
+
+		context.scheduler->wait(group);
+	}
+}
+
+template <class Iterator, class Pointer, class Predicate>
+void parallel_sort(const parallel_sort_context<Iterator, Pointer, Predicate> &context,
+	typename std::iterator_traits<Iterator>::difference_type offset,
+	typename std::iterator_traits<Iterator>::difference_type count,
+	bool toBuffer);
+
+/// Sorts a sub-range.
+template <class Iterator, class Pointer, class Predicate>
+struct parallel_sort_task
+{
+	typedef typename std::iterator_traits<Iterator>::difference_type difference_type;
+
+	const parallel_sort_context<Iterator, Pointer, Predicate> *context;
+	difference_type offset, count;
+	bool toBuffer;
+
+	void operator ()() const { parallel_sort(*context, offset, count, toBuffer); }
+};
+
+/// Sorts both halves of the given range in parallel, merging them into the buffer if requested, otherwise back into the range.
+template <class Iterator, class Pointer, class Predicate>
+void parallel_sort(const parallel_sort_context<Iterator, Pointer, Predicate> &context,
+	typename std::iterator_traits<Iterator>::difference_type offset,
+	typename std::iterator_traits<Iterator>::difference_type count,
+	bool toBuffer)
+{
+	Iterator begin = context.begin + offset;
+	Pointer buffer = context.buffer + offset;
+
+	if (count <= context.grain)
+	{
+		std::sort(begin, begin + count, *context.pred);
+
+		if (toBuffer)
+			for (Iterator it = begin, itEnd = begin + count; it != itEnd; ++it)
+				*buffer++ = LEAN_MOVE(*it);
+	}
+	else
+	{
+		typename std::iterator_traits<Iterator>::difference_type half = count / 2;
+
+		// Sort halves into the opposite storage, merge back into the requested storage
+		task_group group;
+		parallel_sort_task<Iterator, Pointer, Predicate> task = { &context, offset, half, !toBuffer };
+		context.scheduler->spawn(group, task);
+		parallel_sort(context, offset + half, count - half, !toBuffer);
+		context.scheduler->wait(group);
+
+		if (toBuffer)
+			parallel_merge(context, begin, begin + half, begin + half, begin + count, buffer);
+		else
+			parallel_merge(context, buffer, buffer + half, buffer + half, buffer + count, begin);
+	}
+}
+
+} // namespace
+
+/// Calls the given body for each index in [begin, end), splitting the range into chunks of at least the given grain size.
+template <class Index, class Body>
+inline void parallel_for(task_scheduler &scheduler, Index begin, Index end, typename identity<Index>::type grain, const Body &body)
+{
+	impl::parallel_for_context<Index, Index, Body> context = { &scheduler, (grain > 0) ? grain : 1, &body };
+	impl::parallel_for(context, begin, end);
+}
+/// Calls the given body for each index in [begin, end), splitting the range into chunks of at least the given grain size.
+template <class Index, class Body>
+LEAN_INLINE void parallel_for(Index begin, Index end, typename identity<Index>::type grain, const Body &body)
+{
+	parallel_for(default_task_scheduler(), begin, end, grain, body);
+}
+
+/// Grows the given vector to the given size, default-constructing new elements in parallel chunks of the given grain size.
+/// Each page is first touched by the worker constructing the elements it holds, placing it on that worker's NUMA node.
+/// Parallel passes over the vector with matching grain size then mostly access memory local to each worker. Call on
+/// empty vectors to avoid elements being first touched sequentially by reallocation. Chunks failing to construct are
+/// retried on the calling thread. If a retry fails as well, all new elements are destructed and the exception is rethrown.
+template <class Vector>
+inline void parallel_first_touch(task_scheduler &scheduler, Vector &vector, typename Vector::size_type size, size_t grain)
+{
+	typedef typename Vector::construction_policy policy;
+	typedef typename Vector::value_type value_type;
+
+	LEAN_STATIC_ASSERT_MSG_ALT(policy::raw_move,
+		"Parallel first touch requires raw-move vectors.",
+		Parallel_first_touch_requires_raw_move_vectors);
+
+	if (size <= vector.size())
+		return;
+
+	// Large allocations are mapped directly, remaining untouched until construction
+	vector.reserve(size);
+
+	size_t count = size - vector.size();
+	grain = (grain > 0) ? grain : 1;
+	size_t chunkCount = (count + grain - 1) / grain;
+
+	impl::chunk_failures failures(chunkCount);
+	const bool *failed = failures.data();
+
+	impl::first_touch_body<value_type, typename policy::construct_tag, typename policy::destruct_tag> body = { vector.data() + vector.size(), count, grain, failures.data() };
+	parallel_for(scheduler, static_cast<size_t>(0), chunkCount, 1, body);
+
+	size_t chunk = 0;
+
+	try
+	{
+		for (; chunk < chunkCount; ++chunk)
+			if (failed[chunk])
+				body.construct(chunk);
+	}
+	catch (...)
+	{
+		// Failed chunk already cleaned up, destruct all other constructed chunks
+		for (size_t i = 0; i < chunkCount; ++i)
+			if (!failed[i] || i < chunk)
+				body.destruct(i);
+
+		throw;
+	}
+
+	vector.shift_back_n(count);
+}
+/// Grows the given vector to the given size, default-constructing new elements in parallel chunks of the given grain size.
+/// Each page is first touched by the worker constructing the elements it holds, placing it on that worker's NUMA node.
+template <class Vector>
+LEAN_INLINE void parallel_first_touch(Vector &vector, typename Vector::size_type size, size_t grain)
+{
+	parallel_first_touch(default_task_scheduler(), vector, size, grain);
+}
+
+/// Calls the given body for each element in [begin, end), splitting the range into chunks of at least the given grain size.
+template <class Iterator, class Body>
+inline void parallel_for_each(task_scheduler &scheduler, Iterator begin, Iterator end,
+	typename std::iterator_traits<Iterator>::difference_type grain, const Body &body)
+{
+	impl::deref_body<Iterator, Body> derefBody = { &body };
+	impl::parallel_for_context< Iterator, typename std::iterator_traits<Iterator>::difference_type, impl::deref_body<Iterator, Body> > context = { &scheduler, (grain > 0) ? grain : 1, &derefBody };
+	impl::parallel_for(context, begin, end);
+}
+/// Calls the given body for each element in [begin, end), splitting the range into chunks of at least the given grain size.
+template <class Iterator, class Body>
+LEAN_INLINE void parallel_for_each(Iterator begin, Iterator end,
+	typename std::iterator_traits<Iterator>::difference_type grain, const Body &body)
+{
+	parallel_for_each(default_task_scheduler(), begin, end, grain, body);
+}
+/// Calls the given body for each element in the given range, splitting the range into chunks of at least the given grain size.
+template <class Range, class Body>
+LEAN_INLINE typename enable_if_range<Range, void>::type parallel_for_each(Range &range, ptrdiff_t grain, const Body &body)
+{
+	parallel_for_each(default_task_scheduler(), range.begin(), range.end(), grain, body);
+}
+
+/// Stores the results of the given function applied to each element in [begin, end) in the range starting at dest.
+template <class Iterator, class DestIterator, class Function>
+inline void parallel_transform(task_scheduler &scheduler, Iterator begin, Iterator end, DestIterator dest,
+	typename std::iterator_traits<Iterator>::difference_type grain, const Function &fun)
+{
+	impl::transform_body<Iterator, DestIterator, Function> body = { begin, dest, &fun };
+	impl::parallel_for_context< Iterator, typename std::iterator_traits<Iterator>::difference_type, impl::transform_body<Iterator, DestIterator, Function> > context = { &scheduler, (grain > 0) ? grain : 1, &body };
+	impl::parallel_for(context, begin, end);
+}
+/// Stores the results of the given function applied to each element in [begin, end) in the range starting at dest.
+template <class Iterator, class DestIterator, class Function>
+LEAN_INLINE void parallel_transform(Iterator begin, Iterator end, DestIterator dest,
+	typename std::iterator_traits<Iterator>::difference_type grain, const Function &fun)
+{
+	parallel_transform(default_task_scheduler(), begin, end, dest, grain, fun);
+}
+/// Stores the results of the given function applied to each element in the given source range in the given destination range.
+template <class Range, class DestRange, class Function>
+LEAN_INLINE typename enable_if_range2<Range, DestRange, void>::type parallel_transform(const Range &range, DestRange &dest, ptrdiff_t grain, const Function &fun)
+{
+	LEAN_ASSERT(dest.size() >= range.size());
+	parallel_transform(default_task_scheduler(), range.begin(), range.end(), dest.begin(), grain, fun);
+}
+
+/// Reduces the elements in [begin, end) using the given reduction operator, starting with the given identity value in every chunk
+/// and joining partial results of all chunks using the given combination operator.
+template <class Iterator, class Value, class Reduce, class Combine>
+inline Value parallel_reduce(task_scheduler &scheduler, Iterator begin, Iterator end,
+	typename std::iterator_traits<Iterator>::difference_type grain, const Value &identity, const Reduce &reduce, const Combine &combine)
+{
+	impl::parallel_reduce_context<Iterator, Value, Reduce, Combine> context = { &scheduler, (grain > 0) ? grain : 1, &identity, &reduce, &combine };
+	return impl::parallel_reduce(context, begin, end);
+}
+/// Reduces the elements in [begin, end) using the given associative operator, starting with the given identity value in every chunk.
+template <class Iterator, class Value, class Reduce>
+LEAN_INLINE Value parallel_reduce(task_scheduler &scheduler, Iterator begin, Iterator end,
+	typename std::iterator_traits<Iterator>::difference_type grain, const Value &identity, const Reduce &reduce)
+{
+	return parallel_reduce(scheduler, begin, end, grain, identity, reduce, reduce);
+}
+/// Reduces the elements in [begin, end) using the given associative operator, starting with the given identity value in every chunk.
+template <class Iterator, class Value, class Reduce>
+LEAN_INLINE Value parallel_reduce(Iterator begin, Iterator end,
+	typename std::iterator_traits<Iterator>::difference_type grain, const Value &identity, const Reduce &reduce)
+{
+	return parallel_reduce(default_task_scheduler(), begin, end, grain, identity, reduce, reduce);
+}
+/// Reduces the elements in the given range using the given associative operator, starting with the given identity value in every chunk.
+template <class Range, class Value, class Reduce>
+LEAN_INLINE typename enable_if_range<Range, Value>::type parallel_reduce(const Range &range, ptrdiff_t grain, const Value &identity, const Reduce &reduce)
+{
+	return parallel_reduce(default_task_scheduler(), range.begin(), range.end(), grain, identity, reduce, reduce);
+}
+
+/// Sorts the elements in [begin, end) using a parallel merge sort, falling back to std::sort for chunks of the given grain size.
+/// Not stable. Moves the given range into temporary scratch storage.
+template <class Iterator, class Predicate>
+inline void parallel_sort(task_scheduler &scheduler, Iterator begin, Iterator end,
+	typename std::iterator_traits<Iterator>::difference_type grain, const Predicate &pred)
+{
+	typedef typename std::iterator_traits<Iterator>::value_type value_type;
+
+	if (end - begin <= 1)
+		return;
+
+	impl::parallel_sort_buffer<value_type> buffer(begin, end);
+
+	// Sort the moved elements, merging back into the given range
+	impl::parallel_sort_context<value_type*, Iterator, Predicate> context = { &scheduler, (grain > 1) ? grain : 2, &pred, buffer.data(), begin };
+	impl::parallel_sort(context, 0, end - begin, true);
+}
+/// Sorts the elements in [begin, end) using a parallel merge sort, falling back to std::sort for chunks of the given grain size.
+/// Not stable. Moves the given range into temporary scratch storage.
+template <class Iterator, class Predicate>
+LEAN_INLINE void parallel_sort(Iterator begin, Iterator end,
+	typename std::iterator_traits<Iterator>::difference_type grain, const Predicate &pred)
+{
+	parallel_sort(default_task_scheduler(), begin, end, grain, pred);
+}
+/// Sorts the elements in [begin, end) using a parallel merge sort, falling back to std::sort for chunks of the given grain size.
+/// Not stable. Moves the given range into temporary scratch storage.
+template <class Iterator>
+LEAN_INLINE void parallel_sort(Iterator begin, Iterator end,
+	typename std::iterator_traits<Iterator>::difference_type grain)
+{
+	parallel_sort(default_task_scheduler(), begin, end, grain, std::less<typename std::iterator_traits<Iterator>::value_type>());
+}
+/// Sorts the elements in the given range using a parallel merge sort, falling back to std::sort for chunks of the given grain size.
+/// Not stable. Moves the given range into temporary scratch storage.
+template <class Range, class Predicate>
+LEAN_INLINE typename enable_if_range<Range, void>::type parallel_sort(Range &range, ptrdiff_t grain, const Predicate &pred)
+{
+	parallel_sort(default_task_scheduler(), range.begin(), range.end(), grain, pred);
+}
+/// Sorts the elements in the given range using a parallel merge sort, falling back to std::sort for chunks of the given grain size.
+/// Not stable. Moves the given range into temporary scratch storage.
+template <class Range>
+LEAN_INLINE typename enable_if_range<Range, void>::type parallel_sort(Range &range, ptrdiff_t grain)
+{
+	parallel_sort(range.begin(), range.end(), grain);
+}
+
+} // namespace
+
+using functional::parallel_for;
+using functional::parallel_for_each;
+using functional::parallel_first_touch;
+using functional::parallel_transform;
+using functional::parallel_reduce;
+using functional::parallel_sort;
+
+} // namespace
+
+#endif
\ No newline at end of file
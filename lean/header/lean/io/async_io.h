@@ -0,0 +1,178 @@
+/*****************************************************/
+/* lean I/O                     (c) Tobias Zirr 2011 */
+/*****************************************************/
+
+#pragma once
+#ifndef LEAN_LOGGING_IO_ASYNC_IO
+#define LEAN_LOGGING_IO_ASYNC_IO
+
+#include "../lean.h"
+#include "../tags/noncopyable.h"
+#include "raw_file.h"
+
+#ifdef DOXYGEN_READ_THIS
+	/// Define this to disable io_uring, always using the thread pool engine for asynchronous I/O.
+	/// @ingroup AssortedSwitches
+	#define LEAN_NO_IO_URING
+	#undef LEAN_NO_IO_URING
+#endif
+
+namespace lean
+{
+namespace io
+{
+
+/// Asynchronous read or write request. Requests are owned by the caller & need to stay alive until completed.
+struct async_request
+{
+	/// Operations.
+	enum operation_type
+	{
+		read,		///< Reads from the file into the buffer.
+		write		///< Writes the buffer to the file.
+	};
+
+	/// Completion callback, called on the thread processing completions. Required not to throw.
+	typedef void (*callback_type)(async_request &request);
+
+	raw_file *file;				///< File to transfer data from or to.
+	operation_type operation;	///< Operation to perform.
+	uint8 offset;				///< File offset to start the transfer at.
+	char *buffer;				///< Buffer to transfer data from or to.
+	uint4 count;				///< Number of bytes to transfer.
+	int bufferIndex;			///< Index of the registered buffer containing the buffer, -1 if unregistered.
+	callback_type callback;		///< Completion callback, may be nullptr.
+	void *context;				///< User data.
+
+	/// Number of bytes transferred, valid once done. Short transfers are continued by all engines, fewer bytes than
+	/// requested are only transferred at the end of the file or on errors. Errors occurring before any bytes were
+	/// transferred are reported as negative error codes by the io_uring engine, logged & reported as zero by the
+	/// thread pool engine.
+	ptrdiff_t result;
+	/// Nonzero once completed.
+	volatile long completed;
+	/// Next request in internal queues.
+	async_request *next;
+
+	/// Constructs an empty request.
+	async_request()
+		: file(nullptr),
+		operation(read),
+		offset(0),
+		buffer(nullptr),
+		count(0),
+		bufferIndex(-1),
+		callback(nullptr),
+		context(nullptr),
+		result(0),
+		completed(0),
+		next(nullptr) { }
+	/// Constructs a request transferring the given range of bytes.
+	async_request(raw_file &file, operation_type operation, uint8 offset, char *buffer, uint4 count,
+			callback_type callback = nullptr, void *context = nullptr)
+		: file(&file),
+		operation(operation),
+		offset(offset),
+		buffer(buffer),
+		count(count),
+		bufferIndex(-1),
+		callback(callback),
+		context(context),
+		result(0),
+		completed(0),
+		next(nullptr) { }
+
+	/// Checks whether this request has completed.
+	LEAN_INLINE bool done() const { return (completed != 0); }
+};
+
+/// Buffer registered with an asynchronous I/O engine.
+struct async_buffer
+{
+	void *data;		///< Buffer memory.
+	size_t size;	///< Buffer size, in bytes.
+};
+
+namespace impl
+{
+	class async_io_engine;
+}
+
+/// Asynchronous I/O engine submitting batches of reads & writes against raw files. Uses io_uring on Linux,
+/// falling back to a pool of threads issuing positional reads & writes where io_uring is unavailable. Requests
+/// are prepared, then submitted in batches by flush(). Completion callbacks are called by the thread calling
+/// poll() or wait(). The number of requests in flight is limited by the queue depth, preparing further requests
+/// blocks until earlier requests have completed. Engines are NOT thread-safe, use one engine per thread.
+class async_io : public noncopyable
+{
+public:
+	/// Engine types.
+	enum engine_type
+	{
+		io_uring,		///< Linux io_uring.
+		thread_pool		///< Pool of threads issuing synchronous positional requests.
+	};
+
+private:
+	impl::async_io_engine *m_engine;
+	engine_type m_engineType;
+	size_t m_queueDepth;
+	size_t m_inFlight;
+
+	/// Processes completions, blocking until at least one request has completed if requested.
+	LEAN_MAYBE_EXPORT size_t process(bool wait);
+
+public:
+	/// Constructs an asynchronous I/O engine keeping up to the given number of requests in flight. The given number
+	/// of threads is only started by the thread pool engine, which is used where io_uring is unavailable or forced.
+	LEAN_MAYBE_EXPORT explicit async_io(size_t queueDepth = 64, size_t threadCount = 4, bool forceThreadPool = false);
+	/// Waits for all requests in flight to complete.
+	LEAN_MAYBE_EXPORT ~async_io();
+
+	/// Prepares the given request for submission by the next call to flush(). Blocks processing completions while
+	/// the maximum number of requests is in flight.
+	LEAN_MAYBE_EXPORT void prepare(async_request &request);
+	/// Submits all prepared requests, returning the number of requests submitted.
+	LEAN_MAYBE_EXPORT size_t flush();
+	/// Submits the given request.
+	LEAN_INLINE void submit(async_request &request)
+	{
+		prepare(request);
+		flush();
+	}
+
+	/// Processes all completed requests without blocking, returning the number of requests completed.
+	LEAN_INLINE size_t poll() { return process(false); }
+	/// Submits all prepared requests & blocks until the given request has completed, processing completions.
+	LEAN_MAYBE_EXPORT void wait(async_request &request);
+	/// Submits all prepared requests & blocks until all requests in flight have completed, processing completions.
+	LEAN_MAYBE_EXPORT void wait_all();
+
+	/// Registers the given buffers, allowing for requests to reference them by index. Registered buffers are
+	/// mapped once, rather than for every request. Replaces previously registered buffers, no requests may be in
+	/// flight. Returns false if buffers could not be registered, e.g. exceeding the limit of locked memory.
+	LEAN_MAYBE_EXPORT bool register_buffers(const async_buffer *buffers, size_t count);
+	/// Unregisters all buffers, no requests may be in flight.
+	LEAN_MAYBE_EXPORT void unregister_buffers();
+
+	/// Gets the type of engine used.
+	LEAN_INLINE engine_type engine() const { return m_engineType; }
+	/// Gets the maximum number of requests in flight.
+	LEAN_INLINE size_t queue_depth() const { return m_queueDepth; }
+	/// Gets the number of requests in flight, including prepared requests.
+	LEAN_INLINE size_t in_flight() const { return m_inFlight; }
+};
+
+} // namespace
+
+using io::async_request;
+using io::async_buffer;
+using io::async_io;
+
+} // namespace
+
+#ifdef LEAN_INCLUDE_INLINED
+#include "source/async_io.cpp"
+#endif
+
+#endif
\ No newline at end of file
@@ -18,6 +18,7 @@ namespace lean
 #include "file.h"
 #include "raw_file.h"
 #include "raw_file_inserter.h"
+#include "raw_file_extractor.h"
 #include "mapped_file.h"
 
 #endif
\ No newline at end of file
@@ -0,0 +1,297 @@
+/*****************************************************/
+/* lean I/O                     (c) Tobias Zirr 2011 */
+/*****************************************************/
+
+#pragma once
+#ifndef LEAN_LOGGING_IO_MAPPED_ARENA
+#define LEAN_LOGGING_IO_MAPPED_ARENA
+
+#include "../lean.h"
+#include "../strings/types.h"
+#include "../tags/noncopyable.h"
+#include "../meta/strip.h"
+#include "../memory/offset_ptr.h"
+#include "mapped_file.h"
+#include <new>
+
+namespace lean
+{
+namespace io
+{
+
+/// Header stored at the beginning of every mapped arena file, keeping track of the memory allocated.
+/// Located inside the file, the header may be referenced by objects stored in the file via offset pointers.
+struct mapped_arena_header
+{
+	/// Identifies mapped arena files.
+	static const uint4 magic_value = 0x616e726c;
+	/// Current file format version.
+	static const uint4 version_value = 1;
+
+	uint4 magic;		///< Identifies mapped arena files.
+	uint4 version;		///< File format version.
+	uint8 capacity;		///< Size of the file, in bytes.
+	uint8 size;			///< Number of bytes allocated, including this header.
+	uint8 root;			///< Offset of the root object, 0 if none.
+
+	/// Allocates the given number of bytes respecting the given alignment, returns nullptr if exhausted.
+	LEAN_INLINE void* try_allocate(size_t size, size_t alignment)
+	{
+		uint8 offset = (this->size + (alignment - 1)) & ~static_cast<uint8>(alignment - 1);
+
+		if (offset > capacity || size > capacity - offset)
+			return nullptr;
+
+		this->size = offset + size;
+		return reinterpret_cast<char*>(this) + offset;
+	}
+	/// Frees the given block of memory, only reclaimed if allocated last.
+	LEAN_INLINE void free(void *memory, size_t size)
+	{
+		if (static_cast<char*>(memory) + size == reinterpret_cast<char*>(this) + this->size)
+			this->size -= size;
+	}
+
+	/// Gets the root object, nullptr if none.
+	LEAN_INLINE void* root_object() const
+	{
+		return (root) ? const_cast<char*>(reinterpret_cast<const char*>(this)) + root : nullptr;
+	}
+};
+
+/// Arena allocating from a memory-mapped file, allowing for complex data structures to be stored in the file &
+/// reopened without any serialization. Data structures stored in the file need to reference each other via offset
+/// pointers, e.g. containers such as simple_vector and simple_hash_map using mapped_arena_allocator. One root object
+/// may be registered to be retrieved on reopening. Growing the file may map it to a different address, invalidating
+/// all raw pointers into the file.
+class mapped_arena : public noncopyable
+{
+private:
+	mapped_file m_file;
+
+	/// Initializes or validates the arena header.
+	LEAN_MAYBE_EXPORT void init();
+
+public:
+	/// Size type.
+	typedef size_t size_type;
+	/// Default alignment.
+	static const size_type default_alignment = sizeof(void*);
+
+	/// Opens the given arena file, creating a new arena of the given capacity if the file does not exist or is
+	/// to be overwritten. Throws a runtime_error if the file exists but does not contain a mapped arena.
+	LEAN_MAYBE_EXPORT explicit mapped_arena(const utf8_ntri &name, uint8 capacity = 1024 * 1024,
+		file::open_mode mode = file::open, uint4 hints = file::random, uint4 share = file::dont_share);
+	/// Closes this arena, memory stays allocated in the file.
+	LEAN_MAYBE_EXPORT ~mapped_arena();
+
+	/// Allocates the given amount of memory respecting the given alignment. Grows the file if exhausted,
+	/// re-mapping it and thereby invalidating all raw pointers into the file.
+	LEAN_MAYBE_EXPORT void* allocate(size_type size, size_type alignment);
+	/// Allocates the given amount of memory. Grows the file if exhausted, see allocate(size_type, size_type).
+	LEAN_INLINE void* allocate(size_type size) { return allocate(size, default_alignment); }
+	/// Allocates the given amount of memory respecting the given alignment. Grows the file if exhausted,
+	/// see allocate(size_type, size_type).
+	template <size_t Alignment>
+	LEAN_INLINE void* allocate(size_type size) { return allocate(size, Alignment); }
+	/// Frees the given block of memory of the given size, only reclaimed if allocated last.
+	LEAN_INLINE void free(void *memory, size_type size) { header()->free(memory, size); }
+
+	/// Grows the file to the given capacity, re-mapping it and thereby invalidating all raw pointers into the file.
+	/// Allocators stored inside the file never grow the file, reserve sufficient capacity before filling them.
+	LEAN_MAYBE_EXPORT void reserve(uint8 capacity);
+	/// Truncates the file to the memory allocated, re-mapping it and thereby invalidating all raw pointers into the file.
+	LEAN_MAYBE_EXPORT void trim();
+	/// Flushes all changes to disk, returning true on success.
+	LEAN_INLINE bool flush() { return m_file.flush(); }
+
+	/// Sets the root object, to be retrieved on reopening.
+	LEAN_INLINE void root(void *object)
+	{
+		header()->root = (object) ? static_cast<char*>(object) - static_cast<char*>(m_file.data()) : 0;
+	}
+	/// Gets the root object, nullptr if none.
+	LEAN_INLINE void* root() const { return header()->root_object(); }
+
+	/// Gets the number of bytes allocated, including the arena header.
+	LEAN_INLINE uint8 size() const { return header()->size; }
+	/// Gets the size of the file.
+	LEAN_INLINE uint8 capacity() const { return header()->capacity; }
+
+	/// Gets the arena header.
+	LEAN_INLINE mapped_arena_header* header() { return static_cast<mapped_arena_header*>(m_file.data()); }
+	/// Gets the arena header.
+	LEAN_INLINE const mapped_arena_header* header() const { return static_cast<const mapped_arena_header*>(m_file.data()); }
+	/// Gets the underlying file.
+	LEAN_INLINE const mapped_file& backing_file() const { return m_file; }
+};
+
+/// STL allocator allocating from a mapped arena. Stores offset pointers only, allowing for containers
+/// using this allocator to be placed inside the arena and reopened later on. Never grows the arena file,
+/// throwing bad_alloc when exhausted, as growing might move the containers while still allocating.
+/// Deallocation only reclaims memory allocated last.
+template <class Element>
+class mapped_arena_allocator
+{
+	template <class Other>
+	friend class mapped_arena_allocator;
+
+public:
+	/// Value type.
+	typedef typename strip_const<Element>::type value_type;
+
+	/// Pointer type.
+	typedef value_type* pointer;
+	/// Reference type.
+	typedef value_type& reference;
+	/// Pointer type.
+	typedef const value_type* const_pointer;
+	/// Reference type.
+	typedef const value_type& const_reference;
+	/// Pointer type stored by containers.
+	typedef offset_ptr<value_type> stored_pointer;
+
+	/// Size type.
+	typedef size_t size_type;
+	/// Pointer difference type.
+	typedef ptrdiff_t difference_type;
+
+	/// Allows for the creation of differently-typed equivalent allocators.
+	template <class Other>
+	struct rebind
+	{
+		/// Equivalent allocator allocating elements of type Other.
+		typedef mapped_arena_allocator<Other> other;
+	};
+
+private:
+	offset_ptr<mapped_arena_header> m_header;
+
+public:
+	/// Allocates from the given arena.
+	LEAN_INLINE explicit mapped_arena_allocator(mapped_arena &arena)
+		: m_header(arena.header()) { }
+	/// Allocates from the given arena.
+	LEAN_INLINE explicit mapped_arena_allocator(mapped_arena_header *header)
+		: m_header(header) { }
+	/// Copy constructor.
+	LEAN_INLINE mapped_arena_allocator(const mapped_arena_allocator &right)
+		: m_header(right.m_header) { }
+	/// Copy constructor.
+	template <class Other>
+	LEAN_INLINE mapped_arena_allocator(const mapped_arena_allocator<Other> &right)
+		: m_header(right.m_header) { }
+	/// Assignment operator.
+	LEAN_INLINE mapped_arena_allocator& operator=(const mapped_arena_allocator &right)
+	{
+		m_header = right.m_header;
+		return *this;
+	}
+	/// Assignment operator.
+	template <class Other>
+	LEAN_INLINE mapped_arena_allocator& operator=(const mapped_arena_allocator<Other> &right)
+	{
+		m_header = right.m_header;
+		return *this;
+	}
+
+	/// Allocates the given number of elements.
+	LEAN_INLINE pointer allocate(size_type count)
+	{
+		void *memory = m_header->try_allocate(count * sizeof(value_type), alignof(value_type));
+
+		if (!memory)
+			throw std::bad_alloc();
+
+		return static_cast<pointer>(memory);
+	}
+	/// Allocates the given amount of memory.
+	LEAN_INLINE pointer allocate(size_type count, const void *)
+	{
+		return allocate(count);
+	}
+	/// Deallocates the given number of elements, only reclaimed if allocated last.
+	LEAN_INLINE void deallocate(pointer ptr, size_type count)
+	{
+		m_header->free(ptr, count * sizeof(value_type));
+	}
+
+	/// Constructs a new element from the given value at the given pointer.
+	LEAN_INLINE void construct(pointer ptr, const value_type& value)
+	{
+		new(reinterpret_cast<void*>(ptr)) Element(value);
+	}
+	/// Constructs a new element from the given value at the given pointer.
+	template <class Other>
+	LEAN_INLINE void construct(pointer ptr, const Other& value)
+	{
+		new(reinterpret_cast<void*>(ptr)) Element(value);
+	}
+#ifndef LEAN0X_NO_RVALUE_REFERENCES
+	/// Constructs a new element from the given value at the given pointer.
+	LEAN_INLINE void construct(pointer ptr, value_type&& value)
+	{
+		new(reinterpret_cast<void*>(ptr)) Element(std::move(value));
+	}
+	/// Constructs a new element from the given value at the given pointer.
+	template <class Other>
+	LEAN_INLINE void construct(pointer ptr, Other&& value)
+	{
+		new(reinterpret_cast<void*>(ptr)) Element(std::forward<Other>(value));
+	}
+#endif
+	/// Destructs an element at the given pointer.
+	LEAN_INLINE void destroy(pointer ptr)
+	{
+		ptr->~Element();
+	}
+
+	/// Gets the address of the given element.
+	LEAN_INLINE pointer address(reference value) const
+	{
+		return reinterpret_cast<pointer>( &reinterpret_cast<char&>(value) );
+	}
+	/// Gets the address of the given element.
+	LEAN_INLINE const_pointer address(const_reference value) const
+	{
+		return reinterpret_cast<const_pointer>( &reinterpret_cast<const char&>(value) );
+	}
+
+	/// Estimates the maximum number of elements that may be constructed.
+	LEAN_INLINE size_type max_size() const
+	{
+		size_type count = static_cast<size_type>(-1) / sizeof(Element);
+		return (0 < count) ? count : 1;
+	}
+
+	/// Gets the header of the arena allocated from.
+	LEAN_INLINE mapped_arena_header* header() const { return m_header; }
+};
+
+/// Checks the given two allocators for equivalence.
+template <class Element, class Other>
+LEAN_INLINE bool operator ==(const mapped_arena_allocator<Element> &left, const mapped_arena_allocator<Other> &right)
+{
+	return left.header() == right.header();
+}
+
+/// Checks the given two allocators for inequivalence.
+template <class Element, class Other>
+LEAN_INLINE bool operator !=(const mapped_arena_allocator<Element> &left, const mapped_arena_allocator<Other> &right)
+{
+	return left.header() != right.header();
+}
+
+} // namespace
+
+using io::mapped_arena_header;
+using io::mapped_arena;
+using io::mapped_arena_allocator;
+
+} // namespace
+
+#ifdef LEAN_INCLUDE_INLINED
+#include "source/mapped_arena.cpp"
+#endif
+
+#endif
\ No newline at end of file
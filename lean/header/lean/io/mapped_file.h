@@ -33,11 +33,11 @@ protected:
 	/// Closes this file.
 	LEAN_MAYBE_EXPORT ~mapped_file_base();
 
-	/// Maps the given view of this file. A size of 0 maps the entire file starting at the given offset.
-	/// Throws a runtime_exception on error.
-	LEAN_MAYBE_EXPORT void* map(bool readonly, uint8 offset, size_t size);
+	/// Maps the given view of this file. A size of 0 maps the entire file starting at the given offset,
+	/// the given size is updated to the number of bytes actually mapped. Throws a runtime_exception on error.
+	LEAN_MAYBE_EXPORT void* map(bool readonly, uint8 offset, size_t &size);
 	/// Unmaps the given view of this file.
-	LEAN_MAYBE_EXPORT void unmap(void *memory);
+	LEAN_MAYBE_EXPORT void unmap(void *memory, size_t size);
 
 	/// Resizes the file, either extending or truncating it. Throws a runtime_exception on error.
 	/// Destroys the mapping, re-mapping is only possible again after this method has returned successfully.
@@ -48,6 +48,7 @@ protected:
 class rmapped_file : public mapped_file_base
 {
 private:
+	size_t m_size;
 	const void *m_memory;
 
 public:
@@ -66,6 +67,8 @@ public:
 
 	/// Gets a pointer to the file in memory, nullptr if currently unmapped.
 	LEAN_INLINE const void* data() const { return m_memory; };
+	/// Gets the number of bytes currently mapped.
+	LEAN_INLINE size_t mapped_size() const { return m_size; }
 
 	/// Gets whether the file is currently mapped.
 	LEAN_INLINE bool mapped() const { return (m_memory != nullptr); }
@@ -75,6 +78,7 @@ public:
 class mapped_file : public mapped_file_base
 {
 private:
+	size_t m_size;
 	void *m_memory;
 
 public:
@@ -103,6 +107,8 @@ public:
 	LEAN_INLINE void* data() { return m_memory; }
 	/// Gets a pointer to the file in memory, nullptr if currently unmapped.
 	LEAN_INLINE const void* data() const { return m_memory; }
+	/// Gets the number of bytes currently mapped.
+	LEAN_INLINE size_t mapped_size() const { return m_size; }
 
 	/// Gets whether the file is currently mapped.
 	LEAN_INLINE bool mapped() const { return (m_memory != nullptr); }
@@ -19,6 +19,15 @@ namespace io
 class raw_file : public file
 {
 public:
+	/// Range of bytes to be read.
+	typedef range<char*> span;
+	/// Range of bytes to be written.
+	typedef range<const char*> const_span;
+	/// List of ranges of bytes to be read.
+	typedef range<const span*> span_list;
+	/// List of ranges of bytes to be written.
+	typedef range<const const_span*> const_span_list;
+
 	/// Opens the given file according to the given flags. Throws a runtime_exception on error.
 	LEAN_MAYBE_EXPORT explicit raw_file(const utf8_ntri &name,
 		uint4 access = file::read | file::write, open_mode mode = file::open,
@@ -31,6 +40,28 @@ public:
 	/// Writes the given number of bytes to the file, returning the number of bytes written. This method is thread-safe.
 	LEAN_MAYBE_EXPORT size_t write(const char *begin, size_t count);
 
+	/// Reads the given number of bytes starting at the given file offset, returning the number of bytes read.
+	/// Independent of the current file cursor position, this method may be called by many threads at once.
+	/// The file cursor position is unspecified afterwards.
+	LEAN_MAYBE_EXPORT size_t read_at(uint8 offset, char *begin, size_t count) const;
+	/// Writes the given number of bytes starting at the given file offset, returning the number of bytes written.
+	/// Independent of the current file cursor position, this method may be called by many threads at once.
+	/// The file cursor position is unspecified afterwards.
+	LEAN_MAYBE_EXPORT size_t write_at(uint8 offset, const char *begin, size_t count);
+
+	/// Reads into the given list of ranges of bytes in order, returning the number of bytes read. Issues one
+	/// system call for several ranges where supported. This method is thread-safe.
+	LEAN_MAYBE_EXPORT size_t read(span_list spans) const;
+	/// Writes the given list of ranges of bytes in order, returning the number of bytes written. Issues one
+	/// system call for several ranges where supported. This method is thread-safe.
+	LEAN_MAYBE_EXPORT size_t write(const_span_list spans);
+	/// Reads into the given list of ranges of bytes starting at the given file offset, returning the number of
+	/// bytes read. Independent of the current file cursor position, see read_at().
+	LEAN_MAYBE_EXPORT size_t read_at(uint8 offset, span_list spans) const;
+	/// Writes the given list of ranges of bytes starting at the given file offset, returning the number of
+	/// bytes written. Independent of the current file cursor position, see write_at().
+	LEAN_MAYBE_EXPORT size_t write_at(uint8 offset, const_span_list spans);
+
 	/// Prints the given range of characters to the file. This method is thread-safe.
 	LEAN_MAYBE_EXPORT size_t print(const char_ntri &message);
 };
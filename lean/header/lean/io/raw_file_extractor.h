@@ -0,0 +1,319 @@
+/*****************************************************/
+/* lean I/O                     (c) Tobias Zirr 2011 */
+/*****************************************************/
+
+#pragma once
+#ifndef LEAN_LOGGING_IO_RAW_FILE_EXTRACTOR
+#define LEAN_LOGGING_IO_RAW_FILE_EXTRACTOR
+
+#include "../lean.h"
+#include "../tags/noncopyable.h"
+#include "../concurrent/semaphore.h"
+#include "../concurrent/thread.h"
+#include "raw_file.h"
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+namespace lean
+{
+namespace io
+{
+
+/// File extractor class that allows for convenient buffered file input, following the STL input iterator concept
+/// or handing out ranges of buffered bytes to be parsed in place. Optionally reads ahead on a background thread,
+/// overlapping parsing and I/O. Open files using file::sequential to additionally enable read-ahead by the OS.
+template <size_t BufferSize = 64 * 1024>
+class raw_file_extractor : public noncopyable
+{
+public:
+	/// Range of buffered bytes.
+	typedef range<const char*> span;
+
+private:
+	/// Reads ahead into the next buffer.
+	struct read_ahead
+	{
+		raw_file_extractor *extractor;
+
+		void operator ()()
+		{
+			extractor->run_read_ahead();
+		}
+	};
+	friend struct read_ahead;
+
+	raw_file *m_file;
+
+	// Every buffer is preceded by room for bytes carried over from the previous buffer
+	std::vector<char> m_memory;
+	char *m_buffer;
+	const char *m_begin;
+	const char *m_end;
+	bool m_eof;
+
+	char *m_nextBuffer;
+	size_t m_nextCount;
+	semaphore m_requested;
+	semaphore m_completed;
+	volatile bool m_stop;
+	thread m_thread;
+
+	LEAN_STATIC_ASSERT_MSG_ALT(BufferSize > 0,
+		"Buffer size is required to be greater than 0",
+		Buffer_size_is_required_to_be_greater_than_0);
+
+	/// Reads into the given buffer.
+	size_t fill(char *buffer)
+	{
+		return m_file->read(buffer + BufferSize, BufferSize);
+	}
+
+	/// Fills the next buffer whenever requested.
+	void run_read_ahead()
+	{
+		for (;;)
+		{
+			m_requested.lock();
+
+			if (m_stop)
+				break;
+
+			m_nextCount = fill(m_nextBuffer);
+			m_completed.unlock();
+		}
+	}
+
+	/// Appends the next buffer to all unconsumed bytes, returning false if no more bytes available.
+	bool refill()
+	{
+		if (m_eof)
+			return false;
+
+		size_t remaining = m_end - m_begin;
+		LEAN_ASSERT(remaining <= BufferSize);
+
+		char *buffer;
+		size_t count;
+
+		if (m_thread.joinable())
+		{
+			m_completed.lock();
+
+			buffer = m_nextBuffer;
+			count = m_nextCount;
+			memcpy(buffer + BufferSize - remaining, m_begin, remaining);
+
+			// Read ahead into the buffer just consumed
+			m_nextBuffer = m_buffer;
+			m_requested.unlock();
+		}
+		else
+		{
+			buffer = m_buffer;
+			memmove(buffer + BufferSize - remaining, m_begin, remaining);
+			count = fill(buffer);
+		}
+
+		m_buffer = buffer;
+		m_begin = buffer + BufferSize - remaining;
+		m_end = buffer + BufferSize + count;
+		m_eof = (count == 0);
+
+		return !m_eof;
+	}
+
+public:
+	/// Character type.
+	typedef char value_type;
+	/// Character reference type.
+	typedef const char& const_reference;
+
+	/// Iterator type.
+	class iterator
+	{
+	private:
+		raw_file_extractor *m_extractor;
+
+		/// Checks whether there are no more characters to be extracted.
+		LEAN_INLINE bool at_end() const
+		{
+			return !m_extractor || m_extractor->empty();
+		}
+
+	public:
+		/// Iterator category.
+		typedef std::input_iterator_tag iterator_category;
+		/// Character type.
+		typedef char value_type;
+		/// Difference type.
+		typedef ptrdiff_t difference_type;
+		/// Character pointer type.
+		typedef const char* pointer;
+		/// Character reference type.
+		typedef const char& reference;
+
+		/// Constructs an end-of-file iterator.
+		LEAN_INLINE iterator()
+			: m_extractor(nullptr) { }
+		/// Constructs a file-extractor-based input iterator.
+		LEAN_INLINE explicit iterator(raw_file_extractor &extractor)
+			: m_extractor(&extractor) { }
+
+		/// Gets the current character.
+		LEAN_INLINE reference operator *() const
+		{
+			return *m_extractor->peek().begin();
+		}
+
+		/// Extracts the current character.
+		LEAN_INLINE iterator& operator ++()
+		{
+			m_extractor->consume(1);
+			return *this;
+		}
+		/// Extracts the current character.
+		LEAN_INLINE iterator& operator ++(int)
+		{
+			// Follow the STL pattern and fake post-increment
+			m_extractor->consume(1);
+			return *this;
+		}
+
+		/// Checks whether both iterators are at the end of the file or refer to the same extractor.
+		LEAN_INLINE bool operator ==(const iterator &right) const
+		{
+			bool atEnd = at_end();
+			return (atEnd == right.at_end()) && (atEnd || m_extractor == right.m_extractor);
+		}
+		/// Checks whether either iterator is not at the end of the file.
+		LEAN_INLINE bool operator !=(const iterator &right) const
+		{
+			return !(*this == right);
+		}
+	};
+
+	/// Constructs a file extractor reading from the current position of the given raw file. Reads the next buffer
+	/// on a background thread while the current buffer is being parsed, if requested.
+	explicit raw_file_extractor(raw_file &file, bool readAhead = false)
+		: m_file(&file),
+		m_memory((readAhead ? 4 : 2) * BufferSize),
+		m_buffer(&m_memory[0]),
+		m_begin(m_buffer + BufferSize),
+		m_end(m_begin),
+		m_eof(false),
+		m_nextBuffer(readAhead ? m_buffer + 2 * BufferSize : nullptr),
+		m_nextCount(0),
+		m_requested(0),
+		m_completed(0),
+		m_stop(false)
+	{
+		if (readAhead)
+		{
+			// Start reading right away
+			read_ahead task = { this };
+			m_thread = thread(task);
+			m_requested.unlock();
+		}
+	}
+	/// Stops reading ahead.
+	~raw_file_extractor()
+	{
+		if (m_thread.joinable())
+		{
+			m_stop = true;
+			m_requested.unlock();
+			m_thread.join();
+		}
+	}
+
+	/// Gets all buffered bytes, reading more if none are left. Returns an empty range at the end of the file.
+	LEAN_INLINE span peek()
+	{
+		if (m_begin == m_end)
+			refill();
+
+		return span(m_begin, m_end);
+	}
+	/// Gets at least the given number of contiguous bytes, reading more if necessary. Returns fewer bytes only
+	/// at the end of the file. The given number of bytes may not exceed the buffer size.
+	LEAN_INLINE span peek(size_t count)
+	{
+		LEAN_ASSERT(count <= BufferSize);
+
+		while (static_cast<size_t>(m_end - m_begin) < count && refill());
+
+		return span(m_begin, m_end);
+	}
+	/// Consumes the given number of bytes returned by the last call to peek().
+	LEAN_INLINE void consume(size_t count)
+	{
+		LEAN_ASSERT(count <= static_cast<size_t>(m_end - m_begin));
+		m_begin += count;
+	}
+
+	/// Extracts the next character, returning false at the end of the file.
+	LEAN_INLINE bool extract(char &value)
+	{
+		if (m_begin == m_end && !refill())
+			return false;
+
+		value = *m_begin++;
+		return true;
+	}
+	/// Extracts up to the given number of bytes, returning the number of bytes extracted.
+	size_t extract(char *begin, size_t count)
+	{
+		size_t total = 0;
+
+		while (total < count)
+		{
+			span buffered = peek();
+
+			if (buffered.empty())
+				break;
+
+			size_t chunk = min(static_cast<size_t>(buffered.size()), count - total);
+			memcpy(begin + total, buffered.begin(), chunk);
+			consume(chunk);
+			total += chunk;
+		}
+
+		return total;
+	}
+
+	/// Checks whether there are no more bytes to be extracted.
+	LEAN_INLINE bool empty()
+	{
+		return (m_begin == m_end) && !refill();
+	}
+	/// Checks whether the end of the file has been reached & all bytes have been extracted.
+	LEAN_INLINE bool eof() const
+	{
+		return m_eof && (m_begin == m_end);
+	}
+	/// Checks whether reading ahead on a background thread.
+	LEAN_INLINE bool reading_ahead() const
+	{
+		return m_thread.joinable();
+	}
+
+	/// Gets an input iterator.
+	LEAN_INLINE iterator iter()
+	{
+		return iterator(*this);
+	}
+	/// Gets an end-of-file iterator.
+	LEAN_INLINE iterator iter_end() const
+	{
+		return iterator();
+	}
+};
+
+} // namespace
+
+using io::raw_file_extractor;
+
+} // namespace
+
+#endif
\ No newline at end of file
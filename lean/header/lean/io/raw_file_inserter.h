@@ -9,6 +9,10 @@
 #include "../lean.h"
 #include "../tags/noncopyable.h"
 #include "raw_file.h"
+#include "../concurrent/semaphore.h"
+#include "../concurrent/thread.h"
+#include <cstring>
+#include <vector>
 
 namespace lean
 {
@@ -16,27 +20,92 @@ namespace io
 {
 
 /// File inserter class that follows the STL output iterator concept to allow for convenient buffered file output.
+/// Optionally hands full buffers to a background thread, filling the next buffer while the last one is written.
 template <size_t BufferSize = 4096>
 class raw_file_inserter : public noncopyable
 {
 private:
+	/// Writes full buffers in the background.
+	struct background_writer
+	{
+		raw_file_inserter *inserter;
+
+		void operator ()()
+		{
+			inserter->run_writer();
+		}
+	};
+	friend struct background_writer;
+
+	/// Marks the end of all output written in the background.
+	static const size_t stop_count = static_cast<size_t>(-1);
+
 	raw_file *m_file;
 	char m_buffer[BufferSize];
+	char *m_begin;
 	char *m_end;
+	char *m_bufferEnd;
+
+	std::vector<char> m_backBuffers;
+	std::vector<size_t> m_counts;
+	size_t m_current;
+	semaphore m_free;
+	semaphore m_queued;
+	thread m_thread;
 
 	LEAN_STATIC_ASSERT_MSG_ALT(BufferSize > 0,
 		"Buffer size is required to be greater than 0",
 		Buffer_size_is_required_to_be_greater_than_0);
 
-	/// Flushes all buffered output to file.
+	/// Gets the buffer of the given index.
+	LEAN_INLINE char* buffer(size_t index)
+	{
+		return (index == 0) ? m_buffer : &m_backBuffers[(index - 1) * BufferSize];
+	}
+
+	/// Writes queued buffers in order until stopped.
+	void run_writer()
+	{
+		for (size_t index = 0; ; index = (index + 1) % m_counts.size())
+		{
+			m_queued.lock();
+
+			size_t count = m_counts[index];
+
+			if (count == stop_count)
+				break;
+
+			m_file->write(buffer(index), count);
+			m_free.unlock();
+		}
+	}
+
+	/// Queues the current buffer for the background writer, blocking until the next buffer has been written.
+	void hand_off(size_t count)
+	{
+		m_counts[m_current] = count;
+		m_queued.unlock();
+
+		m_current = (m_current + 1) % m_counts.size();
+		m_free.lock();
+
+		m_begin = buffer(m_current);
+		m_bufferEnd = m_begin + BufferSize;
+	}
+
+	/// Flushes all buffered output to file, or to the background writer.
 	void flush()
 	{
-		size_t count = m_end - m_buffer;
+		size_t count = m_end - m_begin;
 
 		if (count != 0)
 		{
-			m_file->write(m_buffer, count);
-			m_end = m_buffer;
+			if (m_thread.joinable())
+				hand_off(count);
+			else
+				m_file->write(m_begin, count);
+
+			m_end = m_begin;
 		}
 	}
 
@@ -87,7 +156,32 @@ public:
 	/// Constructs a file inserter from the given raw file.
 	LEAN_INLINE explicit raw_file_inserter(raw_file &file)
 		: m_file(&file),
-		m_end(m_buffer) { }
+		m_begin(m_buffer),
+		m_end(m_buffer),
+		m_bufferEnd(m_buffer + BufferSize),
+		m_current(0),
+		m_free(0),
+		m_queued(0) { }
+	/// Constructs a file inserter from the given raw file, writing full buffers on a background thread while
+	/// filling the next of the given number of buffers. Blocks while all other buffers are still being written.
+	/// Writes synchronously, if less than two buffers are given.
+	raw_file_inserter(raw_file &file, size_t bufferCount)
+		: m_file(&file),
+		m_begin(m_buffer),
+		m_end(m_buffer),
+		m_bufferEnd(m_buffer + BufferSize),
+		m_backBuffers((bufferCount > 1) ? (bufferCount - 1) * BufferSize : 0),
+		m_counts((bufferCount > 1) ? bufferCount : 0),
+		m_current(0),
+		m_free( static_cast<long>((bufferCount > 1) ? bufferCount - 1 : 0) ),
+		m_queued(0)
+	{
+		if (bufferCount > 1)
+		{
+			background_writer task = { this };
+			m_thread = thread(task);
+		}
+	}
 	/// Copy constructor.
 /*	LEAN_INLINE raw_file_inserter(const raw_file_inserter &right)
 		: m_file(right.m_file),
@@ -96,6 +190,14 @@ public:
 	LEAN_INLINE ~raw_file_inserter()
 	{
 		flush();
+
+		if (m_thread.joinable())
+		{
+			// Stop after all buffers queued before
+			m_counts[m_current] = stop_count;
+			m_queued.unlock();
+			m_thread.join();
+		}
 	}
 
 	/// Assigns the given file inserter to this file inserter.
@@ -111,10 +213,97 @@ public:
 	{
 		*(m_end++) = value;
 
-		if (m_end == m_buffer + BufferSize)
+		if (m_end == m_bufferEnd)
 			flush();
 	}
 
+	/// Inserts the given range of bytes.
+	void insert(const char *begin, size_t count)
+	{
+		// Large ranges are written along with all buffered output right away
+		if (count >= BufferSize && !m_thread.joinable())
+		{
+			raw_file::const_span span(begin, begin + count);
+			insert(raw_file::const_span_list(&span, &span + 1));
+			return;
+		}
+
+		for (;;)
+		{
+			size_t chunk = min(count, static_cast<size_t>(m_bufferEnd - m_end));
+			memcpy(m_end, begin, chunk);
+			m_end += chunk;
+
+			if (m_end != m_bufferEnd)
+				break;
+
+			begin += chunk;
+			count -= chunk;
+			flush();
+		}
+	}
+
+	/// Inserts the given list of ranges of bytes. Ranges not fitting into the buffer are written along with all
+	/// buffered output, issuing as few system calls as possible.
+	void insert(raw_file::const_span_list spans)
+	{
+		// Output needs to pass through the background writer
+		if (m_thread.joinable())
+		{
+			for (const raw_file::const_span *it = spans.begin(); it != spans.end(); ++it)
+				insert(it->begin(), it->size());
+
+			return;
+		}
+
+		size_t count = 0;
+
+		for (const raw_file::const_span *it = spans.begin(); it != spans.end(); ++it)
+			count += it->size();
+
+		// Small ranges are simply buffered
+		if (count < static_cast<size_t>(m_bufferEnd - m_end))
+		{
+			for (const raw_file::const_span *it = spans.begin(); it != spans.end(); ++it)
+			{
+				memcpy(m_end, it->begin(), it->size());
+				m_end += it->size();
+			}
+		}
+		else
+		{
+			static const size_t batch_size = 16;
+			raw_file::const_span batch[batch_size];
+			size_t batchCount = 0;
+
+			// Buffered output goes first
+			if (m_end != m_begin)
+				batch[batchCount++] = raw_file::const_span(m_begin, m_end);
+
+			for (const raw_file::const_span *it = spans.begin(); it != spans.end(); ++it)
+			{
+				batch[batchCount++] = *it;
+
+				if (batchCount == batch_size)
+				{
+					m_file->write( raw_file::const_span_list(batch, batch + batchCount) );
+					batchCount = 0;
+				}
+			}
+
+			if (batchCount != 0)
+				m_file->write( raw_file::const_span_list(batch, batch + batchCount) );
+
+			m_end = m_begin;
+		}
+	}
+
+	/// Checks whether full buffers are written on a background thread.
+	LEAN_INLINE bool background() const
+	{
+		return m_thread.joinable();
+	}
+
 	/// Gets an output iterator.
 	LEAN_INLINE iterator iter()
 	{
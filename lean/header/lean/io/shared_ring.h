@@ -0,0 +1,333 @@
+/*****************************************************/
+/* lean I/O                     (c) Tobias Zirr 2011 */
+/*****************************************************/
+
+#pragma once
+#ifndef LEAN_LOGGING_IO_SHARED_RING
+#define LEAN_LOGGING_IO_SHARED_RING
+
+#include "../lean.h"
+#include "../strings/types.h"
+#include "../tags/noncopyable.h"
+#include "../memory/alignment.h"
+#include "../concurrent/atomic.h"
+#include "mapped_file.h"
+#include <cstring>
+
+namespace lean
+{
+namespace io
+{
+
+/// Header stored at the beginning of every shared ring file, followed by the ring buffer. Positions are
+/// byte offsets growing monotonically, the ring buffer index being the position modulo the capacity.
+/// Positions modified by different parties are kept on separate cache lines to avoid false sharing.
+struct shared_ring_header
+{
+	/// Identifies shared ring files.
+	static const uint4 magic_value = 0x676e6972;
+	/// Marks shared ring files currently being initialized.
+	static const uint4 initializing_value = 0x74696e69;
+	/// Current file format version.
+	static const uint4 version_value = 1;
+	/// Cache line size assumed.
+	static const size_t cache_line_size = 64;
+
+	volatile uint4 magic;		///< Identifies shared ring files.
+	uint4 version;				///< File format version.
+	uint8 capacity;				///< Size of the ring buffer, in bytes (power of two).
+	char pad0[cache_line_size - 2 * sizeof(uint4) - sizeof(uint8)];
+
+	volatile uint8 tail;		///< Position up to which space has been reserved by producers.
+	char pad1[cache_line_size - sizeof(uint8)];
+
+	volatile uint8 headCache;	///< Recent head position, limits the number of times producers touch the consumer's cache line.
+	char pad2[cache_line_size - sizeof(uint8)];
+
+	volatile uint8 head;		///< Position up to which records have been consumed.
+	char pad3[cache_line_size - sizeof(uint8)];
+
+	volatile int readSignal;	///< Incremented to wake the consumer.
+	volatile int readWaiters;	///< Number of consumers waiting for records to be committed.
+	char pad4[cache_line_size - 2 * sizeof(int)];
+
+	volatile int writeSignal;	///< Incremented to wake producers.
+	volatile int writeWaiters;	///< Number of producers waiting for records to be consumed.
+	char pad5[cache_line_size - 2 * sizeof(int)];
+};
+
+/// Header preceding every record in a shared ring.
+struct shared_ring_record_header
+{
+	/// Record length including this header, negative while reserved, 0 if not reserved yet.
+	volatile int4 length;
+	/// Record type, padding records are skipped by consumers.
+	int4 type;
+};
+
+/// Multi-producer single-consumer ring buffer of variable-length records residing in a memory-mapped file,
+/// allowing for messages to be passed between processes without copying them through the kernel. Producers
+/// reserve records, fill them in place & commit them, the consumer reads them in place & releases them.
+/// Blocking waits use shared futexes on Linux, falling back to polling on other platforms.
+class shared_ring : public noncopyable
+{
+public:
+	/// Size type.
+	typedef size_t size_type;
+
+	/// Record alignment.
+	static const size_type alignment = sizeof(shared_ring_record_header);
+	/// Record type of padding records.
+	static const int4 padding_type = -1;
+	/// Infinite timeout.
+	static const uint8 infinite = static_cast<uint8>(-1);
+
+private:
+	mapped_file m_file;
+	shared_ring_header *m_header;
+	char *m_buffer;
+	uint8 m_mask;
+
+	/// Initializes or validates the ring header.
+	LEAN_MAYBE_EXPORT void init();
+
+	/// Wakes the consumer.
+	LEAN_MAYBE_EXPORT void wake_readers();
+	/// Wakes all producers.
+	LEAN_MAYBE_EXPORT void wake_writers();
+
+	/// Gets the record at the given position.
+	LEAN_INLINE shared_ring_record_header* record_at(uint8 position) const
+	{
+		return reinterpret_cast<shared_ring_record_header*>(m_buffer + static_cast<size_t>(position & m_mask));
+	}
+	/// Gets the number of bytes occupied by a record of the given payload size.
+	LEAN_INLINE static size_type record_size(size_type size)
+	{
+		return memory::align_integer<alignment>(sizeof(shared_ring_record_header) + size);
+	}
+	/// Gets the number of padding bytes required to place a record of the given size at the given position.
+	LEAN_INLINE uint8 padding_size(uint8 position, size_type recordSize) const
+	{
+		uint8 toEnd = m_mask + 1 - (position & m_mask);
+		return (recordSize > toEnd) ? toEnd : 0;
+	}
+
+	/// Zeroes the record at the given position, making room for producers.
+	LEAN_INLINE uint8 clear_record(uint8 position, int4 length)
+	{
+		size_type size = memory::align_integer<alignment>(static_cast<size_type>(length));
+		memset(record_at(position), 0, size);
+		return position + size;
+	}
+	/// Consumes all records up to the given position.
+	LEAN_INLINE void consume(uint8 position)
+	{
+		// NOTE: Publish head before checking for waiters, pairs with wait_writable()
+		concurrent::atomic_store(m_header->head, position, concurrent::memory_order_seq_cst);
+
+		if (concurrent::atomic_load(m_header->writeWaiters, concurrent::memory_order_seq_cst))
+			wake_writers();
+	}
+	/// Publishes the given record length.
+	LEAN_INLINE void publish(shared_ring_record_header *record, int4 length)
+	{
+		// NOTE: Publish record before checking for waiters, pairs with wait_readable()
+		concurrent::atomic_store(record->length, length, concurrent::memory_order_seq_cst);
+
+		if (concurrent::atomic_load(m_header->readWaiters, concurrent::memory_order_seq_cst))
+			wake_readers();
+	}
+
+public:
+	/// Opens the given ring file, creating a new ring of (at least) the given capacity if the file does not exist
+	/// or is to be overwritten. All producers & the consumer open the same file. Throws a runtime_error if the
+	/// file exists but does not contain a shared ring.
+	LEAN_MAYBE_EXPORT explicit shared_ring(const utf8_ntri &name, size_type capacity = 1024 * 1024,
+		file::open_mode mode = file::open);
+	/// Closes this ring, records stay in the file.
+	LEAN_MAYBE_EXPORT ~shared_ring();
+
+	/// Reserves a record of the given size & type, returning a pointer to its payload or nullptr if the ring is
+	/// currently full. The record is required to be committed or aborted, blocking the consumer until then.
+	LEAN_INLINE void* reserve(size_type size, int4 type = 0)
+	{
+		LEAN_ASSERT(size <= max_record_size());
+		LEAN_ASSERT(type != padding_type);
+
+		shared_ring_header &header = *m_header;
+		const uint8 capacity = m_mask + 1;
+		const size_type recordSize = record_size(size);
+		uint8 tail, padding;
+
+		do
+		{
+			tail = concurrent::atomic_load(header.tail, concurrent::memory_order_acquire);
+			// Pairs with the release below, records behind the cached head are guaranteed to be consumed
+			uint8 head = concurrent::atomic_load(header.headCache, concurrent::memory_order_acquire);
+
+			// Records never wrap, pad up to the end of the buffer instead
+			padding = padding_size(tail, recordSize);
+			uint8 required = tail + padding + recordSize;
+
+			if (required - head > capacity)
+			{
+				head = concurrent::atomic_load(header.head, concurrent::memory_order_acquire);
+
+				if (required - head > capacity)
+					return nullptr;
+
+				concurrent::atomic_store(header.headCache, head, concurrent::memory_order_release);
+			}
+		}
+		while (!concurrent::atomic_test_and_set(header.tail, tail, tail + padding + recordSize));
+
+		if (padding)
+		{
+			shared_ring_record_header *paddingRecord = record_at(tail);
+			paddingRecord->type = padding_type;
+			concurrent::atomic_store(paddingRecord->length, static_cast<int4>(padding), concurrent::memory_order_release);
+			tail += padding;
+		}
+
+		shared_ring_record_header *record = record_at(tail);
+		record->type = type;
+		record->length = -static_cast<int4>(sizeof(shared_ring_record_header) + size);
+		return record + 1;
+	}
+	/// Commits the given reserved record, making it visible to the consumer.
+	LEAN_INLINE void commit(void *data)
+	{
+		shared_ring_record_header *record = static_cast<shared_ring_record_header*>(data) - 1;
+		LEAN_ASSERT(record->length < 0);
+		publish(record, -record->length);
+	}
+	/// Aborts the given reserved record, the consumer skips it.
+	LEAN_INLINE void abort(void *data)
+	{
+		shared_ring_record_header *record = static_cast<shared_ring_record_header*>(data) - 1;
+		LEAN_ASSERT(record->length < 0);
+		record->type = padding_type;
+		publish(record, -record->length);
+	}
+	/// Copies the given data into a new record of the given type, returning false if the ring is currently full.
+	LEAN_INLINE bool write(const void *data, size_type size, int4 type = 0)
+	{
+		void *record = reserve(size, type);
+
+		if (record)
+		{
+			memcpy(record, data, size);
+			commit(record);
+		}
+
+		return (record != nullptr);
+	}
+	/// Blocks until a record of the given size might be reserved or the given timeout has elapsed, returning false
+	/// if there is still not enough space. May return early, another producer may have taken the space in between.
+	LEAN_MAYBE_EXPORT bool wait_writable(size_type size, uint8 timeoutMicroseconds = infinite);
+
+	/// Gets the next committed record & its size and type, nullptr if none. Skips padding.
+	LEAN_INLINE const void* peek(size_type &size, int4 &type)
+	{
+		uint8 head = concurrent::atomic_load(m_header->head, concurrent::memory_order_relaxed);
+
+		for (;;)
+		{
+			shared_ring_record_header *record = record_at(head);
+			int4 length = concurrent::atomic_load(record->length, concurrent::memory_order_acquire);
+
+			if (length <= 0)
+				return nullptr;
+
+			if (record->type != padding_type)
+			{
+				size = length - sizeof(shared_ring_record_header);
+				type = record->type;
+				return record + 1;
+			}
+
+			head = clear_record(head, length);
+			consume(head);
+		}
+	}
+	/// Gets the next committed record & its size, nullptr if none. Skips padding.
+	LEAN_INLINE const void* peek(size_type &size)
+	{
+		int4 type;
+		return peek(size, type);
+	}
+	/// Releases the record returned by the last call to peek().
+	LEAN_INLINE void release()
+	{
+		uint8 head = concurrent::atomic_load(m_header->head, concurrent::memory_order_relaxed);
+		consume( clear_record(head, record_at(head)->length) );
+	}
+	/// Passes up to the given number of committed records to the given function, releasing all of them at once.
+	/// The function is called as fun(const void *data, size_type size, int4 type). Returns the number of records read.
+	template <class Function>
+	LEAN_INLINE size_type read(Function fun, size_type limit = static_cast<size_type>(-1))
+	{
+		const uint8 start = concurrent::atomic_load(m_header->head, concurrent::memory_order_relaxed);
+		uint8 head = start;
+		size_type count = 0;
+
+		while (count < limit)
+		{
+			shared_ring_record_header *record = record_at(head);
+			int4 length = concurrent::atomic_load(record->length, concurrent::memory_order_acquire);
+
+			if (length <= 0)
+				break;
+
+			if (record->type != padding_type)
+			{
+				fun(static_cast<const void*>(record + 1), static_cast<size_type>(length - sizeof(shared_ring_record_header)), record->type);
+				++count;
+			}
+
+			head = clear_record(head, length);
+		}
+
+		if (head != start)
+			consume(head);
+
+		return count;
+	}
+	/// Blocks until a record has been committed or the given timeout has elapsed, returning false if there are
+	/// still no records. May return early.
+	LEAN_MAYBE_EXPORT bool wait_readable(uint8 timeoutMicroseconds = infinite);
+
+	/// Gets the number of bytes currently occupied by records, including those still being reserved.
+	LEAN_INLINE uint8 size() const
+	{
+		return concurrent::atomic_load(m_header->tail, concurrent::memory_order_relaxed)
+			- concurrent::atomic_load(m_header->head, concurrent::memory_order_relaxed);
+	}
+	/// Checks whether the ring is currently empty.
+	LEAN_INLINE bool empty() const { return (size() == 0); }
+	/// Gets the size of the ring buffer, in bytes.
+	LEAN_INLINE size_type capacity() const { return static_cast<size_type>(m_mask + 1); }
+	/// Gets the maximum record size.
+	LEAN_INLINE size_type max_record_size() const { return capacity() / 4 - sizeof(shared_ring_record_header); }
+
+	/// Gets the ring header.
+	LEAN_INLINE shared_ring_header* header() { return m_header; }
+	/// Gets the ring header.
+	LEAN_INLINE const shared_ring_header* header() const { return m_header; }
+	/// Gets the underlying file.
+	LEAN_INLINE const mapped_file& backing_file() const { return m_file; }
+};
+
+} // namespace
+
+using io::shared_ring_header;
+using io::shared_ring;
+
+} // namespace
+
+#ifdef LEAN_INCLUDE_INLINED
+#include "source/shared_ring.cpp"
+#endif
+
+#endif
\ No newline at end of file
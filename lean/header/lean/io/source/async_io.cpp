@@ -0,0 +1,676 @@
+#ifdef LEAN_BUILD_LIB
+#include "../../depconfig.h"
+#endif
+
+// Use short file names in logging
+#ifndef LEAN_DEFAULT_FILE_MACRO
+	#line __LINE__ "async_io.cpp"
+#endif
+
+#include "../async_io.h"
+#include "../../concurrent/atomic.h"
+#include "../../concurrent/critical_section.h"
+#include "../../concurrent/semaphore.h"
+#include "../../concurrent/thread.h"
+#include "../../logging/errors.h"
+#include <vector>
+#include <cstring>
+
+#if defined(__linux__) && !defined(LEAN_NO_IO_URING)
+	#include <linux/io_uring.h>
+	#include <sys/mman.h>
+	#include <sys/syscall.h>
+	#include <sys/uio.h>
+	#include <unistd.h>
+	#include <cerrno>
+	#include "../../logging/posix_errors.h"
+
+	// NOTE: IORING_OP_READ & IORING_OP_WRITE were introduced together with fast poll
+	#if defined(IORING_FEAT_FAST_POLL) && defined(__NR_io_uring_setup)
+		#define LEAN_ASYNC_IO_URING
+	#endif
+#endif
+
+namespace lean
+{
+namespace io
+{
+namespace impl
+{
+	/// Asynchronous I/O engine interface.
+	class async_io_engine
+	{
+	protected:
+		async_io_engine() { }
+		virtual ~async_io_engine() { }
+
+	public:
+		/// Destroys this engine, no requests may be in flight.
+		virtual void destroy() = 0;
+
+		/// Prepares the given request for submission.
+		virtual void prepare(async_request &request) = 0;
+		/// Submits all prepared requests, returning the number of requests submitted.
+		virtual size_t flush() = 0;
+		/// Gets a list of completed requests linked by their next pointers, blocking until at least one request
+		/// has completed if requested.
+		virtual async_request* complete(bool wait) = 0;
+
+		/// Registers the given buffers.
+		virtual bool register_buffers(const async_buffer *buffers, size_t count) = 0;
+		/// Unregisters all buffers.
+		virtual void unregister_buffers() = 0;
+	};
+
+#ifdef LEAN_ASYNC_IO_URING
+
+	/// Asynchronous I/O engine based on a Linux io_uring, set up using raw system calls.
+	class uring_async_io_engine : public async_io_engine
+	{
+	private:
+		int m_ring;
+
+		void *m_ringMemory;
+		size_t m_ringSize;
+		io_uring_sqe *m_sqes;
+		size_t m_sqesSize;
+
+		volatile uint4 *m_sqHead;
+		volatile uint4 *m_sqTail;
+		uint4 m_sqMask;
+		uint4 *m_sqArray;
+		uint4 m_sqLocalTail;
+		uint4 m_sqEntries;
+
+		volatile uint4 *m_cqHead;
+		volatile uint4 *m_cqTail;
+		uint4 m_cqMask;
+		io_uring_cqe *m_cqes;
+
+		size_t m_prepared;
+		size_t m_pending;
+
+		/// Constructs an io_uring engine from the given ring file descriptor.
+		uring_async_io_engine(int ring)
+			: m_ring(ring),
+			m_ringMemory(MAP_FAILED),
+			m_ringSize(0),
+			m_sqes(static_cast<io_uring_sqe*>(MAP_FAILED)),
+			m_sqesSize(0),
+			m_prepared(0),
+			m_pending(0) { }
+		/// Unmaps the ring & closes the ring file descriptor.
+		~uring_async_io_engine()
+		{
+			if (m_sqes != MAP_FAILED)
+				::munmap(m_sqes, m_sqesSize);
+			if (m_ringMemory != MAP_FAILED)
+				::munmap(m_ringMemory, m_ringSize);
+			::close(m_ring);
+		}
+
+		/// Maps the ring buffers shared with the kernel.
+		bool map(const io_uring_params &params)
+		{
+			size_t sqSize = params.sq_off.array + params.sq_entries * sizeof(uint4);
+			size_t cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+			m_ringSize = (sqSize > cqSize) ? sqSize : cqSize;
+
+			m_ringMemory = ::mmap(nullptr, m_ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_SQ_RING);
+			if (m_ringMemory == MAP_FAILED)
+				return false;
+
+			m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+			m_sqes = static_cast<io_uring_sqe*>(
+					::mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_SQES)
+				);
+			if (m_sqes == MAP_FAILED)
+				return false;
+
+			char *ring = static_cast<char*>(m_ringMemory);
+
+			m_sqHead = reinterpret_cast<uint4*>(ring + params.sq_off.head);
+			m_sqTail = reinterpret_cast<uint4*>(ring + params.sq_off.tail);
+			m_sqMask = *reinterpret_cast<uint4*>(ring + params.sq_off.ring_mask);
+			m_sqArray = reinterpret_cast<uint4*>(ring + params.sq_off.array);
+			m_sqLocalTail = *m_sqTail;
+			m_sqEntries = params.sq_entries;
+
+			m_cqHead = reinterpret_cast<uint4*>(ring + params.cq_off.head);
+			m_cqTail = reinterpret_cast<uint4*>(ring + params.cq_off.tail);
+			m_cqMask = *reinterpret_cast<uint4*>(ring + params.cq_off.ring_mask);
+			m_cqes = reinterpret_cast<io_uring_cqe*>(ring + params.cq_off.cqes);
+
+			return true;
+		}
+
+		/// Submits the given number of requests, waiting for the given number of completions.
+		int enter(uint4 toSubmit, uint4 minComplete, uint4 flags)
+		{
+			return static_cast<int>( ::syscall(__NR_io_uring_enter, m_ring, toSubmit, minComplete, flags, nullptr, 0) );
+		}
+
+	public:
+		/// Creates an io_uring engine of the given queue depth, returning nullptr if io_uring is unavailable.
+		static uring_async_io_engine* create(size_t queueDepth)
+		{
+			io_uring_params params;
+			memset(&params, 0, sizeof(params));
+
+			int ring = static_cast<int>( ::syscall(__NR_io_uring_setup, static_cast<uint4>(queueDepth), &params) );
+
+			// Disabled, blocked by seccomp or too old
+			if (ring < 0)
+				return nullptr;
+
+			uring_async_io_engine *engine = new uring_async_io_engine(ring);
+
+			if (!(params.features & IORING_FEAT_FAST_POLL) || !engine->map(params))
+			{
+				delete engine;
+				return nullptr;
+			}
+
+			return engine;
+		}
+
+		/// Destroys this engine.
+		void destroy()
+		{
+			delete this;
+		}
+
+		/// Prepares the remainder of the given request for submission.
+		void prepare(async_request &request)
+		{
+			// Queue depth never exceeds submission queue size
+			LEAN_ASSERT(m_sqLocalTail - concurrent::atomic_load(*m_sqHead, concurrent::memory_order_acquire) < m_sqEntries);
+
+			// Result holds the number of bytes transferred so far
+			uint4 transferred = static_cast<uint4>(request.result);
+
+			uint4 index = m_sqLocalTail & m_sqMask;
+			io_uring_sqe &sqe = m_sqes[index];
+			memset(&sqe, 0, sizeof(sqe));
+
+			bool fixed = (request.bufferIndex >= 0);
+			sqe.opcode = static_cast<uint1>( (request.operation == async_request::write)
+				? (fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE)
+				: (fixed ? IORING_OP_READ_FIXED : IORING_OP_READ) );
+			sqe.fd = static_cast<int>(reinterpret_cast<intptr_t>(request.file->handle().get()));
+			sqe.off = request.offset + transferred;
+			sqe.addr = reinterpret_cast<uintptr_t>(request.buffer + transferred);
+			sqe.len = request.count - transferred;
+			if (fixed)
+				sqe.buf_index = static_cast<uint2>(request.bufferIndex);
+			sqe.user_data = reinterpret_cast<uintptr_t>(&request);
+
+			m_sqArray[index] = index;
+			++m_sqLocalTail;
+			++m_prepared;
+		}
+
+		/// Submits all prepared requests.
+		size_t flush()
+		{
+			size_t submitted = m_prepared;
+
+			if (submitted)
+			{
+				// NOTE: Publish entries before tail
+				concurrent::atomic_store(*m_sqTail, m_sqLocalTail, concurrent::memory_order_release);
+
+				while (m_prepared)
+				{
+					int result = enter(static_cast<uint4>(m_prepared), 0, 0);
+
+					if (result >= 0)
+					{
+						m_prepared -= result;
+						m_pending += result;
+					}
+					else if (errno == EAGAIN || errno == EBUSY)
+						// Kernel out of resources, make room by reaping completions
+						break;
+					else if (errno != EINTR)
+						LEAN_THROW_POSIX_ERROR_MSG("io_uring_enter()");
+				}
+
+				submitted -= m_prepared;
+			}
+
+			return submitted;
+		}
+
+		/// Gets a list of completed requests.
+		async_request* complete(bool wait)
+		{
+			async_request *first = nullptr, **last = &first;
+
+			for (;;)
+			{
+				uint4 head = *m_cqHead;
+				uint4 tail = concurrent::atomic_load(*m_cqTail, concurrent::memory_order_acquire);
+				bool resubmit = false;
+
+				for (; head != tail; ++head)
+				{
+					const io_uring_cqe &cqe = m_cqes[head & m_cqMask];
+
+					async_request *request = reinterpret_cast<async_request*>(static_cast<uintptr_t>(cqe.user_data));
+					--m_pending;
+
+					if (cqe.res > 0)
+					{
+						request->result += cqe.res;
+
+						// Short transfer, resubmit the remainder like the thread pool engine does
+						if (request->result < static_cast<ptrdiff_t>(request->count))
+						{
+							prepare(*request);
+							resubmit = true;
+							continue;
+						}
+					}
+					// Errors only reported if nothing was transferred
+					else if (cqe.res < 0 && request->result == 0)
+						request->result = cqe.res;
+
+					request->next = nullptr;
+					*last = request;
+					last = &request->next;
+				}
+
+				// NOTE: Release entries after reading them
+				concurrent::atomic_store(*m_cqHead, head, concurrent::memory_order_release);
+
+				if (resubmit)
+					flush();
+
+				if (first || !wait || (!m_pending && !m_prepared))
+					break;
+
+				// Submit what could not be submitted before, blocking for completions
+				int result = enter(static_cast<uint4>(m_prepared), 1, IORING_ENTER_GETEVENTS);
+
+				if (result >= 0)
+				{
+					m_prepared -= result;
+					m_pending += result;
+				}
+				else if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+					LEAN_THROW_POSIX_ERROR_MSG("io_uring_enter()");
+			}
+
+			return first;
+		}
+
+		/// Registers the given buffers.
+		bool register_buffers(const async_buffer *buffers, size_t count)
+		{
+			unregister_buffers();
+
+			std::vector<iovec> vectors(count);
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				vectors[i].iov_base = buffers[i].data;
+				vectors[i].iov_len = buffers[i].size;
+			}
+
+			return ::syscall(__NR_io_uring_register, m_ring, IORING_REGISTER_BUFFERS,
+				(count) ? &vectors[0] : nullptr, static_cast<uint4>(count)) == 0;
+		}
+
+		/// Unregisters all buffers.
+		void unregister_buffers()
+		{
+			// Fails if no buffers registered
+			::syscall(__NR_io_uring_register, m_ring, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+		}
+	};
+
+#endif
+
+	/// Asynchronous I/O engine issuing synchronous positional requests on a pool of threads.
+	class thread_pool_async_io_engine : public async_io_engine
+	{
+	private:
+		/// Intrusive request queue.
+		struct request_queue
+		{
+			async_request *first;
+			async_request **last;
+
+			/// Constructs an empty queue.
+			request_queue()
+				: first(nullptr),
+				last(&first) { }
+
+			/// Appends the given request.
+			void push(async_request &request)
+			{
+				request.next = nullptr;
+				*last = &request;
+				last = &request.next;
+			}
+			/// Appends the given list of requests.
+			void push(request_queue &queue)
+			{
+				if (queue.first)
+				{
+					*last = queue.first;
+					last = queue.last;
+					queue.clear();
+				}
+			}
+			/// Removes the first request.
+			async_request* pop()
+			{
+				async_request *request = first;
+
+				if (request)
+				{
+					first = request->next;
+					if (!first)
+						last = &first;
+				}
+
+				return request;
+			}
+			/// Removes all requests.
+			void clear()
+			{
+				first = nullptr;
+				last = &first;
+			}
+		};
+
+		/// Worker thread.
+		struct worker
+		{
+			thread_pool_async_io_engine *engine;
+
+			void operator ()()
+			{
+				while (async_request *request = engine->acquire())
+				{
+					request->result = static_cast<ptrdiff_t>( (request->operation == async_request::write)
+						? request->file->write_at(request->offset, request->buffer, request->count)
+						: request->file->read_at(request->offset, request->buffer, request->count) );
+
+					engine->release(*request);
+				}
+			}
+		};
+		friend struct worker;
+
+		request_queue m_prepared;
+
+		critical_section m_queueLock;
+		request_queue m_queued;
+		semaphore m_queuedCount;
+
+		critical_section m_completedLock;
+		request_queue m_completed;
+		semaphore m_completedCount;
+
+		std::vector<thread> m_threads;
+
+		/// Waits for the next queued request, nullptr when stopping.
+		async_request* acquire()
+		{
+			m_queuedCount.lock();
+
+			scoped_cs_lock lock(m_queueLock);
+			return m_queued.pop();
+		}
+		/// Enqueues the given completed request.
+		void release(async_request &request)
+		{
+			{
+				scoped_cs_lock lock(m_completedLock);
+				m_completed.push(request);
+			}
+
+			m_completedCount.unlock();
+		}
+
+	public:
+		/// Starts the given number of threads.
+		explicit thread_pool_async_io_engine(size_t threadCount)
+			: m_queuedCount(0),
+			m_completedCount(0)
+		{
+			m_threads.reserve(threadCount);
+
+			try
+			{
+				for (size_t i = 0; i < threadCount; ++i)
+				{
+					worker task = { this };
+					m_threads.push_back( thread(task) );
+				}
+			}
+			catch (...)
+			{
+				stop();
+				throw;
+			}
+		}
+		/// Stops all threads.
+		~thread_pool_async_io_engine()
+		{
+			stop();
+		}
+
+		/// Stops all threads.
+		void stop()
+		{
+			// Empty queue stops workers
+			for (size_t i = 0; i < m_threads.size(); ++i)
+				m_queuedCount.unlock();
+
+			for (size_t i = 0; i < m_threads.size(); ++i)
+				m_threads[i].join();
+
+			m_threads.clear();
+		}
+
+		/// Destroys this engine.
+		void destroy()
+		{
+			delete this;
+		}
+
+		/// Prepares the given request for submission.
+		void prepare(async_request &request)
+		{
+			m_prepared.push(request);
+		}
+
+		/// Submits all prepared requests.
+		size_t flush()
+		{
+			size_t submitted = 0;
+
+			for (async_request *request = m_prepared.first; request; request = request->next)
+				++submitted;
+
+			if (submitted)
+			{
+				{
+					scoped_cs_lock lock(m_queueLock);
+					m_queued.push(m_prepared);
+				}
+
+				for (size_t i = 0; i < submitted; ++i)
+					m_queuedCount.unlock();
+			}
+
+			return submitted;
+		}
+
+		/// Gets a list of completed requests.
+		async_request* complete(bool wait)
+		{
+			async_request *first;
+
+			do
+			{
+				// NOTE: Permits may be left over from requests taken along earlier, simply retry
+				if (wait)
+					m_completedCount.lock();
+				else if (!m_completedCount.try_lock())
+					return nullptr;
+
+				scoped_cs_lock lock(m_completedLock);
+				first = m_completed.first;
+				m_completed.clear();
+			}
+			while (!first);
+
+			return first;
+		}
+
+		/// Registers the given buffers.
+		bool register_buffers(const async_buffer*, size_t)
+		{
+			// Nothing to be gained
+			return true;
+		}
+
+		/// Unregisters all buffers.
+		void unregister_buffers() { }
+	};
+
+	/// Creates an asynchronous I/O engine.
+	inline async_io_engine* create_async_io_engine(size_t queueDepth, size_t threadCount, bool forceThreadPool,
+		async_io::engine_type &engineType)
+	{
+#ifdef LEAN_ASYNC_IO_URING
+		if (!forceThreadPool)
+			if (async_io_engine *engine = uring_async_io_engine::create(queueDepth))
+			{
+				engineType = async_io::io_uring;
+				return engine;
+			}
+#endif
+
+		engineType = async_io::thread_pool;
+		return new thread_pool_async_io_engine((threadCount > 0) ? threadCount : 1);
+	}
+
+} // namespace
+} // namespace
+} // namespace
+
+// Constructs an asynchronous I/O engine keeping up to the given number of requests in flight.
+LEAN_MAYBE_INLINE lean::io::async_io::async_io(size_t queueDepth, size_t threadCount, bool forceThreadPool)
+	: m_engine(nullptr),
+	m_engineType(thread_pool),
+	m_queueDepth((queueDepth > 0) ? queueDepth : 1),
+	m_inFlight(0)
+{
+	m_engine = impl::create_async_io_engine(m_queueDepth, threadCount, forceThreadPool, m_engineType);
+}
+
+// Waits for all requests in flight to complete.
+LEAN_MAYBE_INLINE lean::io::async_io::~async_io()
+{
+	try
+	{
+		wait_all();
+	}
+	catch (...)
+	{
+		LEAN_LOG_ERROR_MSG("Failed to complete asynchronous I/O requests in flight");
+	}
+
+	m_engine->destroy();
+}
+
+// Prepares the given request for submission by the next call to flush().
+LEAN_MAYBE_INLINE void lean::io::async_io::prepare(async_request &request)
+{
+	LEAN_ASSERT(request.file);
+
+	while (m_inFlight >= m_queueDepth)
+	{
+		flush();
+		process(true);
+	}
+
+	request.result = 0;
+	request.completed = 0;
+	m_engine->prepare(request);
+	++m_inFlight;
+}
+
+// Submits all prepared requests, returning the number of requests submitted.
+LEAN_MAYBE_INLINE size_t lean::io::async_io::flush()
+{
+	return m_engine->flush();
+}
+
+// Processes completions, blocking until at least one request has completed if requested.
+LEAN_MAYBE_INLINE size_t lean::io::async_io::process(bool wait)
+{
+	size_t count = 0;
+
+	if (m_inFlight)
+	{
+		async_request *request = m_engine->complete(wait);
+
+		while (request)
+		{
+			// NOTE: Request may be reused by its callback
+			async_request *next = request->next;
+
+			--m_inFlight;
+			++count;
+
+			concurrent::atomic_store(request->completed, 1L, concurrent::memory_order_release);
+			if (request->callback)
+				request->callback(*request);
+
+			request = next;
+		}
+	}
+
+	return count;
+}
+
+// Submits all prepared requests & blocks until the given request has completed.
+LEAN_MAYBE_INLINE void lean::io::async_io::wait(async_request &request)
+{
+	flush();
+
+	while (!request.done() && m_inFlight)
+		process(true);
+}
+
+// Submits all prepared requests & blocks until all requests in flight have completed.
+LEAN_MAYBE_INLINE void lean::io::async_io::wait_all()
+{
+	flush();
+
+	while (m_inFlight)
+		process(true);
+}
+
+// Registers the given buffers, allowing for requests to reference them by index.
+LEAN_MAYBE_INLINE bool lean::io::async_io::register_buffers(const async_buffer *buffers, size_t count)
+{
+	LEAN_ASSERT(m_inFlight == 0);
+
+	return m_engine->register_buffers(buffers, count);
+}
+
+// Unregisters all buffers.
+LEAN_MAYBE_INLINE void lean::io::async_io::unregister_buffers()
+{
+	LEAN_ASSERT(m_inFlight == 0);
+
+	m_engine->unregister_buffers();
+}
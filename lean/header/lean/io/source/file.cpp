@@ -7,6 +7,8 @@
 	#line __LINE__ "file.cpp"
 #endif
 
+#ifdef _WIN32
+
 #include <windows.h>
 #include "../file.h"
 #include "../../strings/conversions.h"
@@ -175,4 +177,186 @@ LEAN_MAYBE_INLINE void lean::io::file::touch()
 	
 	if (!::SetFileTime(m_handle, nullptr, nullptr, &currentFileTime))
 		LEAN_LOG_WIN_ERROR_CTX("SetFileTime()", name().c_str());
-}
\ No newline at end of file
+}
+
+#else
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include "../file.h"
+#include "../../logging/posix_errors.h"
+
+namespace lean
+{
+namespace io
+{
+namespace impl
+{
+	/// Converts the given access flags & open mode into valid POSIX open flags.
+	inline int get_posix_open_flags(uint4 access, file::open_mode mode)
+	{
+		int flags = O_CLOEXEC;
+
+		if (access & file::write)
+		{
+			flags |= (access & file::read) ? O_RDWR : O_WRONLY;
+
+			switch (mode)
+			{
+			case file::append:
+				break;
+			case file::create:
+				flags |= O_CREAT | O_EXCL;
+				break;
+			case file::overwrite:
+				flags |= O_CREAT | O_TRUNC;
+				break;
+			case file::open:
+			default:
+				flags |= O_CREAT;
+				break;
+			}
+		}
+		else
+			// Always require some kind of access
+			flags |= O_RDONLY;
+
+		return flags;
+	}
+
+	/// Converts the given optimization hints into the corresponding POSIX advice.
+	inline int get_posix_advice(uint4 hints)
+	{
+		if (hints & file::sequential)
+			return POSIX_FADV_SEQUENTIAL;
+		else if (hints & file::random)
+			return POSIX_FADV_RANDOM;
+		else
+			return POSIX_FADV_NORMAL;
+	}
+
+	/// Checks whether the given sharing flags require exclusive access to be enforced.
+	inline bool requires_exclusive_access(uint4 share, uint4 access)
+	{
+		// Emulate windows sharing semantics, deny other writers unless shared for writing
+		return !(share & file::write) && ((access & file::write) || share == file::dont_share);
+	}
+
+	/// Wraps the given file descriptor into a file handle.
+	inline windows_file_handle to_file_handle(int fd)
+	{
+		return reinterpret_cast<void*>(static_cast<intptr_t>(fd));
+	}
+
+	/// Gets the file descriptor wrapped by the given file handle.
+	inline int to_file_descriptor(windows_file_handle handle)
+	{
+		return static_cast<int>(reinterpret_cast<intptr_t>(handle.get()));
+	}
+
+	/// Opens the given file according to the given flags. Throws a runtime_exception on error.
+	inline int open_file(const utf8_string &name, uint4 access, file::open_mode mode, uint4 hints, uint4 share)
+	{
+		int fd = ::open(name.c_str(), get_posix_open_flags(access, mode), 0666);
+
+		if (fd == -1)
+			LEAN_THROW_POSIX_ERROR_CTX("open()", name.c_str());
+
+		// Emulate exclusive access using advisory locks
+		if (requires_exclusive_access(share, access) && ::flock(fd, LOCK_EX | LOCK_NB) == -1)
+		{
+			int error = errno;
+			::close(fd);
+			errno = error;
+			LEAN_THROW_POSIX_ERROR_CTX("flock()", name.c_str());
+		}
+
+		if (hints != file::none)
+			::posix_fadvise(fd, 0, 0, get_posix_advice(hints));
+
+		return fd;
+	}
+
+} // namespace
+} // namespace
+} // namespace
+
+// Opens the given file according to the given flags. Throws a runtime_exception on error.
+LEAN_MAYBE_INLINE lean::io::file::file(const utf8_ntri &name,
+	uint4 access, open_mode mode, uint4 hints, uint4 share)
+	: m_name(name.to<utf8_string>()),
+	m_handle( impl::to_file_handle(impl::open_file(m_name, access, mode, hints, share)) )
+{
+}
+
+// Closes this file.
+LEAN_MAYBE_INLINE lean::io::file::~file()
+{
+	::close(impl::to_file_descriptor(m_handle));
+}
+
+// Sets the current file cursor position. Throws a runtime_exception on error.
+LEAN_MAYBE_INLINE void lean::io::file::pos(uint8 newPos)
+{
+	if (::lseek(impl::to_file_descriptor(handle()), static_cast<off_t>(newPos), SEEK_SET) == static_cast<off_t>(-1))
+		LEAN_THROW_POSIX_ERROR_CTX("lseek()", name().c_str());
+}
+
+// Gets the current file cursor position. Returns 0 on error.
+LEAN_MAYBE_INLINE lean::uint8 lean::io::file::pos() const
+{
+	off_t pos = ::lseek(impl::to_file_descriptor(handle()), 0, SEEK_CUR);
+	return (pos != static_cast<off_t>(-1)) ? static_cast<uint8>(pos) : 0;
+}
+
+// Resizes the file, either extending or truncating it. Throws a runtime_exception on error.
+LEAN_MAYBE_INLINE void lean::io::file::resize(uint8 newSize)
+{
+	if (::ftruncate(impl::to_file_descriptor(handle()), static_cast<off_t>(newSize)) == -1)
+		LEAN_THROW_POSIX_ERROR_CTX("ftruncate()", name().c_str());
+
+	pos(0);
+}
+
+// Gets the last modification time in microseconds since 1/1/1970. Returns 0 if file is currently open for writing.
+LEAN_MAYBE_INLINE lean::uint8 lean::io::file::revision() const
+{
+	struct stat status;
+
+	if (::fstat(impl::to_file_descriptor(m_handle), &status) == -1)
+	{
+		LEAN_LOG_POSIX_ERROR_CTX("fstat()", name().c_str());
+		return 0;
+	}
+
+	return static_cast<uint8>(status.st_mtim.tv_sec) * 1000000U
+		+ static_cast<uint8>(status.st_mtim.tv_nsec) / 1000U;
+}
+
+// Gets the size of this file, in bytes.
+LEAN_MAYBE_INLINE lean::uint8 lean::io::file::size() const
+{
+	struct stat status;
+
+	if (::fstat(impl::to_file_descriptor(m_handle), &status) == -1)
+	{
+		LEAN_LOG_POSIX_ERROR_CTX("fstat()", name().c_str());
+		return 0;
+	}
+
+	return static_cast<uint8>(status.st_size);
+}
+
+// Marks this file modified.
+LEAN_MAYBE_INLINE void lean::io::file::touch()
+{
+	// Null times equal current time
+	if (::futimens(impl::to_file_descriptor(m_handle), nullptr) == -1)
+		LEAN_LOG_POSIX_ERROR_CTX("futimens()", name().c_str());
+}
+
+#endif
\ No newline at end of file
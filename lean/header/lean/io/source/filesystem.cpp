@@ -7,6 +7,8 @@
 	#line __LINE__ "filesystem.cpp"
 #endif
 
+#ifdef _WIN32
+
 #include <windows.h>
 #include "../filesystem.h"
 #include "../../logging/win_errors.h"
@@ -81,3 +83,74 @@ LEAN_MAYBE_LINK size_t lean::io::current_directory(utf16_t *buffer, size_t buffe
 			buffer
 		);
 }
+
+#else
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <climits>
+#include "../filesystem.h"
+#include "../../logging/posix_errors.h"
+
+// Checks whether the given file exists.
+LEAN_MAYBE_LINK bool lean::io::file_exists(const utf16_nti& file)
+{
+	struct stat status;
+	return (::stat(utf_to_utf8(file).c_str(), &status) == 0);
+}
+
+// Gets the last modification time in microseconds since 1/1/1970. Returns 0 on error.
+LEAN_MAYBE_LINK lean::uint8 lean::io::file_revision(const utf16_nti& file)
+{
+	uint8 revision = 0;
+	utf8_string fileName = utf_to_utf8(file);
+	struct stat status;
+
+	if (::stat(fileName.c_str(), &status) == -1)
+		LEAN_LOG_POSIX_ERROR_CTX("stat()", fileName.c_str());
+	else
+		revision = static_cast<uint8>(status.st_mtim.tv_sec) * 1000000U
+			+ static_cast<uint8>(status.st_mtim.tv_nsec) / 1000U;
+
+	return revision;
+}
+
+// Gets the size of the given file, in bytes. Returns 0 on error.
+LEAN_MAYBE_LINK lean::uint8 lean::io::file_size(const utf16_nti& file)
+{
+	uint8 size = 0;
+	utf8_string fileName = utf_to_utf8(file);
+	struct stat status;
+
+	if (::stat(fileName.c_str(), &status) == -1)
+		LEAN_LOG_POSIX_ERROR_CTX("stat()", fileName.c_str());
+	else
+		size = static_cast<uint8>(status.st_size);
+
+	return size;
+}
+
+// Gets the current directory. Will return the buffer size required to store the
+// current directory, if the given buffer is too small, the number of actual
+// characters written, otherwise (excluding the terminating null appended).
+LEAN_MAYBE_LINK size_t lean::io::current_directory(utf16_t *buffer, size_t bufferSize)
+{
+	char directory[PATH_MAX];
+
+	if (!::getcwd(directory, PATH_MAX))
+	{
+		LEAN_LOG_POSIX_ERROR_MSG("getcwd()");
+		return 0;
+	}
+
+	utf16_string wideDirectory = utf_to_utf16(directory);
+
+	if (wideDirectory.size() >= bufferSize)
+		return wideDirectory.size() + 1;
+
+	std::copy(wideDirectory.begin(), wideDirectory.end(), buffer);
+	buffer[wideDirectory.size()] = 0;
+	return wideDirectory.size();
+}
+
+#endif
@@ -0,0 +1,107 @@
+#ifdef LEAN_BUILD_LIB
+#include "../../depconfig.h"
+#endif
+
+// Use short file names in logging
+#ifndef LEAN_DEFAULT_FILE_MACRO
+	#line __LINE__ "mapped_arena.cpp"
+#endif
+
+#include "../mapped_arena.h"
+#include "../filesystem.h"
+#include "../../logging/errors.h"
+
+namespace lean
+{
+namespace io
+{
+namespace impl
+{
+	/// Gets the size of the file to be opened, 0 to keep the current file size.
+	inline uint8 get_mapped_arena_size(const utf8_ntri &name, uint8 capacity, file::open_mode mode)
+	{
+		if (mode != file::overwrite && file_exists(name) && file_size(name) >= sizeof(mapped_arena_header))
+			return 0;
+		else
+			return (capacity > sizeof(mapped_arena_header)) ? capacity : sizeof(mapped_arena_header);
+	}
+
+} // namespace
+} // namespace
+} // namespace
+
+// Opens the given arena file, creating a new arena of the given capacity if the file does not exist or is to be overwritten.
+LEAN_MAYBE_INLINE lean::io::mapped_arena::mapped_arena(const utf8_ntri &name, uint8 capacity,
+		file::open_mode mode, uint4 hints, uint4 share)
+	: m_file(name, impl::get_mapped_arena_size(name, capacity, mode), true, mode, hints, share)
+{
+	init();
+}
+
+// Closes this arena, memory stays allocated in the file.
+LEAN_MAYBE_INLINE lean::io::mapped_arena::~mapped_arena()
+{
+}
+
+// Initializes or validates the arena header.
+LEAN_MAYBE_INLINE void lean::io::mapped_arena::init()
+{
+	mapped_arena_header &header = *this->header();
+
+	// New files are zero-initialized
+	if (header.magic == 0 && header.size == 0)
+	{
+		header.magic = mapped_arena_header::magic_value;
+		header.version = mapped_arena_header::version_value;
+		header.size = sizeof(mapped_arena_header);
+		header.root = 0;
+	}
+	else if (header.magic != mapped_arena_header::magic_value || header.version != mapped_arena_header::version_value
+		|| header.size < sizeof(mapped_arena_header) || header.size > m_file.size())
+		LEAN_THROW_ERROR_CTX("Invalid mapped arena file", m_file.name().c_str());
+
+	header.capacity = m_file.size();
+}
+
+// Allocates the given amount of memory respecting the given alignment.
+LEAN_MAYBE_INLINE void* lean::io::mapped_arena::allocate(size_type size, size_type alignment)
+{
+	void *memory = header()->try_allocate(size, alignment);
+
+	if (!memory)
+	{
+		// Grow geometrically to amortize re-mapping
+		uint8 required = this->size() + alignment + size;
+		uint8 newCapacity = 2 * capacity();
+		reserve( (newCapacity > required) ? newCapacity : required );
+
+		memory = header()->try_allocate(size, alignment);
+		LEAN_ASSERT(memory);
+	}
+
+	return memory;
+}
+
+// Grows the file to the given capacity.
+LEAN_MAYBE_INLINE void lean::io::mapped_arena::reserve(uint8 capacity)
+{
+	if (capacity > this->capacity())
+	{
+		m_file.resize(capacity);
+		m_file.map();
+		header()->capacity = capacity;
+	}
+}
+
+// Truncates the file to the memory allocated.
+LEAN_MAYBE_INLINE void lean::io::mapped_arena::trim()
+{
+	uint8 size = this->size();
+
+	if (size < capacity())
+	{
+		m_file.resize(size);
+		m_file.map();
+		header()->capacity = size;
+	}
+}
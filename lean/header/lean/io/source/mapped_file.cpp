@@ -7,6 +7,8 @@
 	#line __LINE__ "mapped_file.cpp"
 #endif
 
+#ifdef _WIN32
+
 #include <windows.h>
 #include "../mapped_file.h"
 #include "../../logging/win_errors.h"
@@ -126,17 +128,23 @@ LEAN_MAYBE_INLINE void lean::io::mapped_file_base::resize(uint8 newSize)
 	m_mappingHandle = createMapping(*this, false, newSize);
 }
 
-// Maps the given view of this file. A size of 0 maps the entire file starting at the given offset.
-// Throws a runtime_exception on error.
-LEAN_MAYBE_INLINE void* lean::io::mapped_file_base::map(bool readonly, uint8 offset, size_t size)
+// Maps the given view of this file. A size of 0 maps the entire file starting at the given offset,
+// the given size is updated to the number of bytes actually mapped. Throws a runtime_exception on error.
+LEAN_MAYBE_INLINE void* lean::io::mapped_file_base::map(bool readonly, uint8 offset, size_t &size)
 {
+	// Resolve size of 0 to end of file
+	if (size == 0)
+	{
+		uint8 fileSize = this->size();
+		size = (offset < fileSize) ? impl::clamp_map_size(fileSize - offset) : 0;
+	}
+
 	// Offset is required to be aligned using system allocation granularity
 	uint8 alignedOffset = impl::align_map_offset(offset);
 	size_t alignmentDelta = static_cast<size_t>(offset - alignedOffset);
 	// WARNING: DON'T align size, easily out-of-bounds otherwise
 	size_t alignedSize = /*impl::align_map_size(*/ size + alignmentDelta /*)*/;
 
-	// Handles size of 0 equal to end of file
 	void *memory = (m_mappingHandle != NULL)
 		? ::MapViewOfFile(m_mappingHandle,
 			(readonly) ? FILE_MAP_READ : (FILE_MAP_READ | FILE_MAP_WRITE),
@@ -153,17 +161,165 @@ LEAN_MAYBE_INLINE void* lean::io::mapped_file_base::map(bool readonly, uint8 off
 }
 
 // Unmaps the given view of this file.
-LEAN_MAYBE_INLINE void lean::io::mapped_file_base::unmap(void *memory)
+LEAN_MAYBE_INLINE void lean::io::mapped_file_base::unmap(void *memory, size_t size)
 {
 	if (memory)
 		::UnmapViewOfFile(impl::align_mapped_memory(memory));
 }
 
+// Flushes the file contents in the mapped range to disk, returing true on success. Ignored, if currently unmapped.
+LEAN_MAYBE_INLINE bool lean::io::mapped_file::flush()
+{
+	return (m_memory)
+		? (::FlushViewOfFile(m_memory, 0) != FALSE)
+		: false;
+}
+
+#else
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include "../mapped_file.h"
+#include "../../logging/posix_errors.h"
+
+namespace lean
+{
+namespace io
+{
+namespace impl
+{
+	/// Gets the memory alignment required in offset map calls.
+	inline size_t get_map_alignment()
+	{
+		static const size_t alignment = static_cast<size_t>( ::sysconf(_SC_PAGESIZE) );
+		
+		// Guarantee a power of two
+		LEAN_ASSERT( (alignment & (alignment - 1)) == 0 );
+
+		return alignment;
+	}
+
+	/// Aligns the given map offset.
+	inline uint8 align_map_offset(uint8 offset)
+	{
+		return offset & ~static_cast<uint8>(get_map_alignment() - 1);
+	}
+
+	/// Aligns the given pointer to mapped memory.
+	template <class Type>
+	inline Type* align_mapped_memory(Type *memory)
+	{
+		return reinterpret_cast<Type*>(
+			reinterpret_cast<uintptr_t>(memory) &  ~static_cast<uintptr_t>(get_map_alignment() - 1) );
+	}
+
+	/// Clamps the given map size.
+	inline size_t clamp_map_size(uint8 size)
+	{
+		return (size < static_cast<size_t>(-1))
+			? static_cast<size_t>(size)
+			: static_cast<size_t>(-1);
+	}
+
+} // namespace
+} // namespace
+} // namespace
+
+// Opens the given file according to the given flags. Throws a runtime_exception on error.
+LEAN_MAYBE_INLINE lean::io::mapped_file_base::mapped_file_base(const utf8_ntri &name,
+		bool readonly, uint8 size,
+		open_mode mode, uint4 hints, uint4 share)
+	: file(name,
+		(readonly) ? file::read : (file::read | file::write),
+		mode, hints, share),
+	m_mappingHandle( createMapping(*this, readonly, size) )
+{
+}
+
+// Closes this file.
+LEAN_MAYBE_INLINE lean::io::mapped_file_base::~mapped_file_base()
+{
+}
+
+// Creates a file mapping. Throws a runtime_exception on error.
+// A size of 0 equals the current file size. Sets the file size to the given size if not read-only.
+LEAN_MAYBE_INLINE lean::io::windows_file_handle lean::io::mapped_file_base::createMapping(file &file, bool readonly, uint8 size)
+{
+	if (!readonly && size != 0 && size != file.size())
+		file.resize(size);
+
+	// Files are mapped directly, no separate mapping object
+	return nullptr;
+}
+
+// Resizes the file, either extending or truncating it. Throws a runtime_exception on error.
+// Automatically destroys the mapping, re-mapping is only possible again after this method has returned successfully.
+LEAN_MAYBE_INLINE void lean::io::mapped_file_base::resize(uint8 newSize)
+{
+	m_mappingHandle = createMapping(*this, false, newSize);
+}
+
+// Maps the given view of this file. A size of 0 maps the entire file starting at the given offset,
+// the given size is updated to the number of bytes actually mapped. Throws a runtime_exception on error.
+LEAN_MAYBE_INLINE void* lean::io::mapped_file_base::map(bool readonly, uint8 offset, size_t &size)
+{
+	// Resolve size of 0 to end of file
+	if (size == 0)
+	{
+		uint8 fileSize = this->size();
+		size = (offset < fileSize) ? impl::clamp_map_size(fileSize - offset) : 0;
+	}
+
+	// Offset is required to be aligned using page size
+	uint8 alignedOffset = impl::align_map_offset(offset);
+	size_t alignmentDelta = static_cast<size_t>(offset - alignedOffset);
+
+	void *memory = ::mmap(nullptr, size + alignmentDelta,
+		(readonly) ? PROT_READ : (PROT_READ | PROT_WRITE),
+		MAP_SHARED,
+		static_cast<int>(reinterpret_cast<intptr_t>(handle().get())),
+		static_cast<off_t>(alignedOffset));
+
+	if (memory == MAP_FAILED)
+		LEAN_THROW_POSIX_ERROR_CTX("mmap()", name().c_str());
+
+	// Return requested unaligned address
+	return reinterpret_cast<char*>(memory) + alignmentDelta;
+}
+
+// Unmaps the given view of this file.
+LEAN_MAYBE_INLINE void lean::io::mapped_file_base::unmap(void *memory, size_t size)
+{
+	if (memory)
+	{
+		void *alignedMemory = impl::align_mapped_memory(memory);
+		::munmap(alignedMemory, size + static_cast<size_t>(static_cast<char*>(memory) - static_cast<char*>(alignedMemory)));
+	}
+}
+
+// Flushes the file contents in the mapped range to disk, returing true on success. Ignored, if currently unmapped.
+LEAN_MAYBE_INLINE bool lean::io::mapped_file::flush()
+{
+	if (m_memory)
+	{
+		void *alignedMemory = impl::align_mapped_memory(m_memory);
+		
+		return (::msync(alignedMemory,
+			m_size + static_cast<size_t>(static_cast<char*>(m_memory) - static_cast<char*>(alignedMemory)),
+			MS_SYNC) == 0);
+	}
+	else
+		return false;
+}
+
+#endif
+
 // Opens the given file according to the given flags. Throws a runtime_exception on error.
 LEAN_MAYBE_INLINE lean::io::rmapped_file::rmapped_file(const utf8_ntri &name,
 		bool mapWhole, open_mode mode, uint4 hints, uint4 share)
 	: mapped_file_base(name, true, 0, mode, hints, share),
-	m_memory( (mapWhole) ? mapped_file_base::map(true, 0, 0) : nullptr )
+	m_size(0),
+	m_memory( (mapWhole) ? mapped_file_base::map(true, 0, m_size) : nullptr )
 {
 }
 
@@ -181,14 +337,16 @@ LEAN_MAYBE_INLINE const void* lean::io::rmapped_file::map(uint8 offset, size_t s
 		unmap();
 
 	m_memory = mapped_file_base::map(true, offset, size);
+	m_size = size;
 	return m_memory;
 }
 
 // Unmaps the file.
 LEAN_MAYBE_INLINE void lean::io::rmapped_file::unmap()
 {
-	mapped_file_base::unmap(const_cast<void*>(m_memory));
+	mapped_file_base::unmap(const_cast<void*>(m_memory), m_size);
 	m_memory = nullptr;
+	m_size = 0;
 }
 
 // Opens the given file according to the given flags. Throws a runtime_exception on error.
@@ -196,8 +354,9 @@ LEAN_MAYBE_INLINE void lean::io::rmapped_file::unmap()
 LEAN_MAYBE_INLINE lean::io::mapped_file::mapped_file(const utf8_ntri &name,
 		uint8 size, bool mapWhole, open_mode mode, uint4 hints, uint4 share)
 	: mapped_file_base(name, false, size, mode, hints, share),
+	m_size( (mapWhole) ? impl::clamp_map_size(size) : 0 ),
 	m_memory( (mapWhole)
-		? mapped_file_base::map(false, 0, impl::clamp_map_size(size))
+		? mapped_file_base::map(false, 0, m_size)
 		: nullptr )
 {
 }
@@ -216,22 +375,16 @@ LEAN_MAYBE_INLINE void* lean::io::mapped_file::map(uint8 offset, size_t size)
 		unmap();
 
 	m_memory = mapped_file_base::map(false, offset, size);
+	m_size = size;
 	return m_memory;
 }
 
 // Unmaps the file.
 LEAN_MAYBE_INLINE void lean::io::mapped_file::unmap()
 {
-	mapped_file_base::unmap(m_memory);
+	mapped_file_base::unmap(m_memory, m_size);
 	m_memory = nullptr;
-}
-
-// Flushes the file contents in the mapped range to disk, returing true on success. Ignored, if currently unmapped.
-LEAN_MAYBE_INLINE bool lean::io::mapped_file::flush()
-{
-	return (m_memory)
-		? (::FlushViewOfFile(m_memory, 0) != FALSE)
-		: false;
+	m_size = 0;
 }
 
 // Resizes the file, either extending or truncating it. Throws a runtime_exception on error.
@@ -7,9 +7,165 @@
 	#line __LINE__ "raw_file.cpp"
 #endif
 
-#include <windows.h>
 #include "../raw_file.h"
-#include "../../logging/win_errors.h"
+
+#ifdef _WIN32
+	#include <windows.h>
+	#include "../../logging/win_errors.h"
+#else
+	#include <unistd.h>
+	#include <sys/uio.h>
+	#include <cerrno>
+	#include <climits>
+	#include "../../logging/posix_errors.h"
+#endif
+
+namespace lean
+{
+namespace io
+{
+namespace impl
+{
+#ifdef _WIN32
+	/// Clamps the given number of bytes to the maximum transferable by one call.
+	inline DWORD clamp_transfer_size(size_t count)
+	{
+		return (count > static_cast<DWORD>(-1)) ? static_cast<DWORD>(-1) : static_cast<DWORD>(count);
+	}
+
+	/// Constructs an overlapped structure pointing to the given file offset.
+	inline ::OVERLAPPED make_file_offset(uint8 offset)
+	{
+		::OVERLAPPED overlapped = { 0 };
+		overlapped.Offset = static_cast<DWORD>(offset);
+		overlapped.OffsetHigh = static_cast<DWORD>(offset >> size_info<DWORD>::bits);
+		return overlapped;
+	}
+#else
+	/// Clamps the given number of bytes to the maximum transferable by one call.
+	inline size_t clamp_transfer_size(size_t count)
+	{
+		return (count > static_cast<size_t>(SSIZE_MAX)) ? static_cast<size_t>(SSIZE_MAX) : count;
+	}
+
+	/// Gets the file descriptor of the given file.
+	inline int get_file_descriptor(const file &file)
+	{
+		return static_cast<int>(reinterpret_cast<intptr_t>(file.handle().get()));
+	}
+
+	/// Maximum number of ranges passed to one vectored system call.
+	static const int max_io_vector_count = 64;
+
+	/// Vectored system calls.
+	enum io_vector_call
+	{
+		call_readv,
+		call_writev,
+		call_preadv,
+		call_pwritev
+	};
+
+	/// Gets the name of the given vectored system call.
+	inline const char* get_io_vector_call_name(io_vector_call call)
+	{
+		static const char *const names[] = { "readv()", "writev()", "preadv()", "pwritev()" };
+		return names[call];
+	}
+
+	/// Transfers the given list of ranges of bytes in batches of vectored system calls.
+	template <class Span>
+	inline size_t transfer_spans(const raw_file &file, io_vector_call call, const range<const Span*> &spans, uint8 offset)
+	{
+		const int fd = get_file_descriptor(file);
+		const Span *span = spans.begin();
+		size_t spanOffset = 0;
+		size_t total = 0;
+
+		for (;;)
+		{
+			::iovec vectors[max_io_vector_count];
+			int vectorCount = 0;
+			size_t vectorBytes = 0;
+
+			for (const Span *it = span; it != spans.end() && vectorCount < max_io_vector_count; ++it)
+			{
+				size_t begin = (it == span) ? spanOffset : 0;
+				size_t count = clamp_transfer_size(it->size() - begin);
+
+				// Stay within limits of one call
+				if (count > static_cast<size_t>(SSIZE_MAX) - vectorBytes)
+					count = static_cast<size_t>(SSIZE_MAX) - vectorBytes;
+				if (count == 0)
+					continue;
+
+				vectors[vectorCount].iov_base = const_cast<char*>(it->begin() + begin);
+				vectors[vectorCount].iov_len = count;
+				++vectorCount;
+				vectorBytes += count;
+			}
+
+			if (vectorCount == 0)
+				break;
+
+			ssize_t transferred;
+
+			switch (call)
+			{
+			case call_readv:
+				transferred = ::readv(fd, vectors, vectorCount);
+				break;
+			case call_writev:
+				transferred = ::writev(fd, vectors, vectorCount);
+				break;
+			case call_preadv:
+				transferred = ::preadv(fd, vectors, vectorCount, static_cast<off_t>(offset + total));
+				break;
+			default:
+				transferred = ::pwritev(fd, vectors, vectorCount, static_cast<off_t>(offset + total));
+				break;
+			}
+
+			if (transferred == -1)
+			{
+				if (errno == EINTR)
+					continue;
+
+				LEAN_LOG_POSIX_ERROR_CTX(get_io_vector_call_name(call), file.name().c_str());
+				break;
+			}
+			// End of file
+			else if (transferred == 0)
+				break;
+
+			total += static_cast<size_t>(transferred);
+
+			// Skip ranges transferred completely
+			for (size_t remaining = static_cast<size_t>(transferred); remaining > 0; )
+			{
+				size_t left = span->size() - spanOffset;
+
+				if (remaining < left)
+				{
+					spanOffset += remaining;
+					remaining = 0;
+				}
+				else
+				{
+					remaining -= left;
+					++span;
+					spanOffset = 0;
+				}
+			}
+		}
+
+		return total;
+	}
+#endif
+
+} // namespace
+} // namespace
+} // namespace
 
 // Opens the given file according to the given flags. Throws a runtime_exception on error.
 LEAN_MAYBE_INLINE lean::io::raw_file::raw_file(const utf8_ntri &name,
@@ -23,6 +179,8 @@ LEAN_MAYBE_INLINE lean::io::raw_file::~raw_file()
 {
 }
 
+#ifdef _WIN32
+
 // Reads the given number of bytes from the file, returning the number of bytes read. This method is thread-safe.
 LEAN_MAYBE_INLINE size_t lean::io::raw_file::read(char *begin, size_t count) const
 {
@@ -30,7 +188,7 @@ LEAN_MAYBE_INLINE size_t lean::io::raw_file::read(char *begin, size_t count) con
 
 	// Thread-safe: http://msdn.microsoft.com/en-us/library/ms810467
 	// MONITOR: DWORD 32 bit only!
-	if (!::ReadFile(handle(), begin, (count > static_cast<DWORD>(-1)) ? static_cast<DWORD>(-1) : static_cast<DWORD>(count), &read, nullptr))
+	if (!::ReadFile(handle(), begin, impl::clamp_transfer_size(count), &read, nullptr))
 		LEAN_LOG_WIN_ERROR_CTX("ReadFile()", name().c_str());
 	
 	return read;
@@ -43,12 +201,249 @@ LEAN_MAYBE_INLINE size_t lean::io::raw_file::write(const char *begin, size_t cou
 
 	// Thread-safe: http://msdn.microsoft.com/en-us/library/ms810467
 	// MONITOR: DWORD 32 bit only!
-	if (!::WriteFile(handle(), begin, (count > static_cast<DWORD>(-1)) ? static_cast<DWORD>(-1) : static_cast<DWORD>(count), &written, nullptr))
+	if (!::WriteFile(handle(), begin, impl::clamp_transfer_size(count), &written, nullptr))
 		LEAN_LOG_WIN_ERROR_CTX("WriteFile()", name().c_str());
 	
 	return written;
 }
 
+// Reads the given number of bytes starting at the given file offset, returning the number of bytes read.
+LEAN_MAYBE_INLINE size_t lean::io::raw_file::read_at(uint8 offset, char *begin, size_t count) const
+{
+	size_t total = 0;
+
+	while (total < count)
+	{
+		DWORD read = 0;
+		// Thread-safe: Offset passed along with the request, not shared by the handle
+		::OVERLAPPED overlapped = impl::make_file_offset(offset + total);
+
+		if (!::ReadFile(handle(), begin + total, impl::clamp_transfer_size(count - total), &read, &overlapped))
+		{
+			// End of file reported as error when passing offsets
+			if (::GetLastError() != ERROR_HANDLE_EOF)
+				LEAN_LOG_WIN_ERROR_CTX("ReadFile()", name().c_str());
+			break;
+		}
+		else if (read == 0)
+			break;
+
+		total += read;
+	}
+
+	return total;
+}
+
+// Writes the given number of bytes starting at the given file offset, returning the number of bytes written.
+LEAN_MAYBE_INLINE size_t lean::io::raw_file::write_at(uint8 offset, const char *begin, size_t count)
+{
+	size_t total = 0;
+
+	while (total < count)
+	{
+		DWORD written = 0;
+		// Thread-safe: Offset passed along with the request, not shared by the handle
+		::OVERLAPPED overlapped = impl::make_file_offset(offset + total);
+
+		if (!::WriteFile(handle(), begin + total, impl::clamp_transfer_size(count - total), &written, &overlapped))
+		{
+			LEAN_LOG_WIN_ERROR_CTX("WriteFile()", name().c_str());
+			break;
+		}
+		else if (written == 0)
+			break;
+
+		total += written;
+	}
+
+	return total;
+}
+
+// Reads into the given list of ranges of bytes in order, returning the number of bytes read.
+LEAN_MAYBE_INLINE size_t lean::io::raw_file::read(span_list spans) const
+{
+	size_t total = 0;
+
+	// NOTE: ReadFileScatter() requires unbuffered page-sized transfers
+	for (const span *it = spans.begin(); it != spans.end(); ++it)
+	{
+		size_t read = this->read(it->begin(), it->size());
+		total += read;
+
+		if (read != it->size())
+			break;
+	}
+
+	return total;
+}
+
+// Writes the given list of ranges of bytes in order, returning the number of bytes written.
+LEAN_MAYBE_INLINE size_t lean::io::raw_file::write(const_span_list spans)
+{
+	size_t total = 0;
+
+	// NOTE: WriteFileGather() requires unbuffered page-sized transfers
+	for (const const_span *it = spans.begin(); it != spans.end(); ++it)
+	{
+		size_t written = write(it->begin(), it->size());
+		total += written;
+
+		if (written != it->size())
+			break;
+	}
+
+	return total;
+}
+
+// Reads into the given list of ranges of bytes starting at the given file offset, returning the number of bytes read.
+LEAN_MAYBE_INLINE size_t lean::io::raw_file::read_at(uint8 offset, span_list spans) const
+{
+	size_t total = 0;
+
+	for (const span *it = spans.begin(); it != spans.end(); ++it)
+	{
+		size_t read = read_at(offset + total, it->begin(), it->size());
+		total += read;
+
+		if (read != it->size())
+			break;
+	}
+
+	return total;
+}
+
+// Writes the given list of ranges of bytes starting at the given file offset, returning the number of bytes written.
+LEAN_MAYBE_INLINE size_t lean::io::raw_file::write_at(uint8 offset, const_span_list spans)
+{
+	size_t total = 0;
+
+	for (const const_span *it = spans.begin(); it != spans.end(); ++it)
+	{
+		size_t written = write_at(offset + total, it->begin(), it->size());
+		total += written;
+
+		if (written != it->size())
+			break;
+	}
+
+	return total;
+}
+
+#else
+
+// Reads the given number of bytes from the file, returning the number of bytes read. This method is thread-safe.
+LEAN_MAYBE_INLINE size_t lean::io::raw_file::read(char *begin, size_t count) const
+{
+	ssize_t read;
+
+	while ((read = ::read(impl::get_file_descriptor(*this), begin, impl::clamp_transfer_size(count))) == -1 && errno == EINTR);
+
+	if (read == -1)
+	{
+		LEAN_LOG_POSIX_ERROR_CTX("read()", name().c_str());
+		return 0;
+	}
+
+	return static_cast<size_t>(read);
+}
+
+// Writes the given number of bytes to the file, returning the number of bytes written. This method is thread-safe.
+LEAN_MAYBE_INLINE size_t lean::io::raw_file::write(const char *begin, size_t count)
+{
+	ssize_t written;
+
+	while ((written = ::write(impl::get_file_descriptor(*this), begin, impl::clamp_transfer_size(count))) == -1 && errno == EINTR);
+
+	if (written == -1)
+	{
+		LEAN_LOG_POSIX_ERROR_CTX("write()", name().c_str());
+		return 0;
+	}
+
+	return static_cast<size_t>(written);
+}
+
+// Reads the given number of bytes starting at the given file offset, returning the number of bytes read.
+LEAN_MAYBE_INLINE size_t lean::io::raw_file::read_at(uint8 offset, char *begin, size_t count) const
+{
+	size_t total = 0;
+
+	while (total < count)
+	{
+		ssize_t read = ::pread(impl::get_file_descriptor(*this), begin + total,
+			impl::clamp_transfer_size(count - total), static_cast<off_t>(offset + total));
+
+		if (read == -1)
+		{
+			if (errno == EINTR)
+				continue;
+
+			LEAN_LOG_POSIX_ERROR_CTX("pread()", name().c_str());
+			break;
+		}
+		// End of file
+		else if (read == 0)
+			break;
+
+		total += static_cast<size_t>(read);
+	}
+
+	return total;
+}
+
+// Writes the given number of bytes starting at the given file offset, returning the number of bytes written.
+LEAN_MAYBE_INLINE size_t lean::io::raw_file::write_at(uint8 offset, const char *begin, size_t count)
+{
+	size_t total = 0;
+
+	while (total < count)
+	{
+		ssize_t written = ::pwrite(impl::get_file_descriptor(*this), begin + total,
+			impl::clamp_transfer_size(count - total), static_cast<off_t>(offset + total));
+
+		if (written == -1)
+		{
+			if (errno == EINTR)
+				continue;
+
+			LEAN_LOG_POSIX_ERROR_CTX("pwrite()", name().c_str());
+			break;
+		}
+		else if (written == 0)
+			break;
+
+		total += static_cast<size_t>(written);
+	}
+
+	return total;
+}
+
+// Reads into the given list of ranges of bytes in order, returning the number of bytes read.
+LEAN_MAYBE_INLINE size_t lean::io::raw_file::read(span_list spans) const
+{
+	return impl::transfer_spans(*this, impl::call_readv, spans, 0);
+}
+
+// Writes the given list of ranges of bytes in order, returning the number of bytes written.
+LEAN_MAYBE_INLINE size_t lean::io::raw_file::write(const_span_list spans)
+{
+	return impl::transfer_spans(*this, impl::call_writev, spans, 0);
+}
+
+// Reads into the given list of ranges of bytes starting at the given file offset, returning the number of bytes read.
+LEAN_MAYBE_INLINE size_t lean::io::raw_file::read_at(uint8 offset, span_list spans) const
+{
+	return impl::transfer_spans(*this, impl::call_preadv, spans, offset);
+}
+
+// Writes the given list of ranges of bytes starting at the given file offset, returning the number of bytes written.
+LEAN_MAYBE_INLINE size_t lean::io::raw_file::write_at(uint8 offset, const_span_list spans)
+{
+	return impl::transfer_spans(*this, impl::call_pwritev, spans, offset);
+}
+
+#endif
+
 // Prints the given range of characters to the file. This method is thread-safe.
 LEAN_MAYBE_INLINE size_t lean::io::raw_file::print(const char_ntri &message)
 {
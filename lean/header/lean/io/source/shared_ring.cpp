@@ -0,0 +1,246 @@
+#ifdef LEAN_BUILD_LIB
+#include "../../depconfig.h"
+#endif
+
+// Use short file names in logging
+#ifndef LEAN_DEFAULT_FILE_MACRO
+	#line __LINE__ "shared_ring.cpp"
+#endif
+
+#include "../shared_ring.h"
+#include "../filesystem.h"
+#include "../../concurrent/backoff.h"
+#include "../../concurrent/task_scheduler.h"
+#include "../../logging/errors.h"
+
+#ifdef __linux__
+	#include "../../concurrent/futex.h"
+#else
+	#include "../../time/highres_timer.h"
+#endif
+
+namespace lean
+{
+namespace io
+{
+namespace impl
+{
+	/// Gets the ring buffer capacity for the given requested capacity.
+	inline uint8 get_shared_ring_capacity(size_t capacity)
+	{
+		// Power of two, large enough for a couple of records
+		uint8 ringCapacity = 4 * shared_ring_header::cache_line_size;
+
+		while (ringCapacity < capacity)
+			ringCapacity *= 2;
+
+		return ringCapacity;
+	}
+
+	/// Gets the size of the file to be opened, 0 to keep the current file size.
+	inline uint8 get_shared_ring_size(const utf8_ntri &name, size_t capacity, file::open_mode mode)
+	{
+		if (mode != file::overwrite && file_exists(name) && file_size(name) > sizeof(shared_ring_header))
+			return 0;
+		else
+			return sizeof(shared_ring_header) + get_shared_ring_capacity(capacity);
+	}
+
+	/// Gets the number of times a condition is re-checked before blocking.
+	inline int get_shared_ring_spin_count()
+	{
+		// Spinning only delays the other party on single-processor machines
+		static const int spinCount = (task_scheduler::hardware_concurrency() > 1) ? 4096 : 0;
+		return spinCount;
+	}
+
+	/// Spins until the given condition holds, returning false if it still does not after a while.
+	template <class Condition>
+	inline bool spin_shared_ring(Condition condition)
+	{
+		const int spinCount = get_shared_ring_spin_count();
+
+		for (int i = 0; i < spinCount; ++i)
+		{
+			if (condition())
+				return true;
+
+			cpu_pause();
+		}
+
+		return condition();
+	}
+
+#ifndef __linux__
+	/// Polls the given condition until it holds or the given timeout has elapsed.
+	template <class Condition>
+	inline bool poll_shared_ring(Condition condition, uint8 timeoutMicroseconds)
+	{
+		highres_timer timer;
+		yield_backoff<> backoff;
+
+		while (!condition())
+		{
+			if (timeoutMicroseconds != shared_ring::infinite && timer.milliseconds() * 1000.0 >= timeoutMicroseconds)
+				return condition();
+
+			backoff.pause();
+		}
+
+		return true;
+	}
+#endif
+
+} // namespace
+} // namespace
+} // namespace
+
+// Opens the given ring file, creating a new ring of (at least) the given capacity if the file does not exist
+// or is to be overwritten.
+LEAN_MAYBE_INLINE lean::io::shared_ring::shared_ring(const utf8_ntri &name, size_type capacity, file::open_mode mode)
+	: m_file(name, impl::get_shared_ring_size(name, capacity, mode), true, mode, file::none, file::read | file::write),
+	m_header( static_cast<shared_ring_header*>(m_file.data()) ),
+	m_buffer( static_cast<char*>(m_file.data()) + sizeof(shared_ring_header) ),
+	m_mask(0)
+{
+	init();
+}
+
+// Closes this ring, records stay in the file.
+LEAN_MAYBE_INLINE lean::io::shared_ring::~shared_ring()
+{
+}
+
+// Initializes or validates the ring header.
+LEAN_MAYBE_INLINE void lean::io::shared_ring::init()
+{
+	shared_ring_header &header = *m_header;
+
+	// New files are zero-initialized, first process to open the file initializes the header
+	if (concurrent::atomic_test_and_set(header.magic, 0U, shared_ring_header::initializing_value))
+	{
+		header.version = shared_ring_header::version_value;
+		header.capacity = m_file.size() - sizeof(shared_ring_header);
+		concurrent::atomic_store(header.magic, shared_ring_header::magic_value, concurrent::memory_order_release);
+	}
+	else
+	{
+		yield_backoff<> backoff;
+
+		while (concurrent::atomic_load(header.magic, concurrent::memory_order_acquire) == shared_ring_header::initializing_value)
+			backoff.pause();
+	}
+
+	if (header.magic != shared_ring_header::magic_value || header.version != shared_ring_header::version_value
+		|| header.capacity == 0 || (header.capacity & (header.capacity - 1)) != 0
+		|| header.capacity != m_file.mapped_size() - sizeof(shared_ring_header))
+		LEAN_THROW_ERROR_CTX("Invalid shared ring file", m_file.name().c_str());
+
+	m_mask = header.capacity - 1;
+}
+
+// Wakes the consumer.
+LEAN_MAYBE_INLINE void lean::io::shared_ring::wake_readers()
+{
+	concurrent::atomic_increment(m_header->readSignal);
+#ifdef __linux__
+	futex_wake_shared(m_header->readSignal);
+#endif
+}
+
+// Wakes all producers.
+LEAN_MAYBE_INLINE void lean::io::shared_ring::wake_writers()
+{
+	concurrent::atomic_increment(m_header->writeSignal);
+#ifdef __linux__
+	futex_wake_shared(m_header->writeSignal, INT_MAX);
+#endif
+}
+
+// Blocks until a record of the given size might be reserved or the given timeout has elapsed.
+LEAN_MAYBE_INLINE bool lean::io::shared_ring::wait_writable(size_type size, uint8 timeoutMicroseconds)
+{
+	struct writable
+	{
+		const shared_ring *ring;
+		size_type recordSize;
+
+		bool operator ()() const
+		{
+			uint8 tail = concurrent::atomic_load(ring->m_header->tail, concurrent::memory_order_seq_cst);
+			uint8 head = concurrent::atomic_load(ring->m_header->head, concurrent::memory_order_seq_cst);
+			return (tail + ring->padding_size(tail, recordSize) + recordSize - head <= ring->m_mask + 1);
+		}
+	};
+	writable condition = { this, record_size(size) };
+
+	// Messages typically follow in quick succession, avoid sleeping
+	if (impl::spin_shared_ring(condition))
+		return true;
+
+#ifdef __linux__
+	int signal = concurrent::atomic_load(m_header->writeSignal, concurrent::memory_order_acquire);
+
+	// NOTE: Register before re-checking, pairs with consume()
+	concurrent::atomic_increment(m_header->writeWaiters);
+	bool result = condition();
+
+	if (!result)
+	{
+		if (timeoutMicroseconds != infinite)
+			futex_wait_shared(m_header->writeSignal, signal, timeoutMicroseconds);
+		else
+			futex_wait_shared(m_header->writeSignal, signal);
+
+		result = condition();
+	}
+
+	concurrent::atomic_decrement(m_header->writeWaiters);
+	return result;
+#else
+	return impl::poll_shared_ring(condition, timeoutMicroseconds);
+#endif
+}
+
+// Blocks until a record has been committed or the given timeout has elapsed.
+LEAN_MAYBE_INLINE bool lean::io::shared_ring::wait_readable(uint8 timeoutMicroseconds)
+{
+	struct readable
+	{
+		shared_ring *ring;
+
+		bool operator ()() const
+		{
+			size_type size;
+			return (ring->peek(size) != nullptr);
+		}
+	};
+	readable condition = { this };
+
+	// Messages typically follow in quick succession, avoid sleeping
+	if (impl::spin_shared_ring(condition))
+		return true;
+
+#ifdef __linux__
+	int signal = concurrent::atomic_load(m_header->readSignal, concurrent::memory_order_acquire);
+
+	// NOTE: Register before re-checking, pairs with publish()
+	concurrent::atomic_increment(m_header->readWaiters);
+	bool result = condition();
+
+	if (!result)
+	{
+		if (timeoutMicroseconds != infinite)
+			futex_wait_shared(m_header->readSignal, signal, timeoutMicroseconds);
+		else
+			futex_wait_shared(m_header->readSignal, signal);
+
+		result = condition();
+	}
+
+	concurrent::atomic_decrement(m_header->readWaiters);
+	return result;
+#else
+	return impl::poll_shared_ring(condition, timeoutMicroseconds);
+#endif
+}
@@ -13,10 +13,12 @@ namespace lean
 namespace io
 {
 
-/// @typedef windows_file_handle Opaque windows file handle.
+/// @typedef windows_file_handle Opaque windows file handle, stores the file descriptor on POSIX systems.
 DECLARE_OPAQUE_TYPE(windows_file_handle, void*);
 #ifdef _WINDOWS_
 DEFINE_OPAQUE_TYPE(windows_file_handle, HANDLE);
+#elif !defined(_WIN32)
+DEFINE_OPAQUE_TYPE(windows_file_handle, void*);
 #endif
 
 }
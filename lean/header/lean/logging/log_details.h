@@ -10,7 +10,7 @@
 #include "../tags/noncopyable.h"
 #include "../strings/types.h"
 #include "../concurrent/spin_lock.h"
-#include "../concurrent/shareable_spin_lock.h"
+#include "../concurrent/distributed_shareable_lock.h"
 #include <vector>
 #include <iosfwd>
 #include <ostream>
@@ -38,7 +38,7 @@ private:
 
 	typedef std::vector<log_target*> target_vector;
 	target_vector m_targets;
-	shareable_spin_lock<> m_targetLock;
+	distributed_shareable_lock<> m_targetLock;
 
 	/// Acquires a stream to write to. This method is thread-safe.
 	LEAN_MAYBE_EXPORT output_stream& acquireStream();
@@ -0,0 +1,99 @@
+/*****************************************************/
+/* lean Logging                 (c) Tobias Zirr 2011 */
+/*****************************************************/
+
+#pragma once
+#ifndef LEAN_LOGGING_POSIX_ERRORS
+#define LEAN_LOGGING_POSIX_ERRORS
+
+#include "../lean.h"
+#include "../strings/types.h"
+#include "../logging/errors.h"
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+namespace lean
+{
+namespace logging
+{
+
+/// Gets an error message describing the last POSIX error that occurred.
+inline utf8_string get_last_posix_error_msg()
+{
+	return utf8_string( ::strerror(errno) );
+}
+
+/// Logs the last POSIX error.
+template <class String1>
+LEAN_NOTINLINE void log_last_posix_error(const String1 &source)
+{
+	log_error(source, get_last_posix_error_msg().c_str());
+}
+/// Logs the last POSIX error.
+template <class String1, class String2>
+LEAN_NOTINLINE void log_last_posix_error(const String1 &source, const String2 &reason)
+{
+	log_error_ex(source, get_last_posix_error_msg().c_str(), reason);
+}
+/// Logs the last POSIX error.
+template <class String1, class String2, class String3>
+LEAN_NOTINLINE void log_last_posix_error(const String1 &source, const String2 &reason, const String3 &context)
+{
+	log_error_ex(source, get_last_posix_error_msg().c_str(), reason, context);
+}
+
+/// Throws a runtime_error exception containing the last POSIX error.
+template <class String1>
+LEAN_NOTINLINE void throw_last_posix_error(const String1 &source)
+{
+	throw_error(source, get_last_posix_error_msg().c_str());
+}
+/// Throws a runtime_error exception containing the last POSIX error.
+template <class String1, class String2>
+LEAN_NOTINLINE void throw_last_posix_error(const String1 &source, const String2 &reason)
+{
+	throw_error_ex(source, get_last_posix_error_msg().c_str(), reason);
+}
+/// Throws a runtime_error exception containing the last POSIX error.
+template <class String1, class String2, class String3>
+LEAN_NOTINLINE void throw_last_posix_error(const String1 &source, const String2 &reason, const String3 &context)
+{
+	throw_error_ex(source, get_last_posix_error_msg().c_str(), reason, context);
+}
+
+} // namespace
+
+using logging::log_last_posix_error;
+using logging::throw_last_posix_error;
+using logging::get_last_posix_error_msg;
+
+} // namespace
+
+/// @addtogroup LoggingMacros
+/// @see lean::logging
+/// @{
+
+/// Logs an error message, prepending the caller's file and line.
+#define LEAN_LOG_POSIX_ERROR() ::lean::logging::log_last_posix_error(__FILE__ " (" LEAN_QUOTE_VALUE(__LINE__) ")")
+/// Logs the given error message, prepending the caller's file and line.
+#define LEAN_LOG_POSIX_ERROR_MSG(msg) ::lean::logging::log_last_posix_error(__FILE__ " (" LEAN_QUOTE_VALUE(__LINE__) ")", msg)
+/// Logs the given error message and context, prepending the caller's file and line.
+#define LEAN_LOG_POSIX_ERROR_CTX(msg, ctx) ::lean::logging::log_last_posix_error(__FILE__ " (" LEAN_QUOTE_VALUE(__LINE__) ")", msg, ctx)
+
+/// @}
+
+/// @addtogroup ExceptionMacros
+/// @see lean::logging
+/// @{
+
+/// Throws a runtime_error exception.
+#define LEAN_THROW_POSIX_ERROR() ::lean::logging::throw_last_posix_error(__FILE__ " (" LEAN_QUOTE_VALUE(__LINE__) ")")
+/// Throws a runtime_error exception.
+#define LEAN_THROW_POSIX_ERROR_MSG(msg) ::lean::logging::throw_last_posix_error(__FILE__ " (" LEAN_QUOTE_VALUE(__LINE__) ")", msg)
+/// Throws a runtime_error exception.
+#define LEAN_THROW_POSIX_ERROR_CTX(msg, ctx) ::lean::logging::throw_last_posix_error(__FILE__ " (" LEAN_QUOTE_VALUE(__LINE__) ")", msg, ctx)
+
+/// @}
+
+#endif
\ No newline at end of file
@@ -38,7 +38,7 @@ LEAN_ALWAYS_LINK void log_details::add_target(log_target *target)
 {
 	if (target != nullptr)
 	{
-		scoped_ssl_lock lock(m_targetLock);
+		scoped_dsl_lock lock(m_targetLock);
 		m_targets.push_back(target);
 	}
 }
@@ -48,7 +48,7 @@ LEAN_ALWAYS_LINK void log_details::remove_target(log_target *target)
 {
 	if (target != nullptr)
 	{
-		scoped_ssl_lock lock(m_targetLock);
+		scoped_dsl_lock lock(m_targetLock);
 		m_targets.erase(
 			std::remove(m_targets.begin(), m_targets.end(), target),
 			m_targets.end() );
@@ -58,7 +58,7 @@ LEAN_ALWAYS_LINK void log_details::remove_target(log_target *target)
 // Prints the given message. This method is thread-safe.
 LEAN_ALWAYS_LINK void log_details::print(const char_ntri &message)
 {
-	scoped_ssl_lock_shared lock(m_targetLock);
+	scoped_dsl_lock_shared lock(m_targetLock);
 
 	for (target_vector::const_iterator itTarget = m_targets.begin();
 		itTarget != m_targets.end(); ++itTarget)
@@ -108,6 +108,26 @@ namespace memory
 			align_integer<Alignment>( reinterpret_cast<uintptr_t>(pointer) ) );
 	}
 
+	/// (Negatively) aligns the given pointer on the given run-time alignment boundaries.
+	template <class Value>
+	LEAN_INLINE Value* lower_align(Value *pointer, size_t alignment)
+	{
+		LEAN_ASSERT(check_alignment(alignment));
+
+		return reinterpret_cast<Value*>(
+			reinterpret_cast<uintptr_t>(pointer) & ~static_cast<uintptr_t>(alignment - 1) );
+	}
+
+	/// Aligns the given pointer on the given run-time alignment boundaries.
+	template <class Value>
+	LEAN_INLINE Value* align(Value *pointer, size_t alignment)
+	{
+		LEAN_ASSERT(check_alignment(alignment));
+
+		return reinterpret_cast<Value*>(
+			(reinterpret_cast<uintptr_t>(pointer) + (alignment - 1)) & ~static_cast<uintptr_t>(alignment - 1) );
+	}
+
 	/// Aligns the given unsigned integer on the given alignment boundaries, incrementing it at least by one.
 	template <size_t Alignment, class Integer>
 	LEAN_INLINE Integer upper_align_integer(Integer integer)
@@ -156,6 +176,12 @@ namespace memory
 	template <> struct alignas(32) stack_aligned<32> { };
 	template <> struct alignas(64) stack_aligned<64> { };
 	template <> struct alignas(128) stack_aligned<128> { };
+	template <> struct alignas(256) stack_aligned<256> { };
+	template <> struct alignas(512) stack_aligned<512> { };
+	template <> struct alignas(1024) stack_aligned<1024> { };
+	template <> struct alignas(2048) stack_aligned<2048> { };
+	template <> struct alignas(4096) stack_aligned<4096> { };
+	template <> struct alignas(8192) stack_aligned<8192> { };
 
 #ifdef _MSC_VER
 	#pragma warning(pop)
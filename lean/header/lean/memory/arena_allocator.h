@@ -0,0 +1,272 @@
+/*****************************************************/
+/* lean Memory                  (c) Tobias Zirr 2011 */
+/*****************************************************/
+
+#pragma once
+#ifndef LEAN_MEMORY_ARENA_ALLOCATOR
+#define LEAN_MEMORY_ARENA_ALLOCATOR
+
+#include "../lean.h"
+#include "../meta/strip.h"
+#include "alignment.h"
+#include "default_heap.h"
+#include "chunk_heap.h"
+
+namespace lean
+{
+namespace memory
+{
+
+/// Default arena type, a purely dynamic chunk heap.
+typedef chunk_heap<64 * 1024, default_heap, 0> default_arena;
+
+/// STL allocator referencing a particular arena, e.g. a chunk heap or a scoped arena. Deallocation does nothing,
+/// memory is released all at once by clearing, resetting or rewinding the arena. The arena needs to outlive all
+/// containers allocating from it.
+template <class Element, class Arena = default_arena, size_t AlignmentOrZero = 0>
+class arena_allocator
+{
+	template <class Other, class OtherArena, size_t OtherAlignmentOrZero>
+	friend class arena_allocator;
+
+public:
+	/// Alignment.
+	struct alignment
+	{
+		/// Alignment.
+		static const size_t value = (AlignmentOrZero) ? AlignmentOrZero : alignof(Element);
+	};
+
+	/// Arena referenced by this allocator.
+	typedef Arena arena_type;
+
+	/// Value type.
+	typedef typename strip_const<Element>::type value_type;
+
+	/// Pointer type.
+	typedef value_type* pointer;
+	/// Reference type.
+	typedef value_type& reference;
+	/// Pointer type.
+	typedef const value_type* const_pointer;
+	/// Reference type.
+	typedef const value_type& const_reference;
+
+	/// Size type.
+	typedef typename arena_type::size_type size_type;
+	/// Pointer difference type.
+	typedef ptrdiff_t difference_type;
+
+	/// Allows for the creation of differently-typed equivalent allocators.
+	template <class Other>
+	struct rebind
+	{
+		/// Equivalent allocator allocating elements of type Other.
+		typedef arena_allocator<Other, Arena, AlignmentOrZero> other;
+	};
+
+private:
+	arena_type *m_arena;
+
+public:
+	/// Allocates from the given arena.
+	LEAN_INLINE explicit arena_allocator(arena_type &arena)
+		: m_arena(&arena) { }
+	/// Copy constructor.
+	template <class Other>
+	LEAN_INLINE arena_allocator(const arena_allocator<Other, Arena, AlignmentOrZero> &right)
+		: m_arena(right.m_arena) { }
+	/// Assignment operator.
+	template <class Other>
+	LEAN_INLINE arena_allocator& operator=(const arena_allocator<Other, Arena, AlignmentOrZero> &right)
+	{
+		m_arena = right.m_arena;
+		return *this;
+	}
+
+	/// Allocates the given number of elements.
+	LEAN_INLINE pointer allocate(size_type count)
+	{
+		return static_cast<pointer>( m_arena->template allocate<alignment::value>(count * sizeof(value_type)) );
+	}
+	/// Allocates the given amount of memory.
+	LEAN_INLINE pointer allocate(size_type count, const void *)
+	{
+		return allocate(count);
+	}
+	/// Does nothing, memory is released by the arena.
+	LEAN_INLINE void deallocate(pointer ptr, size_type) { }
+
+	/// Constructs a new element from the given value at the given pointer.
+	LEAN_INLINE void construct(pointer ptr, const value_type& value)
+	{
+		new(reinterpret_cast<void*>(ptr)) Element(value);
+	}
+	/// Constructs a new element from the given value at the given pointer.
+	template <class Other>
+	LEAN_INLINE void construct(pointer ptr, const Other& value)
+	{
+		new(reinterpret_cast<void*>(ptr)) Element(value);
+	}
+#ifndef LEAN0X_NO_RVALUE_REFERENCES
+	/// Constructs a new element from the given value at the given pointer.
+	LEAN_INLINE void construct(pointer ptr, value_type&& value)
+	{
+		new(reinterpret_cast<void*>(ptr)) Element(std::move(value));
+	}
+	/// Constructs a new element from the given value at the given pointer.
+	template <class Other>
+	LEAN_INLINE void construct(pointer ptr, Other&& value)
+	{
+		new(reinterpret_cast<void*>(ptr)) Element(std::forward<Other>(value));
+	}
+#endif
+	/// Destructs an element at the given pointer.
+	LEAN_INLINE void destroy(pointer ptr)
+	{
+		ptr->~Element();
+	}
+
+	/// Gets the address of the given element.
+	LEAN_INLINE pointer address(reference value) const
+	{
+		return reinterpret_cast<pointer>( &reinterpret_cast<char&>(value) );
+	}
+	/// Gets the address of the given element.
+	LEAN_INLINE const_pointer address(const_reference value) const
+	{
+		return reinterpret_cast<const_pointer>( &reinterpret_cast<const char&>(value) );
+	}
+
+	/// Estimates the maximum number of elements that may be constructed.
+	LEAN_INLINE size_type max_size() const
+	{
+		size_type count = static_cast<size_type>(-1) / sizeof(Element);
+		return (0 < count) ? count : 1;
+	}
+
+	/// Gets the arena referenced by this allocator.
+	LEAN_INLINE arena_type& arena() const { return *m_arena; }
+};
+
+#ifndef DOXYGEN_SKIP_THIS
+
+/// STL allocator referencing a particular arena.
+template <class Arena, size_t AlignmentOrZero>
+class arena_allocator<void, Arena, AlignmentOrZero>
+{
+	template <class Other, class OtherArena, size_t OtherAlignmentOrZero>
+	friend class arena_allocator;
+
+public:
+	/// Arena referenced by this allocator.
+	typedef Arena arena_type;
+
+	/// Value type.
+	typedef void value_type;
+
+	/// Pointer type.
+	typedef value_type* pointer;
+	/// Pointer type.
+	typedef const value_type* const_pointer;
+
+	/// Size type.
+	typedef typename arena_type::size_type size_type;
+	/// Pointer difference type.
+	typedef ptrdiff_t difference_type;
+
+	/// Allows for the creation of differently-typed equivalent allocators.
+	template <class Other>
+	struct rebind
+	{
+		/// Equivalent allocator allocating elements of type Other.
+		typedef arena_allocator<Other, Arena, AlignmentOrZero> other;
+	};
+
+private:
+	arena_type *m_arena;
+
+public:
+	/// Allocates from the given arena.
+	LEAN_INLINE explicit arena_allocator(arena_type &arena)
+		: m_arena(&arena) { }
+	/// Copy constructor.
+	template <class Other>
+	LEAN_INLINE arena_allocator(const arena_allocator<Other, Arena, AlignmentOrZero> &right)
+		: m_arena(right.m_arena) { }
+	/// Assignment operator.
+	template <class Other>
+	LEAN_INLINE arena_allocator& operator=(const arena_allocator<Other, Arena, AlignmentOrZero> &right)
+	{
+		m_arena = right.m_arena;
+		return *this;
+	}
+
+	/// Gets the arena referenced by this allocator.
+	LEAN_INLINE arena_type& arena() const { return *m_arena; }
+};
+
+#endif
+
+/// Checks the given two allocators for equivalence.
+template <class Element, class Arena, size_t AlignmentOrZero, class Other>
+LEAN_INLINE bool operator ==(const arena_allocator<Element, Arena, AlignmentOrZero> &left, const arena_allocator<Other, Arena, AlignmentOrZero> &right)
+{
+	return &left.arena() == &right.arena();
+}
+
+/// Checks the given two allocators for inequivalence.
+template <class Element, class Arena, size_t AlignmentOrZero, class Other>
+LEAN_INLINE bool operator !=(const arena_allocator<Element, Arena, AlignmentOrZero> &left, const arena_allocator<Other, Arena, AlignmentOrZero> &right)
+{
+	return &left.arena() != &right.arena();
+}
+
+/// Heap adapter referencing a particular arena, e.g. for use with dynamic_array. Freeing does nothing,
+/// memory is released all at once by clearing, resetting or rewinding the arena.
+template <class Arena = default_arena>
+class arena_heap
+{
+public:
+	/// Arena referenced by this heap.
+	typedef Arena arena_type;
+	/// Size type.
+	typedef typename arena_type::size_type size_type;
+	/// Default alignment.
+	static const size_type default_alignment = sizeof(void*);
+
+private:
+	arena_type *m_arena;
+
+public:
+	/// Allocates from the given arena.
+	LEAN_INLINE explicit arena_heap(arena_type &arena)
+		: m_arena(&arena) { }
+
+	/// Allocates the given amount of memory.
+	LEAN_INLINE void* allocate(size_type size) { return m_arena->template allocate<default_alignment>(size); }
+	/// Does nothing, memory is released by the arena.
+	LEAN_INLINE void free(void *memory) { }
+
+	/// Allocates the given amount of memory respecting the given alignment.
+	template <size_t Alignment>
+	LEAN_INLINE void* allocate(size_type size) { return m_arena->template allocate<Alignment>(size); }
+	/// Does nothing, memory is released by the arena.
+	template <size_t Alignment>
+	LEAN_INLINE void free(void *memory) { }
+	/// Does nothing, memory is released by the arena.
+	LEAN_INLINE void free(void *memory, size_t alignment) { }
+
+	/// Gets the arena referenced by this heap.
+	LEAN_INLINE arena_type& arena() const { return *m_arena; }
+};
+
+} // namespace
+
+using memory::default_arena;
+using memory::arena_allocator;
+using memory::arena_heap;
+
+} // namespace
+
+#endif
\ No newline at end of file
@@ -38,8 +38,50 @@ struct optional_mem_block<0>
 	LEAN_INLINE operator const char*() const { return nullptr; }
 };
 
+/// Defines chunk growth policies for chunk heaps.
+namespace chunk_growth_policies
+{
+	/// Allocates chunks of the default chunk size, unless tweaked otherwise.
+	struct fixed
+	{
+		/// Computes the size of the chunk following a chunk of the given size.
+		static LEAN_INLINE size_t next_chunk_size(size_t chunkSize, size_t defaultChunkSize)
+		{
+			return (defaultChunkSize != 0) ? defaultChunkSize : chunkSize;
+		}
+	};
+
+	/// Multiplies the chunk size by the given factor with every new chunk, up to the given maximum chunk size.
+	template <size_t Factor = 2, size_t MaxChunkSize = 64 * 1024 * 1024>
+	struct geometric
+	{
+		/// Growth factor.
+		static const size_t factor = Factor;
+		/// Maximum chunk size.
+		static const size_t max_chunk_size = MaxChunkSize;
+
+		/// Computes the size of the chunk following a chunk of the given size.
+		static LEAN_INLINE size_t next_chunk_size(size_t chunkSize, size_t defaultChunkSize)
+		{
+			size_t nextChunkSize = (chunkSize < MaxChunkSize / Factor) ? chunkSize * Factor : MaxChunkSize;
+			return (nextChunkSize < defaultChunkSize) ? defaultChunkSize : nextChunkSize;
+		}
+	};
+}
+
+/// Chunk heap memory statistics.
+struct chunk_heap_stats
+{
+	size_t reservedBytes;	///< Bytes held in chunks, including the static chunk & retained chunks.
+	size_t usedBytes;		///< Bytes allocated, including alignment padding.
+	size_t wastedBytes;		///< Bytes left unused at the end of exhausted chunks.
+	size_t spareBytes;		///< Bytes held in retained chunks, see reset().
+	size_t chunkCount;		///< Number of dynamically allocated chunks, including retained chunks.
+};
+
 /// Contiguous chunk allocator heap.
-template <size_t ChunkSize, class Heap = default_heap, size_t StaticChunkSize = ChunkSize, size_t DefaultAlignment = sizeof(void*)>
+template <size_t ChunkSize, class Heap = default_heap, size_t StaticChunkSize = ChunkSize, size_t DefaultAlignment = sizeof(void*),
+	class GrowthPolicy = chunk_growth_policies::fixed>
 class chunk_heap : public lean::noncopyable
 {
 public:
@@ -47,11 +89,21 @@ public:
 	typedef Heap heap_type;
 	/// Size type.
 	typedef typename heap_type::size_type size_type;
+	/// Chunk growth policy.
+	typedef GrowthPolicy growth_policy;
 	/// Chunk size.
 	static const size_type chunk_size = ChunkSize;
 	/// Default alignment.
 	static const size_type default_alignment = DefaultAlignment;
 
+	/// Allocation position, see mark() & rewind().
+	struct marker
+	{
+		char *chunk;
+		char *chunkOffset;
+		char *chunkEnd;
+	};
+
 private:
 	// Optional first static chunk
 	optional_mem_block<StaticChunkSize> m_firstChunk;
@@ -64,23 +116,84 @@ private:
 	// Next chunk size
 	size_type m_nextChunkSize;
 
+	// Retained chunks
+	char *m_spareChunks;
+
+	// Statistics
+	size_type m_chunkCount;
+	size_type m_reservedBytes;
+	size_type m_spareBytes;
+	size_type m_wastedBytes;
+
 	/// Chunk header
 	struct chunk_header
 	{
 		char *prev_chunk;
+		char *chunk_end;
+		size_type prev_waste;
 
 		/// Constructor.
-		chunk_header(char *prev_chunk)
-			: prev_chunk(prev_chunk) { }
+		chunk_header(char *prev_chunk, char *chunk_end)
+			: prev_chunk(prev_chunk),
+			chunk_end(chunk_end),
+			prev_waste(0) { }
 	};
-	// Chunk alignment
-	static const size_t chunk_alignment = alignof(chunk_header);
+	// Chunk alignment, dynamic chunks start on default alignment boundaries
+	static const size_t chunk_alignment = (DefaultAlignment > alignof(chunk_header)) ? DefaultAlignment : alignof(chunk_header);
+	// Offset of dynamic chunks from the beginning of their memory blocks, headers stored right in front of chunks
+	static const size_t chunk_offset = (sizeof(chunk_header) + (chunk_alignment - 1)) & ~(chunk_alignment - 1);
 
 	/// Gets the header of the given dynamically allocated chunk.
 	LEAN_INLINE static chunk_header* to_chunk_header(char *chunk)
 	{
 		return reinterpret_cast<chunk_header*>(chunk) - 1;
 	}
+	/// Gets the memory block of the chunk belonging to the given header.
+	LEAN_INLINE static void* to_chunk_base(chunk_header *header)
+	{
+		return reinterpret_cast<char*>(header + 1) - chunk_offset;
+	}
+
+	/// Takes the first retained chunk large enough to hold the given number of bytes, nullptr if none.
+	char* take_spare_chunk(size_type size)
+	{
+		for (char **spare = &m_spareChunks; *spare; spare = &to_chunk_header(*spare)->prev_chunk)
+		{
+			char *chunk = *spare;
+
+			size_type spareSize = to_chunk_header(chunk)->chunk_end - chunk;
+
+			if (spareSize >= size)
+			{
+				*spare = to_chunk_header(chunk)->prev_chunk;
+				m_spareBytes -= spareSize;
+				return chunk;
+			}
+		}
+
+		return nullptr;
+	}
+
+	/// Frees the current chunk, moving on to the previous chunk. Returns the number of bytes left unused
+	/// at the end of the previous chunk when it was exhausted.
+	LEAN_INLINE size_type free_current()
+	{
+		chunk_header *freeChunkBase = to_chunk_header(m_chunk);
+		size_type prevWaste = freeChunkBase->prev_waste;
+
+		// Immediately store previous chunk (exception-safe)
+		m_chunk = freeChunkBase->prev_chunk;
+		m_chunkOffset = m_chunk;
+		m_chunkEnd = (m_chunk == m_firstChunk) ? m_chunk + StaticChunkSize : to_chunk_header(m_chunk)->chunk_end;
+
+		--m_chunkCount;
+		m_reservedBytes -= freeChunkBase->chunk_end - reinterpret_cast<char*>(freeChunkBase + 1);
+		m_wastedBytes -= prevWaste;
+
+		Heap::free<chunk_alignment>( to_chunk_base(freeChunkBase) );
+
+		return prevWaste;
+	}
 
 	/// Allocates the given amount of memory.
 	template <size_t Alignment>
@@ -95,22 +208,37 @@ private:
 			// Make sure new chunk is large enough for requested amount of memory + alignment
 			size_type alignedSize = size + (Alignment - 1);
 
-			size_type nextChunkSize = m_nextChunkSize;
-			if (nextChunkSize < alignedSize)
-				nextChunkSize = alignedSize;
+			char *nextChunk = take_spare_chunk(alignedSize);
 
-			nextChunkSize += sizeof(chunk_header);
+			if (!nextChunk)
+			{
+				size_type nextChunkSize = m_nextChunkSize;
+				if (nextChunkSize < alignedSize)
+					nextChunkSize = alignedSize;
 
-			char *nextChunkBase = static_cast<char*>( Heap::allocate<chunk_alignment>(nextChunkSize) );
-			new( static_cast<void*>(nextChunkBase) ) chunk_header(m_chunk);
+				nextChunkSize += chunk_offset;
 
-			m_chunk = nextChunkBase + sizeof(chunk_header);
-			m_chunkOffset = m_chunk;
-			m_chunkEnd = nextChunkBase + nextChunkSize;
+				char *nextChunkBase = static_cast<char*>( Heap::allocate<chunk_alignment>(nextChunkSize) );
+				nextChunk = nextChunkBase + chunk_offset;
+				new( static_cast<void*>(to_chunk_header(nextChunk)) ) chunk_header(m_chunk, nextChunkBase + nextChunkSize);
 
-			// Reset chunk size
-			if (chunk_size != 0)
-				m_nextChunkSize = chunk_size;
+				++m_chunkCount;
+				m_reservedBytes += nextChunkSize - chunk_offset;
+
+				// Advance chunk size
+				m_nextChunkSize = GrowthPolicy::next_chunk_size(m_nextChunkSize, chunk_size);
+			}
+
+			chunk_header *nextChunkHeader = to_chunk_header(nextChunk);
+			nextChunkHeader->prev_chunk = m_chunk;
+
+			// Remaining capacity of the exhausted chunk is wasted
+			nextChunkHeader->prev_waste = m_chunkEnd - m_chunkOffset;
+			m_wastedBytes += nextChunkHeader->prev_waste;
+
+			m_chunk = nextChunk;
+			m_chunkOffset = m_chunk;
+			m_chunkEnd = to_chunk_header(m_chunk)->chunk_end;
 
 			// Get next free memory location
 			aligned = align<Alignment>(m_chunkOffset);
@@ -128,7 +256,12 @@ public:
 		: m_chunk(m_firstChunk),
 		m_chunkOffset(m_firstChunk),
 		m_chunkEnd(m_firstChunk.get() + StaticChunkSize),
-		m_nextChunkSize(chunkSize) { }
+		m_nextChunkSize(chunkSize),
+		m_spareChunks(nullptr),
+		m_chunkCount(0),
+		m_reservedBytes(0),
+		m_spareBytes(0),
+		m_wastedBytes(0) { }
 	/// Destructor
 	LEAN_INLINE ~chunk_heap()
 	{
@@ -156,32 +289,89 @@ public:
 			nextChunkSize( max(newCapacity - currentCapacity, minChunkSize) );
 	}
 
-	/// Clears and frees all chunks allocated by this allocator.
+	/// Clears and frees all chunks allocated by this allocator, including retained chunks.
 	void clear()
 	{
 		// Free as many chunks as possible
 		while (m_chunk != m_firstChunk)
+			free_current();
+
+		while (m_spareChunks)
 		{
-			chunk_header *freeChunkBase = to_chunk_header(m_chunk);
+			chunk_header *freeChunkBase = to_chunk_header(m_spareChunks);
+			m_spareChunks = freeChunkBase->prev_chunk;
 
-			// Immediately store previous chunk in case clear is re-called after exception
-			m_chunk = freeChunkBase->prev_chunk;
-			m_chunkOffset = m_chunk;
-			m_chunkEnd = m_chunk;
+			--m_chunkCount;
+			m_reservedBytes -= freeChunkBase->chunk_end - reinterpret_cast<char*>(freeChunkBase + 1);
+
+			Heap::free<chunk_alignment>( to_chunk_base(freeChunkBase) );
+		}
+
+		m_spareBytes = 0;
 
-			Heap::free<chunk_alignment>(freeChunkBase);
+		// Re-initialize with first chunk
+		m_chunkOffset = m_chunk;
+		m_chunkEnd = m_chunk + StaticChunkSize;
+	}
+
+	/// Clears all chunks, retaining all chunks dynamically allocated by this allocator for subsequent allocations.
+	void reset()
+	{
+		while (m_chunk != m_firstChunk)
+		{
+			chunk_header *spareChunkBase = to_chunk_header(m_chunk);
+			char *prevChunk = spareChunkBase->prev_chunk;
+
+			spareChunkBase->prev_chunk = m_spareChunks;
+			m_spareChunks = m_chunk;
+			m_spareBytes += spareChunkBase->chunk_end - m_chunk;
+			m_chunk = prevChunk;
 		}
 
+		m_wastedBytes = 0;
+
 		// Re-initialize with first chunk
+		m_chunkOffset = m_chunk;
 		m_chunkEnd = m_chunk + StaticChunkSize;
 	}
 
+	/// Gets the current allocation position.
+	LEAN_INLINE marker mark() const
+	{
+		marker position = { m_chunk, m_chunkOffset, m_chunkEnd };
+		return position;
+	}
+	/// Frees all memory allocated since the given position was marked, freeing all chunks allocated since.
+	/// Markers are invalidated by rewinding to earlier positions, clear() & reset().
+	void rewind(const marker &position)
+	{
+		// Free chunks allocated since
+		while (m_chunk != position.chunk)
+		{
+			LEAN_ASSERT(m_chunk != m_firstChunk);
+			free_current();
+		}
+
+		LEAN_ASSERT(m_chunk <= position.chunkOffset && position.chunkOffset <= position.chunkEnd);
+
+		m_chunkOffset = position.chunkOffset;
+		m_chunkEnd = position.chunkEnd;
+	}
+
 	/// Clears all chunks and frees all chunks but the first one dynamically allocated by this allocator if it has not been exhausted yet.
 	void clearButFirst()
 	{
 		if (m_chunk != m_firstChunk && to_chunk_header(m_chunk)->prev_chunk == m_firstChunk)
+		{
+			chunk_header *chunkHeader = to_chunk_header(m_chunk);
+
+			// Static chunk remains unused
+			m_wastedBytes += StaticChunkSize - chunkHeader->prev_waste;
+			chunkHeader->prev_waste = StaticChunkSize;
+
 			// Re-initialize first dynamic chunk
 			m_chunkOffset = m_chunk;
+		}
 		else
 			clear();
 	}
@@ -203,19 +393,15 @@ public:
 		m_chunkOffset = m_chunk;
 		return m_chunk;
 	}
-	/// Clears all chunks and frees the current chunk, returning the next. For advanced clean-up logic only.
+	/// Clears all chunks and frees the current chunk, returning the next. The current offset then marks
+	/// the end of the memory occupied in the next chunk. For advanced clean-up logic only.
 	char* clearNext()
 	{
 		if (m_chunk != m_firstChunk)
 		{
-			chunk_header *freeChunkBase = to_chunk_header(m_chunk);
-
-			// Immediately store previous chunk (exception-safe)
-			m_chunk = freeChunkBase->prev_chunk;
-			m_chunkOffset = m_chunk;
-			m_chunkEnd = (m_chunk == m_firstChunk) ? m_chunk + StaticChunkSize : m_chunk;
-
-			Heap::free<chunk_alignment>(freeChunkBase);
+			size_type prevWaste = free_current();
+			// Previous chunk is occupied up to where it was exhausted
+			m_chunkOffset = m_chunkEnd - prevWaste;
 		}
 
 		return m_chunk;
@@ -239,6 +425,18 @@ public:
 		// Freeing of individual memory blocks unsupported
 	}
 
+	/// Gets memory statistics.
+	chunk_heap_stats stats() const
+	{
+		chunk_heap_stats stats;
+		stats.reservedBytes = StaticChunkSize + m_reservedBytes;
+		stats.wastedBytes = m_wastedBytes;
+		stats.spareBytes = m_spareBytes;
+		stats.usedBytes = stats.reservedBytes - m_spareBytes - m_wastedBytes - capacity();
+		stats.chunkCount = m_chunkCount;
+		return stats;
+	}
+
 	/// Swaps the contents of the given chunk heap with the ones of this chunk heap.
 	LEAN_INLINE void swap(chunk_heap &right)
 	{
@@ -252,20 +450,27 @@ public:
 		swap(m_chunkOffset, right.m_chunkOffset);
 		swap(m_chunkEnd, right.m_chunkEnd);
 		swap(m_nextChunkSize, right.m_nextChunkSize);
+		swap(m_spareChunks, right.m_spareChunks);
+		swap(m_chunkCount, right.m_chunkCount);
+		swap(m_reservedBytes, right.m_reservedBytes);
+		swap(m_spareBytes, right.m_spareBytes);
+		swap(m_wastedBytes, right.m_wastedBytes);
 	}
 };
 
 /// Swaps the contents of the given chunk heap with the ones of this chunk heap.
-template <size_t ChunkSize, class Heap, size_t StaticChunkSize, size_t DefaultAlignment>
+template <size_t ChunkSize, class Heap, size_t StaticChunkSize, size_t DefaultAlignment, class GrowthPolicy>
 LEAN_INLINE void swap(
-	chunk_heap<ChunkSize, Heap, StaticChunkSize, DefaultAlignment> &left,
-	chunk_heap<ChunkSize, Heap, StaticChunkSize, DefaultAlignment> &right)
+	chunk_heap<ChunkSize, Heap, StaticChunkSize, DefaultAlignment, GrowthPolicy> &left,
+	chunk_heap<ChunkSize, Heap, StaticChunkSize, DefaultAlignment, GrowthPolicy> &right)
 {
 	left.swap(right);
 }
 
 } // namespace
 
+namespace chunk_growth_policies = memory::chunk_growth_policies;
+using memory::chunk_heap_stats;
 using memory::chunk_heap;
 
 } // namespace
@@ -16,7 +16,8 @@ namespace memory
 {
 
 /// Contiguous chunk allocator heap.
-template <class Element, size_t ChunkSize, class Heap = default_heap, size_t StaticChunkSize = ChunkSize, size_t Alignment = alignof(Element)>
+template <class Element, size_t ChunkSize, class Heap = default_heap, size_t StaticChunkSize = ChunkSize, size_t Alignment = alignof(Element),
+	class GrowthPolicy = chunk_growth_policies::fixed>
 class chunk_pool : public lean::noncopyable
 {
 public:
@@ -26,13 +27,15 @@ public:
 	typedef Heap heap_type;
 	/// Size type.
 	typedef typename heap_type::size_type size_type;
+	/// Chunk growth policy.
+	typedef GrowthPolicy growth_policy;
 	/// Chunk size.
 	static const size_type chunk_size = ChunkSize;
 	/// Alignment.
 	static const size_type alignment = Alignment;
 
 private:
-	typedef chunk_heap<ChunkSize * sizeof(Element), Heap, StaticChunkSize * sizeof(Element), Alignment> chunk_heap;
+	typedef chunk_heap<ChunkSize * sizeof(Element), Heap, StaticChunkSize * sizeof(Element), Alignment, GrowthPolicy> chunk_heap;
 	chunk_heap m_heap;
 
 	/// Free element node
@@ -112,6 +115,9 @@ public:
 		m_freeHead = new(memory) free_node(m_freeHead);
 	}
 
+	/// Gets memory statistics. Freed elements count as used.
+	LEAN_INLINE chunk_heap_stats stats() const { return m_heap.stats(); }
+
 	/// Swaps the contents of the given chunk heap with the ones of this chunk heap.
 	LEAN_INLINE void swap(chunk_pool &right)
 	{
@@ -123,10 +129,10 @@ public:
 };
 
 /// Swaps the contents of the given chunk heap with the ones of this chunk heap.
-template <class Element, size_t ChunkSize, class Heap, size_t StaticChunkSize, size_t Alignment>
+template <class Element, size_t ChunkSize, class Heap, size_t StaticChunkSize, size_t Alignment, class GrowthPolicy>
 LEAN_INLINE void swap(
-	chunk_pool<Element, ChunkSize, Heap, StaticChunkSize, Alignment> &left,
-	chunk_pool<Element, ChunkSize, Heap, StaticChunkSize, Alignment> &right)
+	chunk_pool<Element, ChunkSize, Heap, StaticChunkSize, Alignment, GrowthPolicy> &left,
+	chunk_pool<Element, ChunkSize, Heap, StaticChunkSize, Alignment, GrowthPolicy> &right)
 {
 	left.swap(right);
 }
@@ -0,0 +1,348 @@
+/*****************************************************/
+/* lean Memory                  (c) Tobias Zirr 2011 */
+/*****************************************************/
+
+#pragma once
+#ifndef LEAN_MEMORY_CONCURRENT_CHUNK_POOL
+#define LEAN_MEMORY_CONCURRENT_CHUNK_POOL
+
+#include "../lean.h"
+#include "../tags/noncopyable.h"
+#include "../concurrent/atomic.h"
+#include "../concurrent/spin_lock.h"
+#include "../concurrent/thread_slot.h"
+#include "chunk_heap.h"
+
+namespace lean
+{
+namespace memory
+{
+
+/// Thread-safe contiguous chunk allocator heap. Threads allocate from and free to magazines of free elements
+/// they own, exchanging full magazines with a shared lock-free depot. New elements are carved from chunks
+/// allocated in bulk. Owned magazines are looked up via thread-local storage & accessed without locking. Threads
+/// claim magazines for the lifetime of the pool, threads beyond the magazine count share locked magazines.
+template <class Element, size_t ChunkSize, class Heap = default_heap,
+	size_t MagazineSize = 32, size_t MagazineCount = 16, size_t Alignment = alignof(Element)>
+class concurrent_chunk_pool : public lean::noncopyable
+{
+public:
+	/// Value type.
+	typedef Element value_type;
+	/// Heap type.
+	typedef Heap heap_type;
+	/// Size type.
+	typedef typename heap_type::size_type size_type;
+	/// Chunk size.
+	static const size_type chunk_size = ChunkSize;
+	/// Number of elements exchanged with the shared depot at once.
+	static const size_type magazine_size = MagazineSize;
+	/// Number of magazines owned by threads, threads beyond this number share locked magazines.
+	static const size_type magazine_count = MagazineCount;
+	/// Number of locked magazines shared by threads not owning a magazine.
+	static const size_type shared_magazine_count = 4;
+	/// Alignment.
+	static const size_type alignment = Alignment;
+	/// Assumed size of one cache line.
+	static const size_t cache_line_size = 64;
+
+	LEAN_STATIC_ASSERT_MSG_ALT(MagazineSize > 0,
+		"Magazine size is required to be non-zero.",
+		Magazine_size_is_required_to_be_non_zero);
+
+private:
+	typedef chunk_heap<ChunkSize * sizeof(Element), Heap, 0, Alignment> chunk_heap;
+	chunk_heap m_heap;
+	spin_lock<> m_heapLock;
+
+	/// Free element node
+	struct free_node
+	{
+		free_node *next;
+	};
+
+	/// First free element node of a full magazine stored in the depot
+	struct batch_node : public free_node
+	{
+		batch_node *nextBatch;
+	};
+
+	LEAN_STATIC_ASSERT_MSG_ALT(
+		sizeof(Element) >= sizeof(batch_node),
+		"Inline free list requires elements greater or equal to two pointers",
+		Inline_free_list_requires_elements_greater_or_equal_to_two_pointers );
+
+	/// Magazine of free elements.
+	struct magazine
+	{
+		volatile long owner;	///< Slot + 1 of the owning thread, zero if not owned.
+		spin_lock<> lock;		///< Only used by shared magazines.
+		free_node *head;
+		size_type count;
+		char pad[cache_line_size];
+
+		/// Constructor.
+		magazine()
+			: owner(0),
+			head(nullptr),
+			count(0) { }
+	};
+	magazine m_magazines[MagazineCount];
+	magazine m_sharedMagazines[shared_magazine_count];
+
+	/// Unique pool ID, never re-used by pools of the same type.
+	long m_id;
+
+	/// Owned magazine of the calling thread, cached for the pool last used.
+	struct thread_cache
+	{
+		long poolID;
+		magazine *mag;
+	};
+
+	/// Gets the magazine cache of the calling thread.
+	static LEAN_INLINE thread_cache& current_thread_cache()
+	{
+		static LEAN_THREAD_LOCAL thread_cache cache = { 0, nullptr };
+		return cache;
+	}
+
+	/// Gets the next unique pool ID.
+	static long next_pool_id()
+	{
+		static volatile long nextID = 0;
+		return atomic_increment(nextID);
+	}
+
+#ifdef LEAN_ATOMIC_DOUBLE_WORD
+	// Full magazines, tagged to avoid ABA problems
+	volatile double_word m_depot;
+#else
+	batch_node *m_depot;
+	spin_lock<> m_depotLock;
+#endif
+
+	/// Pushes the given full magazine onto the depot.
+	LEAN_INLINE void push_batch(batch_node *batch)
+	{
+#ifdef LEAN_ATOMIC_DOUBLE_WORD
+		double_word head, newHead;
+
+		do
+		{
+			head.high = m_depot.high;
+			head.low = m_depot.low;
+
+			batch->nextBatch = reinterpret_cast<batch_node*>(head.low);
+			newHead.low = reinterpret_cast<uintptr_t>(batch);
+			newHead.high = head.high + 1;
+		}
+		while (!atomic_test_and_set(m_depot, head, newHead));
+#else
+		scoped_sl_lock lock(m_depotLock);
+		batch->nextBatch = m_depot;
+		m_depot = batch;
+#endif
+	}
+
+	/// Pops a full magazine off the depot, returning nullptr if empty.
+	LEAN_INLINE batch_node* pop_batch()
+	{
+#ifdef LEAN_ATOMIC_DOUBLE_WORD
+		double_word head, newHead;
+		batch_node *batch;
+
+		do
+		{
+			head.high = m_depot.high;
+			head.low = m_depot.low;
+
+			batch = reinterpret_cast<batch_node*>(head.low);
+
+			if (!batch)
+				return nullptr;
+
+			// Batch may concurrently be popped & re-used, tag makes sure we do not succeed in that case
+			newHead.low = reinterpret_cast<uintptr_t>(batch->nextBatch);
+			newHead.high = head.high + 1;
+		}
+		while (!atomic_test_and_set(m_depot, head, newHead));
+
+		return batch;
+#else
+		scoped_sl_lock lock(m_depotLock);
+		batch_node *batch = m_depot;
+		if (batch)
+			m_depot = batch->nextBatch;
+		return batch;
+#endif
+	}
+
+	/// Empties the depot.
+	LEAN_INLINE void reset_depot()
+	{
+#ifdef LEAN_ATOMIC_DOUBLE_WORD
+		m_depot.low = 0;
+		m_depot.high = 0;
+#else
+		m_depot = nullptr;
+#endif
+	}
+
+	/// Looks up or claims the magazine owned by the calling thread, caching the result.
+	LEAN_NOINLINE magazine* claim_magazine(thread_cache &cache)
+	{
+		long self = static_cast<long>(current_thread_slot()) + 1;
+		magazine *claimed = nullptr;
+
+		// Magazine may have been claimed before, when the cache was last bound to this pool
+		for (size_type i = 0; i < MagazineCount && !claimed; ++i)
+			if (atomic_load(m_magazines[i].owner, memory_order_relaxed) == self)
+				claimed = &m_magazines[i];
+
+		for (size_type i = 0; i < MagazineCount && !claimed; ++i)
+			if (atomic_load(m_magazines[i].owner, memory_order_relaxed) == 0 && atomic_test_and_set(m_magazines[i].owner, 0L, self))
+				claimed = &m_magazines[i];
+
+		cache.poolID = m_id;
+		cache.mag = claimed;
+		return claimed;
+	}
+
+	/// Gets the magazine owned by the calling thread, nullptr if all magazines are owned by other threads.
+	LEAN_INLINE magazine* owned_magazine()
+	{
+		thread_cache &cache = current_thread_cache();
+		return (cache.poolID == m_id) ? cache.mag : claim_magazine(cache);
+	}
+	/// Gets the shared magazine of the calling thread.
+	LEAN_INLINE magazine& shared_magazine()
+	{
+		return m_sharedMagazines[current_thread_slot(shared_magazine_count)];
+	}
+
+	/// Takes one element from the given magazine.
+	LEAN_INLINE void* pop(magazine &mag)
+	{
+		if (!mag.head)
+			refill(mag);
+
+		free_node *node = mag.head;
+		mag.head = node->next;
+		--mag.count;
+		return node;
+	}
+	/// Puts the given element into the given magazine.
+	LEAN_INLINE void push(magazine &mag, void *memory)
+	{
+		free_node *node = static_cast<free_node*>(memory);
+		node->next = mag.head;
+		mag.head = node;
+
+		// Keep one magazine worth of elements to avoid thrashing
+		if (++mag.count >= 2 * MagazineSize)
+			flush(mag);
+	}
+
+	/// Fills the given empty magazine from the depot or fresh chunk memory.
+	LEAN_NOINLINE void refill(magazine &mag)
+	{
+		batch_node *batch = pop_batch();
+
+		if (batch)
+		{
+			mag.head = batch;
+			mag.count = MagazineSize;
+		}
+		else
+		{
+			scoped_sl_lock lock(m_heapLock);
+
+			for (size_type i = 0; i < MagazineSize; ++i)
+			{
+				free_node *node = static_cast<free_node*>( m_heap.allocate<alignment>(sizeof(Element)) );
+				node->next = mag.head;
+				mag.head = node;
+			}
+
+			mag.count = MagazineSize;
+		}
+	}
+
+	/// Moves one magazine worth of free elements from the given magazine to the depot.
+	LEAN_NOINLINE void flush(magazine &mag)
+	{
+		free_node *batchHead = mag.head;
+		free_node *batchTail = batchHead;
+
+		for (size_type i = 1; i < MagazineSize; ++i)
+			batchTail = batchTail->next;
+
+		mag.head = batchTail->next;
+		mag.count -= MagazineSize;
+
+		batchTail->next = nullptr;
+		push_batch(static_cast<batch_node*>(batchHead));
+	}
+
+public:
+	/// Constructor.
+	concurrent_chunk_pool(size_type chunkSize = ChunkSize)
+		: m_heap( max(chunkSize, static_cast<size_type>(MagazineSize)) * sizeof(Element) ),
+		m_id( next_pool_id() )
+	{
+		reset_depot();
+	}
+
+	/// Allocates one element. This method is thread-safe.
+	LEAN_INLINE void* allocate()
+	{
+		// Owned magazines are never accessed by other threads
+		if (magazine *mag = owned_magazine())
+			return pop(*mag);
+
+		magazine &shared = shared_magazine();
+		scoped_sl_lock lock(shared.lock);
+		return pop(shared);
+	}
+	/// Frees the given element. May be called by any thread, not only the allocating one. This method is thread-safe.
+	LEAN_INLINE void free(void *memory)
+	{
+		if (magazine *mag = owned_magazine())
+			push(*mag, memory);
+		else
+		{
+			magazine &shared = shared_magazine();
+			scoped_sl_lock lock(shared.lock);
+			push(shared, memory);
+		}
+	}
+
+	/// Clears and frees all chunks allocated by this allocator. NOT thread-safe.
+	void clear()
+	{
+		// Magazines stay owned by their threads
+		for (size_type i = 0; i < MagazineCount; ++i)
+		{
+			m_magazines[i].head = nullptr;
+			m_magazines[i].count = 0;
+		}
+
+		for (size_type i = 0; i < shared_magazine_count; ++i)
+		{
+			m_sharedMagazines[i].head = nullptr;
+			m_sharedMagazines[i].count = 0;
+		}
+
+		reset_depot();
+		m_heap.clear();
+	}
+};
+
+} // namespace
+
+using memory::concurrent_chunk_pool;
+
+} // namespace
+
+#endif
\ No newline at end of file
@@ -8,6 +8,13 @@
 
 #include "../lean.h"
 #include "alignment.h"
+#include <new>
+
+#ifdef _MSC_VER
+	#include <malloc.h>
+#else
+	#include <stdlib.h>
+#endif
 
 #ifndef LEAN_ASSUME_CRT_ALIGNMENT
 	// MONITOR: Seems to be guaranteed for MSC & GCC
@@ -26,8 +33,39 @@ namespace lean
 {
 namespace memory
 {
+namespace impl
+{
+
+/// Allocates the given amount of memory natively aligned to the given power-of-two alignment.
+LEAN_INLINE void* crt_aligned_alloc(size_t size, size_t alignment)
+{
+	void *memory;
+
+#ifdef _MSC_VER
+	if ( !(memory = ::_aligned_malloc(size, alignment)) )
+		throw std::bad_alloc();
+#else
+	// NOTE: posix_memalign requires multiples of sizeof(void*), returns nullptr or unique memory on zero size
+	if (::posix_memalign(&memory, (alignment > sizeof(void*)) ? alignment : sizeof(void*), size) != 0)
+		throw std::bad_alloc();
+#endif
+
+	return memory;
+}
+
+/// Frees the given block of memory allocated by crt_aligned_alloc().
+LEAN_INLINE void crt_aligned_free(void *memory)
+{
+#ifdef _MSC_VER
+	::_aligned_free(memory);
+#else
+	::free(memory);
+#endif
+}
 
-/// Default CRT heap.
+} // namespace
+
+/// Default CRT heap. Over-aligned memory is allocated natively aligned, without additional bookkeeping.
 struct crt_heap
 {
 	/// Size type.
@@ -35,7 +73,7 @@ struct crt_heap
 	/// Default alignment.
 	static const size_type default_alignment = LEAN_ASSUME_CRT_ALIGNMENT;
 	/// Maximum alignment.
-	static const size_type max_alignment = static_cast<unsigned char>(-1);
+	static const size_type max_alignment = static_cast<size_type>(1) << 30;
 
 	/// Allocates the given amount of memory.
 	static LEAN_INLINE void* allocate(size_type size) { return ::operator new(size); }
@@ -46,36 +84,41 @@ struct crt_heap
 	template <size_t Alignment>
 	static LEAN_INLINE void* allocate(size_type size)
 	{
-		if (Alignment <= default_alignment && is_valid_alignment<Alignment>::value)
+		LEAN_STATIC_ASSERT_MSG_ALT(is_valid_alignment<Alignment>::value && Alignment <= max_alignment,
+			"Alignment is required to be power of two <= max_alignment.",
+			Alignment_is_required_to_be_power_of_two_not_exceeding_max_alignment);
+
+		if (Alignment <= default_alignment)
 			return allocate(size);
 		else
-		{
-			LEAN_STATIC_ASSERT_MSG_ALT(Alignment <= max_alignment,
-				"Alignment > max unsigned char unsupported.",
-				Alignment_bigger_than_max_unsigned_char_unsupported);
-
-			unsigned char *unaligned = reinterpret_cast<unsigned char*>( allocate(size + Alignment) );
-			unsigned char *aligned = upper_align<Alignment>(unaligned);
-			aligned[-1] = static_cast<unsigned char>(aligned - unaligned);
-			return aligned;
-		}
+			return impl::crt_aligned_alloc(size, Alignment);
 	}
 	/// Frees the given aligned block of memory.
 	template <size_t Alignment>
 	static LEAN_INLINE void free(void *memory)
 	{
-		if (Alignment <= default_alignment && is_valid_alignment<Alignment>::value)
+		if (Alignment <= default_alignment)
 			free(memory);
-		else if (memory)
-			free(reinterpret_cast<unsigned char*>(memory) - reinterpret_cast<unsigned char*>(memory)[-1]);
+		else
+			impl::crt_aligned_free(memory);
+	}
+	/// Allocates the given amount of memory respecting the given power-of-two alignment.
+	static LEAN_INLINE void* allocate(size_type size, size_t alignment)
+	{
+		LEAN_ASSERT(check_alignment(alignment) && alignment <= max_alignment);
+
+		if (alignment <= default_alignment)
+			return allocate(size);
+		else
+			return impl::crt_aligned_alloc(size, alignment);
 	}
 	/// Frees the given aligned block of memory.
 	static LEAN_INLINE void free(void *memory, size_t alignment)
 	{
-		if (alignment <= default_alignment && check_alignment(alignment))
+		if (alignment <= default_alignment)
 			free(memory);
-		else if (memory)
-			free(reinterpret_cast<unsigned char*>(memory) - reinterpret_cast<unsigned char*>(memory)[-1]);
+		else
+			impl::crt_aligned_free(memory);
 	}
 };
 
@@ -15,12 +15,28 @@
 
 #endif
 
+#ifdef DOXYGEN_READ_THIS
+	/// Define this to record allocation statistics of the default heap by wrapping it in a tracking_heap.
+	/// @ingroup MemorySwitches
+	#define LEAN_TRACK_DEFAULT_HEAP
+	#undef LEAN_TRACK_DEFAULT_HEAP
+#endif
+
+#ifdef LEAN_TRACK_DEFAULT_HEAP
+	#include "tracking_heap.h"
+#endif
+
 namespace lean
 {
 	namespace memory
 	{
+#ifdef LEAN_TRACK_DEFAULT_HEAP
+		/// Default heap to be used by all subsequent definitions that make use of the heap concept.
+		typedef tracking_heap<LEAN_DEFAULT_HEAP> default_heap;
+#else
 		/// Default heap to be used by all subsequent definitions that make use of the heap concept.
 		typedef LEAN_DEFAULT_HEAP default_heap;
+#endif
 
 	} // namespace
 
@@ -37,32 +53,54 @@ namespace lean
 
 #ifdef LEAN_OVERRIDE_NEW
 
-	#if LEAN_DEFAULT_HEAP == crt_heap
-		// CRT uses global operators new / delete, overriding them would cause chaos
-		#error Cannot override new using the CRT heap
-	#else
-		/// Allocates memory using the previously defined default_heap.
-		inline void* operator new(size_t size)
-		{
-			return lean::memory::default_heap::allocate(size);
-		}
-		/// Frees memory using the previously defined default_heap heap.
-		inline void operator delete(void *memory)
-		{
-			lean::memory::default_heap::free(memory);
-		}
-		/// Allocates memory using the previously defined default_heap.
-		inline void* operator new[](size_t size)
-		{
-			return lean::memory::default_heap::allocate(size);
-		}
-		/// Frees memory using the previously defined default_heap heap.
-		inline void operator delete[](void *memory)
+	#include "crt_heap.h"
+
+	namespace lean
+	{
+		namespace memory
 		{
-			lean::memory::default_heap::free(memory);
-		}
+			namespace impl
+			{
+				/// Checks if the given heap may be used to override new.
+				template <class Heap>
+				struct can_override_new { static const bool value = true; };
+				// CRT uses global operators new / delete, overriding them would cause chaos
+				template <>
+				struct can_override_new<crt_heap> { static const bool value = false; };
+	#ifdef LEAN_TRACK_DEFAULT_HEAP
+				template <class Heap>
+				struct can_override_new< tracking_heap<Heap> > : public can_override_new<Heap> { };
 	#endif
 
+				LEAN_STATIC_ASSERT_MSG_ALT(can_override_new<default_heap>::value,
+					"Cannot override new using the CRT heap.",
+					Cannot_override_new_using_the_CRT_heap);
+
+			} // namespace
+		} // namespace
+	} // namespace
+
+	/// Allocates memory using the previously defined default_heap.
+	inline void* operator new(size_t size)
+	{
+		return lean::memory::default_heap::allocate(size);
+	}
+	/// Frees memory using the previously defined default_heap heap.
+	inline void operator delete(void *memory) noexcept
+	{
+		lean::memory::default_heap::free(memory);
+	}
+	/// Allocates memory using the previously defined default_heap.
+	inline void* operator new[](size_t size)
+	{
+		return lean::memory::default_heap::allocate(size);
+	}
+	/// Frees memory using the previously defined default_heap heap.
+	inline void operator delete[](void *memory) noexcept
+	{
+		lean::memory::default_heap::free(memory);
+	}
+
 #endif
 
 #endif
\ No newline at end of file
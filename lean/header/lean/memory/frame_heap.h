@@ -0,0 +1,90 @@
+/*****************************************************/
+/* lean Memory                  (c) Tobias Zirr 2011 */
+/*****************************************************/
+
+#pragma once
+#ifndef LEAN_MEMORY_FRAME_HEAP
+#define LEAN_MEMORY_FRAME_HEAP
+
+#include "../lean.h"
+#include "../tags/noncopyable.h"
+#include "chunk_heap.h"
+#include "default_heap.h"
+
+namespace lean
+{
+namespace memory
+{
+
+/// Double-buffered frame allocator heap. Memory allocated during one frame remains valid until the end
+/// of the next frame, when it is freed all at once. Chunks are retained between frames instead of being
+/// freed back to the underlying heap.
+template <size_t ChunkSize, class Heap = default_heap, size_t DefaultAlignment = sizeof(void*)>
+class frame_heap : public lean::noncopyable
+{
+public:
+	/// Heap type.
+	typedef Heap heap_type;
+	/// Chunk heap type.
+	typedef chunk_heap<ChunkSize, Heap, 0, DefaultAlignment> chunk_heap_type;
+	/// Size type.
+	typedef typename heap_type::size_type size_type;
+	/// Chunk size.
+	static const size_type chunk_size = ChunkSize;
+	/// Default alignment.
+	static const size_type default_alignment = DefaultAlignment;
+
+private:
+	chunk_heap_type m_heaps[2];
+	chunk_heap_type *m_current;
+
+public:
+	/// Constructor.
+	LEAN_INLINE frame_heap()
+		: m_current(&m_heaps[0]) { }
+
+	/// Ends the current frame, freeing all memory allocated during the frame before.
+	LEAN_INLINE void next_frame()
+	{
+		m_current = (m_current == &m_heaps[0]) ? &m_heaps[1] : &m_heaps[0];
+		m_current->reset();
+	}
+
+	/// Frees all memory & all chunks retained by this allocator.
+	void clear()
+	{
+		m_heaps[0].clear();
+		m_heaps[1].clear();
+	}
+
+	/// Allocates the given amount of memory.
+	LEAN_INLINE void* allocate(size_type size) { return m_current->allocate(size); }
+	/// Frees the given block of memory.
+	LEAN_INLINE void free(void *memory) { }
+
+	/// Allocates the given amount of memory respecting the given alignment.
+	template <size_t Alignment>
+	LEAN_INLINE void* allocate(size_type size)
+	{
+		return m_current->template allocate<Alignment>(size);
+	}
+	/// Frees the given aligned block of memory.
+	template <size_t Alignment>
+	LEAN_INLINE void free(void *memory)
+	{
+		// Freeing of individual memory blocks unsupported
+	}
+
+	/// Gets the chunk heap serving the current frame.
+	LEAN_INLINE chunk_heap_type& current() { return *m_current; }
+	/// Gets the chunk heap serving the current frame.
+	LEAN_INLINE const chunk_heap_type& current() const { return *m_current; }
+};
+
+} // namespace
+
+using memory::frame_heap;
+
+} // namespace
+
+#endif
\ No newline at end of file
@@ -0,0 +1,127 @@
+/*****************************************************/
+/* lean Memory                  (c) Tobias Zirr 2011 */
+/*****************************************************/
+
+#pragma once
+#ifndef LEAN_MEMORY_NUMA_HEAP
+#define LEAN_MEMORY_NUMA_HEAP
+
+#include "../lean.h"
+#include "page_heap.h"
+
+namespace lean
+{
+namespace memory
+{
+
+/// NUMA page placement policies.
+struct numa_policy
+{
+	/// NUMA page placement policies.
+	enum t
+	{
+		local,		///< Pages placed on the node of the thread touching them first (system default).
+		preferred,	///< Pages placed on the given node, falling back to other nodes when the given node runs out of memory.
+		bind,		///< Pages placed on the given node only.
+		interleave	///< Pages interleaved across the given node or all nodes.
+	};
+};
+
+/// NUMA topology queries & page placement. Placement is supported on Linux only, other systems place
+/// pages on the node of the thread touching them first. Placement requests that cannot be satisfied,
+/// e.g. nodes missing on single-node machines, fall back to the same default.
+struct numa_heap_base : public page_heap_base
+{
+	/// Selects all nodes.
+	static const int all_nodes = -1;
+
+	/// Gets the number of NUMA nodes, 1 if NUMA unsupported.
+	LEAN_MAYBE_EXPORT static int node_count();
+	/// Gets the node of the processor currently running the calling thread, 0 if unknown.
+	LEAN_MAYBE_EXPORT static int current_node();
+	/// Gets the node of the physical page backing the given memory, -1 if unknown.
+	LEAN_MAYBE_EXPORT static int page_node(const void *memory);
+
+	/// Places all pages overlapping the given range according to the given policy, migrating pages already touched.
+	/// Returns false if unsupported or if the given node does not exist.
+	LEAN_MAYBE_EXPORT static bool place_pages(void *memory, size_type size, numa_policy::t policy, int node);
+	/// Places all pages subsequently touched by the calling thread according to the given policy.
+	/// Returns false if unsupported or if the given node does not exist.
+	LEAN_MAYBE_EXPORT static bool set_thread_policy(numa_policy::t policy, int node);
+	/// Restricts the calling thread to the processors of the given node, all_nodes lifting any restriction.
+	/// Returns false if unsupported or if the given node does not exist.
+	LEAN_MAYBE_EXPORT static bool run_on_node(int node);
+
+protected:
+	/// Maps a block of the given size & alignment placed according to the given policy, storing its mapping
+	/// in front of the returned memory.
+	LEAN_MAYBE_EXPORT static void* allocate_placed(size_type size, size_type alignment, numa_policy::t policy, int node);
+};
+
+/// Heap mapping every block to separate pages placed on the given NUMA node, or interleaved across all nodes.
+/// Intended for large blocks, each allocation occupies at least one page & costs two system calls.
+template <int Node, numa_policy::t Policy = numa_policy::bind>
+struct numa_heap : public numa_heap_base
+{
+	/// NUMA node.
+	static const int node = Node;
+	/// NUMA page placement policy.
+	static const numa_policy::t policy = Policy;
+	/// Default alignment.
+	static const size_type default_alignment = 64;
+	/// Maximum alignment.
+	static const size_type max_alignment = static_cast<size_type>(1) << 30;
+
+	/// Allocates the given amount of memory.
+	static LEAN_INLINE void* allocate(size_type size) { return allocate_placed(size, default_alignment, Policy, Node); }
+	/// Allocates the given amount of memory respecting the given alignment.
+	static LEAN_INLINE void* allocate(size_type size, size_type alignment)
+	{
+		return allocate_placed(size, (alignment > default_alignment) ? alignment : static_cast<size_type>(default_alignment), Policy, Node);
+	}
+	/// Frees the given block of memory.
+	static LEAN_INLINE void free(void *memory) { free_block(memory, page_size_policy::normal); }
+
+	/// Allocates the given amount of memory respecting the given alignment.
+	template <size_t Alignment>
+	static LEAN_INLINE void* allocate(size_type size)
+	{
+		LEAN_STATIC_ASSERT_MSG_ALT(Alignment <= max_alignment,
+			"Alignment > 1 GB unsupported.",
+			Alignment_bigger_than_1_GB_unsupported);
+
+		return allocate_placed(size, (Alignment > default_alignment) ? Alignment : default_alignment, Policy, Node);
+	}
+	/// Frees the given aligned block of memory.
+	template <size_t Alignment>
+	static LEAN_INLINE void free(void *memory)
+	{
+		free_block(memory, page_size_policy::normal);
+	}
+	/// Frees the given aligned block of memory.
+	static LEAN_INLINE void free(void *memory, size_t alignment)
+	{
+		free_block(memory, page_size_policy::normal);
+	}
+
+	/// Gets the number of bytes usable in the given block of memory.
+	static LEAN_INLINE size_type size(const void *memory) { return block_size(memory); }
+};
+
+/// Heap mapping every block to separate pages interleaved across all NUMA nodes.
+typedef numa_heap<numa_heap_base::all_nodes, numa_policy::interleave> interleaved_heap;
+
+} // namespace
+
+using memory::numa_policy;
+using memory::numa_heap_base;
+using memory::numa_heap;
+using memory::interleaved_heap;
+
+} // namespace
+
+#ifdef LEAN_INCLUDE_LINKED
+#include "source/numa_heap.cpp"
+#endif
+
+#endif
\ No newline at end of file
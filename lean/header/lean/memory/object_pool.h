@@ -17,7 +17,8 @@ namespace memory
 {
 
 /// Enhances the chunk_heap by proper object deconstruction.
-template <class Element, size_t ChunkSize, class Heap = default_heap, size_t StaticChunkSize = ChunkSize, size_t Alignment = alignof(Element)>
+template <class Element, size_t ChunkSize, class Heap = default_heap, size_t StaticChunkSize = ChunkSize, size_t Alignment = alignof(Element),
+	class GrowthPolicy = chunk_growth_policies::fixed>
 class object_pool : public lean::noncopyable
 {
 public:
@@ -27,13 +28,15 @@ public:
 	typedef Heap heap_type;
 	/// Size type.
 	typedef typename heap_type::size_type size_type;
+	/// Chunk growth policy.
+	typedef GrowthPolicy growth_policy;
 	/// Chunk size.
 	static const size_type chunk_size = ChunkSize;
 	/// Alignment.
 	static const size_type alignment = Alignment;
 
 private:
-	typedef chunk_heap<0, Heap, StaticChunkSize * sizeof(Element), Alignment> chunk_heap;
+	typedef chunk_heap<0, Heap, StaticChunkSize * sizeof(Element), Alignment, GrowthPolicy> chunk_heap;
 	chunk_heap m_heap;
 
 public:
@@ -70,15 +73,17 @@ public:
 
 			if (nextChunkBegin != chunkBegin)
 			{
-				chunkBegin = nextChunkBegin;
-				chunkEnd = chunkBegin
-					+ ((m_heap.currentStatic()) ? StaticChunkSize * sizeof(Element) : m_heap.nextChunkSize());
+				chunkEnd = m_heap.currentOffset();
+				chunkBegin = m_heap.clearCurrent();
 			}
 			else
 				chunkBegin = nullptr;
 		}
 	}
 
+	/// Gets memory statistics.
+	LEAN_INLINE chunk_heap_stats stats() const { return m_heap.stats(); }
+
 	/// Allocates a new element in the object pool. Object MUST BE CONSTRUCTED, WILL BE DESTRUCTED.
 	LEAN_INLINE void* allocate()
 	{
@@ -0,0 +1,162 @@
+/*****************************************************/
+/* lean Memory                  (c) Tobias Zirr 2011 */
+/*****************************************************/
+
+#pragma once
+#ifndef LEAN_MEMORY_OFFSET_PTR
+#define LEAN_MEMORY_OFFSET_PTR
+
+#include "../lean.h"
+
+namespace lean
+{
+namespace memory
+{
+
+/// Pointer storing the offset of the object pointed to relative to its own address. Offset pointers remain valid
+/// when moved together with the objects pointed to, e.g. when stored in a memory-mapped file that is mapped to
+/// a different address later on. Copying an offset pointer to another location recomputes the offset.
+/// Converts implicitly to raw pointers, which only remain valid as long as the memory stays mapped.
+template <class Type>
+class offset_ptr
+{
+	template <class Other>
+	friend class offset_ptr;
+
+public:
+	/// Type of the object pointed to.
+	typedef Type value_type;
+	/// Raw pointer type.
+	typedef Type* pointer;
+	/// Reference type.
+	typedef Type& reference;
+	/// Pointer difference type.
+	typedef ptrdiff_t difference_type;
+
+private:
+	// NOTE: Offset 1 points into the pointer itself, never referring to any other object
+	static const ptrdiff_t null_offset = 1;
+
+	ptrdiff_t m_offset;
+
+	// NOTE: Compute in integers, pointer arithmetic across distinct objects is undefined & optimized accordingly
+
+	/// Computes the offset of the given object relative to this pointer.
+	LEAN_INLINE ptrdiff_t to_offset(const volatile void *object) const
+	{
+		return (object)
+			? static_cast<ptrdiff_t>( reinterpret_cast<uintptr_t>(object) - reinterpret_cast<uintptr_t>(this) )
+			: null_offset;
+	}
+
+public:
+	/// Constructs a null pointer.
+	LEAN_INLINE offset_ptr()
+		: m_offset(null_offset) { }
+	/// Points to the given object.
+	LEAN_INLINE explicit offset_ptr(Type *object)
+		: m_offset( to_offset(object) ) { }
+	/// Points to the object pointed to by the given pointer.
+	LEAN_INLINE offset_ptr(const offset_ptr &right)
+		: m_offset( to_offset(right.get()) ) { }
+	/// Points to the object pointed to by the given pointer.
+	template <class Other>
+	LEAN_INLINE offset_ptr(const offset_ptr<Other> &right)
+		: m_offset( to_offset(static_cast<Type*>(right.get())) ) { }
+
+	/// Points to the given object.
+	LEAN_INLINE offset_ptr& operator =(Type *object)
+	{
+		m_offset = to_offset(object);
+		return *this;
+	}
+	/// Points to the object pointed to by the given pointer.
+	LEAN_INLINE offset_ptr& operator =(const offset_ptr &right)
+	{
+		m_offset = to_offset(right.get());
+		return *this;
+	}
+	/// Points to the object pointed to by the given pointer.
+	template <class Other>
+	LEAN_INLINE offset_ptr& operator =(const offset_ptr<Other> &right)
+	{
+		m_offset = to_offset(static_cast<Type*>(right.get()));
+		return *this;
+	}
+
+	/// Gets the object pointed to, nullptr if null.
+	LEAN_INLINE Type* get() const
+	{
+		return (m_offset != null_offset)
+			? reinterpret_cast<Type*>( reinterpret_cast<uintptr_t>(this) + m_offset )
+			: nullptr;
+	}
+	/// Gets the object pointed to, nullptr if null.
+	LEAN_INLINE operator Type*() const { return get(); }
+	/// Gets the object pointed to.
+	LEAN_INLINE Type& operator *() const { return *get(); }
+	/// Gets the object pointed to.
+	LEAN_INLINE Type* operator ->() const { return get(); }
+
+	/// Points to the next object.
+	LEAN_INLINE offset_ptr& operator ++()
+	{
+		m_offset += sizeof(Type);
+		return *this;
+	}
+	/// Points to the next object.
+	LEAN_INLINE offset_ptr operator ++(int)
+	{
+		offset_ptr prev(*this);
+		++*this;
+		return prev;
+	}
+	/// Points to the previous object.
+	LEAN_INLINE offset_ptr& operator --()
+	{
+		m_offset -= sizeof(Type);
+		return *this;
+	}
+	/// Points to the previous object.
+	LEAN_INLINE offset_ptr operator --(int)
+	{
+		offset_ptr prev(*this);
+		--*this;
+		return prev;
+	}
+	/// Advances this pointer by the given number of objects.
+	LEAN_INLINE offset_ptr& operator +=(difference_type count)
+	{
+		m_offset += count * static_cast<difference_type>(sizeof(Type));
+		return *this;
+	}
+	/// Moves this pointer back by the given number of objects.
+	LEAN_INLINE offset_ptr& operator -=(difference_type count)
+	{
+		m_offset -= count * static_cast<difference_type>(sizeof(Type));
+		return *this;
+	}
+
+	/// Swaps the objects pointed to by the given two pointers.
+	LEAN_INLINE void swap(offset_ptr &right)
+	{
+		Type *object = get();
+		*this = right.get();
+		right = object;
+	}
+};
+
+/// Swaps the objects pointed to by the given two pointers.
+template <class Type>
+LEAN_INLINE void swap(offset_ptr<Type> &left, offset_ptr<Type> &right)
+{
+	left.swap(right);
+}
+
+} // namespace
+
+using memory::offset_ptr;
+
+} // namespace
+
+#endif
\ No newline at end of file
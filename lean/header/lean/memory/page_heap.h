@@ -0,0 +1,132 @@
+/*****************************************************/
+/* lean Memory                  (c) Tobias Zirr 2011 */
+/*****************************************************/
+
+#pragma once
+#ifndef LEAN_MEMORY_PAGE_HEAP
+#define LEAN_MEMORY_PAGE_HEAP
+
+#include "../lean.h"
+#include "alignment.h"
+
+namespace lean
+{
+namespace memory
+{
+
+/// Page size policies.
+struct page_size_policy
+{
+	/// Page size policies.
+	enum t
+	{
+		normal,				///< Regular pages.
+		transparent_huge,	///< Regular pages, hinting the system to transparently back them with huge pages.
+		explicit_huge		///< Huge pages reserved by the system, falling back to transparent huge pages if none available.
+	};
+};
+
+/// Page-granular memory mapped directly from the operating system.
+struct page_heap_base
+{
+	/// Size type.
+	typedef size_t size_type;
+
+	/// Gets the size of regular pages.
+	LEAN_MAYBE_EXPORT static size_type page_size();
+	/// Gets the size of huge pages, the size of regular pages if unsupported.
+	LEAN_MAYBE_EXPORT static size_type huge_page_size();
+	/// Rounds the given size up to whole pages of the given policy.
+	LEAN_MAYBE_EXPORT static size_type round_to_pages(size_type size, page_size_policy::t policy);
+
+	/// Maps the given number of bytes, rounded up to whole pages, aligned to at least the page size.
+	/// Throws bad_alloc on failure, after asking the new handler for more memory.
+	LEAN_MAYBE_EXPORT static void* map_pages(size_type size, size_type alignment, page_size_policy::t policy);
+	/// Unmaps the given pages, size & policy are required to match those passed to map_pages().
+	LEAN_MAYBE_EXPORT static void unmap_pages(void *memory, size_type size, page_size_policy::t policy);
+
+	/// Hints that the contents of all whole pages in the given range are no longer needed, allowing
+	/// the system to reclaim the underlying physical memory. Pages remain accessible, their contents
+	/// become undefined (zero on Linux).
+	LEAN_MAYBE_EXPORT static void decommit(void *memory, size_type size);
+
+protected:
+	/// Gets the number of bytes to be mapped for a block of the given size & alignment.
+	LEAN_MAYBE_EXPORT static size_type block_mapping_size(size_type size, size_type alignment, page_size_policy::t policy);
+	/// Stores the given mapping in front of the block of the given alignment, returning the block memory.
+	LEAN_MAYBE_EXPORT static void* init_block(void *mapped, size_type mappedSize, size_type alignment);
+	/// Maps a block of the given size & alignment, storing its mapping in front of the returned memory.
+	LEAN_MAYBE_EXPORT static void* allocate_block(size_type size, size_type alignment, page_size_policy::t policy);
+	/// Unmaps the given block of memory.
+	LEAN_MAYBE_EXPORT static void free_block(void *memory, page_size_policy::t policy);
+	/// Gets the number of bytes usable in the given block of memory.
+	LEAN_MAYBE_EXPORT static size_type block_size(const void *memory);
+};
+
+/// Heap mapping every block to separate pages directly from the operating system. Intended for large blocks,
+/// each allocation occupies at least one page & costs one system call.
+template <page_size_policy::t Policy = page_size_policy::normal>
+struct basic_page_heap : public page_heap_base
+{
+	/// Page size policy.
+	static const page_size_policy::t policy = Policy;
+	/// Default alignment.
+	static const size_type default_alignment = 64;
+	/// Maximum alignment.
+	static const size_type max_alignment = static_cast<size_type>(1) << 30;
+
+	/// Allocates the given amount of memory.
+	static LEAN_INLINE void* allocate(size_type size) { return allocate_block(size, default_alignment, Policy); }
+	/// Allocates the given amount of memory respecting the given alignment.
+	static LEAN_INLINE void* allocate(size_type size, size_type alignment)
+	{
+		return allocate_block(size, (alignment > default_alignment) ? alignment : static_cast<size_type>(default_alignment), Policy);
+	}
+	/// Frees the given block of memory.
+	static LEAN_INLINE void free(void *memory) { free_block(memory, Policy); }
+
+	/// Allocates the given amount of memory respecting the given alignment.
+	template <size_t Alignment>
+	static LEAN_INLINE void* allocate(size_type size)
+	{
+		LEAN_STATIC_ASSERT_MSG_ALT(Alignment <= max_alignment,
+			"Alignment > 1 GB unsupported.",
+			Alignment_bigger_than_1_GB_unsupported);
+
+		return allocate_block(size, (Alignment > default_alignment) ? Alignment : default_alignment, Policy);
+	}
+	/// Frees the given aligned block of memory.
+	template <size_t Alignment>
+	static LEAN_INLINE void free(void *memory)
+	{
+		free_block(memory, Policy);
+	}
+	/// Frees the given aligned block of memory.
+	static LEAN_INLINE void free(void *memory, size_t alignment)
+	{
+		free_block(memory, Policy);
+	}
+
+	/// Gets the number of bytes usable in the given block of memory.
+	static LEAN_INLINE size_type size(const void *memory) { return block_size(memory); }
+};
+
+/// Heap mapping every block to separate regular pages.
+typedef basic_page_heap<page_size_policy::normal> page_heap;
+/// Heap mapping every block to separate pages, hinting the system to back them with huge pages.
+typedef basic_page_heap<page_size_policy::transparent_huge> huge_page_heap;
+
+} // namespace
+
+using memory::page_size_policy;
+using memory::basic_page_heap;
+using memory::page_heap;
+using memory::huge_page_heap;
+
+} // namespace
+
+#ifdef LEAN_INCLUDE_LINKED
+#include "source/page_heap.cpp"
+#endif
+
+#endif
\ No newline at end of file
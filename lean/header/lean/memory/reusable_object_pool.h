@@ -0,0 +1,327 @@
+/*****************************************************/
+/* lean Memory                  (c) Tobias Zirr 2011 */
+/*****************************************************/
+
+#pragma once
+#ifndef LEAN_MEMORY_REUSABLE_OBJECT_POOL
+#define LEAN_MEMORY_REUSABLE_OBJECT_POOL
+
+#include "../lean.h"
+#include "../tags/noncopyable.h"
+#include "../functional/bits.h"
+#include "alignment.h"
+#include "default_heap.h"
+#include <cstring>
+
+namespace lean
+{
+namespace memory
+{
+
+/// Object pool allowing for individual objects to be destroyed, re-using their slots for subsequent objects.
+/// Tracks live objects in one bitmap per chunk, allowing for fast iteration of all live objects.
+template <class Element, size_t ChunkSize, class Heap = default_heap, size_t Alignment = alignof(Element)>
+class reusable_object_pool : public lean::noncopyable
+{
+public:
+	/// Value type.
+	typedef Element value_type;
+	/// Heap type.
+	typedef Heap heap_type;
+	/// Size type.
+	typedef typename heap_type::size_type size_type;
+	/// Number of objects per chunk.
+	static const size_type chunk_size = ChunkSize;
+	/// Alignment.
+	static const size_type alignment = Alignment;
+
+private:
+	LEAN_STATIC_ASSERT_MSG_ALT(ChunkSize > 0,
+		"Chunk size required to be greater than zero.",
+		Chunk_size_required_to_be_greater_than_zero);
+
+	typedef unsigned long bitmap_word;
+	static const size_t bitmap_word_bits = sizeof(bitmap_word) * CHAR_BIT;
+	static const size_t bitmap_word_count = (ChunkSize + (bitmap_word_bits - 1)) / bitmap_word_bits;
+
+	/// Free slot node
+	struct free_node
+	{
+		free_node *next;
+	};
+
+	/// Chunk header
+	struct chunk_header
+	{
+		size_t liveCount;
+		bitmap_word live[bitmap_word_count];
+	};
+
+	// Slot layout
+	static const size_t slot_alignment = (Alignment > alignof(free_node)) ? Alignment : alignof(free_node);
+	static const size_t slot_size = (((sizeof(Element) > sizeof(free_node)) ? sizeof(Element) : sizeof(free_node))
+		+ (slot_alignment - 1)) & ~(slot_alignment - 1);
+
+	// Chunk layout
+	static const size_t chunk_alignment = (slot_alignment > alignof(chunk_header)) ? slot_alignment : alignof(chunk_header);
+	static const size_t slot_offset = (sizeof(chunk_header) + (slot_alignment - 1)) & ~(slot_alignment - 1);
+	static const size_t chunk_bytes = slot_offset + ChunkSize * slot_size;
+
+	// Chunks, sorted by address
+	chunk_header **m_chunks;
+	size_t m_chunkCount;
+	size_t m_chunkCapacity;
+
+	// Free slots
+	free_node *m_freeHead;
+
+	// Live objects
+	size_type m_size;
+
+	/// Gets the first slot of the given chunk.
+	LEAN_INLINE static char* to_slots(chunk_header *chunk)
+	{
+		return reinterpret_cast<char*>(chunk) + slot_offset;
+	}
+
+	/// Gets the index of the chunk containing the given slot.
+	size_t find_chunk(const void *slot) const
+	{
+		size_t first = 0, last = m_chunkCount;
+
+		// Find last chunk starting before the given slot
+		while (last - first > 1)
+		{
+			size_t middle = first + (last - first) / 2;
+
+			if (static_cast<const void*>(m_chunks[middle]) <= slot)
+				first = middle;
+			else
+				last = middle;
+		}
+
+		LEAN_ASSERT(first < m_chunkCount && static_cast<const void*>(to_slots(m_chunks[first])) <= slot
+			&& slot < static_cast<const void*>(to_slots(m_chunks[first]) + ChunkSize * slot_size));
+
+		return first;
+	}
+
+	/// Adds all slots of the given chunk to the free list, lowest slots taken first.
+	LEAN_INLINE void free_slots(chunk_header *chunk)
+	{
+		char *slots = to_slots(chunk);
+
+		for (size_t i = ChunkSize; i-- > 0; )
+		{
+			free_node *node = reinterpret_cast<free_node*>(slots + i * slot_size);
+			node->next = m_freeHead;
+			m_freeHead = node;
+		}
+	}
+
+	/// Allocates a new chunk of free slots.
+	void allocate_chunk()
+	{
+		// Make room for one more chunk
+		if (m_chunkCount == m_chunkCapacity)
+		{
+			size_t newCapacity = (m_chunkCapacity) ? 2 * m_chunkCapacity : 8;
+
+			chunk_header **newChunks = static_cast<chunk_header**>( Heap::allocate(newCapacity * sizeof(chunk_header*)) );
+			if (m_chunkCount)
+				memcpy(newChunks, m_chunks, m_chunkCount * sizeof(chunk_header*));
+			Heap::free(m_chunks);
+
+			m_chunks = newChunks;
+			m_chunkCapacity = newCapacity;
+		}
+
+		chunk_header *chunk = static_cast<chunk_header*>( Heap::allocate<chunk_alignment>(chunk_bytes) );
+		chunk->liveCount = 0;
+		memset(chunk->live, 0, sizeof(chunk->live));
+
+		// Keep chunks sorted by address
+		size_t pos = m_chunkCount;
+		for (; pos > 0 && chunk < m_chunks[pos - 1]; --pos)
+			m_chunks[pos] = m_chunks[pos - 1];
+		m_chunks[pos] = chunk;
+		++m_chunkCount;
+
+		free_slots(chunk);
+	}
+
+	/// Takes a free slot.
+	LEAN_INLINE void* acquire_slot()
+	{
+		if (!m_freeHead)
+			allocate_chunk();
+
+		free_node *slot = m_freeHead;
+		m_freeHead = slot->next;
+		return slot;
+	}
+	/// Returns the given slot to the free list.
+	LEAN_INLINE void release_slot(void *slot)
+	{
+		free_node *node = static_cast<free_node*>(slot);
+		node->next = m_freeHead;
+		m_freeHead = node;
+	}
+
+	/// Marks the given slot live.
+	LEAN_INLINE Element* mark_live(Element *element)
+	{
+		chunk_header *chunk = m_chunks[find_chunk(element)];
+		size_t index = (reinterpret_cast<char*>(element) - to_slots(chunk)) / slot_size;
+
+		chunk->live[index / bitmap_word_bits] |= static_cast<bitmap_word>(1) << (index % bitmap_word_bits);
+		++chunk->liveCount;
+		++m_size;
+
+		return element;
+	}
+
+public:
+	/// Constructor.
+	LEAN_INLINE reusable_object_pool()
+		: m_chunks(nullptr),
+		m_chunkCount(0),
+		m_chunkCapacity(0),
+		m_freeHead(nullptr),
+		m_size(0) { }
+	/// Destroys all objects in this pool.
+	LEAN_INLINE ~reusable_object_pool()
+	{
+		clear();
+	}
+
+	/// Places the given value into this object pool.
+	Element* place(const Element &value)
+	{
+		void *slot = acquire_slot();
+		Element *element;
+
+		try
+		{
+			element = new(slot) Element(value);
+		}
+		catch (...)
+		{
+			release_slot(slot);
+			throw;
+		}
+
+		return mark_live(element);
+	}
+#ifndef LEAN0X_NO_RVALUE_REFERENCES
+	/// Places the given value into this object pool.
+	Element* place(Element &&value)
+	{
+		void *slot = acquire_slot();
+		Element *element;
+
+		try
+		{
+			element = new(slot) Element( std::move(value) );
+		}
+		catch (...)
+		{
+			release_slot(slot);
+			throw;
+		}
+
+		return mark_live(element);
+	}
+#endif
+
+	/// Destroys the given object, its slot is re-used by subsequent objects.
+	void destroy(Element *element)
+	{
+		chunk_header *chunk = m_chunks[find_chunk(element)];
+		size_t index = (reinterpret_cast<char*>(element) - to_slots(chunk)) / slot_size;
+		bitmap_word bit = static_cast<bitmap_word>(1) << (index % bitmap_word_bits);
+
+		LEAN_ASSERT(chunk->live[index / bitmap_word_bits] & bit);
+
+		element->~Element();
+
+		chunk->live[index / bitmap_word_bits] &= ~bit;
+		--chunk->liveCount;
+		--m_size;
+
+		release_slot(element);
+	}
+
+	/// Calls the given function for every live object. The given function may destroy the object passed,
+	/// but no other objects.
+	template <class Function>
+	void for_each_live(Function fun)
+	{
+		for (size_t c = 0; c < m_chunkCount; ++c)
+		{
+			chunk_header *chunk = m_chunks[c];
+			char *slots = to_slots(chunk);
+
+			for (size_t w = 0; w < bitmap_word_count && chunk->liveCount; ++w)
+				for (bitmap_word word = chunk->live[w]; word; word &= word - 1)
+					fun( *reinterpret_cast<Element*>(slots + (w * bitmap_word_bits + first_bit_low(word)) * slot_size) );
+		}
+	}
+
+	/// Destroys all objects, retaining all chunks for subsequent objects.
+	void destroy_all()
+	{
+		m_freeHead = nullptr;
+
+		for (size_t c = m_chunkCount; c-- > 0; )
+		{
+			chunk_header *chunk = m_chunks[c];
+			char *slots = to_slots(chunk);
+
+			for (size_t w = 0; w < bitmap_word_count && chunk->liveCount; ++w)
+			{
+				for (bitmap_word word = chunk->live[w]; word; word &= word - 1)
+				{
+					reinterpret_cast<Element*>(slots + (w * bitmap_word_bits + first_bit_low(word)) * slot_size)->~Element();
+					--chunk->liveCount;
+				}
+
+				chunk->live[w] = 0;
+			}
+
+			free_slots(chunk);
+		}
+
+		m_size = 0;
+	}
+
+	/// Destroys all objects and frees all chunks allocated by this pool.
+	void clear()
+	{
+		destroy_all();
+
+		m_freeHead = nullptr;
+
+		while (m_chunkCount)
+			Heap::free<chunk_alignment>(m_chunks[--m_chunkCount]);
+
+		Heap::free(m_chunks);
+		m_chunks = nullptr;
+		m_chunkCapacity = 0;
+	}
+
+	/// Gets the number of live objects.
+	LEAN_INLINE size_type size() const { return m_size; }
+	/// Gets whether this pool contains no live objects.
+	LEAN_INLINE bool empty() const { return (m_size == 0); }
+	/// Gets the number of objects this pool can hold without allocating further chunks.
+	LEAN_INLINE size_type capacity() const { return m_chunkCount * ChunkSize; }
+};
+
+} // namespace
+
+using memory::reusable_object_pool;
+
+} // namespace
+
+#endif
\ No newline at end of file
@@ -0,0 +1,69 @@
+/*****************************************************/
+/* lean Memory                  (c) Tobias Zirr 2011 */
+/*****************************************************/
+
+#pragma once
+#ifndef LEAN_MEMORY_SCOPED_ARENA
+#define LEAN_MEMORY_SCOPED_ARENA
+
+#include "../lean.h"
+#include "../tags/noncopyable.h"
+
+namespace lean
+{
+namespace memory
+{
+
+/// Automatic arena management class that marks the allocation position of a given chunk heap on construction,
+/// freeing all memory allocated from the chunk heap in the meantime on destruction. Scoped arenas may be nested.
+template <class ChunkHeap>
+class scoped_arena : public noncopyable
+{
+public:
+	/// Type of the chunk heap managed by this class.
+	typedef ChunkHeap heap_type;
+	/// Size type.
+	typedef typename heap_type::size_type size_type;
+	/// Type of the allocation position markers.
+	typedef typename heap_type::marker marker;
+
+private:
+	heap_type &m_heap;
+	marker m_marker;
+
+public:
+	/// Marks the current allocation position of the given chunk heap, to be rewound on destruction.
+	LEAN_INLINE explicit scoped_arena(heap_type &heap)
+		: m_heap(heap),
+		m_marker(heap.mark()) { }
+	/// Frees all memory allocated since construction.
+	LEAN_INLINE ~scoped_arena()
+	{
+		m_heap.rewind(m_marker);
+	}
+
+	/// Frees all memory allocated since construction, the arena remains usable.
+	LEAN_INLINE void rewind()
+	{
+		m_heap.rewind(m_marker);
+	}
+
+	/// Allocates the given amount of memory.
+	LEAN_INLINE void* allocate(size_type size) { return m_heap.allocate(size); }
+	/// Allocates the given amount of memory respecting the given alignment.
+	template <size_t Alignment>
+	LEAN_INLINE void* allocate(size_type size) { return m_heap.template allocate<Alignment>(size); }
+
+	/// Gets the chunk heap managed by this class.
+	LEAN_INLINE heap_type& get() { return m_heap; }
+	/// Gets the chunk heap managed by this class.
+	LEAN_INLINE const heap_type& get() const { return m_heap; }
+};
+
+} // namespace
+
+using memory::scoped_arena;
+
+} // namespace
+
+#endif
\ No newline at end of file
@@ -0,0 +1,118 @@
+/*****************************************************/
+/* lean Memory                  (c) Tobias Zirr 2011 */
+/*****************************************************/
+
+#pragma once
+#ifndef LEAN_MEMORY_SLAB_HEAP
+#define LEAN_MEMORY_SLAB_HEAP
+
+#include "../lean.h"
+#include "alignment.h"
+
+namespace lean
+{
+namespace memory
+{
+
+/// Thread-safe segregated size-class heap. Small blocks are rounded up to one of a number of size classes
+/// and served from lock-free caches owned by one thread each, refilled in batches from slabs of equally-sized
+/// blocks. Caches are handed on to new threads when their owners exit. Large blocks are mapped directly
+/// from the operating system using the page heap. Slab memory is never returned to the system,
+/// it is recycled for blocks of the same size class.
+struct slab_heap
+{
+	/// Size type.
+	typedef size_t size_type;
+	/// Default alignment.
+	static const size_type default_alignment = 16;
+	/// Size & alignment of the slabs small blocks are carved from.
+	static const size_type slab_size = 64 * 1024;
+	/// Maximum alignment.
+	static const size_type max_alignment = slab_size / 2;
+	/// Largest block size served from slabs.
+	static const size_type max_small_size = 8 * 1024;
+	/// Number of small block size classes.
+	static const size_type size_class_count = 32;
+	/// Number of caches owned exclusively by one thread each.
+	static const size_type cache_count = 32;
+	/// Number of caches shared by all threads not owning a cache.
+	static const size_type shared_cache_count = 8;
+
+	/// Allocates the given amount of memory.
+	LEAN_MAYBE_EXPORT static void* allocate(size_type size);
+	/// Allocates the given amount of memory respecting the given alignment.
+	LEAN_MAYBE_EXPORT static void* allocate(size_type size, size_type alignment);
+	/// Frees the given block of memory. May be called by any thread, not only the allocating one.
+	LEAN_MAYBE_EXPORT static void free(void *memory);
+
+	/// Allocates the given amount of memory respecting the given alignment.
+	template <size_t Alignment>
+	static LEAN_INLINE void* allocate(size_type size)
+	{
+		LEAN_STATIC_ASSERT_MSG_ALT(Alignment <= max_alignment,
+			"Alignment > half the slab size unsupported.",
+			Alignment_bigger_than_half_the_slab_size_unsupported);
+
+		if (Alignment <= default_alignment && is_valid_alignment<Alignment>::value)
+			return allocate(size);
+		else
+			return allocate(size, Alignment);
+	}
+	/// Frees the given aligned block of memory.
+	template <size_t Alignment>
+	static LEAN_INLINE void free(void *memory)
+	{
+		free(memory);
+	}
+	/// Frees the given aligned block of memory.
+	static LEAN_INLINE void free(void *memory, size_t alignment)
+	{
+		free(memory);
+	}
+
+	/// Gets the number of bytes usable in the given block of memory.
+	LEAN_MAYBE_EXPORT static size_type size(const void *memory);
+
+	/// Gets the size class serving blocks of the given size, size_class_count if too large.
+	static LEAN_INLINE size_type size_class(size_type size)
+	{
+		if (size <= 128)
+			return (size > 0) ? (size - 1) >> 4 : 0;
+		else if (size <= max_small_size)
+		{
+			// Four classes per power of two
+			size_type bits = size - 1;
+			size_type log = 7;
+
+			while (bits >> (log + 1))
+				++log;
+
+			return 8 + (log - 7) * 4 + ((bits >> (log - 2)) & 3);
+		}
+		else
+			return size_class_count;
+	}
+	/// Gets the size of the blocks served by the given size class.
+	static LEAN_INLINE size_type class_size(size_type sizeClass)
+	{
+		if (sizeClass < 8)
+			return (sizeClass + 1) * 16;
+		else
+		{
+			size_type log = (sizeClass - 8) / 4;
+			return (128 << log) + ((sizeClass - 8) % 4 + 1) * (32 << log);
+		}
+	}
+};
+
+} // namespace
+
+using memory::slab_heap;
+
+} // namespace
+
+#ifdef LEAN_INCLUDE_LINKED
+#include "source/slab_heap.cpp"
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,311 @@
+#ifdef LEAN_BUILD_LIB
+#include "../../depconfig.h"
+#endif
+
+#include "../numa_heap.h"
+#include <climits>
+#include <cstring>
+#include <cstdio>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <sched.h>
+	#include <unistd.h>
+	#include <sys/syscall.h>
+#endif
+
+namespace lean
+{
+namespace memory
+{
+namespace impl
+{
+
+#ifndef _WIN32
+
+/// Maximum number of NUMA nodes addressable by node masks.
+static const int numa_max_nodes = 1024;
+
+/// NUMA node mask as expected by the Linux memory policy system calls.
+struct numa_node_mask
+{
+	unsigned long bits[numa_max_nodes / (sizeof(unsigned long) * CHAR_BIT)];
+};
+
+/// Linux memory policy modes & flags, see <linux/mempolicy.h>.
+enum numa_mpol
+{
+	mpol_default = 0,
+	mpol_preferred = 1,
+	mpol_bind = 2,
+	mpol_interleave = 3,
+
+	mpol_mf_move = 1 << 1,
+
+	mpol_f_node = 1 << 0,
+	mpol_f_addr = 1 << 1
+};
+
+/// Parses the given list of ranges of non-negative integers, e.g. "0-3,8-11", calling the given function for each range.
+/// Returns false if malformed.
+template <class Function>
+LEAN_INLINE bool parse_sys_list(const char *list, Function fun)
+{
+	while (*list && *list != '\n')
+	{
+		int first, last, length;
+
+		if (::sscanf(list, "%d%n", &first, &length) != 1)
+			return false;
+		list += length;
+		last = first;
+
+		if (*list == '-')
+		{
+			if (::sscanf(list + 1, "%d%n", &last, &length) != 1)
+				return false;
+			list += 1 + length;
+		}
+
+		fun(first, last);
+
+		if (*list == ',')
+			++list;
+	}
+
+	return true;
+}
+
+/// Reads the first line of the given system file, returning false on failure.
+LEAN_ALWAYS_LINK bool read_sys_line(const char *path, char *line, int size)
+{
+	FILE *file = ::fopen(path, "r");
+
+	if (!file)
+		return false;
+
+	bool success = (::fgets(line, size, file) != nullptr);
+	::fclose(file);
+	return success;
+}
+
+/// Tracks the highest number in a list of ranges.
+struct max_in_ranges
+{
+	int *max;
+
+	void operator ()(int first, int last) const
+	{
+		if (last > *max)
+			*max = last;
+	}
+};
+
+/// Adds a list of ranges of processors to a processor set.
+struct add_to_cpu_set
+{
+	cpu_set_t *set;
+
+	void operator ()(int first, int last) const
+	{
+		for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu)
+			CPU_SET(cpu, set);
+	}
+};
+
+/// Queries the number of NUMA nodes from the system, 1 if unknown.
+LEAN_ALWAYS_LINK int query_numa_node_count()
+{
+	char line[1024];
+	int maxNode = 0;
+	max_in_ranges fun = { &maxNode };
+
+	if (read_sys_line("/sys/devices/system/node/online", line, sizeof(line)))
+		parse_sys_list(line, fun);
+
+	return (maxNode < numa_max_nodes) ? maxNode + 1 : numa_max_nodes;
+}
+
+/// Prepares the memory policy mode & node mask for the given placement policy, returning false if the given node does not exist.
+LEAN_ALWAYS_LINK bool get_numa_mpol(numa_policy::t policy, int node, int &mode, numa_node_mask &mask)
+{
+	static const size_t word_bits = sizeof(unsigned long) * CHAR_BIT;
+
+	memset(&mask, 0, sizeof(mask));
+
+	if (policy == numa_policy::local)
+	{
+		mode = mpol_default;
+		return true;
+	}
+
+	int nodeCount = numa_heap_base::node_count();
+
+	if (node == numa_heap_base::all_nodes)
+	{
+		for (int i = 0; i < nodeCount; ++i)
+			mask.bits[i / word_bits] |= 1UL << (i % word_bits);
+	}
+	else if (0 <= node && node < nodeCount)
+		mask.bits[node / word_bits] |= 1UL << (node % word_bits);
+	else
+		return false;
+
+	switch (policy)
+	{
+	case numa_policy::preferred:
+		// Preferring all nodes is the same as the default policy
+		mode = (node == numa_heap_base::all_nodes) ? mpol_default : mpol_preferred;
+		break;
+	case numa_policy::bind:
+		mode = mpol_bind;
+		break;
+	default:
+		mode = mpol_interleave;
+		break;
+	}
+
+	return true;
+}
+
+#endif
+
+} // namespace
+} // namespace
+} // namespace
+
+// Gets the number of NUMA nodes, 1 if NUMA unsupported.
+LEAN_MAYBE_LINK int lean::memory::numa_heap_base::node_count()
+{
+	// Benign race, all threads store the same value
+	static int nodeCount = 0;
+
+	if (!nodeCount)
+	{
+#ifdef _WIN32
+		ULONG highestNode;
+		nodeCount = (::GetNumaHighestNodeNumber(&highestNode)) ? static_cast<int>(highestNode) + 1 : 1;
+#else
+		nodeCount = impl::query_numa_node_count();
+#endif
+	}
+
+	return nodeCount;
+}
+
+// Gets the node of the processor currently running the calling thread, 0 if unknown.
+LEAN_MAYBE_LINK int lean::memory::numa_heap_base::current_node()
+{
+#ifdef _WIN32
+	UCHAR node;
+	return (::GetNumaProcessorNode(static_cast<UCHAR>(::GetCurrentProcessorNumber()), &node) && node != 0xff) ? node : 0;
+#else
+	unsigned int cpu, node;
+	return (::syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) ? static_cast<int>(node) : 0;
+#endif
+}
+
+// Gets the node of the physical page backing the given memory, -1 if unknown.
+LEAN_MAYBE_LINK int lean::memory::numa_heap_base::page_node(const void *memory)
+{
+#ifdef _WIN32
+	return -1;
+#else
+	int node;
+
+	return (::syscall(SYS_get_mempolicy, &node, nullptr, 0UL, memory, impl::mpol_f_node | impl::mpol_f_addr) == 0)
+		? node
+		: -1;
+#endif
+}
+
+// Places all pages overlapping the given range according to the given policy, migrating pages already touched.
+LEAN_MAYBE_LINK bool lean::memory::numa_heap_base::place_pages(void *memory, size_type size, numa_policy::t policy, int node)
+{
+#ifdef _WIN32
+	return false;
+#else
+	int mode;
+	impl::numa_node_mask mask;
+
+	if (!impl::get_numa_mpol(policy, node, mode, mask))
+		return false;
+
+	size_type pageSize = page_size();
+	char *begin = lower_align(static_cast<char*>(memory), pageSize);
+	char *end = align(static_cast<char*>(memory) + size, pageSize);
+
+	return ::syscall(SYS_mbind, begin, static_cast<unsigned long>(end - begin), mode,
+		(mode != impl::mpol_default) ? mask.bits : nullptr, static_cast<unsigned long>(impl::numa_max_nodes + 1),
+		static_cast<unsigned>(impl::mpol_mf_move)) == 0;
+#endif
+}
+
+// Places all pages subsequently touched by the calling thread according to the given policy.
+LEAN_MAYBE_LINK bool lean::memory::numa_heap_base::set_thread_policy(numa_policy::t policy, int node)
+{
+#ifdef _WIN32
+	return false;
+#else
+	int mode;
+	impl::numa_node_mask mask;
+
+	if (!impl::get_numa_mpol(policy, node, mode, mask))
+		return false;
+
+	return ::syscall(SYS_set_mempolicy, mode,
+		(mode != impl::mpol_default) ? mask.bits : nullptr, static_cast<unsigned long>(impl::numa_max_nodes + 1)) == 0;
+#endif
+}
+
+// Restricts the calling thread to the processors of the given node.
+LEAN_MAYBE_LINK bool lean::memory::numa_heap_base::run_on_node(int node)
+{
+	if (node != all_nodes && (node < 0 || node >= node_count()))
+		return false;
+
+#ifdef _WIN32
+	if (node == all_nodes)
+	{
+		DWORD_PTR processMask, systemMask;
+
+		return ::GetProcessAffinityMask(::GetCurrentProcess(), &processMask, &systemMask)
+			&& ::SetThreadAffinityMask(::GetCurrentThread(), processMask) != 0;
+	}
+
+	ULONGLONG processorMask;
+
+	return ::GetNumaNodeProcessorMask(static_cast<UCHAR>(node), &processorMask) && processorMask
+		&& ::SetThreadAffinityMask(::GetCurrentThread(), static_cast<DWORD_PTR>(processorMask)) != 0;
+#else
+	char path[64], line[1024];
+
+	if (node == all_nodes)
+		::strcpy(path, "/sys/devices/system/cpu/online");
+	else
+		::sprintf(path, "/sys/devices/system/node/node%d/cpulist", node);
+
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	impl::add_to_cpu_set fun = { &cpus };
+
+	if (!impl::read_sys_line(path, line, sizeof(line)) || !impl::parse_sys_list(line, fun) || CPU_COUNT(&cpus) == 0)
+		return false;
+
+	return ::sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+#endif
+}
+
+// Maps a block of the given size & alignment placed according to the given policy.
+LEAN_MAYBE_LINK void* lean::memory::numa_heap_base::allocate_placed(size_type size, size_type alignment, numa_policy::t policy, int node)
+{
+	size_type mappedSize = block_mapping_size(size, alignment, page_size_policy::normal);
+	void *mapped = map_pages(mappedSize, alignment, page_size_policy::normal);
+
+	// NOTE: Place before storing the block header, which touches the first page
+	// Unsatisfiable placement falls back to first-touch placement
+	place_pages(mapped, mappedSize, policy, node);
+
+	return init_block(mapped, mappedSize, alignment);
+}
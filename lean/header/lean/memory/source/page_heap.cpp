@@ -0,0 +1,302 @@
+#ifdef LEAN_BUILD_LIB
+#include "../../depconfig.h"
+#endif
+
+#include "../page_heap.h"
+#include "../new_handler.h"
+#include <stdexcept>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <unistd.h>
+	#include <cstdio>
+#endif
+
+namespace lean
+{
+namespace memory
+{
+namespace impl
+{
+
+/// Mapping stored in front of every page heap block.
+struct page_block_header
+{
+	/// Offset of the block from the beginning of the mapping.
+	size_t offset;
+	/// Number of bytes mapped.
+	size_t size;
+};
+
+/// Throws a bad_alloc exception.
+LEAN_ALWAYS_LINK void page_bad_alloc()
+{
+	static const std::bad_alloc exception;
+	throw exception;
+}
+
+/// Queries the size of huge pages from the system, returns zero if unsupported.
+LEAN_ALWAYS_LINK size_t query_huge_page_size()
+{
+#ifdef _WIN32
+	return ::GetLargePageMinimum();
+#else
+	size_t hugePageSize = 0;
+
+	if (FILE *meminfo = ::fopen("/proc/meminfo", "r"))
+	{
+		char line[256];
+		unsigned long sizeKB;
+
+		while (::fgets(line, sizeof(line), meminfo))
+			if (::sscanf(line, "Hugepagesize: %lu kB", &sizeKB) == 1)
+			{
+				hugePageSize = static_cast<size_t>(sizeKB) * 1024;
+				break;
+			}
+
+		::fclose(meminfo);
+	}
+
+	return hugePageSize;
+#endif
+}
+
+#ifdef _WIN32
+
+/// Maps the given number of bytes aligned to the given alignment, returning nullptr on failure.
+LEAN_ALWAYS_LINK void* try_map_pages(size_t size, size_t alignment, page_size_policy::t policy)
+{
+	if (policy == page_size_policy::explicit_huge)
+	{
+		// Large pages are aligned to the large page size, require the lock memory privilege
+		if (alignment <= page_heap_base::huge_page_size())
+			if (void *memory = ::VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE))
+				return memory;
+	}
+
+	// Allocation granularity is 64 KB
+	if (alignment <= 64 * 1024)
+		return ::VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+	// Find aligned free address range, retry if taken by another thread in between
+	for (int attempt = 0; attempt < 8; ++attempt)
+	{
+		char *reserved = static_cast<char*>( ::VirtualAlloc(nullptr, size + alignment, MEM_RESERVE, PAGE_NOACCESS) );
+
+		if (!reserved)
+			return nullptr;
+
+		::VirtualFree(reserved, 0, MEM_RELEASE);
+
+		if (void *memory = ::VirtualAlloc(align(reserved, alignment), size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE))
+			return memory;
+	}
+
+	return nullptr;
+}
+
+#else
+
+/// Maps the given number of bytes aligned to the given alignment, returning nullptr on failure.
+LEAN_ALWAYS_LINK void* try_map_pages_with(size_t size, size_t alignment, size_t pageSize, int flags)
+{
+	// Mappings are aligned to the page size, pad to trim down to the requested alignment
+	size_t paddedSize = (alignment > pageSize) ? size + alignment - pageSize : size;
+	void *mapped = ::mmap(nullptr, paddedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+
+	if (mapped == MAP_FAILED)
+		return nullptr;
+
+	char *unaligned = static_cast<char*>(mapped);
+	char *aligned = align(unaligned, alignment);
+	size_t headSize = aligned - unaligned;
+	size_t tailSize = paddedSize - headSize - size;
+
+	if (headSize)
+		::munmap(unaligned, headSize);
+	if (tailSize)
+		::munmap(aligned + size, tailSize);
+
+	return aligned;
+}
+
+/// Maps the given number of bytes aligned to the given alignment, returning nullptr on failure.
+LEAN_ALWAYS_LINK void* try_map_pages(size_t size, size_t alignment, page_size_policy::t policy)
+{
+	size_t hugePageSize = page_heap_base::huge_page_size();
+
+#ifdef MAP_HUGETLB
+	if (policy == page_size_policy::explicit_huge)
+		if (void *memory = try_map_pages_with(size, alignment, hugePageSize, MAP_HUGETLB))
+			return memory;
+#endif
+
+	if (policy == page_size_policy::normal)
+		return try_map_pages_with(size, alignment, page_heap_base::page_size(), 0);
+
+	// Huge pages can only back huge-page-aligned ranges
+	if (size >= hugePageSize && alignment < hugePageSize)
+		alignment = hugePageSize;
+
+	void *memory = try_map_pages_with(size, alignment, page_heap_base::page_size(), 0);
+
+#ifdef MADV_HUGEPAGE
+	if (memory)
+		::madvise(memory, size, MADV_HUGEPAGE);
+#endif
+
+	return memory;
+}
+
+#endif
+
+} // namespace
+} // namespace
+} // namespace
+
+// Gets the size of regular pages.
+LEAN_MAYBE_LINK lean::memory::page_heap_base::size_type lean::memory::page_heap_base::page_size()
+{
+	// Benign race, all threads store the same value
+	static size_type pageSize = 0;
+
+	if (!pageSize)
+	{
+#ifdef _WIN32
+		SYSTEM_INFO sysInfo;
+		::GetSystemInfo(&sysInfo);
+		pageSize = sysInfo.dwPageSize;
+#else
+		pageSize = static_cast<size_type>( ::sysconf(_SC_PAGESIZE) );
+#endif
+	}
+
+	return pageSize;
+}
+
+// Gets the size of huge pages, the size of regular pages if unsupported.
+LEAN_MAYBE_LINK lean::memory::page_heap_base::size_type lean::memory::page_heap_base::huge_page_size()
+{
+	// Benign race, all threads store the same value
+	static size_type hugePageSize = 0;
+
+	if (!hugePageSize)
+	{
+		size_type querySize = impl::query_huge_page_size();
+		hugePageSize = (querySize != 0) ? querySize : page_size();
+	}
+
+	return hugePageSize;
+}
+
+// Rounds the given size up to whole pages of the given policy.
+LEAN_MAYBE_LINK lean::memory::page_heap_base::size_type lean::memory::page_heap_base::round_to_pages(size_type size, page_size_policy::t policy)
+{
+	size_type pageSize = (policy == page_size_policy::explicit_huge) ? huge_page_size() : page_size();
+
+	if (size > static_cast<size_type>(-1) - pageSize)
+		impl::page_bad_alloc();
+
+	return (size + pageSize - 1) & ~(pageSize - 1);
+}
+
+// Maps the given number of bytes, rounded up to whole pages, aligned to at least the page size.
+LEAN_MAYBE_LINK void* lean::memory::page_heap_base::map_pages(size_type size, size_type alignment, page_size_policy::t policy)
+{
+	LEAN_ASSERT(check_alignment(alignment));
+
+	size = round_to_pages(size, policy);
+	alignment = max(alignment, page_size());
+
+	void *memory;
+
+	// Try to allocate memory until new handler returns false
+	while ( !(memory = impl::try_map_pages(size, alignment, policy)) )
+		if (!call_new_handler())
+			impl::page_bad_alloc();
+
+	LEAN_ASSERT(memory);
+	return memory;
+}
+
+// Unmaps the given pages, size & policy are required to match those passed to map_pages().
+LEAN_MAYBE_LINK void lean::memory::page_heap_base::unmap_pages(void *memory, size_type size, page_size_policy::t policy)
+{
+	if (memory)
+	{
+#ifdef _WIN32
+		::VirtualFree(memory, 0, MEM_RELEASE);
+#else
+		::munmap(memory, round_to_pages(size, policy));
+#endif
+	}
+}
+
+// Hints that the contents of all whole pages in the given range are no longer needed.
+LEAN_MAYBE_LINK void lean::memory::page_heap_base::decommit(void *memory, size_type size)
+{
+	size_type pageSize = page_size();
+
+	char *begin = align(static_cast<char*>(memory), pageSize);
+	char *end = lower_align(static_cast<char*>(memory) + size, pageSize);
+
+	if (begin < end)
+	{
+#ifdef _WIN32
+		::VirtualAlloc(begin, end - begin, MEM_RESET, PAGE_READWRITE);
+#else
+		::madvise(begin, end - begin, MADV_DONTNEED);
+#endif
+	}
+}
+
+// Gets the number of bytes to be mapped for a block of the given size & alignment.
+LEAN_MAYBE_LINK lean::memory::page_heap_base::size_type lean::memory::page_heap_base::block_mapping_size(size_type size, size_type alignment, page_size_policy::t policy)
+{
+	LEAN_ASSERT(check_alignment(alignment) && alignment >= sizeof(impl::page_block_header));
+
+	if (size > static_cast<size_type>(-1) - alignment)
+		impl::page_bad_alloc();
+
+	// Header fits into the space required for alignment
+	return round_to_pages(alignment + size, policy);
+}
+
+// Stores the given mapping in front of the block of the given alignment, returning the block memory.
+LEAN_MAYBE_LINK void* lean::memory::page_heap_base::init_block(void *mapped, size_type mappedSize, size_type alignment)
+{
+	char *memory = static_cast<char*>(mapped) + alignment;
+
+	impl::page_block_header *header = reinterpret_cast<impl::page_block_header*>(memory) - 1;
+	header->offset = alignment;
+	header->size = mappedSize;
+
+	return memory;
+}
+
+// Maps a block of the given size & alignment, storing its mapping in front of the returned memory.
+LEAN_MAYBE_LINK void* lean::memory::page_heap_base::allocate_block(size_type size, size_type alignment, page_size_policy::t policy)
+{
+	size_type mappedSize = block_mapping_size(size, alignment, policy);
+	return init_block(map_pages(mappedSize, alignment, policy), mappedSize, alignment);
+}
+
+// Unmaps the given block of memory.
+LEAN_MAYBE_LINK void lean::memory::page_heap_base::free_block(void *memory, page_size_policy::t policy)
+{
+	if (memory)
+	{
+		impl::page_block_header *header = static_cast<impl::page_block_header*>(memory) - 1;
+		unmap_pages(static_cast<char*>(memory) - header->offset, header->size, policy);
+	}
+}
+
+// Gets the number of bytes usable in the given block of memory.
+LEAN_MAYBE_LINK lean::memory::page_heap_base::size_type lean::memory::page_heap_base::block_size(const void *memory)
+{
+	const impl::page_block_header *header = static_cast<const impl::page_block_header*>(memory) - 1;
+	return header->size - header->offset;
+}
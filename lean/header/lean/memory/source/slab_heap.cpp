@@ -0,0 +1,461 @@
+#ifdef LEAN_BUILD_LIB
+#include "../../depconfig.h"
+#endif
+
+#include "../slab_heap.h"
+#include "../page_heap.h"
+#include "../../concurrent/atomic.h"
+#include "../../concurrent/backoff.h"
+#include "../../concurrent/thread_slot.h"
+#include <stdexcept>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <pthread.h>
+#endif
+
+namespace lean
+{
+namespace memory
+{
+namespace impl
+{
+
+/// Header stored at the beginning of every slab & every large block.
+struct slab_header
+{
+	/// Size class of the blocks in this slab, size_class_count for large blocks.
+	size_t sizeClass;
+	/// Number of bytes mapped for large blocks.
+	size_t mappedSize;
+};
+
+/// Size reserved for the slab header, keeping blocks aligned.
+static const size_t slab_header_size = 64;
+
+/// Free block node.
+struct slab_free_node
+{
+	slab_free_node *next;
+};
+
+/// First free block node of a batch stored in a size class depot.
+struct slab_batch_node : public slab_free_node
+{
+	slab_batch_node *nextBatch;
+};
+
+/// Free blocks cached for one or more threads.
+struct slab_cache
+{
+	/// Guards shared caches.
+	volatile long lock;
+	/// Marks exclusive caches owned by a thread.
+	volatile long owned;
+	slab_free_node *heads[slab_heap::size_class_count];
+	size_t counts[slab_heap::size_class_count];
+	char pad[64];
+};
+
+/// Shared free blocks & slab memory of one size class.
+struct slab_class
+{
+	volatile long lock;
+	slab_batch_node *batches;
+	char *carve;
+	char *carveEnd;
+	char pad[64];
+};
+
+/// Global slab heap state. Plain old data, zero-initialized before any dynamic initialization takes place.
+struct slab_state
+{
+	slab_cache caches[slab_heap::cache_count];
+	slab_cache sharedCaches[slab_heap::shared_cache_count];
+	slab_class classes[slab_heap::size_class_count];
+};
+
+/// Gets the global slab heap state.
+LEAN_ALWAYS_LINK slab_state& get_slab_state()
+{
+	static slab_state state;
+	return state;
+}
+
+/// Acquires the given lock word on construction, releases it on destruction.
+class scoped_slab_lock
+{
+private:
+	volatile long &m_lock;
+
+	scoped_slab_lock(const scoped_slab_lock&);
+	scoped_slab_lock& operator =(const scoped_slab_lock&);
+
+public:
+	/// Acquires the given lock word.
+	LEAN_INLINE explicit scoped_slab_lock(volatile long &lock)
+		: m_lock(lock)
+	{
+		if (!atomic_test_and_set(m_lock, 0L, 1L))
+		{
+			default_backoff backoff;
+
+			do
+			{
+				while (atomic_load(m_lock, memory_order_relaxed) != 0)
+					backoff.pause();
+			}
+			while (!atomic_test_and_set(m_lock, 0L, 1L));
+		}
+	}
+	/// Releases the lock word.
+	LEAN_INLINE ~scoped_slab_lock()
+	{
+		atomic_store(m_lock, 0L, memory_order_release);
+	}
+};
+
+/// Per-thread slab heap state.
+struct slab_thread_state
+{
+	/// Cache owned by the thread, nullptr if none.
+	slab_cache *cache;
+	/// Set once the thread has tried to claim a cache.
+	bool initialized;
+};
+
+/// Gets the slab heap state of the calling thread.
+LEAN_ALWAYS_LINK slab_thread_state& get_slab_thread_state()
+{
+	static LEAN_THREAD_LOCAL slab_thread_state state = { nullptr, false };
+	return state;
+}
+
+/// Releases the cache owned by the exiting thread, handing it on to the next thread together with its blocks.
+#ifdef _WIN32
+LEAN_ALWAYS_LINK VOID WINAPI release_slab_cache(PVOID cache)
+#else
+LEAN_ALWAYS_LINK void release_slab_cache(void *cache)
+#endif
+{
+	// Blocks freed by destructors running later on go to the shared caches
+	get_slab_thread_state().cache = nullptr;
+	atomic_store(static_cast<slab_cache*>(cache)->owned, 0L, memory_order_release);
+}
+
+#ifndef _WIN32
+
+/// Thread-specific data key triggering cache release on thread exit.
+struct slab_cache_key
+{
+	pthread_key_t key;
+	bool valid;
+};
+
+/// Gets the thread-specific data key triggering cache release on thread exit.
+LEAN_ALWAYS_LINK slab_cache_key& get_slab_cache_key()
+{
+	static slab_cache_key key;
+	return key;
+}
+
+/// Creates the thread-specific data key triggering cache release on thread exit.
+LEAN_ALWAYS_LINK void create_slab_cache_key()
+{
+	slab_cache_key &key = get_slab_cache_key();
+	key.valid = (::pthread_key_create(&key.key, &release_slab_cache) == 0);
+}
+
+#endif
+
+/// Registers the given cache to be released when the calling thread exits.
+LEAN_ALWAYS_LINK bool register_slab_cache_release(slab_cache *cache)
+{
+#ifdef _WIN32
+	// Index + 1, zero until allocated
+	static volatile long flsIndex = 0;
+
+	long index = flsIndex;
+
+	if (!index)
+	{
+		DWORD newIndex = ::FlsAlloc(&release_slab_cache);
+
+		if (newIndex == FLS_OUT_OF_INDEXES)
+			return false;
+
+		// Keep the index allocated by the fastest thread
+		if (!atomic_test_and_set(flsIndex, 0L, static_cast<long>(newIndex) + 1))
+			::FlsFree(newIndex);
+
+		index = flsIndex;
+	}
+
+	return (::FlsSetValue(static_cast<DWORD>(index - 1), cache) != FALSE);
+#else
+	static pthread_once_t keyOnce = PTHREAD_ONCE_INIT;
+	::pthread_once(&keyOnce, &create_slab_cache_key);
+
+	slab_cache_key &key = get_slab_cache_key();
+	return key.valid && ::pthread_setspecific(key.key, cache) == 0;
+#endif
+}
+
+/// Claims an exclusive cache for the given thread, if any available.
+LEAN_ALWAYS_LINK void claim_slab_cache(slab_thread_state &thread)
+{
+	thread.initialized = true;
+
+	slab_state &state = get_slab_state();
+
+	for (size_t i = 0; i < slab_heap::cache_count; ++i)
+	{
+		slab_cache &cache = state.caches[i];
+
+		if (cache.owned == 0 && atomic_test_and_set(cache.owned, 0L, 1L))
+		{
+			if (register_slab_cache_release(&cache))
+				thread.cache = &cache;
+			else
+				// Cache would never be released
+				atomic_store(cache.owned, 0L, memory_order_release);
+
+			break;
+		}
+	}
+}
+
+/// Gets the cache owned by the calling thread, nullptr if none available.
+LEAN_INLINE slab_cache* current_slab_cache()
+{
+	slab_thread_state &thread = get_slab_thread_state();
+
+	if (!thread.initialized)
+		claim_slab_cache(thread);
+
+	return thread.cache;
+}
+
+/// Gets the shared cache used by the calling thread.
+LEAN_INLINE slab_cache& current_shared_slab_cache()
+{
+	return get_slab_state().sharedCaches[current_thread_slot(slab_heap::shared_cache_count)];
+}
+
+/// Gets the number of blocks exchanged between caches & depots at once.
+LEAN_INLINE size_t slab_batch_size(size_t sizeClass)
+{
+	size_t batchSize = 8192 / slab_heap::class_size(sizeClass);
+	return (batchSize < 4) ? 4 : (batchSize > 32) ? 32 : batchSize;
+}
+
+/// Throws a bad_alloc exception.
+LEAN_ALWAYS_LINK void slab_bad_alloc()
+{
+	static const std::bad_alloc exception;
+	throw exception;
+}
+
+/// Gets the header of the slab or large block containing the given memory.
+LEAN_INLINE slab_header* get_slab_header(const void *memory)
+{
+	return reinterpret_cast<slab_header*>(
+		reinterpret_cast<uintptr_t>(memory) & ~static_cast<uintptr_t>(slab_heap::slab_size - 1) );
+}
+
+/// Maps a large block of the given size, placing the returned memory at the given offset.
+LEAN_ALWAYS_LINK void* allocate_large(size_t size, size_t offset)
+{
+	if (size > static_cast<size_t>(-1) - offset)
+		slab_bad_alloc();
+
+	size_t mappedSize = page_heap_base::round_to_pages(offset + size, page_size_policy::normal);
+	char *mapped = static_cast<char*>( page_heap_base::map_pages(mappedSize, slab_heap::slab_size, page_size_policy::normal) );
+
+	slab_header *header = reinterpret_cast<slab_header*>(mapped);
+	header->sizeClass = slab_heap::size_class_count;
+	header->mappedSize = mappedSize;
+
+	return mapped + offset;
+}
+
+/// Fills the given cache with a batch of free blocks of the given size class.
+LEAN_ALWAYS_LINK void refill_slab_cache(slab_cache &cache, size_t sizeClass)
+{
+	slab_class &sc = get_slab_state().classes[sizeClass];
+	size_t batchSize = slab_batch_size(sizeClass);
+	scoped_slab_lock lock(sc.lock);
+
+	slab_batch_node *batch = sc.batches;
+
+	if (batch)
+	{
+		sc.batches = batch->nextBatch;
+		cache.heads[sizeClass] = batch;
+		cache.counts[sizeClass] = batchSize;
+	}
+	else
+	{
+		size_t blockSize = slab_heap::class_size(sizeClass);
+		slab_free_node *head = cache.heads[sizeClass];
+
+		for (size_t i = 0; i < batchSize; ++i)
+		{
+			// Start new slab, wasting the tail of the current one
+			if (static_cast<size_t>(sc.carveEnd - sc.carve) < blockSize)
+			{
+				char *slab = static_cast<char*>( page_heap_base::map_pages(slab_heap::slab_size, slab_heap::slab_size, page_size_policy::normal) );
+
+				slab_header *header = reinterpret_cast<slab_header*>(slab);
+				header->sizeClass = sizeClass;
+				header->mappedSize = slab_heap::slab_size;
+
+				sc.carve = slab + slab_header_size;
+				sc.carveEnd = slab + slab_heap::slab_size;
+			}
+
+			slab_free_node *node = reinterpret_cast<slab_free_node*>(sc.carve);
+			sc.carve += blockSize;
+			node->next = head;
+			head = node;
+		}
+
+		cache.heads[sizeClass] = head;
+		cache.counts[sizeClass] = batchSize;
+	}
+}
+
+/// Moves one batch of free blocks of the given size class from the given cache to the shared depot.
+LEAN_ALWAYS_LINK void flush_slab_cache(slab_cache &cache, size_t sizeClass)
+{
+	size_t batchSize = slab_batch_size(sizeClass);
+
+	slab_free_node *batchHead = cache.heads[sizeClass];
+	slab_free_node *batchTail = batchHead;
+
+	for (size_t i = 1; i < batchSize; ++i)
+		batchTail = batchTail->next;
+
+	cache.heads[sizeClass] = batchTail->next;
+	cache.counts[sizeClass] -= batchSize;
+	batchTail->next = nullptr;
+
+	slab_batch_node *batch = static_cast<slab_batch_node*>(batchHead);
+	slab_class &sc = get_slab_state().classes[sizeClass];
+	scoped_slab_lock lock(sc.lock);
+
+	batch->nextBatch = sc.batches;
+	sc.batches = batch;
+}
+
+/// Takes a block of the given size class from the given cache.
+LEAN_INLINE void* pop_slab_block(slab_cache &cache, size_t sizeClass)
+{
+	if (!cache.heads[sizeClass])
+		refill_slab_cache(cache, sizeClass);
+
+	slab_free_node *node = cache.heads[sizeClass];
+	cache.heads[sizeClass] = node->next;
+	--cache.counts[sizeClass];
+	return node;
+}
+
+/// Puts the given block of the given size class into the given cache.
+LEAN_INLINE void push_slab_block(slab_cache &cache, size_t sizeClass, void *memory)
+{
+	slab_free_node *node = static_cast<slab_free_node*>(memory);
+	node->next = cache.heads[sizeClass];
+	cache.heads[sizeClass] = node;
+
+	// Keep one batch worth of blocks to avoid thrashing
+	if (++cache.counts[sizeClass] >= 2 * slab_batch_size(sizeClass))
+		flush_slab_cache(cache, sizeClass);
+}
+
+/// Allocates a block of the given size class.
+LEAN_INLINE void* allocate_small(size_t sizeClass)
+{
+	slab_cache *cache = current_slab_cache();
+
+	if (cache)
+		return pop_slab_block(*cache, sizeClass);
+	else
+	{
+		slab_cache &shared = current_shared_slab_cache();
+		scoped_slab_lock lock(shared.lock);
+		return pop_slab_block(shared, sizeClass);
+	}
+}
+
+/// Frees the given block of the given size class.
+LEAN_INLINE void free_small(void *memory, size_t sizeClass)
+{
+	slab_cache *cache = current_slab_cache();
+
+	if (cache)
+		push_slab_block(*cache, sizeClass, memory);
+	else
+	{
+		slab_cache &shared = current_shared_slab_cache();
+		scoped_slab_lock lock(shared.lock);
+		push_slab_block(shared, sizeClass, memory);
+	}
+}
+
+} // namespace
+} // namespace
+} // namespace
+
+// Allocates the given amount of memory.
+LEAN_MAYBE_LINK void* lean::memory::slab_heap::allocate(size_type size)
+{
+	size_type sizeClass = size_class(size);
+
+	return (sizeClass < size_class_count)
+		? impl::allocate_small(sizeClass)
+		: impl::allocate_large(size, impl::slab_header_size);
+}
+
+// Allocates the given amount of memory respecting the given alignment.
+LEAN_MAYBE_LINK void* lean::memory::slab_heap::allocate(size_type size, size_type alignment)
+{
+	LEAN_ASSERT(check_alignment(alignment) && alignment <= max_alignment);
+
+	// Blocks are aligned to the greatest power of two dividing their size, up to the slab header size
+	if (alignment <= impl::slab_header_size)
+	{
+		// Zero-size blocks need to be at least as large as their alignment
+		size_type sizeClass = size_class( (max(size, alignment) + alignment - 1) & ~(alignment - 1) );
+
+		if (sizeClass < size_class_count)
+			return impl::allocate_small(sizeClass);
+	}
+
+	return impl::allocate_large(size, max(alignment, impl::slab_header_size));
+}
+
+// Frees the given block of memory. May be called by any thread, not only the allocating one.
+LEAN_MAYBE_LINK void lean::memory::slab_heap::free(void *memory)
+{
+	if (!memory)
+		return;
+
+	impl::slab_header *header = impl::get_slab_header(memory);
+	size_type sizeClass = header->sizeClass;
+
+	if (sizeClass < size_class_count)
+		impl::free_small(memory, sizeClass);
+	else
+		page_heap_base::unmap_pages(header, header->mappedSize, page_size_policy::normal);
+}
+
+// Gets the number of bytes usable in the given block of memory.
+LEAN_MAYBE_LINK lean::memory::slab_heap::size_type lean::memory::slab_heap::size(const void *memory)
+{
+	const impl::slab_header *header = impl::get_slab_header(memory);
+
+	return (header->sizeClass < size_class_count)
+		? class_size(header->sizeClass)
+		: header->mappedSize - (static_cast<const char*>(memory) - reinterpret_cast<const char*>(header));
+}
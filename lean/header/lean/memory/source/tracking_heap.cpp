@@ -0,0 +1,305 @@
+#ifdef LEAN_BUILD_LIB
+#include "../../depconfig.h"
+#endif
+
+#include "../tracking_heap.h"
+#include "../../concurrent/atomic.h"
+#include "../../concurrent/backoff.h"
+#include <ostream>
+#include <vector>
+#include <algorithm>
+
+namespace lean
+{
+namespace memory
+{
+namespace impl
+{
+
+/// Global allocation tracking state. Plain old data, zero-initialized before any dynamic initialization takes place.
+struct tracking_state
+{
+	volatile long lock;
+	uint8 clock;
+	size_t siteCount;
+	tracking_site_stats totals;
+	/// Call sites, the first one collecting call sites exceeding the capacity.
+	tracking_site_stats sites[tracking_heap_base::site_capacity];
+	/// Open-addressing hash table of site indices, zero if unused.
+	size_t siteTable[2 * tracking_heap_base::site_capacity];
+};
+
+/// Gets the global allocation tracking state.
+LEAN_ALWAYS_LINK tracking_state& get_tracking_state()
+{
+	static tracking_state state;
+	return state;
+}
+
+/// Per-thread allocation tracking state.
+struct tracking_thread_state
+{
+	const char *tag;
+	size_t allocationCount;
+	size_t forbidCount;
+};
+
+/// Gets the allocation tracking state of the calling thread.
+LEAN_ALWAYS_LINK tracking_thread_state& get_tracking_thread_state()
+{
+	static LEAN_THREAD_LOCAL tracking_thread_state state = { nullptr, 0, 0 };
+	return state;
+}
+
+/// Acquires the global tracking lock on construction, releases it on destruction.
+class scoped_tracking_lock
+{
+private:
+	volatile long &m_lock;
+
+	scoped_tracking_lock(const scoped_tracking_lock&);
+	scoped_tracking_lock& operator =(const scoped_tracking_lock&);
+
+public:
+	/// Acquires the given lock word.
+	LEAN_INLINE explicit scoped_tracking_lock(volatile long &lock)
+		: m_lock(lock)
+	{
+		default_backoff backoff;
+
+		while (!atomic_test_and_set(m_lock, 0L, 1L))
+			while (atomic_load(m_lock, memory_order_relaxed) != 0)
+				backoff.pause();
+	}
+	/// Releases the lock word.
+	LEAN_INLINE ~scoped_tracking_lock()
+	{
+		atomic_store(m_lock, 0L, memory_order_release);
+	}
+};
+
+/// Gets the index of the site identified by the given key, adding a new site if missing. Requires the lock to be held.
+inline size_t get_tracking_site(tracking_state &state, const void *key, const char *tag)
+{
+	static const size_t table_mask = 2 * tracking_heap_base::site_capacity - 1;
+
+	size_t hash = reinterpret_cast<uintptr_t>(key);
+	hash ^= hash >> 16;
+	hash *= 0x45d9f3bU;
+	hash ^= hash >> 16;
+
+	for (size_t slot = hash & table_mask; ; slot = (slot + 1) & table_mask)
+	{
+		size_t index = state.siteTable[slot];
+
+		if (index == 0)
+		{
+			// Merge call sites exceeding the capacity
+			if (state.siteCount + 1 >= tracking_heap_base::site_capacity)
+				return 0;
+
+			index = ++state.siteCount;
+			state.siteTable[slot] = index;
+			state.sites[index].site = key;
+			state.sites[index].tag = tag;
+			return index;
+		}
+		else if (state.sites[index].site == key && state.sites[index].tag == tag)
+			return index;
+	}
+}
+
+/// Gets the lifetime histogram bucket of the given lifetime.
+inline size_t get_lifetime_bucket(uint8 lifetime)
+{
+	size_t bucket = 0;
+
+	while (lifetime && bucket < tracking_site_stats::lifetime_bucket_count - 1)
+	{
+		lifetime >>= 1;
+		++bucket;
+	}
+
+	return bucket;
+}
+
+/// Records the allocation of the given number of bytes.
+inline void track_site_allocation(tracking_site_stats &site, size_t size)
+{
+	++site.allocationCount;
+	site.allocatedBytes += size;
+	site.liveBytes += size;
+
+	if (site.liveBytes > site.peakBytes)
+		site.peakBytes = site.liveBytes;
+}
+
+/// Records the deallocation of the given number of bytes.
+inline void track_site_free(tracking_site_stats &site, size_t size, size_t lifetimeBucket)
+{
+	++site.freeCount;
+	site.liveBytes -= size;
+	++site.lifetimes[lifetimeBucket];
+}
+
+/// Orders sites by live bytes, then by allocated bytes.
+inline bool tracking_site_greater(const tracking_site_stats &left, const tracking_site_stats &right)
+{
+	return (left.liveBytes != right.liveBytes)
+		? left.liveBytes > right.liveBytes
+		: left.allocatedBytes > right.allocatedBytes;
+}
+
+/// Writes the given site statistics to the given stream.
+inline void report_tracking_site(std::ostream &stream, const tracking_site_stats &site)
+{
+	stream << site.allocationCount << " allocations, "
+		<< site.freeCount << " frees, "
+		<< site.allocatedBytes << " bytes allocated, "
+		<< site.liveBytes << " bytes live, "
+		<< site.peakBytes << " bytes peak" << std::endl;
+
+	size_t lastBucket = tracking_site_stats::lifetime_bucket_count;
+
+	while (lastBucket > 0 && !site.lifetimes[lastBucket - 1])
+		--lastBucket;
+
+	if (lastBucket > 0)
+	{
+		stream << "    lifetimes:";
+
+		for (size_t i = 0; i < lastBucket; ++i)
+			stream << " <" << (static_cast<uint8>(1) << i) << ": " << site.lifetimes[i];
+
+		stream << std::endl;
+	}
+}
+
+} // namespace
+} // namespace
+} // namespace
+
+// Gets statistics accumulated over all call sites.
+LEAN_MAYBE_LINK lean::memory::tracking_site_stats lean::memory::tracking_heap_base::totals()
+{
+	impl::tracking_state &state = impl::get_tracking_state();
+	impl::scoped_tracking_lock lock(state.lock);
+	return state.totals;
+}
+
+// Gets the number of call sites tracked.
+LEAN_MAYBE_LINK size_t lean::memory::tracking_heap_base::site_count()
+{
+	impl::tracking_state &state = impl::get_tracking_state();
+	impl::scoped_tracking_lock lock(state.lock);
+	return state.siteCount + 1;
+}
+
+// Copies the statistics of up to the given number of call sites, returning the number of sites copied.
+LEAN_MAYBE_LINK size_t lean::memory::tracking_heap_base::sites(tracking_site_stats *sites, size_t count)
+{
+	impl::tracking_state &state = impl::get_tracking_state();
+	impl::scoped_tracking_lock lock(state.lock);
+
+	if (count > state.siteCount + 1)
+		count = state.siteCount + 1;
+
+	std::copy(state.sites, state.sites + count, sites);
+	return count;
+}
+
+// Writes a report of all call sites to the given stream.
+LEAN_MAYBE_LINK void lean::memory::tracking_heap_base::report(std::ostream &stream)
+{
+	// NOTE: Never allocate while holding the lock, vector might well be allocating from a tracking heap
+	std::vector<tracking_site_stats> siteStats(site_count());
+	siteStats.resize( sites(&siteStats[0], siteStats.size()) );
+
+	std::sort(siteStats.begin(), siteStats.end(), &impl::tracking_site_greater);
+
+	stream << "Allocations: ";
+	impl::report_tracking_site(stream, totals());
+
+	for (std::vector<tracking_site_stats>::const_iterator it = siteStats.begin(); it != siteStats.end(); ++it)
+		if (it->allocationCount)
+		{
+			if (it->tag)
+				stream << "  " << it->tag << ": ";
+			else if (it->site)
+				stream << "  " << it->site << ": ";
+			else
+				stream << "  (other): ";
+
+			impl::report_tracking_site(stream, *it);
+		}
+}
+
+// Gets the number of blocks allocated by the calling thread.
+LEAN_MAYBE_LINK size_t lean::memory::tracking_heap_base::thread_allocation_count()
+{
+	return impl::get_tracking_thread_state().allocationCount;
+}
+
+// Sets the tag attributed with subsequent allocations of the calling thread, returning the previous tag.
+LEAN_MAYBE_LINK const char* lean::memory::tracking_heap_base::set_thread_tag(const char *tag)
+{
+	impl::tracking_thread_state &threadState = impl::get_tracking_thread_state();
+	const char *prevTag = threadState.tag;
+	threadState.tag = tag;
+	return prevTag;
+}
+
+// Asserts that no allocations happen on the calling thread until allow_allocations() is called.
+LEAN_MAYBE_LINK void lean::memory::tracking_heap_base::forbid_allocations()
+{
+	++impl::get_tracking_thread_state().forbidCount;
+}
+
+// Ends the last call to forbid_allocations().
+LEAN_MAYBE_LINK void lean::memory::tracking_heap_base::allow_allocations()
+{
+	--impl::get_tracking_thread_state().forbidCount;
+}
+
+// Records the allocation of the given number of bytes by the given caller.
+LEAN_MAYBE_LINK void* lean::memory::tracking_heap_base::track_allocation(void *block, size_t offset, size_type size, const void *caller)
+{
+	impl::tracking_thread_state &threadState = impl::get_tracking_thread_state();
+
+	++threadState.allocationCount;
+	LEAN_ASSERT_DEBUG_CTX(threadState.forbidCount == 0, "No allocations allowed in no_allocation_scope", __FILE__, __LINE__);
+
+	char *memory = static_cast<char*>(block) + offset;
+	block_header *header = reinterpret_cast<block_header*>(memory) - 1;
+	header->base = block;
+	header->size = size;
+
+	const void *key = (threadState.tag) ? static_cast<const void*>(threadState.tag) : caller;
+
+	impl::tracking_state &state = impl::get_tracking_state();
+	impl::scoped_tracking_lock lock(state.lock);
+
+	header->site = impl::get_tracking_site(state, key, threadState.tag);
+	header->clock = ++state.clock;
+
+	impl::track_site_allocation(state.sites[header->site], size);
+	impl::track_site_allocation(state.totals, size);
+
+	return memory;
+}
+
+// Records the deallocation of the given memory, returning the underlying block.
+LEAN_MAYBE_LINK void* lean::memory::tracking_heap_base::track_free(void *memory)
+{
+	block_header *header = static_cast<block_header*>(memory) - 1;
+
+	impl::tracking_state &state = impl::get_tracking_state();
+	impl::scoped_tracking_lock lock(state.lock);
+
+	size_t lifetimeBucket = impl::get_lifetime_bucket(state.clock - header->clock);
+
+	impl::track_site_free(state.sites[header->site], header->size, lifetimeBucket);
+	impl::track_site_free(state.totals, header->size, lifetimeBucket);
+
+	return header->base;
+}
@@ -0,0 +1,209 @@
+/*****************************************************/
+/* lean Memory                  (c) Tobias Zirr 2011 */
+/*****************************************************/
+
+#pragma once
+#ifndef LEAN_MEMORY_TRACKING_HEAP
+#define LEAN_MEMORY_TRACKING_HEAP
+
+#include "../lean.h"
+#include "../tags/noncopyable.h"
+#include <iosfwd>
+
+#ifdef _MSC_VER
+	#include <intrin.h>
+	#pragma intrinsic(_ReturnAddress)
+#endif
+
+namespace lean
+{
+namespace memory
+{
+
+/// Allocation statistics of one call site.
+struct tracking_site_stats
+{
+	/// Number of lifetime histogram buckets.
+	static const size_t lifetime_bucket_count = 24;
+
+	const void *site;			///< Address of the calling code, tag if tagged.
+	const char *tag;			///< Tag assigned by scoped_allocation_tag, nullptr if untagged.
+	size_t allocationCount;		///< Number of blocks allocated.
+	size_t freeCount;			///< Number of blocks freed.
+	size_t allocatedBytes;		///< Total number of bytes allocated.
+	size_t liveBytes;			///< Number of bytes currently allocated.
+	size_t peakBytes;			///< Maximum number of bytes allocated at any one time.
+	/// Number of freed blocks by lifetime, bucket i counting lifetimes of [2^(i-1), 2^i) allocations.
+	/// Lifetimes are measured in allocations performed by any tracking heap in the meantime.
+	size_t lifetimes[lifetime_bucket_count];
+};
+
+/// Allocation tracking shared by all tracking heaps.
+struct tracking_heap_base
+{
+	/// Size type.
+	typedef size_t size_type;
+	/// Maximum number of distinct call sites, further call sites are merged into one.
+	static const size_t site_capacity = 1024;
+
+	/// Gets statistics accumulated over all call sites.
+	LEAN_MAYBE_EXPORT static tracking_site_stats totals();
+	/// Gets the number of call sites tracked.
+	LEAN_MAYBE_EXPORT static size_t site_count();
+	/// Copies the statistics of up to the given number of call sites, returning the number of sites copied.
+	LEAN_MAYBE_EXPORT static size_t sites(tracking_site_stats *sites, size_t count);
+	/// Writes a report of all call sites to the given stream, ordered by live & allocated bytes.
+	LEAN_MAYBE_EXPORT static void report(std::ostream &stream);
+
+	/// Gets the number of blocks allocated by the calling thread.
+	LEAN_MAYBE_EXPORT static size_t thread_allocation_count();
+	/// Sets the tag attributed with subsequent allocations of the calling thread, returning the previous tag.
+	/// Tags are identified by address, nullptr attributes allocations to the calling code.
+	LEAN_MAYBE_EXPORT static const char* set_thread_tag(const char *tag);
+	/// Asserts that no allocations happen on the calling thread until allow_allocations() is called.
+	LEAN_MAYBE_EXPORT static void forbid_allocations();
+	/// Ends the last call to forbid_allocations().
+	LEAN_MAYBE_EXPORT static void allow_allocations();
+
+protected:
+	/// Tracking information stored in front of every block.
+	struct block_header
+	{
+		void *base;
+		size_t size;
+		size_t site;
+		uint8 clock;
+	};
+
+	/// Offset of the memory returned from the beginning of the underlying block.
+	template <size_t Alignment>
+	struct header_offset
+	{
+		/// Alignment of the underlying block.
+		static const size_t alignment = (Alignment > alignof(block_header)) ? Alignment : alignof(block_header);
+		/// Offset of the memory returned.
+		static const size_t value = (sizeof(block_header) + (alignment - 1)) & ~(alignment - 1);
+	};
+
+	/// Records the allocation of the given number of bytes by the given caller, returning the memory
+	/// located at the given offset from the given block.
+	LEAN_MAYBE_EXPORT static void* track_allocation(void *block, size_t offset, size_type size, const void *caller);
+	/// Records the deallocation of the given memory, returning the underlying block.
+	LEAN_MAYBE_EXPORT static void* track_free(void *memory);
+};
+
+/// Heap adapter recording allocation statistics per call site. Call sites are identified by the address
+/// of the code calling into this heap, unless tagged by scoped_allocation_tag. Define LEAN_TRACK_DEFAULT_HEAP
+/// to wrap the default heap & thereby all lean containers.
+template <class Heap>
+struct tracking_heap : public tracking_heap_base
+{
+	/// Heap adapted by this heap.
+	typedef Heap heap_type;
+	/// Size type.
+	typedef typename heap_type::size_type size_type;
+	/// Default alignment.
+	static const size_type default_alignment = Heap::default_alignment;
+	/// Maximum alignment.
+	static const size_type max_alignment = Heap::max_alignment;
+
+	LEAN_STATIC_ASSERT_MSG_ALT(Heap::default_alignment >= alignof(block_header),
+		"Adapted heap alignment insufficient for block headers.",
+		Adapted_heap_alignment_insufficient_for_block_headers);
+
+	/// Allocates the given amount of memory.
+	static LEAN_NOINLINE void* allocate(size_type size)
+	{
+		static const size_t offset = header_offset<default_alignment>::value;
+		return track_allocation(Heap::allocate(size + offset), offset, size, LEAN_RETURN_ADDRESS());
+	}
+	/// Frees the given block of memory.
+	static LEAN_INLINE void free(void *memory)
+	{
+		if (memory)
+			Heap::free(track_free(memory));
+	}
+
+	/// Allocates the given amount of memory respecting the given alignment.
+	template <size_t Alignment>
+	static LEAN_NOINLINE void* allocate(size_type size)
+	{
+		typedef header_offset<Alignment> offset;
+		return track_allocation(Heap::template allocate<offset::alignment>(size + offset::value), offset::value, size, LEAN_RETURN_ADDRESS());
+	}
+	/// Frees the given aligned block of memory.
+	template <size_t Alignment>
+	static LEAN_INLINE void free(void *memory)
+	{
+		if (memory)
+			Heap::template free<header_offset<Alignment>::alignment>(track_free(memory));
+	}
+	/// Frees the given aligned block of memory.
+	static LEAN_INLINE void free(void *memory, size_t alignment)
+	{
+		if (memory)
+			Heap::free(track_free(memory), (alignment > alignof(block_header)) ? alignment : alignof(block_header));
+	}
+};
+
+/// Attributes all allocations of the calling thread performed during the lifetime of this object to the given tag.
+class scoped_allocation_tag : public noncopyable
+{
+private:
+	const char *m_prevTag;
+
+public:
+	/// Attributes subsequent allocations of the calling thread to the given tag, identified by address.
+	LEAN_INLINE explicit scoped_allocation_tag(const char *tag)
+		: m_prevTag( tracking_heap_base::set_thread_tag(tag) ) { }
+	/// Restores the previous tag.
+	LEAN_INLINE ~scoped_allocation_tag()
+	{
+		tracking_heap_base::set_thread_tag(m_prevTag);
+	}
+};
+
+/// Asserts that the calling thread does not allocate from any tracking heap during the lifetime of this object.
+class no_allocation_scope : public noncopyable
+{
+private:
+	size_t m_allocationCount;
+	bool m_forbidden;
+
+public:
+	/// Asserts that no allocations happen in this scope, breaking at the offending allocation if requested.
+	LEAN_INLINE explicit no_allocation_scope(bool breakOnAllocation = true)
+		: m_allocationCount( tracking_heap_base::thread_allocation_count() ),
+		m_forbidden(breakOnAllocation)
+	{
+		if (m_forbidden)
+			tracking_heap_base::forbid_allocations();
+	}
+	/// Ends this scope.
+	LEAN_INLINE ~no_allocation_scope()
+	{
+		if (m_forbidden)
+			tracking_heap_base::allow_allocations();
+	}
+
+	/// Gets the number of allocations performed by the calling thread in this scope so far.
+	LEAN_INLINE size_t allocations() const
+	{
+		return tracking_heap_base::thread_allocation_count() - m_allocationCount;
+	}
+};
+
+} // namespace
+
+using memory::tracking_site_stats;
+using memory::tracking_heap;
+using memory::scoped_allocation_tag;
+using memory::no_allocation_scope;
+
+} // namespace
+
+#ifdef LEAN_INCLUDE_LINKED
+#include "source/tracking_heap.cpp"
+#endif
+
+#endif
\ No newline at end of file
@@ -8,6 +8,7 @@
 
 #include "../lean.h"
 #include "alignment.h"
+#include "crt_heap.h"
 
 #ifndef LEAN_ASSUME_WIN_ALIGNMENT
 	// MONITOR: Windows heap aligns memory to 8 byte (16 on x64) boundaries by default
@@ -28,7 +29,7 @@ namespace lean
 namespace memory
 {
 
-/// Windows heap.
+/// Windows heap. Over-aligned memory is allocated natively aligned by the CRT, without additional bookkeeping.
 struct win_heap
 {
 	/// Size type.
@@ -36,7 +37,7 @@ struct win_heap
 	/// Default alignment.
 	static const size_type default_alignment = LEAN_ASSUME_WIN_ALIGNMENT;
 	/// Maximum alignment.
-	static const size_type max_alignment = static_cast<unsigned char>(-1);
+	static const size_type max_alignment = crt_heap::max_alignment;
 
 	/// Allocates the given amount of memory.
 	LEAN_MAYBE_EXPORT static void* allocate(size_type size);
@@ -47,36 +48,41 @@ struct win_heap
 	template <size_t Alignment>
 	static LEAN_INLINE void* allocate(size_type size)
 	{
-		if (Alignment <= default_alignment && is_valid_alignment<Alignment>::value)
+		LEAN_STATIC_ASSERT_MSG_ALT(is_valid_alignment<Alignment>::value && Alignment <= max_alignment,
+			"Alignment is required to be power of two <= max_alignment.",
+			Alignment_is_required_to_be_power_of_two_not_exceeding_max_alignment);
+
+		if (Alignment <= default_alignment)
 			return allocate(size);
 		else
-		{
-			LEAN_STATIC_ASSERT_MSG_ALT(Alignment <= max_alignment,
-				"Alignment > max unsigned char unsupported.",
-				Alignment_bigger_than_max_unsigned_char_unsupported);
-
-			unsigned char *unaligned = reinterpret_cast<unsigned char*>( allocate(size + Alignment) );
-			unsigned char *aligned = upper_align<Alignment>(unaligned);
-			aligned[-1] = static_cast<unsigned char>(aligned - unaligned);
-			return aligned;
-		}
+			return impl::crt_aligned_alloc(size, Alignment);
 	}
 	/// Frees the given aligned block of memory.
 	template <size_t Alignment>
 	static LEAN_INLINE void free(void *memory)
 	{
-		if (Alignment <= default_alignment && is_valid_alignment<Alignment>::value)
+		if (Alignment <= default_alignment)
 			free(memory);
-		else if (memory)
-			free(reinterpret_cast<unsigned char*>(memory) - reinterpret_cast<unsigned char*>(memory)[-1]);
+		else
+			impl::crt_aligned_free(memory);
+	}
+	/// Allocates the given amount of memory respecting the given power-of-two alignment.
+	static LEAN_INLINE void* allocate(size_type size, size_t alignment)
+	{
+		LEAN_ASSERT(check_alignment(alignment) && alignment <= max_alignment);
+
+		if (alignment <= default_alignment)
+			return allocate(size);
+		else
+			return impl::crt_aligned_alloc(size, alignment);
 	}
 	/// Frees the given aligned block of memory.
 	static LEAN_INLINE void free(void *memory, size_t alignment)
 	{
-		if (alignment <= default_alignment && check_alignment(alignment))
+		if (alignment <= default_alignment)
 			free(memory);
-		else if (memory)
-			free(reinterpret_cast<unsigned char*>(memory) - reinterpret_cast<unsigned char*>(memory)[-1]);
+		else
+			impl::crt_aligned_free(memory);
 	}
 };
 
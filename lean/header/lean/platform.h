@@ -99,6 +99,30 @@
 /// Instructs the compiler not to inline a specific template function in a header file.
 #define LEAN_NOTINLINE LEAN_NOLTINLINE
 
+#ifdef _MSC_VER
+	/// Gives a static or global variable thread-local storage duration.
+	#define LEAN_THREAD_LOCAL __declspec(thread)
+#else
+	/// Gives a static or global variable thread-local storage duration.
+	#define LEAN_THREAD_LOCAL __thread
+#endif
+
+#ifdef _MSC_VER
+	/// Gets the address the calling function returns to (requires intrin.h).
+	#define LEAN_RETURN_ADDRESS() _ReturnAddress()
+#else
+	/// Gets the address the calling function returns to.
+	#define LEAN_RETURN_ADDRESS() __builtin_return_address(0)
+#endif
+
+#ifdef _MSC_VER
+	/// Aligns a type or variable to the given number of bytes.
+	#define LEAN_ALIGN(alignment) __declspec(align(alignment))
+#else
+	/// Aligns a type or variable to the given number of bytes.
+	#define LEAN_ALIGN(alignment) __attribute__((aligned(alignment)))
+#endif
+
 /// @}
 
 #endif
\ No newline at end of file
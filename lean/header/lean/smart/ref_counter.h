@@ -205,7 +205,8 @@ public:
 	{
 		LEAN_ASSERT(m_counts);
 
-		return atomic_increment(m_counts->references);
+		// New references can only be created from existing ones, no ordering required
+		return atomic_fetch_add(m_counts->references, 1, memory_order_relaxed) + 1;
 	}
 	/// Decrements the current reference count.
 	counter_type decrement() const
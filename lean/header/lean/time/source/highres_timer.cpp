@@ -3,6 +3,9 @@
 #endif
 
 #include "../highres_timer.h"
+
+#ifdef _WIN32
+
 #include <windows.h>
 
 // Constructs a new timer from the current system time.
@@ -33,3 +36,52 @@ LEAN_MAYBE_INLINE double lean::time::highres_timer::milliseconds() const
 	::QueryPerformanceCounter(reinterpret_cast<LARGE_INTEGER*>(&newTime));
 	return ((newTime - m_time) * 1000000 / m_frequency) * (1.0 / 1000.0);
 }
+
+#else
+
+#include <time.h>
+
+namespace lean
+{
+namespace time
+{
+namespace impl
+{
+	/// Gets the current monotonic time in nanoseconds.
+	inline uint8 get_monotonic_time()
+	{
+		::timespec now;
+		::clock_gettime(CLOCK_MONOTONIC, &now);
+		return static_cast<uint8>(now.tv_sec) * 1000000000U + static_cast<uint8>(now.tv_nsec);
+	}
+
+} // namespace
+} // namespace
+} // namespace
+
+// Constructs a new timer from the current system time.
+LEAN_MAYBE_INLINE lean::time::highres_timer::highres_timer()
+	: m_frequency(1000000000U),
+	m_time(impl::get_monotonic_time())
+{
+}
+
+// Updates the reference time stored by this timer.
+LEAN_MAYBE_INLINE void lean::time::highres_timer::tick()
+{
+	m_time = impl::get_monotonic_time();
+}
+
+// Gets the time that has elapsed since the last tick.
+LEAN_MAYBE_INLINE double lean::time::highres_timer::seconds() const
+{
+	return (impl::get_monotonic_time() - m_time) * (1.0 / 1000000000.0);
+}
+
+// Gets the time that has elapsed since the last tick.
+LEAN_MAYBE_INLINE double lean::time::highres_timer::milliseconds() const
+{
+	return (impl::get_monotonic_time() - m_time) * (1.0 / 1000000.0);
+}
+
+#endif
@@ -22,6 +22,12 @@
 	#define LEAN_XML_FILE_SAVE_BATCH_SIZE 4096
 #endif
 
+#ifndef LEAN_XML_FILE_SAVE_BATCH_COUNT
+	/// Number of batches filled while writing XML files, batches being written on a background thread if greater than 1.
+	/// @ingroup AssortedSwitches
+	#define LEAN_XML_FILE_SAVE_BATCH_COUNT 1
+#endif
+
 namespace lean
 {
 namespace xml
@@ -66,7 +72,8 @@ template <int PrintFlags, class Char>
 LEAN_INLINE void save_xml_file(const utf8_ntri &fileName, const rapidxml::xml_node<Char> &document)
 {
 	raw_file file(fileName, file::write, file::overwrite);
-	print(raw_file_inserter<LEAN_XML_FILE_SAVE_BATCH_SIZE>(file).iter(), document, PrintFlags);
+	raw_file_inserter<LEAN_XML_FILE_SAVE_BATCH_SIZE> inserter(file, LEAN_XML_FILE_SAVE_BATCH_COUNT);
+	print(inserter.iter(), document, PrintFlags);
 }
 
 /// This convenience class wraps up the most common xml file functionality.
@@ -1,5 +1,7 @@
 #include "stdafx.h"
 #include <lean/memory/aligned.h>
+#include <lean/memory/crt_heap.h>
+#include <lean/memory/chunk_heap.h>
 
 #include <iostream>
 
@@ -10,6 +12,11 @@ struct aligned_object : public lean::aligned<16>
 	~aligned_object() { ::std::cout << "dtor"; };
 };
 
+struct page_aligned_object : public lean::aligned<4096, lean::crt_heap>
+{
+	float a[16];
+};
+
 BOOST_AUTO_TEST_SUITE( aligned )
 
 BOOST_AUTO_TEST_CASE( stack_aligned_array )
@@ -24,4 +31,42 @@ BOOST_AUTO_TEST_CASE( aligned_array )
 	unsigned int a = reinterpret_cast<const unsigned int&>(b);
 }
 
+BOOST_AUTO_TEST_CASE( crt_over_aligned )
+{
+	void *block64 = lean::crt_heap::allocate<64>(10);
+	void *block512 = lean::crt_heap::allocate<512>(10);
+	void *blockPage = lean::crt_heap::allocate<4096>(10);
+	void *blockRuntime = lean::crt_heap::allocate(10, 8192);
+
+	BOOST_CHECK( reinterpret_cast<uintptr_t>(block64) % 64 == 0 );
+	BOOST_CHECK( reinterpret_cast<uintptr_t>(block512) % 512 == 0 );
+	BOOST_CHECK( reinterpret_cast<uintptr_t>(blockPage) % 4096 == 0 );
+	BOOST_CHECK( reinterpret_cast<uintptr_t>(blockRuntime) % 8192 == 0 );
+
+	lean::crt_heap::free<64>(block64);
+	lean::crt_heap::free(block512, 512);
+	lean::crt_heap::free<4096>(blockPage);
+	lean::crt_heap::free(blockRuntime, 8192);
+	lean::crt_heap::free<64>(nullptr);
+}
+
+BOOST_AUTO_TEST_CASE( page_aligned_new )
+{
+	page_aligned_object *object = new page_aligned_object();
+	BOOST_CHECK( reinterpret_cast<uintptr_t>(object) % 4096 == 0 );
+	delete object;
+}
+
+BOOST_AUTO_TEST_CASE( chunk_heap_simd_aligned )
+{
+	lean::chunk_heap<1024, lean::crt_heap, 0, 64> heap;
+
+	for (int i = 0; i < 100; ++i)
+		BOOST_CHECK( reinterpret_cast<uintptr_t>(heap.allocate(48)) % 64 == 0 );
+
+	// Chunks start aligned, no alignment padding in front of first allocation
+	lean::chunk_heap_stats stats = heap.stats();
+	BOOST_CHECK_EQUAL(stats.usedBytes, 100U * 48U + (100U - stats.chunkCount) * 16U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
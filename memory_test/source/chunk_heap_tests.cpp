@@ -0,0 +1,267 @@
+#include "stdafx.h"
+#include <lean/memory/chunk_heap.h>
+#include <lean/memory/scoped_arena.h>
+#include <lean/memory/frame_heap.h>
+#include <lean/memory/object_pool.h>
+#include <lean/memory/crt_heap.h>
+#include <cstring>
+
+namespace
+{
+
+/// CRT heap counting live allocations.
+struct counting_heap : public lean::crt_heap
+{
+	static long allocations;
+
+	static void* allocate(size_type size) { ++allocations; return lean::crt_heap::allocate(size); }
+	static void free(void *memory) { if (memory) --allocations; lean::crt_heap::free(memory); }
+
+	template <size_t Alignment>
+	static void* allocate(size_type size) { ++allocations; return lean::crt_heap::allocate<Alignment>(size); }
+	template <size_t Alignment>
+	static void free(void *memory) { if (memory) --allocations; lean::crt_heap::free<Alignment>(memory); }
+};
+
+long counting_heap::allocations = 0;
+
+typedef lean::chunk_heap<256, counting_heap, 0> test_heap;
+typedef lean::chunk_heap<256, counting_heap, 128> static_test_heap;
+typedef lean::chunk_heap<256, counting_heap, 0, sizeof(void*), lean::chunk_growth_policies::geometric<2, 2048> > growing_test_heap;
+
+/// Counts live instances.
+struct counted
+{
+	static long instances;
+	int value;
+
+	counted(int value) : value(value) { ++instances; }
+	counted(const counted &right) : value(right.value) { ++instances; }
+	~counted() { --instances; }
+};
+
+long counted::instances = 0;
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE( chunk_heap )
+
+BOOST_AUTO_TEST_CASE( mark_rewind )
+{
+	{
+		test_heap heap;
+
+		void *first = heap.allocate(16);
+		test_heap::marker position = heap.mark();
+		void *second = heap.allocate(16);
+
+		// Rewind within chunk
+		heap.rewind(position);
+		BOOST_CHECK_EQUAL(heap.allocate(16), second);
+		BOOST_CHECK_EQUAL(counting_heap::allocations, 1);
+
+		// Rewind across chunks
+		heap.rewind(position);
+		for (int i = 0; i < 100; ++i)
+			memset(heap.allocate(100), i, 100);
+
+		BOOST_CHECK(counting_heap::allocations > 1);
+		heap.rewind(position);
+		BOOST_CHECK_EQUAL(counting_heap::allocations, 1);
+		BOOST_CHECK_EQUAL(heap.allocate(16), second);
+		BOOST_CHECK(first != second);
+	}
+
+	BOOST_CHECK_EQUAL(counting_heap::allocations, 0);
+}
+
+BOOST_AUTO_TEST_CASE( static_chunk_rewind )
+{
+	{
+		static_test_heap heap;
+
+		static_test_heap::marker position = heap.mark();
+		void *first = heap.allocate(16);
+
+		for (int i = 0; i < 10; ++i)
+			heap.allocate(100);
+
+		heap.rewind(position);
+		BOOST_CHECK_EQUAL(counting_heap::allocations, 0);
+		BOOST_CHECK_EQUAL(heap.allocate(16), first);
+	}
+
+	BOOST_CHECK_EQUAL(counting_heap::allocations, 0);
+}
+
+BOOST_AUTO_TEST_CASE( nested_arenas )
+{
+	test_heap heap;
+	heap.allocate(16);
+
+	void *outerFirst;
+
+	{
+		lean::scoped_arena<test_heap> outer(heap);
+		outerFirst = outer.allocate(64);
+
+		void *innerFirst;
+
+		{
+			lean::scoped_arena<test_heap> inner(heap);
+			innerFirst = inner.allocate<16>(64);
+			BOOST_CHECK(reinterpret_cast<uintptr_t>(innerFirst) % 16 == 0);
+
+			for (int i = 0; i < 20; ++i)
+				inner.allocate(200);
+		}
+
+		BOOST_CHECK(outer.allocate<16>(64) == innerFirst);
+	}
+
+	BOOST_CHECK(heap.allocate(64) == outerFirst);
+}
+
+BOOST_AUTO_TEST_CASE( reset_retains_chunks )
+{
+	{
+		test_heap heap;
+
+		for (int i = 0; i < 20; ++i)
+			heap.allocate(200);
+
+		long chunkCount = counting_heap::allocations;
+		heap.reset();
+		BOOST_CHECK_EQUAL(counting_heap::allocations, chunkCount);
+
+		// Retained chunks are re-used
+		for (int i = 0; i < 20; ++i)
+			heap.allocate(200);
+
+		BOOST_CHECK_EQUAL(counting_heap::allocations, chunkCount);
+
+		// Larger chunks allocated if no retained chunk large enough
+		heap.reset();
+		heap.allocate(1000);
+		BOOST_CHECK_EQUAL(counting_heap::allocations, chunkCount + 1);
+	}
+
+	BOOST_CHECK_EQUAL(counting_heap::allocations, 0);
+}
+
+BOOST_AUTO_TEST_CASE( frame_heap )
+{
+	{
+		lean::frame_heap<256, counting_heap> frames;
+
+		char *frame0 = static_cast<char*>( frames.allocate(100) );
+		memset(frame0, 0x0f, 100);
+		frames.next_frame();
+
+		char *frame1 = static_cast<char*>( frames.allocate(100) );
+		memset(frame1, 0xf0, 100);
+
+		// Memory of the previous frame remains valid
+		BOOST_CHECK(frame0[99] == 0x0f);
+		BOOST_CHECK(frame0 != frame1);
+
+		long chunkCount = counting_heap::allocations;
+		frames.next_frame();
+
+		// Chunks of the frame before last are re-used
+		BOOST_CHECK_EQUAL(frames.allocate(100), frame0);
+		BOOST_CHECK(frame1[99] == static_cast<char>(0xf0));
+		BOOST_CHECK_EQUAL(counting_heap::allocations, chunkCount);
+	}
+
+	BOOST_CHECK_EQUAL(counting_heap::allocations, 0);
+}
+
+BOOST_AUTO_TEST_CASE( geometric_growth )
+{
+	{
+		growing_test_heap heap;
+
+		heap.allocate(16);
+		BOOST_CHECK(heap.nextChunkSize() == 512);
+		heap.allocate(256);
+		BOOST_CHECK(heap.nextChunkSize() == 1024);
+
+		for (int i = 0; i < 100; ++i)
+			heap.allocate(256);
+
+		// Growth capped
+		BOOST_CHECK(heap.nextChunkSize() == 2048);
+		BOOST_CHECK(counting_heap::allocations < 20);
+	}
+
+	BOOST_CHECK_EQUAL(counting_heap::allocations, 0);
+}
+
+BOOST_AUTO_TEST_CASE( statistics )
+{
+	static_test_heap heap;
+
+	lean::chunk_heap_stats stats = heap.stats();
+	BOOST_CHECK(stats.reservedBytes == 128);
+	BOOST_CHECK(stats.usedBytes == 0);
+	BOOST_CHECK(stats.chunkCount == 0);
+
+	heap.allocate(100);
+	heap.allocate(100);
+	stats = heap.stats();
+	BOOST_CHECK(stats.reservedBytes == 128 + 256);
+	BOOST_CHECK(stats.usedBytes == 200);
+	BOOST_CHECK(stats.wastedBytes == 28);
+	BOOST_CHECK(stats.chunkCount == 1);
+
+	static_test_heap::marker position = heap.mark();
+	heap.allocate(200);
+	heap.allocate(100);
+	BOOST_CHECK(heap.stats().chunkCount == 3);
+
+	heap.rewind(position);
+	stats = heap.stats();
+	BOOST_CHECK(stats.usedBytes == 200);
+	BOOST_CHECK(stats.wastedBytes == 28);
+	BOOST_CHECK(stats.chunkCount == 1);
+
+	heap.allocate(200);
+	heap.reset();
+	stats = heap.stats();
+	BOOST_CHECK(stats.usedBytes == 0);
+	BOOST_CHECK(stats.wastedBytes == 0);
+	BOOST_CHECK(stats.spareBytes == 512);
+	BOOST_CHECK(stats.reservedBytes == 128 + 512);
+
+	heap.clear();
+	stats = heap.stats();
+	BOOST_CHECK(stats.reservedBytes == 128);
+	BOOST_CHECK(stats.spareBytes == 0);
+	BOOST_CHECK(stats.chunkCount == 0);
+}
+
+BOOST_AUTO_TEST_CASE( object_pool_growth )
+{
+	{
+		lean::object_pool<counted, 4, counting_heap, 2, alignof(counted), lean::chunk_growth_policies::geometric<> > pool;
+
+		for (int i = 0; i < 1000; ++i)
+			pool.place(counted(i));
+
+		BOOST_CHECK_EQUAL(counted::instances, 1000);
+		BOOST_CHECK(pool.stats().chunkCount < 16);
+		BOOST_CHECK(pool.stats().usedBytes == 1000 * sizeof(counted));
+
+		pool.clear();
+		BOOST_CHECK_EQUAL(counted::instances, 0);
+
+		for (int i = 0; i < 10; ++i)
+			pool.place(counted(i));
+	}
+
+	BOOST_CHECK_EQUAL(counted::instances, 0);
+	BOOST_CHECK_EQUAL(counting_heap::allocations, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,147 @@
+#include "stdafx.h"
+#include <lean/memory/concurrent_chunk_pool.h>
+#include <lean/containers/mpmc_queue.h>
+#include <lean/concurrent/thread.h>
+#include <set>
+#include <vector>
+
+namespace
+{
+
+struct element
+{
+	long values[4];
+};
+
+typedef lean::concurrent_chunk_pool<element, 256, lean::default_heap, 8, 4> test_pool;
+typedef lean::blocking_mpmc_queue<element*> element_queue;
+
+static const long transfer_count = 20000;
+
+struct producer
+{
+	test_pool *pool;
+	element_queue *queue;
+
+	void operator ()() const
+	{
+		for (long i = 0; i < transfer_count; ++i)
+		{
+			element *e = static_cast<element*>(pool->allocate());
+			e->values[0] = i;
+			e->values[3] = -i;
+			queue->push(e);
+		}
+
+		queue->push(nullptr);
+	}
+};
+
+struct consumer
+{
+	test_pool *pool;
+	element_queue *queue;
+	volatile long *corrupted;
+
+	void operator ()() const
+	{
+		for (;;)
+		{
+			element *e;
+			queue->pop(e);
+
+			// One terminator per producer
+			if (!e)
+				break;
+
+			if (e->values[0] != -e->values[3])
+				lean::atomic_increment(*corrupted);
+
+			// Cross-thread free
+			pool->free(e);
+		}
+	}
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE( concurrent_chunk_pool )
+
+BOOST_AUTO_TEST_CASE( unique_elements )
+{
+	test_pool pool;
+
+	std::vector<void*> elements;
+	std::set<void*> unique;
+
+	for (int i = 0; i < 1000; ++i)
+	{
+		void *e = pool.allocate();
+		elements.push_back(e);
+		unique.insert(e);
+		BOOST_CHECK(reinterpret_cast<uintptr_t>(e) % alignof(element) == 0);
+	}
+
+	BOOST_CHECK_EQUAL(unique.size(), elements.size());
+
+	// Elements are re-used after free, passing through the depot
+	for (size_t i = 0; i < elements.size(); ++i)
+		pool.free(elements[i]);
+
+	for (int i = 0; i < 1000; ++i)
+		BOOST_CHECK(unique.count(pool.allocate()) == 1);
+}
+
+BOOST_AUTO_TEST_CASE( producer_consumer )
+{
+	static const int pairCount = 3;
+
+	test_pool pool;
+	element_queue queue(256);
+	volatile long corrupted = 0;
+
+	lean::thread threads[2 * pairCount];
+
+	for (int i = 0; i < pairCount; ++i)
+	{
+		consumer cons = { &pool, &queue, &corrupted };
+		threads[2 * i] = lean::thread(cons);
+		producer prod = { &pool, &queue };
+		threads[2 * i + 1] = lean::thread(prod);
+	}
+
+	for (int i = 0; i < 2 * pairCount; ++i)
+		threads[i].join();
+
+	BOOST_CHECK_EQUAL(corrupted, 0);
+}
+
+BOOST_AUTO_TEST_CASE( multiple_pools )
+{
+	// Thread-local magazine lookup re-bound on every switch between pools
+	for (int round = 0; round < 3; ++round)
+	{
+		test_pool a, b;
+		std::set<void*> fromA, fromB;
+
+		for (int i = 0; i < 100; ++i)
+		{
+			fromA.insert(a.allocate());
+			fromB.insert(b.allocate());
+		}
+
+		BOOST_CHECK_EQUAL(fromA.size(), 100U);
+		BOOST_CHECK_EQUAL(fromB.size(), 100U);
+
+		for (std::set<void*>::iterator it = fromA.begin(); it != fromA.end(); ++it)
+		{
+			BOOST_CHECK(fromB.count(*it) == 0);
+			a.free(*it);
+		}
+
+		for (std::set<void*>::iterator it = fromB.begin(); it != fromB.end(); ++it)
+			b.free(*it);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
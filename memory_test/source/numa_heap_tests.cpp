@@ -0,0 +1,60 @@
+#include "stdafx.h"
+#include <lean/memory/numa_heap.h>
+#include <cstring>
+
+BOOST_AUTO_TEST_SUITE( numa_heap )
+
+BOOST_AUTO_TEST_CASE( topology )
+{
+	int nodeCount = lean::numa_heap_base::node_count();
+	BOOST_CHECK(nodeCount >= 1);
+
+	int node = lean::numa_heap_base::current_node();
+	BOOST_CHECK(0 <= node && node < nodeCount);
+
+	BOOST_CHECK(lean::numa_heap_base::run_on_node(0) || nodeCount == 1);
+	BOOST_CHECK(!lean::numa_heap_base::run_on_node(nodeCount));
+	BOOST_CHECK(lean::numa_heap_base::run_on_node(lean::numa_heap_base::all_nodes));
+}
+
+BOOST_AUTO_TEST_CASE( bound_blocks )
+{
+	typedef lean::numa_heap<0> heap;
+
+	const size_t size = 1 << 20;
+	char *block = static_cast<char*>( heap::allocate(size) );
+	BOOST_CHECK(reinterpret_cast<uintptr_t>(block) % heap::default_alignment == 0);
+	BOOST_CHECK(heap::size(block) >= size);
+	memset(block, 0xab, size);
+
+	int node = heap::page_node(block);
+	BOOST_CHECK(node == 0 || node == -1);
+
+	void *aligned = heap::allocate<4096>(100);
+	BOOST_CHECK(reinterpret_cast<uintptr_t>(aligned) % 4096 == 0);
+
+	heap::free<4096>(aligned);
+	heap::free(block);
+}
+
+BOOST_AUTO_TEST_CASE( interleaved_blocks )
+{
+	const size_t size = 1 << 20;
+	char *block = static_cast<char*>( lean::interleaved_heap::allocate(size) );
+	memset(block, 0xab, size);
+	BOOST_CHECK_EQUAL(block[size - 1], static_cast<char>(0xab));
+	lean::interleaved_heap::free(block);
+}
+
+BOOST_AUTO_TEST_CASE( missing_node )
+{
+	// Placement on missing nodes falls back to first touch
+	typedef lean::numa_heap<1000> heap;
+
+	char *block = static_cast<char*>( heap::allocate(10000) );
+	memset(block, 0xab, 10000);
+	BOOST_CHECK(!lean::numa_heap_base::place_pages(block, 10000, lean::numa_policy::bind, 1000));
+	heap::free(block);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,108 @@
+#include "stdafx.h"
+#include <lean/memory/page_heap.h>
+#include <lean/memory/chunk_heap.h>
+#include <lean/memory/heap_allocator.h>
+#include <cstring>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE( page_heap )
+
+BOOST_AUTO_TEST_CASE( page_rounding )
+{
+	size_t pageSize = lean::page_heap::page_size();
+	size_t hugePageSize = lean::page_heap::huge_page_size();
+
+	BOOST_CHECK(lean::check_alignment(pageSize));
+	BOOST_CHECK(lean::check_alignment(hugePageSize));
+	BOOST_CHECK(hugePageSize >= pageSize);
+
+	BOOST_CHECK_EQUAL(lean::page_heap::round_to_pages(1, lean::page_size_policy::normal), pageSize);
+	BOOST_CHECK_EQUAL(lean::page_heap::round_to_pages(pageSize, lean::page_size_policy::normal), pageSize);
+	BOOST_CHECK_EQUAL(lean::page_heap::round_to_pages(pageSize + 1, lean::page_size_policy::normal), 2 * pageSize);
+	BOOST_CHECK_EQUAL(lean::page_heap::round_to_pages(1, lean::page_size_policy::explicit_huge), hugePageSize);
+}
+
+BOOST_AUTO_TEST_CASE( aligned_blocks )
+{
+	void *block = lean::page_heap::allocate(100);
+	void *block4k = lean::page_heap::allocate<4096>(10000);
+	void *block2m = lean::page_heap::allocate<2 * 1024 * 1024>(10);
+	void *block1k = lean::page_heap::allocate(10, 1024);
+
+	BOOST_CHECK(reinterpret_cast<uintptr_t>(block) % lean::page_heap::default_alignment == 0);
+	BOOST_CHECK(reinterpret_cast<uintptr_t>(block4k) % 4096 == 0);
+	BOOST_CHECK(reinterpret_cast<uintptr_t>(block2m) % (2 * 1024 * 1024) == 0);
+	BOOST_CHECK(reinterpret_cast<uintptr_t>(block1k) % 1024 == 0);
+
+	BOOST_CHECK(lean::page_heap::size(block) >= 100);
+	BOOST_CHECK(lean::page_heap::size(block4k) >= 10000);
+	BOOST_CHECK(lean::page_heap::size(block2m) >= 10);
+
+	memset(block4k, 0xab, 10000);
+	memset(block2m, 0xcd, 10);
+
+	lean::page_heap::free(block);
+	lean::page_heap::free<4096>(block4k);
+	lean::page_heap::free<2 * 1024 * 1024>(block2m);
+	lean::page_heap::free(block1k, 1024);
+	lean::page_heap::free(nullptr);
+}
+
+BOOST_AUTO_TEST_CASE( huge_pages )
+{
+	static const size_t size = 8 * 1024 * 1024;
+
+	// Falls back to regular pages if huge pages unavailable
+	unsigned char *transparent = static_cast<unsigned char*>( lean::huge_page_heap::allocate(size) );
+	unsigned char *explicitHuge = static_cast<unsigned char*>( lean::basic_page_heap<lean::page_size_policy::explicit_huge>::allocate(size) );
+
+	memset(transparent, 1, size);
+	memset(explicitHuge, 2, size);
+
+	BOOST_CHECK(transparent[size - 1] == 1);
+	BOOST_CHECK(explicitHuge[size - 1] == 2);
+	BOOST_CHECK(lean::basic_page_heap<lean::page_size_policy::explicit_huge>::size(explicitHuge) >= size);
+
+	lean::huge_page_heap::free(transparent);
+	lean::basic_page_heap<lean::page_size_policy::explicit_huge>::free(explicitHuge);
+}
+
+BOOST_AUTO_TEST_CASE( decommit )
+{
+	size_t pageSize = lean::page_heap::page_size();
+	size_t size = 16 * pageSize;
+
+	unsigned char *pages = static_cast<unsigned char*>( lean::page_heap::map_pages(size, pageSize, lean::page_size_policy::normal) );
+	memset(pages, 0xff, size);
+
+	// Partial pages at the range boundaries are left untouched
+	lean::page_heap::decommit(pages + 1, size - 2);
+	BOOST_CHECK(pages[0] == 0xff);
+	BOOST_CHECK(pages[size - 1] == 0xff);
+#ifdef __linux__
+	BOOST_CHECK(pages[pageSize] == 0);
+#endif
+
+	// Pages remain accessible
+	memset(pages, 0x11, size);
+	BOOST_CHECK(pages[size / 2] == 0x11);
+
+	lean::page_heap::unmap_pages(pages, size, lean::page_size_policy::normal);
+}
+
+BOOST_AUTO_TEST_CASE( heap_concept )
+{
+	lean::chunk_heap<1024 * 1024, lean::huge_page_heap, 0> chunks;
+
+	for (int i = 0; i < 100; ++i)
+		memset(chunks.allocate(100000), i, 100000);
+
+	std::vector<int, lean::heap_allocator<int, lean::page_heap> > vector;
+
+	for (int i = 0; i < 100000; ++i)
+		vector.push_back(i);
+
+	BOOST_CHECK_EQUAL(vector[99999], 99999);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
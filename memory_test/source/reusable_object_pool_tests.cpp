@@ -0,0 +1,137 @@
+#include "stdafx.h"
+#include <lean/memory/reusable_object_pool.h>
+#include <vector>
+#include <algorithm>
+
+namespace
+{
+
+/// Counts live instances.
+struct session
+{
+	static long instances;
+	int id;
+	char data[20];
+
+	session(int id) : id(id) { ++instances; }
+	session(const session &right) : id(right.id) { ++instances; }
+	~session() { --instances; }
+};
+
+long session::instances = 0;
+
+/// Throws on copy construction.
+struct throwing
+{
+	throwing() { }
+	throwing(const throwing&) { throw 0; }
+};
+
+/// Collects the ids of all objects passed.
+struct collect_ids
+{
+	std::vector<int> *ids;
+
+	collect_ids(std::vector<int> &ids) : ids(&ids) { }
+	void operator ()(session &s) const { ids->push_back(s.id); }
+};
+
+typedef lean::reusable_object_pool<session, 40> session_pool;
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE( reusable_object_pool )
+
+BOOST_AUTO_TEST_CASE( destroy_reuse )
+{
+	{
+		session_pool pool;
+
+		session *first = pool.place(session(0));
+		session *second = pool.place(session(1));
+		BOOST_CHECK_EQUAL(session::instances, 2);
+		BOOST_CHECK_EQUAL(pool.size(), 2U);
+
+		pool.destroy(first);
+		BOOST_CHECK_EQUAL(session::instances, 1);
+
+		// Slot re-used
+		BOOST_CHECK(pool.place(session(2)) == first);
+		BOOST_CHECK_EQUAL(second->id, 1);
+		BOOST_CHECK_EQUAL(pool.capacity(), 40U);
+	}
+
+	BOOST_CHECK_EQUAL(session::instances, 0);
+}
+
+BOOST_AUTO_TEST_CASE( for_each_live )
+{
+	session_pool pool;
+	std::vector<session*> sessions;
+
+	for (int i = 0; i < 1000; ++i)
+		sessions.push_back( pool.place(session(i)) );
+
+	// Destroy every third session
+	for (int i = 0; i < 1000; i += 3)
+		pool.destroy(sessions[i]);
+
+	std::vector<int> ids;
+	pool.for_each_live(collect_ids(ids));
+	std::sort(ids.begin(), ids.end());
+
+	BOOST_CHECK_EQUAL(ids.size(), pool.size());
+	BOOST_CHECK_EQUAL(ids.size(), 666U);
+
+	for (size_t i = 0; i < ids.size(); ++i)
+		BOOST_CHECK(ids[i] % 3 != 0);
+
+	// No chunks allocated while slots are free
+	size_t capacity = pool.capacity();
+	for (int i = 0; i < 334; ++i)
+		pool.place(session(i));
+	BOOST_CHECK_EQUAL(pool.capacity(), capacity);
+}
+
+BOOST_AUTO_TEST_CASE( destroy_all )
+{
+	{
+		session_pool pool;
+
+		for (int i = 0; i < 500; ++i)
+			pool.place(session(i));
+
+		size_t capacity = pool.capacity();
+		pool.destroy_all();
+		BOOST_CHECK_EQUAL(session::instances, 0);
+		BOOST_CHECK(pool.empty());
+
+		// Chunks retained
+		for (int i = 0; i < 500; ++i)
+			pool.place(session(i));
+		BOOST_CHECK_EQUAL(pool.capacity(), capacity);
+		BOOST_CHECK_EQUAL(session::instances, 500);
+
+		pool.clear();
+		BOOST_CHECK_EQUAL(session::instances, 0);
+		BOOST_CHECK_EQUAL(pool.capacity(), 0U);
+
+		pool.place(session(0));
+	}
+
+	BOOST_CHECK_EQUAL(session::instances, 0);
+}
+
+BOOST_AUTO_TEST_CASE( construction_failure )
+{
+	lean::reusable_object_pool<throwing, 8> pool;
+
+	BOOST_CHECK_THROW(pool.place(throwing()), int);
+	BOOST_CHECK(pool.empty());
+
+	// Slot returned
+	BOOST_CHECK_THROW(pool.place(throwing()), int);
+	BOOST_CHECK_EQUAL(pool.capacity(), 8U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,269 @@
+#include "stdafx.h"
+#include <lean/memory/slab_heap.h>
+#include <lean/memory/heap_allocator.h>
+#include <lean/memory/heap_bound.h>
+#include <lean/containers/dynamic_array.h>
+#include <lean/containers/mpmc_queue.h>
+#include <lean/concurrent/thread.h>
+#include <lean/concurrent/backoff.h>
+#include <cstring>
+#include <set>
+#include <vector>
+
+namespace
+{
+
+struct bound_object : public lean::heap_bound<lean::slab_heap>
+{
+	long values[5];
+};
+
+typedef lean::blocking_mpmc_queue<unsigned char*> block_queue;
+
+static const long transfer_count = 20000;
+
+/// Block size derived from the given index, covering small & large blocks.
+inline size_t block_size(long i)
+{
+	return (i % 97 == 0) ? 10000 + i % 5000 : sizeof(size_t) + 1 + (i * 37) % 2048;
+}
+
+struct producer
+{
+	block_queue *queue;
+
+	void operator ()() const
+	{
+		for (long i = 0; i < transfer_count; ++i)
+		{
+			size_t size = block_size(i);
+			unsigned char *block = static_cast<unsigned char*>( lean::slab_heap::allocate(size) );
+			memcpy(block, &size, sizeof(size));
+			block[size - 1] = static_cast<unsigned char>(size);
+			queue->push(block);
+		}
+
+		queue->push(nullptr);
+	}
+};
+
+struct consumer
+{
+	block_queue *queue;
+	volatile long *corrupted;
+
+	void operator ()() const
+	{
+		for (;;)
+		{
+			unsigned char *block;
+			queue->pop(block);
+
+			// One terminator per producer
+			if (!block)
+				break;
+
+			size_t size;
+			memcpy(&size, block, sizeof(size));
+
+			if (lean::slab_heap::size(block) < size || block[size - 1] != static_cast<unsigned char>(size))
+				lean::atomic_increment(*corrupted);
+
+			// Cross-thread free
+			lean::slab_heap::free(block);
+		}
+	}
+};
+
+struct overlapping_thread
+{
+	volatile long *started;
+	long threadCount;
+	volatile long *corrupted;
+
+	void operator ()() const
+	{
+		std::vector<unsigned char*> blocks;
+
+		for (long i = 0; i < 100; ++i)
+		{
+			size_t size = block_size(i);
+			unsigned char *block = static_cast<unsigned char*>( lean::slab_heap::allocate(size) );
+			memcpy(block, &size, sizeof(size));
+			blocks.push_back(block);
+		}
+
+		// Keep all threads alive at the same time, exceeding the number of exclusive caches
+		lean::atomic_increment(*started);
+
+		while (*started < threadCount)
+			lean::yield_thread();
+
+		for (size_t i = 0; i < blocks.size(); ++i)
+		{
+			size_t size;
+			memcpy(&size, blocks[i], sizeof(size));
+
+			if (size != block_size(static_cast<long>(i)))
+				lean::atomic_increment(*corrupted);
+
+			lean::slab_heap::free(blocks[i]);
+		}
+	}
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE( slab_heap )
+
+BOOST_AUTO_TEST_CASE( size_classes )
+{
+	size_t previousSize = 0;
+
+	for (size_t i = 0; i < lean::slab_heap::size_class_count; ++i)
+	{
+		size_t classSize = lean::slab_heap::class_size(i);
+		BOOST_CHECK(classSize > previousSize);
+		BOOST_CHECK_EQUAL(classSize % lean::slab_heap::default_alignment, 0U);
+		BOOST_CHECK_EQUAL(lean::slab_heap::size_class(classSize), i);
+		BOOST_CHECK_EQUAL(lean::slab_heap::size_class(previousSize + 1), i);
+		previousSize = classSize;
+	}
+
+	BOOST_CHECK(previousSize == lean::slab_heap::max_small_size);
+	BOOST_CHECK(lean::slab_heap::size_class(lean::slab_heap::max_small_size + 1) == lean::slab_heap::size_class_count);
+}
+
+BOOST_AUTO_TEST_CASE( unique_blocks )
+{
+	std::vector<unsigned char*> blocks;
+	std::set<unsigned char*> unique;
+
+	for (long i = 0; i < 2000; ++i)
+	{
+		size_t size = block_size(i);
+		unsigned char *block = static_cast<unsigned char*>( lean::slab_heap::allocate(size) );
+		BOOST_CHECK(reinterpret_cast<uintptr_t>(block) % lean::slab_heap::default_alignment == 0);
+		BOOST_CHECK(lean::slab_heap::size(block) >= size);
+
+		memset(block, static_cast<int>(i & 0xff), size);
+		blocks.push_back(block);
+		unique.insert(block);
+	}
+
+	BOOST_CHECK_EQUAL(unique.size(), blocks.size());
+
+	for (long i = 0; i < static_cast<long>(blocks.size()); ++i)
+	{
+		size_t size = block_size(i);
+		BOOST_CHECK(blocks[i][0] == static_cast<unsigned char>(i & 0xff));
+		BOOST_CHECK(blocks[i][size - 1] == static_cast<unsigned char>(i & 0xff));
+		lean::slab_heap::free(blocks[i]);
+	}
+
+	lean::slab_heap::free(nullptr);
+}
+
+BOOST_AUTO_TEST_CASE( aligned_blocks )
+{
+	void *block32 = lean::slab_heap::allocate<32>(40);
+	void *block64 = lean::slab_heap::allocate<64>(100);
+	void *block4k = lean::slab_heap::allocate<4096>(10);
+	void *block64large = lean::slab_heap::allocate<64>(20000);
+
+	BOOST_CHECK(reinterpret_cast<uintptr_t>(block32) % 32 == 0);
+	BOOST_CHECK(reinterpret_cast<uintptr_t>(block64) % 64 == 0);
+	BOOST_CHECK(reinterpret_cast<uintptr_t>(block4k) % 4096 == 0);
+	BOOST_CHECK(reinterpret_cast<uintptr_t>(block64large) % 64 == 0);
+	BOOST_CHECK(lean::slab_heap::size(block4k) >= 10);
+	BOOST_CHECK(lean::slab_heap::size(block64large) >= 20000);
+
+	lean::slab_heap::free<32>(block32);
+	lean::slab_heap::free<64>(block64);
+	lean::slab_heap::free(block4k, 4096);
+	lean::slab_heap::free<64>(block64large);
+
+	// Zero-size blocks are aligned, too
+	for (int i = 0; i < 16; ++i)
+	{
+		void *empty32 = lean::slab_heap::allocate<32>(0);
+		void *empty64 = lean::slab_heap::allocate<64>(0);
+
+		BOOST_CHECK(reinterpret_cast<uintptr_t>(empty32) % 32 == 0);
+		BOOST_CHECK(reinterpret_cast<uintptr_t>(empty64) % 64 == 0);
+
+		lean::slab_heap::free<32>(empty32);
+		lean::slab_heap::free<64>(empty64);
+	}
+}
+
+BOOST_AUTO_TEST_CASE( heap_concept )
+{
+	std::vector<int, lean::heap_allocator<int, lean::slab_heap> > vector;
+
+	for (int i = 0; i < 10000; ++i)
+		vector.push_back(i);
+
+	BOOST_CHECK_EQUAL(vector[9999], 9999);
+
+	lean::dynamic_array<long, lean::slab_heap> array(100);
+
+	for (long i = 0; i < 100; ++i)
+		array.push_back(i);
+
+	BOOST_CHECK_EQUAL(array[99], 99);
+
+	bound_object *object = new bound_object();
+	BOOST_CHECK(lean::slab_heap::size(object) >= sizeof(bound_object));
+	delete object;
+}
+
+BOOST_AUTO_TEST_CASE( producer_consumer )
+{
+	static const int pairCount = 3;
+
+	block_queue queue(256);
+	volatile long corrupted = 0;
+
+	lean::thread threads[2 * pairCount];
+
+	for (int i = 0; i < pairCount; ++i)
+	{
+		consumer cons = { &queue, &corrupted };
+		threads[2 * i] = lean::thread(cons);
+		producer prod = { &queue };
+		threads[2 * i + 1] = lean::thread(prod);
+	}
+
+	for (int i = 0; i < 2 * pairCount; ++i)
+		threads[i].join();
+
+	BOOST_CHECK_EQUAL(corrupted, 0);
+}
+
+BOOST_AUTO_TEST_CASE( thread_exit )
+{
+	static const long threadCount = lean::slab_heap::cache_count + 8;
+
+	volatile long corrupted = 0;
+
+	// Caches of exited threads are handed on to threads of the next round
+	for (int round = 0; round < 3; ++round)
+	{
+		volatile long started = 0;
+		std::vector<lean::thread> threads(threadCount);
+
+		for (long i = 0; i < threadCount; ++i)
+		{
+			overlapping_thread overlapping = { &started, threadCount, &corrupted };
+			threads[i] = lean::thread(overlapping);
+		}
+
+		for (long i = 0; i < threadCount; ++i)
+			threads[i].join();
+	}
+
+	BOOST_CHECK_EQUAL(corrupted, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,135 @@
+#include "stdafx.h"
+#include <lean/memory/tracking_heap.h>
+#include <lean/memory/crt_heap.h>
+#include <lean/memory/heap_allocator.h>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+
+typedef lean::tracking_heap<lean::crt_heap> test_heap;
+
+/// Gets the statistics of the site identified by the given tag.
+lean::tracking_site_stats get_tagged_site(const char *tag)
+{
+	std::vector<lean::tracking_site_stats> sites(test_heap::site_count());
+	sites.resize( test_heap::sites(&sites[0], sites.size()) );
+
+	for (size_t i = 0; i < sites.size(); ++i)
+		if (sites[i].tag == tag)
+			return sites[i];
+
+	lean::tracking_site_stats none = { };
+	return none;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE( tracking_heap )
+
+BOOST_AUTO_TEST_CASE( tagged_sites )
+{
+	static const char *const tag = "tagged_sites";
+
+	void *blocks[10];
+
+	{
+		lean::scoped_allocation_tag scope(tag);
+
+		for (int i = 0; i < 10; ++i)
+			blocks[i] = test_heap::allocate(100);
+	}
+
+	lean::tracking_site_stats site = get_tagged_site(tag);
+	BOOST_CHECK_EQUAL(site.allocationCount, 10U);
+	BOOST_CHECK_EQUAL(site.liveBytes, 1000U);
+	BOOST_CHECK_EQUAL(site.peakBytes, 1000U);
+
+	// Untagged allocations attributed elsewhere
+	void *untagged = test_heap::allocate(100);
+
+	for (int i = 0; i < 10; ++i)
+		test_heap::free(blocks[i]);
+
+	site = get_tagged_site(tag);
+	BOOST_CHECK_EQUAL(site.allocationCount, 10U);
+	BOOST_CHECK_EQUAL(site.freeCount, 10U);
+	BOOST_CHECK_EQUAL(site.liveBytes, 0U);
+	BOOST_CHECK_EQUAL(site.peakBytes, 1000U);
+	BOOST_CHECK_EQUAL(site.allocatedBytes, 1000U);
+
+	test_heap::free(untagged);
+}
+
+BOOST_AUTO_TEST_CASE( aligned_blocks )
+{
+	void *block16 = test_heap::allocate<16>(10);
+	void *block64 = test_heap::allocate<64>(10);
+	void *block128 = test_heap::allocate<128>(10);
+
+	BOOST_CHECK(reinterpret_cast<uintptr_t>(block16) % 16 == 0);
+	BOOST_CHECK(reinterpret_cast<uintptr_t>(block64) % 64 == 0);
+	BOOST_CHECK(reinterpret_cast<uintptr_t>(block128) % 128 == 0);
+
+	test_heap::free<16>(block16);
+	test_heap::free<64>(block64);
+	test_heap::free(block128, 128);
+	test_heap::free(nullptr);
+}
+
+BOOST_AUTO_TEST_CASE( lifetimes )
+{
+	static const char *const tag = "lifetimes";
+
+	lean::scoped_allocation_tag scope(tag);
+
+	// Immediately freed
+	test_heap::free(test_heap::allocate(10));
+
+	// Freed after 100 allocations
+	void *longLived = test_heap::allocate(10);
+	for (int i = 0; i < 100; ++i)
+		test_heap::free(test_heap::allocate(10));
+	test_heap::free(longLived);
+
+	lean::tracking_site_stats site = get_tagged_site(tag);
+	BOOST_CHECK_EQUAL(site.lifetimes[0], 101U);
+	BOOST_CHECK_EQUAL(site.lifetimes[7], 1U);
+}
+
+BOOST_AUTO_TEST_CASE( no_allocation )
+{
+	std::vector<int, lean::heap_allocator<int, test_heap> > vector(100);
+
+	{
+		lean::no_allocation_scope scope;
+
+		for (int i = 0; i < 100; ++i)
+			vector[i] = i;
+
+		BOOST_CHECK_EQUAL(scope.allocations(), 0U);
+	}
+
+	{
+		lean::no_allocation_scope scope(false);
+		vector.push_back(100);
+		BOOST_CHECK_EQUAL(scope.allocations(), 1U);
+	}
+}
+
+BOOST_AUTO_TEST_CASE( report )
+{
+	static const char *const tag = "report";
+
+	lean::scoped_allocation_tag scope(tag);
+	void *block = test_heap::allocate(10);
+
+	std::ostringstream stream;
+	test_heap::report(stream);
+	BOOST_CHECK(stream.str().find(tag) != std::string::npos);
+
+	test_heap::free(block);
+}
+
+BOOST_AUTO_TEST_SUITE_END()